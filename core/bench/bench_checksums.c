@@ -0,0 +1,208 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/*
+ * Checksum benchmark: the throughput of every CRC-32 and Adler-32 path of miniz
+ * on the buffers of the sizes the PNG writer gives them. The paths are internal,
+ * so the library source is compiled right here.
+ *
+ * Usage: bench_checksums [-m megabytes]
+ *   -m N        Amount of data checksummed by every path for every size (default 256)
+ *
+ * Every path must give the same checksum as the byte-wise one, otherwise the run fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "miniz.c"
+
+#include "core_sys.h"
+
+enum
+{
+    PATH_CRC_BYTEWISE = 0,
+    PATH_CRC_SLICE8,
+    PATH_CRC_PCLMUL,
+    PATH_CRC_DISPATCH,
+    PATH_ADLER_SCALAR,
+    PATH_ADLER_SSE2,
+    PATH_ADLER_DISPATCH,
+    PATH_COUNT
+};
+
+static const char *s_pathNames[PATH_COUNT] =
+{
+    "crc32,bytewise",
+    "crc32,slicing-by-8",
+    "crc32,pclmul",
+    "crc32,mz_crc32",
+    "adler32,scalar",
+    "adler32,sse2",
+    "adler32,mz_adler32"
+};
+
+/* The table loop miniz had before the slicing, the reference for the speed-up */
+static mz_uint32 crcBytewise(const mz_uint8 *p, size_t len)
+{
+    mz_uint32 crc = 0xFFFFFFFF;
+
+    while (len--)
+        crc = (crc >> 8) ^ s_crc_table[0][(crc ^ *p++) & 0xFF];
+
+    return ~crc;
+}
+
+/* Returns 0 if the path isn't available on this CPU or for this size */
+static int runPath(int path, const mz_uint8 *p, size_t len, mz_uint32 *result)
+{
+    mz_uint32 s1 = 1, s2 = 0;
+#if MINIZ_X86_SIMD_CHECKSUMS
+    size_t done;
+#endif
+
+    switch (path)
+    {
+    case PATH_CRC_BYTEWISE:
+        *result = crcBytewise(p, len);
+        return 1;
+    case PATH_CRC_SLICE8:
+#ifndef MINIZ_ARM_CRC32
+        *result = ~mz_crc32_slice8(0xFFFFFFFF, p, len);
+        return 1;
+#else
+        return 0;
+#endif
+    case PATH_CRC_PCLMUL:
+#if MINIZ_X86_SIMD_CHECKSUMS
+        if (len < 64 || (len & 15) || !(mz_x86_cpu_features() & MZ_CPU_PCLMUL))
+            return 0;
+        *result = ~mz_crc32_pclmul(0xFFFFFFFF, p, len);
+        return 1;
+#else
+        return 0;
+#endif
+    case PATH_CRC_DISPATCH:
+        *result = (mz_uint32)mz_crc32(MZ_CRC32_INIT, p, len);
+        return 1;
+    case PATH_ADLER_SCALAR:
+        mz_adler32_scalar(&s1, &s2, p, len);
+        *result = (s2 << 16) + s1;
+        return 1;
+    case PATH_ADLER_SSE2:
+#if MINIZ_X86_SIMD_CHECKSUMS
+        if (!(mz_x86_cpu_features() & MZ_CPU_SSE2))
+            return 0;
+        done = mz_adler32_sse2(&s1, &s2, p, len);
+        mz_adler32_scalar(&s1, &s2, p + done, len - done);
+        *result = (s2 << 16) + s1;
+        return 1;
+#else
+        return 0;
+#endif
+    default:
+        *result = (mz_uint32)mz_adler32(MZ_ADLER32_INIT, p, len);
+        return 1;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    /* A short row, the 8 KB IDAT chunk of spng, the stripe of the striped encoder, and a whole 1080p frame */
+    static const size_t sizes[] = {64, 1024, 8192, 262144, 1920 * 1080 * 3};
+    unsigned long megabytes = 256, rnd = 1;
+    mz_uint32 result, expect = 0;
+    uint64_t start, elapsed;
+    size_t s, total, done, i, maxSize = 1920 * 1080 * 3;
+    mz_uint8 *buf;
+    int path, a, first;
+
+    for (a = 1; a < argc; ++a)
+    {
+        if (strcmp(argv[a], "-m") == 0 && a + 1 < argc)
+            megabytes = strtoul(argv[++a], NULL, 10);
+        else
+        {
+            fprintf(stderr, "Usage: bench_checksums [-m megabytes]\n");
+            return 1;
+        }
+    }
+
+    if (megabytes < 1)
+        megabytes = 1;
+
+    buf = (mz_uint8 *)malloc(maxSize);
+    if (!buf)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    for (i = 0; i < maxSize; ++i)
+    {
+        rnd = rnd * 1103515245UL + 12345UL;
+        buf[i] = (mz_uint8)(rnd >> 16);
+    }
+
+    total = (size_t)megabytes * 1024 * 1024;
+    first = buf[0];
+
+    printf("checksum,path,bytes,mb_per_s\n");
+
+    for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        for (path = 0; path < PATH_COUNT; ++path)
+        {
+            buf[0] = (mz_uint8)first;
+            if (!runPath(path, buf, sizes[s], &result))
+                continue;
+
+            if (path == PATH_CRC_BYTEWISE || path == PATH_ADLER_SCALAR)
+                expect = result;
+            else if (result != expect)
+            {
+                fprintf(stderr, "%s: %lu bytes give 0x%08lX instead of 0x%08lX\n", s_pathNames[path],
+                        (unsigned long)sizes[s], (unsigned long)result, (unsigned long)expect);
+                return 1;
+            }
+
+            /* Every run changes the first byte, so the runs can't be merged by the compiler */
+            start = coreSys_timeUs();
+            for (done = 0; done < total; done += sizes[s])
+            {
+                runPath(path, buf, sizes[s], &result);
+                buf[0] = (mz_uint8)result;
+            }
+            elapsed = coreSys_timeUs() - start;
+
+            printf("%s,%lu,%.0f\n", s_pathNames[path], (unsigned long)sizes[s],
+                   elapsed > 0 ? (double)done * 1000000.0 / (1024.0 * 1024.0) / (double)elapsed : 0.0);
+            fflush(stdout);
+        }
+    }
+
+    free(buf);
+
+    return 0;
+}
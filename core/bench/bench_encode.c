@@ -0,0 +1,917 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Encoder benchmark: compresses the set of screen-like frames with every combination of the filters,
+ * compression level, strategy and colour type, and prints the speed and size of every run.
+ *
+ * Usage: bench_encode [options] [name_WIDTHxHEIGHT.rgba ...]
+ *   -r N        Number of the encodings of every frame for every combination (default 1)
+ *   -w N        Number of the stripe encoding workers, 1 is the plain single-threaded libspng (default 1)
+ *   -s WxH      Size of the generated frames (default 1920x1080)
+ *   -j          Print JSON instead of CSV
+ *   -q          Quick run: only the combinations used by the compression presets
+ *   -f          Compare the file formats instead: every PNG preset against QOI, BMP and TGA, RGB only
+ *   -p          Print the speed and size of every PNG preset by the stripe count instead, RGB only
+ *   -d DIR      Write the generated frames as raw RGBA files into the directory and exit
+ *
+ * Without the file arguments, the built-in corpus gets generated: desktop, IDE, game and photo.
+ * It is made from the fixed seed, so results are comparable between machines and builds.
+ * Raw files are plain 8-bit RGBA pixels without any header, their size is taken from the file name.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#   include <windows.h>
+#   include <psapi.h>
+#else
+#   include <sys/resource.h>
+#endif
+
+#include "spng.h"
+#include "miniz.h"
+#include "png_preset.h"
+#include "png_stripes.h"
+#include "shot_format.h"
+#include "core_sys.h"
+
+struct BenchFrame
+{
+    char name[64];
+    uint32_t w;
+    uint32_t h;
+    /* RGBA pixels */
+    uint8_t *rgba;
+    /* Same pixels without alpha */
+    uint8_t *rgb;
+};
+
+typedef struct BenchFrame BenchFrame;
+
+#define BENCH_MAX_FRAMES    32
+
+static const struct
+{
+    const char *name;
+    int mask;
+} s_filters[] =
+{
+    {"none",        SPNG_FILTER_CHOICE_NONE},
+    {"sub+up",      SPNG_FILTER_CHOICE_SUB | SPNG_FILTER_CHOICE_UP},
+    {"sub+up+paeth", SPNG_FILTER_CHOICE_SUB | SPNG_FILTER_CHOICE_UP | SPNG_FILTER_CHOICE_PAETH},
+    {"all",         SPNG_FILTER_CHOICE_ALL}
+};
+
+static const struct
+{
+    const char *name;
+    int id;
+} s_strategies[] =
+{
+    {"default",     MZ_DEFAULT_STRATEGY},
+    {"filtered",    MZ_FILTERED},
+    {"rle",         MZ_RLE}
+};
+
+static const int s_levels[] = {1, 3, 6, 9};
+
+#define ARRAY_LEN(a) (sizeof(a) / sizeof(a[0]))
+
+
+/* ---------------------------------------------------------------------------------------------- */
+/*  Corpus generation                                                                             */
+/* ---------------------------------------------------------------------------------------------- */
+
+static uint32_t s_seed;
+
+static uint32_t rnd(void)
+{
+    s_seed = s_seed * 1103515245u + 12345u;
+    return (s_seed >> 8) & 0xFFFFFF;
+}
+
+static uint32_t rndRange(uint32_t max)
+{
+    return max ? rnd() % max : 0;
+}
+
+static void putPixel(BenchFrame *f, uint32_t x, uint32_t y, int r, int g, int b)
+{
+    uint8_t *p;
+
+    if(x >= f->w || y >= f->h)
+        return;
+
+    p = f->rgba + ((size_t)y * f->w + x) * 4;
+    p[0] = (uint8_t)(r < 0 ? 0 : r > 255 ? 255 : r);
+    p[1] = (uint8_t)(g < 0 ? 0 : g > 255 ? 255 : g);
+    p[2] = (uint8_t)(b < 0 ? 0 : b > 255 ? 255 : b);
+    p[3] = 255;
+}
+
+static void fillRect(BenchFrame *f, uint32_t x, uint32_t y, uint32_t w, uint32_t h, int r, int g, int b)
+{
+    uint32_t i, j;
+
+    for(j = y; j < y + h && j < f->h; ++j)
+    {
+        for(i = x; i < x + w && i < f->w; ++i)
+            putPixel(f, i, j, r, g, b);
+    }
+}
+
+/* Line of the text-like glyphs: every glyph is a 6x9 cell with a pseudo-random set of strokes */
+static uint32_t drawText(BenchFrame *f, uint32_t x, uint32_t y, uint32_t glyphs, int r, int g, int b)
+{
+    uint32_t i, gx, gy, bits;
+
+    for(i = 0; i < glyphs; ++i, x += 7)
+    {
+        if(rndRange(6) == 0)
+            continue; /* Space */
+
+        bits = rnd();
+
+        for(gy = 0; gy < 9; ++gy)
+        {
+            for(gx = 0; gx < 5; ++gx)
+            {
+                if((gx == 0 && (bits & 1)) || (gx == 4 && (bits & 2)) ||
+                   (gy == 0 && (bits & 4)) || (gy == 8 && (bits & 8)) || (gy == 4 && (bits & 16)) ||
+                   (gx == gy / 2 && (bits & 32)))
+                    putPixel(f, x + gx, y + gy, r, g, b);
+            }
+        }
+    }
+
+    return x;
+}
+
+static void genDesktop(BenchFrame *f)
+{
+    uint32_t x, y, i, line, wx, wy, ww, wh;
+
+    /* Gradient wallpaper */
+    for(y = 0; y < f->h; ++y)
+    {
+        for(x = 0; x < f->w; ++x)
+            putPixel(f, x, y, 40 + (int)(y * 60 / f->h), 90 + (int)(x * 40 / f->w), 150);
+    }
+
+    /* Desktop icons */
+    for(i = 0; i < 8; ++i)
+    {
+        fillRect(f, 20, 20 + i * 90, 48, 48, 200 - (int)i * 20, 180, 60 + (int)i * 20);
+        drawText(f, 16, 74 + i * 90, 8, 255, 255, 255);
+    }
+
+    /* Windows with title bars, buttons and text */
+    for(i = 0; i < 5; ++i)
+    {
+        ww = f->w / 3 + rndRange(f->w / 4);
+        wh = f->h / 3 + rndRange(f->h / 4);
+        wx = 100 + rndRange(f->w - ww - 100);
+        wy = rndRange(f->h - wh - 40);
+
+        fillRect(f, wx, wy, ww, wh, 212, 208, 200);
+        fillRect(f, wx + 3, wy + 3, ww - 6, 18, 10, 36, 106);
+        drawText(f, wx + 8, wy + 7, (ww - 80) / 7 / 2, 255, 255, 255);
+        fillRect(f, wx + ww - 22, wy + 5, 14, 14, 212, 208, 200);
+        fillRect(f, wx + 6, wy + 46, ww - 12, wh - 52, 255, 255, 255);
+
+        for(line = wy + 50; line + 12 < wy + wh - 6; line += 14)
+            drawText(f, wx + 10, line, rndRange((ww - 30) / 7), 0, 0, 0);
+    }
+
+    /* Taskbar */
+    fillRect(f, 0, f->h - 30, f->w, 30, 212, 208, 200);
+    fillRect(f, 2, f->h - 26, 60, 22, 190, 190, 190);
+    for(i = 0; i < 5; ++i)
+        drawText(f, 80 + i * 160, f->h - 20, 18, 0, 0, 0);
+}
+
+static void genIde(BenchFrame *f)
+{
+    static const int colours[][3] =
+    {
+        {212, 212, 212}, {86, 156, 214}, {206, 145, 120}, {106, 153, 85}, {197, 134, 192}, {78, 201, 176}
+    };
+    uint32_t y, x, line = 0;
+    const int *c;
+
+    fillRect(f, 0, 0, f->w, f->h, 30, 30, 30);
+    fillRect(f, 0, 0, 250, f->h, 37, 37, 38);
+    fillRect(f, 0, 0, f->w, 30, 51, 51, 51);
+    fillRect(f, 0, f->h - 22, f->w, 22, 0, 122, 204);
+
+    /* Project tree */
+    for(y = 40; y + 16 < f->h - 22; y += 22)
+        drawText(f, 20 + rndRange(4) * 14, y, 6 + rndRange(20), 204, 204, 204);
+
+    /* Source code with the indentation, line numbers and syntax highlighting */
+    for(y = 40; y + 16 < f->h - 22; y += 18, ++line)
+    {
+        drawText(f, 260, y, 4, 133, 133, 133);
+        x = 310 + (line % 7) * 28;
+
+        while(x < f->w - 100 && rndRange(8) != 0)
+        {
+            c = colours[rndRange(ARRAY_LEN(colours))];
+            x = drawText(f, x, y, 2 + rndRange(10), c[0], c[1], c[2]) + 7;
+        }
+    }
+}
+
+static void genGame(BenchFrame *f)
+{
+    uint32_t x, y, i, ground;
+    int n;
+
+    for(x = 0; x < f->w; ++x)
+    {
+        ground = f->h * 2 / 3 + (uint32_t)(sin(x * 0.01) * f->h / 12 + sin(x * 0.037) * f->h / 40);
+
+        for(y = 0; y < f->h; ++y)
+        {
+            if(y < ground)
+                putPixel(f, x, y, 100 + (int)(y * 120 / f->h), 150 + (int)(y * 80 / f->h), 255);
+            else
+            {
+                /* Noisy dithered ground texture */
+                n = (int)rndRange(40);
+                putPixel(f, x, y, 90 + n, 60 + n / 2 + (int)((y - ground) & 15), 30 + n / 3);
+            }
+        }
+    }
+
+    /* Sprites and particles */
+    for(i = 0; i < 40; ++i)
+        fillRect(f, rndRange(f->w), rndRange(f->h), 16 + rndRange(48), 16 + rndRange(48),
+                 (int)rndRange(256), (int)rndRange(256), (int)rndRange(256));
+
+    /* HUD */
+    fillRect(f, 20, 20, 300, 24, 0, 0, 0);
+    fillRect(f, 22, 22, 220, 20, 200, 30, 30);
+    drawText(f, f->w - 200, 26, 20, 255, 255, 0);
+}
+
+static void genPhoto(BenchFrame *f)
+{
+    /* Value noise of several octaves plus the sensor noise */
+    enum { GRID = 17 };
+    static float grid[3][GRID][GRID];
+    uint32_t x, y;
+    int o, c, gx, gy, v[3];
+    float fx, fy, a, b;
+
+    for(o = 0; o < 3; ++o)
+    {
+        for(gy = 0; gy < GRID; ++gy)
+        {
+            for(gx = 0; gx < GRID; ++gx)
+                grid[o][gy][gx] = (float)rndRange(256);
+        }
+    }
+
+    for(y = 0; y < f->h; ++y)
+    {
+        for(x = 0; x < f->w; ++x)
+        {
+            for(c = 0; c < 3; ++c)
+                v[c] = 0;
+
+            for(o = 0; o < 3; ++o)
+            {
+                fx = (float)x * (GRID - 1) * (float)(o + 1) / 3.0f / f->w;
+                fy = (float)y * (GRID - 1) * (float)(o + 1) / 3.0f / f->h;
+                gx = (int)fx;
+                gy = (int)fy;
+                fx -= (float)gx;
+                fy -= (float)gy;
+                a = grid[o][gy][gx] * (1.0f - fx) + grid[o][gy][gx + 1] * fx;
+                b = grid[o][gy + 1][gx] * (1.0f - fx) + grid[o][gy + 1][gx + 1] * fx;
+                a = a * (1.0f - fy) + b * fy;
+
+                for(c = 0; c < 3; ++c)
+                    v[c] += (int)(a * (0.9f - c * 0.2f)) >> o;
+            }
+
+            o = (int)rndRange(9) - 4;
+            putPixel(f, x, y, v[0] / 2 + o, v[1] / 2 + o + 20, v[2] / 2 + o + 10);
+        }
+    }
+}
+
+static int allocFrame(BenchFrame *f, const char *name, uint32_t w, uint32_t h)
+{
+    memset(f, 0, sizeof(BenchFrame));
+    strncpy(f->name, name, sizeof(f->name) - 1);
+    f->w = w;
+    f->h = h;
+    f->rgba = (uint8_t *)malloc((size_t)w * h * 4);
+
+    return f->rgba != NULL;
+}
+
+static void makeRgb(BenchFrame *f)
+{
+    size_t i, count = (size_t)f->w * f->h;
+
+    f->rgb = (uint8_t *)malloc(count * 3);
+    if(!f->rgb)
+        return;
+
+    for(i = 0; i < count; ++i)
+        memcpy(f->rgb + i * 3, f->rgba + i * 4, 3);
+}
+
+static int generateCorpus(BenchFrame *frames, uint32_t w, uint32_t h)
+{
+    static const struct
+    {
+        const char *name;
+        void (*gen)(BenchFrame *f);
+    } gens[] =
+    {
+        {"desktop", genDesktop},
+        {"ide", genIde},
+        {"game", genGame},
+        {"photo", genPhoto}
+    };
+    size_t i;
+
+    for(i = 0; i < ARRAY_LEN(gens); ++i)
+    {
+        if(!allocFrame(&frames[i], gens[i].name, w, h))
+            return -1;
+
+        s_seed = 0x5C12EE2u + (uint32_t)i;
+        gens[i].gen(&frames[i]);
+    }
+
+    return (int)ARRAY_LEN(gens);
+}
+
+static int loadFrame(BenchFrame *f, const char *path)
+{
+    const char *base = path, *p;
+    unsigned long w = 0, h = 0;
+    size_t len;
+    FILE *in;
+
+    for(p = path; *p; ++p)
+    {
+        if(*p == '/' || *p == '\\')
+            base = p + 1;
+    }
+
+    /* The size is the last "_WxH" part of the name */
+    p = strrchr(base, '_');
+    if(!p || sscanf(p + 1, "%lux%lu", &w, &h) != 2 || !w || !h)
+    {
+        fprintf(stderr, "%s: can't get the frame size from the file name, expected name_WIDTHxHEIGHT.rgba\n", path);
+        return 0;
+    }
+
+    if(!allocFrame(f, base, (uint32_t)w, (uint32_t)h))
+        return 0;
+
+    if(strchr(f->name, '.'))
+        *strrchr(f->name, '.') = '\0';
+
+    in = fopen(path, "rb");
+    if(!in)
+    {
+        fprintf(stderr, "%s: can't open the file\n", path);
+        return 0;
+    }
+
+    len = fread(f->rgba, 1, (size_t)w * h * 4, in);
+    fclose(in);
+
+    if(len != (size_t)w * h * 4)
+    {
+        fprintf(stderr, "%s: the file is shorter than %lux%lu RGBA pixels\n", path, w, h);
+        return 0;
+    }
+
+    return 1;
+}
+
+static int dumpCorpus(const BenchFrame *frames, int count, const char *dir)
+{
+    char path[1024];
+    FILE *out;
+    int i, len;
+
+    for(i = 0; i < count; ++i)
+    {
+        len = snprintf(path, sizeof(path), "%s%c%s_%lux%lu.rgba", dir, CORE_PATH_SEP, frames[i].name,
+                       (unsigned long)frames[i].w, (unsigned long)frames[i].h);
+        if(len < 0 || (size_t)len >= sizeof(path))
+        {
+            fprintf(stderr, "%s: the path is too long\n", dir);
+            return 1;
+        }
+
+        out = fopen(path, "wb");
+        if(!out || fwrite(frames[i].rgba, 1, (size_t)frames[i].w * frames[i].h * 4, out) != (size_t)frames[i].w * frames[i].h * 4)
+        {
+            fprintf(stderr, "%s: can't write the file\n", path);
+            if(out)
+                fclose(out);
+            return 1;
+        }
+
+        fclose(out);
+        fprintf(stderr, "%s\n", path);
+    }
+
+    return 0;
+}
+
+
+/* ---------------------------------------------------------------------------------------------- */
+/*  Measuring                                                                                     */
+/* ---------------------------------------------------------------------------------------------- */
+
+static unsigned long peakRssKb(void)
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+
+    memset(&pmc, 0, sizeof(pmc));
+    pmc.cb = sizeof(pmc);
+
+    if(!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return 0;
+
+    return (unsigned long)(pmc.PeakWorkingSetSize / 1024);
+#else
+    struct rusage usage;
+
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+#   ifdef __APPLE__
+    return (unsigned long)(usage.ru_maxrss / 1024);
+#   else
+    return (unsigned long)usage.ru_maxrss;
+#   endif
+#endif
+}
+
+/* Same way as the saver thread does it: plain libspng for one worker, the striped encoder otherwise */
+static int encodeFrame(const BenchFrame *f, int channels, int workers, const PngPreset *preset, size_t *out_len)
+{
+    const uint8_t *pixels = channels == 4 ? f->rgba : f->rgb;
+    struct spng_ihdr ihdr;
+    spng_ctx *ctx;
+    uint8_t *png;
+    int ret;
+
+    if(workers > 1)
+    {
+        ret = pngStripes_encodeToBuffer(&png, out_len, pixels, f->w, f->h, f->w * channels, channels, workers, preset);
+        if(ret == 0)
+            free(png);
+        return ret;
+    }
+
+    ctx = spng_ctx_new(SPNG_CTX_ENCODER);
+    if(!ctx)
+        return SPNG_EMEM;
+
+    memset(&ihdr, 0, sizeof(ihdr));
+    ihdr.width = f->w;
+    ihdr.height = f->h;
+    ihdr.bit_depth = 8;
+    ihdr.color_type = channels == 4 ? SPNG_COLOR_TYPE_TRUECOLOR_ALPHA : SPNG_COLOR_TYPE_TRUECOLOR;
+
+    spng_set_ihdr(ctx, &ihdr);
+    spng_set_option(ctx, SPNG_ENCODE_TO_BUFFER, 1);
+    spng_set_option(ctx, SPNG_IMG_COMPRESSION_LEVEL, preset->level);
+    spng_set_option(ctx, SPNG_IMG_COMPRESSION_STRATEGY, preset->strategy);
+    spng_set_option(ctx, SPNG_FILTER_CHOICE, preset->filters);
+
+    ret = spng_encode_image(ctx, pixels, (size_t)f->w * f->h * channels, SPNG_FMT_PNG, SPNG_ENCODE_FINALIZE);
+    if(ret == 0)
+    {
+        png = (uint8_t *)spng_get_png_buffer(ctx, out_len, &ret);
+        free(png);
+    }
+
+    spng_ctx_free(ctx);
+
+    return ret;
+}
+
+static int isPresetCombo(int filters, int level, int strategy)
+{
+    int i;
+    const PngPreset *p;
+
+    for(i = 0; i < PNG_PRESET_COUNT; ++i)
+    {
+        p = pngPreset_get(i);
+        if(p->filters == filters && p->level == level && p->strategy == strategy)
+            return 1;
+    }
+
+    return 0;
+}
+
+/* The fast formats are encoded by one thread, the same way as the saver does it */
+static int encodeFormat(const BenchFrame *f, int format, size_t *out_len)
+{
+    uint8_t *out;
+    int ret;
+
+    ret = shotFormat_encode(format, &out, out_len, f->rgb, f->w, f->h, f->w * 3, 1, NULL);
+    if(ret == 0)
+        free(out);
+
+    return ret;
+}
+
+/* The sizes and times mean nothing if the file doesn't decode back into the same frame */
+static int checkFormat(const BenchFrame *f, int format)
+{
+    uint8_t *out = NULL, *pixels = NULL;
+    size_t out_len = 0;
+    uint32_t w = 0, h = 0;
+    int same;
+
+    if(shotFormat_encode(format, &out, &out_len, f->rgb, f->w, f->h, f->w * 3, 1, NULL) != 0)
+        return 0;
+
+    same = shotFormat_decode(out, out_len, &pixels, &w, &h) == format && w == f->w && h == f->h &&
+           memcmp(pixels, f->rgb, (size_t)w * h * 3) == 0;
+
+    free(out);
+    if(pixels)
+        free(pixels);
+
+    return same;
+}
+
+/* Rows of the PNG presets go first, then the other formats */
+static int benchFormats(const BenchFrame *frames, int count, int repeats, int workers, int json)
+{
+    int i, row, r, ret, first = 1;
+    const int rows = PNG_PRESET_COUNT + SHOT_FORMAT_COUNT - 1;
+    const char *format, *preset;
+    uint64_t start, elapsed;
+    double ms, mbs, in_mb;
+    size_t out_len = 0;
+
+    if(json)
+        printf("[\n");
+    else
+        printf("frame,width,height,format,preset,workers,ms_per_frame,mb_per_s,bytes,ratio,peak_rss_kb\n");
+
+    for(i = 0; i < count; ++i)
+    {
+        in_mb = (double)frames[i].w * frames[i].h * 3 / (1024.0 * 1024.0);
+
+        for(row = 0; row < rows; ++row)
+        {
+            start = coreSys_timeUs();
+
+            for(r = 0, ret = 0; r < repeats && ret == 0; ++r)
+            {
+                if(row < PNG_PRESET_COUNT)
+                    ret = encodeFrame(&frames[i], 3, workers, pngPreset_get(row), &out_len);
+                else
+                    ret = encodeFormat(&frames[i], row - PNG_PRESET_COUNT + 1, &out_len);
+            }
+
+            elapsed = coreSys_timeUs() - start;
+
+            if(ret != 0)
+            {
+                fprintf(stderr, "%s: encode failed: %s\n", frames[i].name, spng_strerror(ret));
+                return 1;
+            }
+
+            if(row >= PNG_PRESET_COUNT && !checkFormat(&frames[i], row - PNG_PRESET_COUNT + 1))
+            {
+                fprintf(stderr, "%s: %s doesn't decode into the same frame\n", frames[i].name,
+                        shotFormat_name(row - PNG_PRESET_COUNT + 1));
+                return 1;
+            }
+
+            format = shotFormat_name(row < PNG_PRESET_COUNT ? SHOT_FORMAT_PNG : row - PNG_PRESET_COUNT + 1);
+            preset = row < PNG_PRESET_COUNT ? pngPreset_get(row)->name : "-";
+            ms = (double)elapsed / 1000.0 / repeats;
+            mbs = ms > 0.0 ? in_mb * 1000.0 / ms : 0.0;
+
+            if(json)
+            {
+                printf("%s  {\"frame\": \"%s\", \"width\": %lu, \"height\": %lu, \"format\": \"%s\", "
+                       "\"preset\": \"%s\", \"workers\": %d, \"ms_per_frame\": %.3f, \"mb_per_s\": %.2f, "
+                       "\"bytes\": %lu, \"ratio\": %.4f, \"peak_rss_kb\": %lu}",
+                       first ? "" : ",\n",
+                       frames[i].name, (unsigned long)frames[i].w, (unsigned long)frames[i].h, format, preset,
+                       row < PNG_PRESET_COUNT ? workers : 1, ms, mbs, (unsigned long)out_len,
+                       (double)out_len / (in_mb * 1024.0 * 1024.0), peakRssKb());
+            }
+            else
+            {
+                printf("%s,%lu,%lu,%s,%s,%d,%.3f,%.2f,%lu,%.4f,%lu\n",
+                       frames[i].name, (unsigned long)frames[i].w, (unsigned long)frames[i].h, format, preset,
+                       row < PNG_PRESET_COUNT ? workers : 1, ms, mbs, (unsigned long)out_len,
+                       (double)out_len / (in_mb * 1024.0 * 1024.0), peakRssKb());
+            }
+
+            first = 0;
+            fflush(stdout);
+        }
+    }
+
+    if(json)
+        printf("\n]\n");
+
+    return 0;
+}
+
+/* Every preset with 1, 2, 4 and 8 stripes, the same way as the saver encodes the shots */
+static int benchPresets(const BenchFrame *frames, int count, int repeats, int json)
+{
+    static const int stripes[] = {1, 2, 4, 8};
+    int i, p, s, r, ret, first = 1;
+    const PngPreset *preset;
+    uint64_t start, elapsed;
+    double ms, mbs, in_mb;
+    size_t out_len = 0;
+
+    if(json)
+        printf("[\n");
+    else
+        printf("frame,width,height,preset,stripes,ms_per_frame,mb_per_s,bytes,ratio\n");
+
+    for(i = 0; i < count; ++i)
+    {
+        in_mb = (double)frames[i].w * frames[i].h * 3 / (1024.0 * 1024.0);
+
+        for(p = 0; p < PNG_PRESET_COUNT; ++p)
+        {
+            preset = pngPreset_get(p);
+
+            for(s = 0; s < (int)ARRAY_LEN(stripes); ++s)
+            {
+                start = coreSys_timeUs();
+
+                for(r = 0, ret = 0; r < repeats && ret == 0; ++r)
+                    ret = encodeFrame(&frames[i], 3, stripes[s], preset, &out_len);
+
+                elapsed = coreSys_timeUs() - start;
+
+                if(ret != 0)
+                {
+                    fprintf(stderr, "%s: encode failed: %s\n", frames[i].name, spng_strerror(ret));
+                    return 1;
+                }
+
+                ms = (double)elapsed / 1000.0 / repeats;
+                mbs = ms > 0.0 ? in_mb * 1000.0 / ms : 0.0;
+
+                if(json)
+                {
+                    printf("%s  {\"frame\": \"%s\", \"width\": %lu, \"height\": %lu, \"preset\": \"%s\", "
+                           "\"stripes\": %d, \"ms_per_frame\": %.3f, \"mb_per_s\": %.2f, \"bytes\": %lu, \"ratio\": %.4f}",
+                           first ? "" : ",\n",
+                           frames[i].name, (unsigned long)frames[i].w, (unsigned long)frames[i].h, preset->name,
+                           stripes[s], ms, mbs, (unsigned long)out_len, (double)out_len / (in_mb * 1024.0 * 1024.0));
+                }
+                else
+                {
+                    printf("%s,%lu,%lu,%s,%d,%.3f,%.2f,%lu,%.4f\n",
+                           frames[i].name, (unsigned long)frames[i].w, (unsigned long)frames[i].h, preset->name,
+                           stripes[s], ms, mbs, (unsigned long)out_len, (double)out_len / (in_mb * 1024.0 * 1024.0));
+                }
+
+                first = 0;
+                fflush(stdout);
+            }
+        }
+    }
+
+    if(json)
+        printf("\n]\n");
+
+    return 0;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "Usage: bench_encode [-r repeats] [-w workers] [-s WxH] [-j] [-q] [-f] [-p] [-d dir] [name_WIDTHxHEIGHT.rgba ...]\n");
+}
+
+int main(int argc, char **argv)
+{
+    BenchFrame frames[BENCH_MAX_FRAMES];
+    int count = 0, repeats = 1, workers = 1, json = 0, quick = 0, formats = 0, presets = 0, first = 1;
+    unsigned long gen_w = 1920, gen_h = 1080;
+    const char *dump_dir = NULL;
+    size_t fi, li, si, out_len = 0;
+    int i, r, c, channels, ret;
+    uint64_t start, elapsed;
+    double ms, mbs, in_mb;
+    PngPreset preset;
+
+    memset(frames, 0, sizeof(frames));
+
+    for(i = 1; i < argc; ++i)
+    {
+        if(strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            repeats = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+            workers = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+        {
+            if(sscanf(argv[++i], "%lux%lu", &gen_w, &gen_h) != 2 || gen_w < 64 || gen_h < 64)
+            {
+                usage();
+                return 1;
+            }
+        }
+        else if(strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+            dump_dir = argv[++i];
+        else if(strcmp(argv[i], "-j") == 0)
+            json = 1;
+        else if(strcmp(argv[i], "-q") == 0)
+            quick = 1;
+        else if(strcmp(argv[i], "-f") == 0)
+            formats = 1;
+        else if(strcmp(argv[i], "-p") == 0)
+            presets = 1;
+        else if(argv[i][0] == '-')
+        {
+            usage();
+            return 1;
+        }
+        else if(count < BENCH_MAX_FRAMES)
+        {
+            if(!loadFrame(&frames[count++], argv[i]))
+                return 1;
+        }
+    }
+
+    if(repeats < 1)
+        repeats = 1;
+
+    if(count == 0)
+    {
+        count = generateCorpus(frames, (uint32_t)gen_w, (uint32_t)gen_h);
+        if(count < 0)
+        {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+    }
+
+    if(dump_dir)
+        return dumpCorpus(frames, count, dump_dir);
+
+    for(i = 0; i < count; ++i)
+    {
+        makeRgb(&frames[i]);
+        if(!frames[i].rgb)
+        {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+    }
+
+    /* The stripe helpers are started once like in the saver, not for every encoding */
+    pngStripes_init(workers > 8 ? workers : 8);
+
+    if(formats || presets)
+    {
+        if(presets)
+            ret = benchPresets(frames, count, repeats, json);
+        else
+            ret = benchFormats(frames, count, repeats, workers, json);
+
+        for(i = 0; i < count; ++i)
+        {
+            free(frames[i].rgba);
+            free(frames[i].rgb);
+        }
+
+        pngStripes_quit();
+
+        return ret;
+    }
+
+    if(json)
+        printf("[\n");
+    else
+        printf("frame,width,height,colour,filters,level,strategy,workers,ms_per_frame,mb_per_s,bytes,ratio,peak_rss_kb\n");
+
+    for(i = 0; i < count; ++i)
+    {
+        for(c = 0; c < 2; ++c)
+        {
+            channels = c == 0 ? 3 : 4;
+            in_mb = (double)frames[i].w * frames[i].h * channels / (1024.0 * 1024.0);
+
+            for(fi = 0; fi < ARRAY_LEN(s_filters); ++fi)
+            {
+                for(li = 0; li < ARRAY_LEN(s_levels); ++li)
+                {
+                    for(si = 0; si < ARRAY_LEN(s_strategies); ++si)
+                    {
+                        if(quick && !isPresetCombo(s_filters[fi].mask, s_levels[li], s_strategies[si].id))
+                            continue;
+
+                        preset.name = "bench";
+                        preset.level = s_levels[li];
+                        preset.strategy = s_strategies[si].id;
+                        preset.filters = s_filters[fi].mask;
+
+                        start = coreSys_timeUs();
+
+                        for(r = 0, ret = 0; r < repeats && ret == 0; ++r)
+                            ret = encodeFrame(&frames[i], channels, workers, &preset, &out_len);
+
+                        elapsed = coreSys_timeUs() - start;
+
+                        if(ret != 0)
+                        {
+                            fprintf(stderr, "%s: encode failed: %s\n", frames[i].name, spng_strerror(ret));
+                            return 1;
+                        }
+
+                        ms = (double)elapsed / 1000.0 / repeats;
+                        mbs = ms > 0.0 ? in_mb * 1000.0 / ms : 0.0;
+
+                        if(json)
+                        {
+                            printf("%s  {\"frame\": \"%s\", \"width\": %lu, \"height\": %lu, \"colour\": \"%s\", "
+                                   "\"filters\": \"%s\", \"level\": %d, \"strategy\": \"%s\", \"workers\": %d, "
+                                   "\"ms_per_frame\": %.3f, \"mb_per_s\": %.2f, \"bytes\": %lu, \"ratio\": %.4f, "
+                                   "\"peak_rss_kb\": %lu}",
+                                   first ? "" : ",\n",
+                                   frames[i].name, (unsigned long)frames[i].w, (unsigned long)frames[i].h,
+                                   channels == 4 ? "rgba" : "rgb", s_filters[fi].name, s_levels[li],
+                                   s_strategies[si].name, workers, ms, mbs, (unsigned long)out_len,
+                                   (double)out_len / (in_mb * 1024.0 * 1024.0), peakRssKb());
+                        }
+                        else
+                        {
+                            printf("%s,%lu,%lu,%s,%s,%d,%s,%d,%.3f,%.2f,%lu,%.4f,%lu\n",
+                                   frames[i].name, (unsigned long)frames[i].w, (unsigned long)frames[i].h,
+                                   channels == 4 ? "rgba" : "rgb", s_filters[fi].name, s_levels[li],
+                                   s_strategies[si].name, workers, ms, mbs, (unsigned long)out_len,
+                                   (double)out_len / (in_mb * 1024.0 * 1024.0), peakRssKb());
+                        }
+
+                        first = 0;
+                        fflush(stdout);
+                    }
+                }
+            }
+        }
+    }
+
+    if(json)
+        printf("\n]\n");
+
+    for(i = 0; i < count; ++i)
+    {
+        free(frames[i].rgba);
+        free(frames[i].rgb);
+    }
+
+    pngStripes_quit();
+
+    return 0;
+}
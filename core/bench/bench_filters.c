@@ -0,0 +1,186 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/*
+ * Filter micro-benchmark: the cost of one row for every forward filter of the spng
+ * encoder and for the filter scoring, through the SIMD path picked at runtime
+ * and through the byte-by-byte scalar code. The functions are internal, so the
+ * library source is compiled right here.
+ *
+ * Usage: bench_filters [-r repeats] [-w width]
+ *   -r N        Number of passes over the rows (default 20)
+ *   -w N        Width of the rows in pixels (default 1920)
+ *
+ * The rows are half flat UI-like runs and half noise, made from the fixed seed.
+ */
+
+#include <stdlib.h>
+
+#include "spng.c"
+
+#include "core_sys.h"
+
+#define BENCH_ROWS  64
+
+static const char *s_filterNames[] = {"none", "sub", "up", "avg", "paeth"};
+
+static uint32_t s_seed = 0x5C12EE2u;
+
+static uint32_t rnd(void)
+{
+    s_seed = s_seed * 1103515245u + 12345u;
+    return (s_seed >> 8) & 0xFFFFFF;
+}
+
+static void scalarFilter(uint8_t *out, const uint8_t *prev, const uint8_t *cur, size_t len, unsigned bpp, unsigned filter)
+{
+    size_t i;
+
+    for(i = 0; i < len; ++i)
+        out[i] = filter_byte(prev, cur, i, bpp, filter);
+}
+
+static int32_t scalarSum(const uint8_t *prev, const uint8_t *cur, size_t len, unsigned bpp, unsigned filter)
+{
+    uint32_t sum = 0;
+    uint8_t x;
+    size_t i;
+
+    for(i = 0; i < len; ++i)
+    {
+        x = filter_byte(prev, cur, i, bpp, filter);
+        sum += 128 - abs((int)x - 128);
+    }
+
+    return (int32_t)sum;
+}
+
+/* Nanoseconds per row, the result goes into the checksum so the work can't be thrown away */
+static double timeRows(uint8_t **rows, uint8_t *out, size_t len, unsigned bpp, unsigned filter,
+                       int simd, int score, int repeats, uint32_t *check)
+{
+    uint64_t start, elapsed;
+    int r, y;
+
+    start = coreSys_timeUs();
+
+    for(r = 0; r < repeats; ++r)
+    {
+        for(y = 1; y < BENCH_ROWS; ++y)
+        {
+            if(score)
+                *check += (uint32_t)(simd ? filter_sum(rows[y - 1], rows[y], len, bpp, filter)
+                                          : scalarSum(rows[y - 1], rows[y], len, bpp, filter));
+            else
+            {
+                if(simd)
+                    filter_scanline(out, rows[y - 1], rows[y], len + 1, bpp, filter);
+                else
+                    scalarFilter(out, rows[y - 1], rows[y], len, bpp, filter);
+                *check += out[len / 2];
+            }
+        }
+    }
+
+    elapsed = coreSys_timeUs() - start;
+
+    return (double)elapsed * 1000.0 / ((double)repeats * (BENCH_ROWS - 1));
+}
+
+int main(int argc, char **argv)
+{
+    static const unsigned bpps[] = {3, 4};
+    uint8_t *rows[BENCH_ROWS], *out;
+    unsigned long width = 1920;
+    int i, y, b, score, repeats = 20;
+    unsigned filter;
+    uint32_t check = 0;
+    double scalar, simd;
+    size_t len, x;
+
+    for(i = 1; i < argc; ++i)
+    {
+        if(strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            repeats = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+            width = strtoul(argv[++i], NULL, 10);
+        else
+        {
+            fprintf(stderr, "Usage: bench_filters [-r repeats] [-w width]\n");
+            return 1;
+        }
+    }
+
+    if(repeats < 1)
+        repeats = 1;
+    if(width < 16)
+        width = 16;
+
+    len = (size_t)width * 4;
+    out = (uint8_t *)malloc(len + 1);
+
+    for(y = 0; y < BENCH_ROWS; ++y)
+    {
+        rows[y] = (uint8_t *)malloc(len);
+        if(!rows[y] || !out)
+        {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+
+        for(x = 0; x < len; ++x)
+            rows[y][x] = (uint8_t)(y & 1 ? rnd() : 200 + (x / 97 + y / 8) % 3);
+    }
+
+#ifndef SPNG_DISABLE_OPT
+    fprintf(stderr, "SIMD filters: %s\n", simd_filters_supported() ? "yes" : "no");
+#endif
+    printf("op,filter,bpp,row_bytes,scalar_ns_per_row,simd_ns_per_row,speedup\n");
+
+    for(b = 0; b < (int)(sizeof(bpps) / sizeof(bpps[0])); ++b)
+    {
+        len = (size_t)width * bpps[b];
+
+        for(score = 0; score < 2; ++score)
+        {
+            /* None is only scored, filtering by it is a copy */
+            for(filter = score ? 0 : 1; filter <= 4; ++filter)
+            {
+                scalar = timeRows(rows, out, len, bpps[b], filter, 0, score, repeats, &check);
+                simd = timeRows(rows, out, len, bpps[b], filter, 1, score, repeats, &check);
+
+                printf("%s,%s,%u,%lu,%.0f,%.0f,%.2f\n", score ? "score" : "filter", s_filterNames[filter],
+                       bpps[b], (unsigned long)len, scalar, simd, simd > 0.0 ? scalar / simd : 0.0);
+                fflush(stdout);
+            }
+        }
+    }
+
+    fprintf(stderr, "checksum %lu\n", (unsigned long)check);
+
+    for(y = 0; y < BENCH_ROWS; ++y)
+        free(rows[y]);
+    free(out);
+
+    return 0;
+}
@@ -0,0 +1,385 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/*
+ * FTP upload benchmark: runs the core FTP client against the scripted FTP server at 127.0.0.1,
+ * which delays every reply to stand for the round trip of the real link, and prints CSV.
+ *
+ * Usage: bench_ftp [options]
+ *   -l MS       Delay of every server reply in milliseconds (default 20)
+ *   -n N        Number of the files (default 20)
+ *   -b KB       Size of every file in kilobytes (default 200)
+ *   -k N        The most parallel sessions to try, 1 to 8 (default 4)
+ *
+ * The runs:
+ *   reconnect   Every file by the new session: connect, log in, upload, QUIT, like the sender
+ *               did before the session was kept between the batches
+ *   kept        One session for all the files, checked by NOOP before every file like the
+ *               batch on the kept session is
+ *   noop        The keep-alive NOOP alone
+ *   parallel    The files taken from the shared queue by 1, 2, 4 ... kept sessions at once,
+ *               like the [ftp] connections setting does
+ *   connect     The connection alone until the greeting arrives, without the login
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ftp_client.h"
+#include "ftp_test_server.h"
+#include "core_sys.h"
+
+typedef struct tagBenchFile
+{
+    uint8_t *data;
+    size_t size;
+} BenchFile;
+
+static int sendMemory(void *user, CoreSocket sock, long offset)
+{
+    BenchFile *file = (BenchFile *)user;
+    size_t pos = (size_t)offset, chunk;
+    int sent;
+
+    while(pos < file->size)
+    {
+        chunk = file->size - pos < 65536 ? file->size - pos : 65536;
+        sent = coreNet_send(sock, (const char *)file->data + pos, (int)chunk);
+        if(sent <= 0)
+            return 0;
+        pos += (size_t)sent;
+    }
+
+    return 1;
+}
+
+static int login(FtpClient *client, FtpTestServer *server)
+{
+    if(ftpClient_login(client, "127.0.0.1", server->port, "user", "pass", "/"))
+        return 1;
+
+    fprintf(stderr, "Login has failed at the step %d: %s\n", (int)client->step, client->reply);
+    return 0;
+}
+
+static int upload(FtpClient *client, BenchFile *file, int index)
+{
+    FtpUpload upload;
+    char name[32];
+
+    sprintf(name, "Scr_%04d.png", index);
+
+    memset(&upload, 0, sizeof(upload));
+    upload.name = name;
+    upload.size = (long)file->size;
+    upload.send = &sendMemory;
+    upload.user = file;
+
+    if(ftpClient_store(client, &upload) == STORE_DONE)
+        return 1;
+
+    fprintf(stderr, "Upload has failed at the step %d: %s\n", (int)client->step, client->reply);
+    return 0;
+}
+
+static void printRow(const char *test, FtpTestServer *server, int sessions, int files, size_t fileSize, uint64_t elapsed)
+{
+    double ms = (double)elapsed / 1000.0;
+
+    printf("%s,%lu,%d,%d,%lu,%.1f,%.2f,%.2f,%d\n", test, (unsigned long)server->replyDelay, sessions, files,
+           (unsigned long)(fileSize / 1024), ms, files > 0 ? ms / files : 0.0,
+           ms > 0.0 ? (double)fileSize * files / 1048576.0 / (ms / 1000.0) : 0.0, server->logins);
+}
+
+static int benchReconnect(FtpTestServer *server, BenchFile *file, int files)
+{
+    FtpClient client;
+    uint64_t start;
+    int i;
+
+    server->logins = 0;
+    ftpClient_init(&client);
+    start = coreSys_timeUs();
+
+    for(i = 0; i < files; ++i)
+    {
+        if(!login(&client, server) || !upload(&client, file, i))
+            return 1;
+
+        ftpClient_close(&client, 1);
+    }
+
+    printRow("reconnect", server, 1, files, file->size, coreSys_timeUs() - start);
+
+    return 0;
+}
+
+static int benchKept(FtpTestServer *server, BenchFile *file, int files)
+{
+    FtpClient client;
+    uint64_t start, noop;
+    int i;
+
+    server->logins = 0;
+    ftpClient_init(&client);
+    start = coreSys_timeUs();
+
+    if(!login(&client, server))
+        return 1;
+
+    for(i = 0; i < files; ++i)
+    {
+        if(!ftpClient_isAlive(&client) || !ftpClient_noop(&client))
+        {
+            fprintf(stderr, "The kept session has died\n");
+            return 1;
+        }
+
+        if(!upload(&client, file, i))
+            return 1;
+    }
+
+    printRow("kept", server, 1, files, file->size, coreSys_timeUs() - start);
+
+    start = coreSys_timeUs();
+    for(i = 0; i < files; ++i)
+    {
+        if(!ftpClient_noop(&client))
+            return 1;
+    }
+
+    noop = coreSys_timeUs() - start;
+    printRow("noop", server, 1, files, 0, noop);
+
+    ftpClient_close(&client, 1);
+
+    return 0;
+}
+
+typedef struct tagBenchWorker
+{
+    FtpTestServer *server;
+    BenchFile *file;
+    CoreMutex *mutex;
+    int *next;
+    int files;
+    int failed;
+    CoreThread thread;
+} BenchWorker;
+
+static void workerThread(void *arg)
+{
+    BenchWorker *worker = (BenchWorker *)arg;
+    FtpClient client;
+    int i;
+
+    ftpClient_init(&client);
+
+    if(!login(&client, worker->server))
+    {
+        worker->failed = 1;
+        return;
+    }
+
+    for(;;)
+    {
+        coreMutex_lock(worker->mutex);
+        i = (*worker->next)++;
+        coreMutex_unlock(worker->mutex);
+
+        if(i >= worker->files)
+            break;
+
+        if(!upload(&client, worker->file, i))
+        {
+            worker->failed = 1;
+            break;
+        }
+    }
+
+    ftpClient_close(&client, 1);
+}
+
+static int benchParallel(FtpTestServer *server, BenchFile *file, int files, int sessions)
+{
+    BenchWorker workers[8];
+    CoreMutex mutex;
+    uint64_t start;
+    int i, next = 0, failed = 0;
+
+    coreMutex_init(&mutex);
+    server->logins = 0;
+    start = coreSys_timeUs();
+
+    for(i = 0; i < sessions; ++i)
+    {
+        memset(&workers[i], 0, sizeof(BenchWorker));
+        workers[i].server = server;
+        workers[i].file = file;
+        workers[i].mutex = &mutex;
+        workers[i].next = &next;
+        workers[i].files = files;
+
+        if(!coreThread_start(&workers[i].thread, &workerThread, &workers[i]))
+            workers[i].failed = 1;
+    }
+
+    for(i = 0; i < sessions; ++i)
+    {
+        coreThread_join(&workers[i].thread);
+        failed |= workers[i].failed;
+    }
+
+    coreMutex_destroy(&mutex);
+
+    if(failed)
+        return 1;
+
+    printRow("parallel", server, sessions, files, file->size, coreSys_timeUs() - start);
+
+    return 0;
+}
+
+static int benchConnect(FtpTestServer *server, int count)
+{
+    struct sockaddr_in addr;
+    CoreSocket sock;
+    uint64_t start;
+    int i;
+
+    if(!ftpClient_resolve("127.0.0.1", server->port, &addr))
+        return 1;
+
+    server->logins = 0;
+    start = coreSys_timeUs();
+
+    for(i = 0; i < count; ++i)
+    {
+        sock = ftpClient_connect(&addr, 0, 1000);
+        if(sock == CORE_INVALID_SOCKET)
+        {
+            fprintf(stderr, "Can't connect the local FTP server: %d\n", coreNet_lastError());
+            return 1;
+        }
+
+        /* Otherwise the queue of the server fills up faster than it accepts */
+        if(coreNet_waitReadable(sock, 1000) != 1)
+        {
+            fprintf(stderr, "No greeting from the local FTP server\n");
+            coreNet_close(sock);
+            return 1;
+        }
+
+        coreNet_close(sock);
+    }
+
+    printRow("connect", server, 1, count, 0, coreSys_timeUs() - start);
+
+    return 0;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: bench_ftp [-l delay_ms] [-n files] [-b file_kb] [-k sessions]\n");
+}
+
+int main(int argc, char **argv)
+{
+    FtpTestServer server;
+    BenchFile file;
+    int i, files = 20, delay = 20, fileKb = 200, sessions = 4, ret = 0;
+    unsigned long seed = 1;
+
+    for(i = 1; i < argc; ++i)
+    {
+        if(strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+            delay = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            files = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+            fileKb = atoi(argv[++i]);
+        else if(strcmp(argv[i], "-k") == 0 && i + 1 < argc)
+            sessions = atoi(argv[++i]);
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    if(delay < 0 || files < 1 || fileKb < 0 || sessions < 1 || sessions > 8)
+    {
+        usage();
+        return 1;
+    }
+
+    file.size = (size_t)fileKb * 1024;
+    file.data = (uint8_t *)malloc(file.size + 1);
+    if(!file.data)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    for(i = 0; i < (int)file.size; ++i)
+    {
+        seed = seed * 1103515245UL + 12345UL;
+        file.data[i] = (uint8_t)(seed >> 16);
+    }
+
+    if(coreNet_init() != 0)
+    {
+        fprintf(stderr, "Can't start the sockets\n");
+        return 1;
+    }
+
+    ftpClient_initResolver();
+
+    ftpTestServer_init(&server);
+    server.replyDelay = (uint32_t)delay;
+    if(!ftpTestServer_start(&server))
+    {
+        fprintf(stderr, "Can't start the local FTP server\n");
+        return 1;
+    }
+
+    printf("test,delay_ms,sessions,files,file_kb,total_ms,ms_per_file,mb_per_s,logins\n");
+
+    ret = benchReconnect(&server, &file, files);
+    if(ret == 0)
+        ret = benchKept(&server, &file, files);
+
+    for(i = 1; ret == 0 && i <= sessions; i *= 2)
+        ret = benchParallel(&server, &file, files, i);
+
+    if(ret == 0)
+        ret = benchConnect(&server, files);
+
+    ftpTestServer_stop(&server);
+    ftpClient_quitResolver();
+    coreNet_quit();
+    free(file.data);
+
+    return ret;
+}
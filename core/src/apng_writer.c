@@ -0,0 +1,276 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "apng_writer.h"
+#include "png_stripes.h"
+
+#include "miniz.h"
+#include "spng.h"
+
+/* APNG_DISPOSE_OP_NONE and APNG_BLEND_OP_SOURCE */
+#define APNG_DISPOSE_NONE   0
+#define APNG_BLEND_SOURCE   0
+
+static const uint8_t s_pngSignature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+
+static void putU32(uint8_t *out, uint32_t value)
+{
+    out[0] = (uint8_t)(value >> 24);
+    out[1] = (uint8_t)(value >> 16);
+    out[2] = (uint8_t)(value >> 8);
+    out[3] = (uint8_t)value;
+}
+
+static void putU16(uint8_t *out, uint32_t value)
+{
+    out[0] = (uint8_t)(value >> 8);
+    out[1] = (uint8_t)value;
+}
+
+static uint32_t getU32(const uint8_t *in)
+{
+    return ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | in[3];
+}
+
+/* The chunk data is given by two parts, the second one may be empty */
+static int writeChunk(FILE *f, const char *type, const uint8_t *d1, size_t l1, const uint8_t *d2, size_t l2)
+{
+    uint8_t head[8];
+    uint8_t tail[4];
+    mz_ulong crc;
+
+    putU32(head, (uint32_t)(l1 + l2));
+    memcpy(head + 4, type, 4);
+
+    crc = mz_crc32(MZ_CRC32_INIT, head + 4, 4);
+    if(l1)
+        crc = mz_crc32(crc, d1, l1);
+    if(l2)
+        crc = mz_crc32(crc, d2, l2);
+
+    putU32(tail, (uint32_t)crc);
+
+    if(fwrite(head, 1, 8, f) != 8 ||
+       (l1 && fwrite(d1, 1, l1, f) != l1) ||
+       (l2 && fwrite(d2, 1, l2, f) != l2) ||
+       fwrite(tail, 1, 4, f) != 4)
+        return SPNG_IO_ERROR;
+
+    return 0;
+}
+
+/* Write the chunk again at the place where it was written before */
+static int rewriteChunk(FILE *f, long pos, const char *type, const uint8_t *data, size_t len)
+{
+    int ret;
+
+    if(fseek(f, pos, SEEK_SET) != 0)
+        return SPNG_IO_ERROR;
+
+    ret = writeChunk(f, type, data, len, NULL, 0);
+
+    if(fseek(f, 0, SEEK_END) != 0 && !ret)
+        ret = SPNG_IO_ERROR;
+
+    return ret;
+}
+
+static void putActl(uint8_t *out, uint32_t frames)
+{
+    putU32(out, frames);
+    putU32(out + 4, 0); /* Play forever */
+}
+
+int apngWriter_open(ApngWriter *a, const char *path, uint32_t w, uint32_t h)
+{
+    uint8_t ihdr[13];
+    uint8_t actl[8];
+    int ret;
+
+    memset(a, 0, sizeof(ApngWriter));
+
+    if(!w || !h)
+        return SPNG_EINVAL;
+
+    a->f = fopen(path, "wb");
+    if(!a->f)
+        return SPNG_IO_ERROR;
+
+    a->w = w;
+    a->h = h;
+
+    putU32(ihdr, w);
+    putU32(ihdr + 4, h);
+    ihdr[8] = 8; /* Bit depth */
+    ihdr[9] = SPNG_COLOR_TYPE_TRUECOLOR;
+    ihdr[10] = 0; /* Compression method */
+    ihdr[11] = 0; /* Filter method */
+    ihdr[12] = 0; /* Interlace method */
+
+    if(fwrite(s_pngSignature, 1, 8, a->f) != 8)
+        ret = SPNG_IO_ERROR;
+    else
+        ret = writeChunk(a->f, "IHDR", ihdr, 13, NULL, 0);
+
+    /* The number of frames gets set by apngWriter_close() */
+    a->actlPos = ftell(a->f);
+    putActl(actl, 0);
+
+    if(!ret)
+        ret = writeChunk(a->f, "acTL", actl, 8, NULL, 0);
+
+    if(ret)
+    {
+        fclose(a->f);
+        a->f = NULL;
+    }
+
+    return ret;
+}
+
+static void setFctlDelay(uint8_t *fctl, uint32_t delayMs)
+{
+    if(delayMs > APNG_MAX_DELAY)
+        delayMs = APNG_MAX_DELAY;
+
+    putU16(fctl + 20, delayMs);
+    putU16(fctl + 22, 1000);
+}
+
+int apngWriter_addFrame(ApngWriter *a, const uint8_t *png, size_t pngLen, const FrameDeltaRect *rect,
+                        uint32_t timeMs, uint32_t delayMs)
+{
+    const uint8_t *chunk, *end = png + pngLen;
+    uint8_t seq[4];
+    uint32_t len;
+    int ret;
+
+    if(!a->f || pngLen < 8 || memcmp(png, s_pngSignature, 8) != 0)
+        return SPNG_EINVAL;
+
+    if(rect->x + rect->w > a->w || rect->y + rect->h > a->h || !rect->w || !rect->h)
+        return SPNG_EINVAL;
+
+    /* The default image is the first frame, it must be the whole canvas */
+    if(a->frames == 0 && (rect->x || rect->y || rect->w != a->w || rect->h != a->h))
+        return SPNG_EINVAL;
+
+    if(a->frames > 0)
+    {
+        setFctlDelay(a->fctl, timeMs - a->lastTime);
+        ret = rewriteChunk(a->f, a->fctlPos, "fcTL", a->fctl, 26);
+        if(ret)
+            return ret;
+    }
+
+    putU32(a->fctl, a->seq++);
+    putU32(a->fctl + 4, rect->w);
+    putU32(a->fctl + 8, rect->h);
+    putU32(a->fctl + 12, rect->x);
+    putU32(a->fctl + 16, rect->y);
+    setFctlDelay(a->fctl, delayMs);
+    a->fctl[24] = APNG_DISPOSE_NONE;
+    a->fctl[25] = APNG_BLEND_SOURCE;
+
+    a->fctlPos = ftell(a->f);
+    ret = writeChunk(a->f, "fcTL", a->fctl, 26, NULL, 0);
+    if(ret)
+        return ret;
+
+    for(chunk = png + 8; chunk + 12 <= end; chunk += 12 + len)
+    {
+        len = getU32(chunk);
+        if(len > (size_t)(end - chunk) - 12)
+            return SPNG_EINVAL;
+
+        if(memcmp(chunk + 4, "IHDR", 4) == 0)
+        {
+            /* Only the 8-bit RGB frames of the right size fit the canvas */
+            if(len != 13 || getU32(chunk + 8) != rect->w || getU32(chunk + 12) != rect->h ||
+               chunk[16] != 8 || chunk[17] != SPNG_COLOR_TYPE_TRUECOLOR || chunk[20] != 0)
+                return SPNG_EINVAL;
+        }
+        else if(memcmp(chunk + 4, "IDAT", 4) == 0)
+        {
+            if(a->frames == 0)
+                ret = writeChunk(a->f, "IDAT", chunk + 8, len, NULL, 0);
+            else
+            {
+                putU32(seq, a->seq++);
+                ret = writeChunk(a->f, "fdAT", seq, 4, chunk + 8, len);
+            }
+
+            if(ret)
+                return ret;
+        }
+    }
+
+    a->frames++;
+    a->lastTime = timeMs;
+
+    return 0;
+}
+
+int apngWriter_encodeFrame(ApngWriter *a, const uint8_t *pixels, uint32_t pitch, const FrameDeltaRect *rect,
+                           int workers, const PngPreset *preset, uint32_t timeMs, uint32_t delayMs)
+{
+    uint8_t *png = NULL;
+    size_t pngLen = 0;
+    int ret;
+
+    ret = pngStripes_encodeToBuffer(&png, &pngLen, pixels + (size_t)rect->y * pitch + (size_t)rect->x * 3,
+                                    rect->w, rect->h, pitch, 3, workers, preset);
+    if(!ret)
+        ret = apngWriter_addFrame(a, png, pngLen, rect, timeMs, delayMs);
+
+    if(png)
+        free(png);
+
+    return ret;
+}
+
+int apngWriter_close(ApngWriter *a)
+{
+    uint8_t actl[8];
+    int ret;
+
+    if(!a->f)
+        return SPNG_EINVAL;
+
+    ret = writeChunk(a->f, "IEND", NULL, 0, NULL, 0);
+
+    putActl(actl, a->frames);
+    if(!ret)
+        ret = rewriteChunk(a->f, a->actlPos, "acTL", actl, 8);
+
+    if(fclose(a->f) != 0 && !ret)
+        ret = SPNG_IO_ERROR;
+
+    a->f = NULL;
+
+    return ret;
+}
@@ -0,0 +1,115 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef APNG_WRITER_H
+#define APNG_WRITER_H
+
+/*
+ * Writes the sequence of RGB frames into one animated PNG file. The first
+ * frame covers the whole canvas and is the default image seen by the viewers
+ * without the APNG support. The next frames may cover only the changed part
+ * of the canvas: they are drawn over the previous frame (dispose op NONE)
+ * and replace its pixels (blend op SOURCE).
+ *
+ * The frames are compressed by the usual PNG encoder, their IDAT data gets
+ * moved into the fdAT chunks. The number of frames and the delay of every
+ * frame are not known in advance, so they get patched into the file later,
+ * the file must be seekable.
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "frame_delta.h"
+#include "png_preset.h"
+
+/* Longest delay of a frame in milliseconds, the fcTL chunk has 16 bits for it */
+#define APNG_MAX_DELAY  65535
+
+struct ApngWriter
+{
+    FILE *f;
+    /* Size of the canvas */
+    uint32_t w;
+    uint32_t h;
+    uint32_t frames;
+    /* Sequence number of the next fcTL or fdAT chunk */
+    uint32_t seq;
+    /* Positions of the acTL chunk and of the fcTL chunk of the latest frame */
+    long actlPos;
+    long fctlPos;
+    /* Contents of the latest fcTL chunk, its delay gets set by the next frame */
+    uint8_t fctl[26];
+    /* Time of the latest frame in milliseconds */
+    uint32_t lastTime;
+};
+
+typedef struct ApngWriter ApngWriter;
+
+/**
+ * @brief Create the file and write the header of the animation
+ * @param a Writer
+ * @param path Path of the file
+ * @param w Width of the canvas
+ * @param h Height of the canvas
+ * @return 0 on success, or SPNG error code
+ */
+int apngWriter_open(ApngWriter *a, const char *path, uint32_t w, uint32_t h);
+
+/**
+ * @brief Add the frame that is already encoded as PNG
+ * @param a Writer
+ * @param png PNG file of the 8-bit RGB image of rect->w x rect->h, made by spng or png_stripes
+ * @param pngLen Size of the PNG file
+ * @param rect Part of the canvas covered by the frame, the first frame must cover the whole canvas
+ * @param timeMs Time of the frame in milliseconds, it sets the delay of the previous frame
+ * @param delayMs Delay of this frame until the next one comes
+ * @return 0 on success, or SPNG error code
+ */
+int apngWriter_addFrame(ApngWriter *a, const uint8_t *png, size_t pngLen, const FrameDeltaRect *rect,
+                        uint32_t timeMs, uint32_t delayMs);
+
+/**
+ * @brief Encode the part of the RGB frame and add it
+ * @param a Writer
+ * @param pixels Pixels of the whole canvas
+ * @param pitch Length of the canvas row in bytes
+ * @param rect Part of the canvas to encode
+ * @param workers Number of the encoding workers, see pngStripes_workersCount()
+ * @param preset Compression preset
+ * @param timeMs Time of the frame in milliseconds
+ * @param delayMs Delay of this frame until the next one comes
+ * @return 0 on success, or SPNG error code
+ */
+int apngWriter_encodeFrame(ApngWriter *a, const uint8_t *pixels, uint32_t pitch, const FrameDeltaRect *rect,
+                           int workers, const PngPreset *preset, uint32_t timeMs, uint32_t delayMs);
+
+/**
+ * @brief Finish and close the file, the file without frames is invalid and should be removed
+ * @return 0 on success, or SPNG error code
+ */
+int apngWriter_close(ApngWriter *a);
+
+#endif /* APNG_WRITER_H */
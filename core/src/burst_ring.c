@@ -0,0 +1,185 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "burst_ring.h"
+
+void burstRing_init(BurstRing *ring)
+{
+    memset(ring, 0, sizeof(BurstRing));
+    coreMutex_init(&ring->mutex);
+}
+
+/* Must be called with the locked mutex */
+static void freeSlots(BurstRing *ring)
+{
+    int i;
+
+    for(i = 0; i < BURST_RING_MAX_SLOTS; ++i)
+    {
+        if(ring->slots[i].data)
+            free(ring->slots[i].data);
+    }
+
+    memset(ring->slots, 0, sizeof(ring->slots));
+    ring->count = 0;
+    ring->next = 0;
+}
+
+void burstRing_free(BurstRing *ring)
+{
+    coreMutex_lock(&ring->mutex);
+    freeSlots(ring);
+    ring->active = 0;
+    coreMutex_unlock(&ring->mutex);
+
+    coreMutex_destroy(&ring->mutex);
+}
+
+int burstRing_begin(BurstRing *ring, int slots, size_t size)
+{
+    int i;
+
+    if(slots < 1)
+        slots = 1;
+    if(slots > BURST_RING_MAX_SLOTS)
+        slots = BURST_RING_MAX_SLOTS;
+
+    coreMutex_lock(&ring->mutex);
+
+    for(i = 0; i < ring->count; ++i)
+    {
+        if(ring->slots[i].busy)
+        {
+            coreMutex_unlock(&ring->mutex);
+            return BURST_RING_FULL;
+        }
+    }
+
+    freeSlots(ring);
+
+    for(i = 0; i < slots; ++i)
+    {
+        ring->slots[i].data = (uint8_t *)malloc(size);
+        if(!ring->slots[i].data)
+        {
+            freeSlots(ring);
+            coreMutex_unlock(&ring->mutex);
+            return BURST_RING_NOMEM;
+        }
+        ring->slots[i].size = size;
+    }
+
+    ring->count = slots;
+    ring->active = 1;
+
+    coreMutex_unlock(&ring->mutex);
+
+    return BURST_RING_OK;
+}
+
+int burstRing_acquire(BurstRing *ring, uint8_t **out, size_t size)
+{
+    int i, slot;
+
+    *out = NULL;
+
+    coreMutex_lock(&ring->mutex);
+
+    /* The ring is walked in order, the busy slots are passed by as the savers may finish out of order */
+    for(i = 0; i < ring->count && ring->active; ++i)
+    {
+        slot = (ring->next + i) % ring->count;
+
+        if(!ring->slots[slot].busy && ring->slots[slot].size >= size)
+        {
+            ring->slots[slot].busy = 1;
+            ring->next = (slot + 1) % ring->count;
+            ring->taken++;
+            *out = ring->slots[slot].data;
+            coreMutex_unlock(&ring->mutex);
+            return BURST_RING_OK;
+        }
+    }
+
+    ring->drops++;
+    coreMutex_unlock(&ring->mutex);
+
+    return BURST_RING_FULL;
+}
+
+int burstRing_release(BurstRing *ring, uint8_t *buf)
+{
+    int i;
+
+    if(!buf)
+        return 0;
+
+    coreMutex_lock(&ring->mutex);
+
+    for(i = 0; i < ring->count; ++i)
+    {
+        if(ring->slots[i].data == buf)
+        {
+            ring->slots[i].busy = 0;
+
+            /* The burst is over, the ring isn't needed anymore */
+            if(!ring->active)
+            {
+                free(ring->slots[i].data);
+                ring->slots[i].data = NULL;
+                ring->slots[i].size = 0;
+            }
+
+            coreMutex_unlock(&ring->mutex);
+            return 1;
+        }
+    }
+
+    coreMutex_unlock(&ring->mutex);
+
+    return 0;
+}
+
+void burstRing_end(BurstRing *ring)
+{
+    int i;
+
+    coreMutex_lock(&ring->mutex);
+
+    ring->active = 0;
+
+    for(i = 0; i < ring->count; ++i)
+    {
+        if(ring->slots[i].data && !ring->slots[i].busy)
+        {
+            free(ring->slots[i].data);
+            ring->slots[i].data = NULL;
+            ring->slots[i].size = 0;
+        }
+    }
+
+    coreMutex_unlock(&ring->mutex);
+}
@@ -0,0 +1,106 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef BURST_RING_H
+#define BURST_RING_H
+
+/*
+ * Ring of the frame buffers for the burst capture: all memory is allocated at
+ * the burst start, the capture only takes the next free buffer, and the frame
+ * is dropped when every buffer is still waiting for the saver.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core_sys.h"
+
+/* Maximum number of the ring slots */
+#define BURST_RING_MAX_SLOTS    32
+
+enum BurstRingResult
+{
+    BURST_RING_OK = 0,
+    /* All buffers are busy, or the buffers of the previous burst are still being saved */
+    BURST_RING_FULL,
+    /* Failed to allocate memory */
+    BURST_RING_NOMEM
+};
+
+typedef struct tagBurstRingSlot
+{
+    uint8_t *data;
+    size_t size;
+    int busy;
+} BurstRingSlot;
+
+typedef struct tagBurstRing
+{
+    BurstRingSlot slots[BURST_RING_MAX_SLOTS];
+    int count;
+    /* Slot to try first on the next acquire */
+    int next;
+    /* Between burstRing_begin() and burstRing_end() */
+    int active;
+    /* Buffers given to the capture and frames refused, counted over all bursts */
+    unsigned long taken;
+    unsigned long drops;
+    CoreMutex mutex;
+} BurstRing;
+
+void burstRing_init(BurstRing *ring);
+
+/**
+ * @brief Free all buffers, none of them should be in use
+ */
+void burstRing_free(BurstRing *ring);
+
+/**
+ * @brief Allocate the buffers of the new burst
+ * @param slots Number of buffers, up to BURST_RING_MAX_SLOTS
+ * @param size Size of every buffer in bytes
+ * @return BURST_RING_OK on success, BURST_RING_FULL if buffers of the previous burst are still busy,
+ *         or BURST_RING_NOMEM
+ */
+int burstRing_begin(BurstRing *ring, int slots, size_t size);
+
+/**
+ * @brief Take the next free buffer, it stays busy until burstRing_release()
+ * @param out Pointer to the buffer
+ * @param size Required size of the buffer in bytes
+ * @return BURST_RING_OK on success, or BURST_RING_FULL if the frame should be dropped
+ */
+int burstRing_acquire(BurstRing *ring, uint8_t **out, size_t size);
+
+/**
+ * @brief Return the buffer, the buffer of the ended burst gets freed, can be called from any thread
+ * @return 1 if the buffer belongs to the ring, 0 if it came from somewhere else
+ */
+int burstRing_release(BurstRing *ring, uint8_t *buf);
+
+/**
+ * @brief Stop giving the buffers, the free ones get freed now and the busy ones on their release
+ */
+void burstRing_end(BurstRing *ring);
+
+#endif /* BURST_RING_H */
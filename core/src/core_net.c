@@ -0,0 +1,285 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#   define _POSIX_C_SOURCE 200112L /* gethostbyname() and select() in the strict C90 mode */
+#endif
+
+#include <string.h>
+
+#include "core_net.h"
+
+#ifndef _WIN32
+#   include <errno.h>
+#   include <fcntl.h>
+#   include <netdb.h>
+#   include <netinet/tcp.h>
+#   include <unistd.h>
+#   include <arpa/inet.h>
+#   include <sys/select.h>
+#   include <sys/time.h>
+#endif
+
+
+#ifdef _WIN32
+
+int coreNet_init(void)
+{
+    WSADATA w_data;
+
+    return WSAStartup(MAKEWORD(2, 2), &w_data);
+}
+
+void coreNet_quit(void)
+{
+    WSACleanup();
+}
+
+int coreNet_lastError(void)
+{
+    return WSAGetLastError();
+}
+
+static void setLastError(int error)
+{
+    WSASetLastError(error);
+}
+
+static int isInProgress(int error)
+{
+    return error == WSAEWOULDBLOCK || error == WSAEINPROGRESS;
+}
+
+static void setNonBlocking(CoreSocket sock, int nonBlocking)
+{
+    u_long value = (u_long)nonBlocking;
+    ioctlsocket(sock, FIONBIO, &value);
+}
+
+#   define CORE_NET_TIMEDOUT    WSAETIMEDOUT
+#   define CORE_NET_SOCKLEN     int
+
+#else /* _WIN32 */
+
+int coreNet_init(void)
+{
+    return 0;
+}
+
+void coreNet_quit(void)
+{
+}
+
+int coreNet_lastError(void)
+{
+    return errno;
+}
+
+static void setLastError(int error)
+{
+    errno = error;
+}
+
+static int isInProgress(int error)
+{
+    return error == EINPROGRESS || error == EWOULDBLOCK || error == EAGAIN;
+}
+
+static void setNonBlocking(CoreSocket sock, int nonBlocking)
+{
+    int flags = fcntl(sock, F_GETFL, 0);
+
+    if(flags < 0)
+        return;
+
+    fcntl(sock, F_SETFL, nonBlocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK));
+}
+
+#   define closesocket          close
+#   define CORE_NET_TIMEDOUT    ETIMEDOUT
+#   define CORE_NET_SOCKLEN     socklen_t
+
+#endif /* _WIN32 */
+
+
+int coreNet_resolve(const char *host, uint16_t port, struct sockaddr_in *addr)
+{
+    struct hostent *hostEntry;
+    unsigned long ip;
+
+    memset(addr, 0, sizeof(struct sockaddr_in));
+    addr->sin_family = AF_INET;
+    addr->sin_port = htons(port);
+
+    ip = inet_addr(host);
+    if(ip != INADDR_NONE)
+    {
+        addr->sin_addr.s_addr = ip;
+        return 1;
+    }
+
+    hostEntry = gethostbyname(host);
+    if(!hostEntry || hostEntry->h_addrtype != AF_INET || !hostEntry->h_addr_list[0])
+        return 0;
+
+    memcpy(&addr->sin_addr, hostEntry->h_addr_list[0], sizeof(addr->sin_addr));
+
+    return 1;
+}
+
+CoreSocket coreNet_connect(const struct sockaddr_in *addr, int sendBuffer, uint32_t timeout, int *timedOut)
+{
+    CoreSocket sock;
+    fd_set writeSet, errorSet;
+    struct timeval tv;
+    int res, error = 0;
+    CORE_NET_SOCKLEN errorLen = sizeof(error);
+
+    *timedOut = 0;
+
+    sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if(sock == CORE_INVALID_SOCKET)
+        return CORE_INVALID_SOCKET;
+
+    /* The buffer size has to be known before the connection is made */
+    if(sendBuffer > 0)
+        setsockopt(sock, SOL_SOCKET, SO_SNDBUF, (const char *)&sendBuffer, sizeof(sendBuffer));
+
+    setNonBlocking(sock, 1);
+
+    res = connect(sock, (const struct sockaddr *)addr, sizeof(struct sockaddr_in));
+    if(res != 0)
+    {
+        error = coreNet_lastError();
+
+        if(isInProgress(error))
+        {
+            error = 0;
+            FD_ZERO(&writeSet);
+            FD_SET(sock, &writeSet);
+            FD_ZERO(&errorSet);
+            FD_SET(sock, &errorSet);
+            tv.tv_sec = timeout / 1000;
+            tv.tv_usec = (timeout % 1000) * 1000;
+
+            /* WinSock reports the failed connection by the error set, the first argument is ignored there */
+            res = select((int)sock + 1, NULL, &writeSet, &errorSet, &tv);
+            if(res == 0)
+            {
+                error = CORE_NET_TIMEDOUT;
+                *timedOut = 1;
+            }
+            else if(res < 0)
+                error = coreNet_lastError();
+            else if(getsockopt(sock, SOL_SOCKET, SO_ERROR, (char *)&error, &errorLen) != 0)
+                error = coreNet_lastError();
+        }
+    }
+
+    if(error != 0)
+    {
+        closesocket(sock);
+        setLastError(error);
+        return CORE_INVALID_SOCKET;
+    }
+
+    setNonBlocking(sock, 0);
+
+    return sock;
+}
+
+int coreNet_waitReadable(CoreSocket sock, uint32_t timeout)
+{
+    fd_set readSet;
+    struct timeval tv;
+    int res;
+
+    FD_ZERO(&readSet);
+    FD_SET(sock, &readSet);
+    tv.tv_sec = timeout / 1000;
+    tv.tv_usec = (timeout % 1000) * 1000;
+
+    res = select((int)sock + 1, &readSet, NULL, NULL, &tv);
+
+    return res < 0 ? -1 : res > 0;
+}
+
+int coreNet_send(CoreSocket sock, const char *data, int size)
+{
+#ifdef MSG_NOSIGNAL
+    return (int)send(sock, data, size, MSG_NOSIGNAL);
+#else
+    return (int)send(sock, data, size, 0);
+#endif
+}
+
+int coreNet_recv(CoreSocket sock, char *buf, int size)
+{
+    return (int)recv(sock, buf, size, 0);
+}
+
+void coreNet_close(CoreSocket sock)
+{
+    if(sock != CORE_INVALID_SOCKET)
+        closesocket(sock);
+}
+
+void coreNet_setNoDelay(CoreSocket sock)
+{
+    int on = 1;
+
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (const char *)&on, sizeof(on));
+}
+
+CoreSocket coreNet_listenLocal(uint16_t *port, int backlog)
+{
+    CoreSocket sock;
+    struct sockaddr_in addr;
+    CORE_NET_SOCKLEN addrLen = sizeof(addr);
+
+    sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if(sock == CORE_INVALID_SOCKET)
+        return CORE_INVALID_SOCKET;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    addr.sin_port = 0;
+
+    if(bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+       listen(sock, backlog) != 0 ||
+       getsockname(sock, (struct sockaddr *)&addr, &addrLen) != 0)
+    {
+        closesocket(sock);
+        return CORE_INVALID_SOCKET;
+    }
+
+    *port = ntohs(addr.sin_port);
+
+    return sock;
+}
+
+CoreSocket coreNet_accept(CoreSocket listener)
+{
+    return accept(listener, NULL, NULL);
+}
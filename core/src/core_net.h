@@ -0,0 +1,123 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CORE_NET_H
+#define CORE_NET_H
+
+/*
+ * TCP sockets of the FTP client, WinSock 1.1 on Windows (including 9x)
+ * and BSD sockets elsewhere. Only IPv4, like the rest of the sender.
+ */
+
+#include <stdint.h>
+
+#ifdef _WIN32
+#   include <windows.h>
+#   include <winsock.h>
+typedef SOCKET CoreSocket;
+#   define CORE_INVALID_SOCKET  INVALID_SOCKET
+#else
+#   include <sys/types.h>
+#   include <sys/socket.h>
+#   include <netinet/in.h>
+typedef int CoreSocket;
+#   define CORE_INVALID_SOCKET  (-1)
+#endif
+
+/**
+ * @brief Start the socket library for the calling thread, WinSock wants it in every thread
+ * @return 0 on success, or the error code
+ */
+int coreNet_init(void);
+
+/**
+ * @brief Release the socket library, once per the successful coreNet_init()
+ */
+void coreNet_quit(void);
+
+/**
+ * @brief Code of the last socket error of the calling thread: WSAGetLastError() or errno
+ */
+int coreNet_lastError(void);
+
+/**
+ * @brief Get the IPv4 address of the host
+ * @param host IP address or the host name, the name gets asked from the DNS
+ * @param port Port to put into the address
+ * @param addr Receives the address
+ * @return 1 on success, 0 if the name can't be resolved
+ */
+int coreNet_resolve(const char *host, uint16_t port, struct sockaddr_in *addr);
+
+/**
+ * @brief Connect the new socket without stalling for longer than the timeout
+ * @param addr Address to connect
+ * @param sendBuffer Size of the send buffer to set before the connection, 0 to keep the system one
+ * @param timeout Timeout in milliseconds
+ * @param timedOut Set to 1 when the host didn't answer at all, 0 when it has refused or connected
+ * @return Connected blocking socket, or CORE_INVALID_SOCKET with the error in coreNet_lastError()
+ */
+CoreSocket coreNet_connect(const struct sockaddr_in *addr, int sendBuffer, uint32_t timeout, int *timedOut);
+
+/**
+ * @brief Wait until the socket has the data to read, or gets closed by the other side
+ * @param timeout Timeout in milliseconds, 0 to only check
+ * @return 1 when readable, 0 on timeout, -1 on error
+ */
+int coreNet_waitReadable(CoreSocket sock, uint32_t timeout);
+
+/**
+ * @brief Send the data like send(), the broken connection returns the error without the SIGPIPE
+ * @return Number of bytes sent, or -1 on error
+ */
+int coreNet_send(CoreSocket sock, const char *data, int size);
+
+/**
+ * @brief Receive the data like recv()
+ * @return Number of bytes received, 0 when the connection is closed, or -1 on error
+ */
+int coreNet_recv(CoreSocket sock, char *buf, int size);
+
+void coreNet_close(CoreSocket sock);
+
+/**
+ * @brief Send the small writes at once instead of waiting for the ACK of the previous ones,
+ * for the command-reply connections
+ */
+void coreNet_setNoDelay(CoreSocket sock);
+
+/**
+ * @brief Open the listening socket at the random port of 127.0.0.1, used by the local test servers
+ * @param port Receives the port
+ * @param backlog Length of the queue of the connections not yet accepted
+ * @return Listening socket, or CORE_INVALID_SOCKET on error
+ */
+CoreSocket coreNet_listenLocal(uint16_t *port, int backlog);
+
+/**
+ * @brief Accept the connection of the listening socket
+ * @return Connected socket, or CORE_INVALID_SOCKET on error
+ */
+CoreSocket coreNet_accept(CoreSocket listener);
+
+#endif /* CORE_NET_H */
@@ -0,0 +1,314 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#   define _POSIX_C_SOURCE 200112L /* clock_gettime() in the strict C90 mode */
+#endif
+
+#include <ctype.h>
+#include <string.h>
+
+#ifndef _WIN32
+#   include <errno.h>
+#   include <unistd.h>
+#   include <time.h>
+#endif
+
+#include "core_sys.h"
+
+
+#ifdef _WIN32
+
+static DWORD WINAPI coreThread_entry(LPVOID lpParameter)
+{
+    CoreThread *thread = (CoreThread *)lpParameter;
+    thread->func(thread->arg);
+    return 0;
+}
+
+int coreThread_start(CoreThread *thread, CoreThreadFunc func, void *arg)
+{
+    thread->func = func;
+    thread->arg = arg;
+    thread->handle = CreateThread(NULL, 0, &coreThread_entry, thread, 0, NULL);
+
+    return thread->handle != NULL;
+}
+
+void coreThread_join(CoreThread *thread)
+{
+    if(!thread->handle)
+        return;
+
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+    thread->handle = NULL;
+}
+
+void coreMutex_init(CoreMutex *mutex)
+{
+    InitializeCriticalSection(&mutex->handle);
+    mutex->created = 1;
+}
+
+void coreMutex_destroy(CoreMutex *mutex)
+{
+    if(mutex->created)
+    {
+        DeleteCriticalSection(&mutex->handle);
+        mutex->created = 0;
+    }
+}
+
+void coreMutex_lock(CoreMutex *mutex)
+{
+    if(mutex->created)
+        EnterCriticalSection(&mutex->handle);
+}
+
+void coreMutex_unlock(CoreMutex *mutex)
+{
+    if(mutex->created)
+        LeaveCriticalSection(&mutex->handle);
+}
+
+int coreSemaphore_init(CoreSemaphore *sem, unsigned long count)
+{
+    sem->handle = CreateSemaphoreA(NULL, (LONG)count, 0x7FFFFFFF, NULL);
+
+    return sem->handle != NULL;
+}
+
+void coreSemaphore_destroy(CoreSemaphore *sem)
+{
+    if(sem->handle)
+    {
+        CloseHandle(sem->handle);
+        sem->handle = NULL;
+    }
+}
+
+void coreSemaphore_post(CoreSemaphore *sem, unsigned long count)
+{
+    if(sem->handle && count > 0)
+        ReleaseSemaphore(sem->handle, (LONG)count, NULL);
+}
+
+void coreSemaphore_wait(CoreSemaphore *sem)
+{
+    if(sem->handle)
+        WaitForSingleObject(sem->handle, INFINITE);
+}
+
+int coreSys_cpuCount(void)
+{
+    SYSTEM_INFO sysInfo;
+
+    GetSystemInfo(&sysInfo);
+
+    return sysInfo.dwNumberOfProcessors > 0 ? (int)sysInfo.dwNumberOfProcessors : 1;
+}
+
+unsigned long coreSys_threadId(void)
+{
+    return (unsigned long)GetCurrentThreadId();
+}
+
+uint64_t coreSys_timeUs(void)
+{
+    static LARGE_INTEGER s_freq;
+    LARGE_INTEGER now;
+
+    if(s_freq.QuadPart == 0 && !QueryPerformanceFrequency(&s_freq))
+        s_freq.QuadPart = -1;
+
+    /* No high-resolution counter on some ancient machines */
+    if(s_freq.QuadPart < 0 || !QueryPerformanceCounter(&now))
+        return (uint64_t)GetTickCount() * 1000;
+
+    return (uint64_t)(now.QuadPart / s_freq.QuadPart) * 1000000 +
+           (uint64_t)(now.QuadPart % s_freq.QuadPart) * 1000000 / s_freq.QuadPart;
+}
+
+void coreSys_sleep(uint32_t ms)
+{
+    Sleep(ms);
+}
+
+#else /* _WIN32 */
+
+static void *coreThread_entry(void *arg)
+{
+    CoreThread *thread = (CoreThread *)arg;
+    thread->func(thread->arg);
+    return NULL;
+}
+
+int coreThread_start(CoreThread *thread, CoreThreadFunc func, void *arg)
+{
+    thread->func = func;
+    thread->arg = arg;
+    thread->started = pthread_create(&thread->handle, NULL, &coreThread_entry, thread) == 0;
+
+    return thread->started;
+}
+
+void coreThread_join(CoreThread *thread)
+{
+    if(!thread->started)
+        return;
+
+    pthread_join(thread->handle, NULL);
+    thread->started = 0;
+}
+
+void coreMutex_init(CoreMutex *mutex)
+{
+    mutex->created = pthread_mutex_init(&mutex->handle, NULL) == 0;
+}
+
+void coreMutex_destroy(CoreMutex *mutex)
+{
+    if(mutex->created)
+    {
+        pthread_mutex_destroy(&mutex->handle);
+        mutex->created = 0;
+    }
+}
+
+void coreMutex_lock(CoreMutex *mutex)
+{
+    if(mutex->created)
+        pthread_mutex_lock(&mutex->handle);
+}
+
+void coreMutex_unlock(CoreMutex *mutex)
+{
+    if(mutex->created)
+        pthread_mutex_unlock(&mutex->handle);
+}
+
+int coreSemaphore_init(CoreSemaphore *sem, unsigned long count)
+{
+    sem->count = count;
+    sem->created = 0;
+
+    if(pthread_mutex_init(&sem->mutex, NULL) != 0)
+        return 0;
+
+    if(pthread_cond_init(&sem->cond, NULL) != 0)
+    {
+        pthread_mutex_destroy(&sem->mutex);
+        return 0;
+    }
+
+    sem->created = 1;
+
+    return 1;
+}
+
+void coreSemaphore_destroy(CoreSemaphore *sem)
+{
+    if(sem->created)
+    {
+        pthread_cond_destroy(&sem->cond);
+        pthread_mutex_destroy(&sem->mutex);
+        sem->created = 0;
+    }
+}
+
+void coreSemaphore_post(CoreSemaphore *sem, unsigned long count)
+{
+    if(!sem->created || count == 0)
+        return;
+
+    pthread_mutex_lock(&sem->mutex);
+    sem->count += count;
+    if(count > 1)
+        pthread_cond_broadcast(&sem->cond);
+    else
+        pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->mutex);
+}
+
+void coreSemaphore_wait(CoreSemaphore *sem)
+{
+    if(!sem->created)
+        return;
+
+    pthread_mutex_lock(&sem->mutex);
+    while(sem->count == 0)
+        pthread_cond_wait(&sem->cond, &sem->mutex);
+    sem->count--;
+    pthread_mutex_unlock(&sem->mutex);
+}
+
+int coreSys_cpuCount(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return count > 0 ? (int)count : 1;
+}
+
+unsigned long coreSys_threadId(void)
+{
+    return (unsigned long)pthread_self();
+}
+
+uint64_t coreSys_timeUs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+}
+
+void coreSys_sleep(uint32_t ms)
+{
+    struct timespec left;
+
+    left.tv_sec = ms / 1000;
+    left.tv_nsec = (long)(ms % 1000) * 1000000;
+
+    /* Continue after the signals */
+    while(nanosleep(&left, &left) != 0 && errno == EINTR)
+        ;
+}
+
+#endif /* _WIN32 */
+
+int coreSys_strcasecmp(const char *a, const char *b)
+{
+    int ca, cb;
+
+    do
+    {
+        ca = tolower((unsigned char)*a++);
+        cb = tolower((unsigned char)*b++);
+    }
+    while(ca && ca == cb);
+
+    return ca - cb;
+}
@@ -0,0 +1,145 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef CORE_SYS_H
+#define CORE_SYS_H
+
+/*
+ * The minimal set of the system services needed by the capture pipeline,
+ * implemented by WinAPI on Windows (including 9x) and by POSIX elsewhere.
+ */
+
+#include <stdint.h>
+
+#ifdef _WIN32
+#   include <windows.h>
+#   define CORE_PATH_SEP   '\\'
+#else
+#   include <pthread.h>
+#   define CORE_PATH_SEP   '/'
+#endif
+
+typedef void (*CoreThreadFunc)(void *arg);
+
+typedef struct tagCoreThread
+{
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    pthread_t handle;
+    int started;
+#endif
+    CoreThreadFunc func;
+    void *arg;
+} CoreThread;
+
+/* Process-local lock, cheap when it's free: the critical section on Windows */
+typedef struct tagCoreMutex
+{
+#ifdef _WIN32
+    CRITICAL_SECTION handle;
+    int created;
+#else
+    pthread_mutex_t handle;
+    int created;
+#endif
+} CoreMutex;
+
+/* Counting semaphore, the threads wait on it for the work */
+typedef struct tagCoreSemaphore
+{
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    unsigned long count;
+    int created;
+#endif
+} CoreSemaphore;
+
+/**
+ * @brief Start the thread
+ * @param thread Thread object, must stay alive until coreThread_join()
+ * @param func Thread function
+ * @param arg Argument of the thread function
+ * @return 1 on success, 0 if the thread can't be started
+ */
+int coreThread_start(CoreThread *thread, CoreThreadFunc func, void *arg);
+
+/**
+ * @brief Wait for the thread to finish and release it, does nothing for the thread that wasn't started
+ */
+void coreThread_join(CoreThread *thread);
+
+void coreMutex_init(CoreMutex *mutex);
+void coreMutex_destroy(CoreMutex *mutex);
+void coreMutex_lock(CoreMutex *mutex);
+void coreMutex_unlock(CoreMutex *mutex);
+
+/**
+ * @brief Create the semaphore
+ * @param sem Semaphore object
+ * @param count Initial count
+ * @return 1 on success, 0 if the semaphore can't be created
+ */
+int coreSemaphore_init(CoreSemaphore *sem, unsigned long count);
+void coreSemaphore_destroy(CoreSemaphore *sem);
+
+/**
+ * @brief Increase the count, waking up to that number of the waiting threads
+ */
+void coreSemaphore_post(CoreSemaphore *sem, unsigned long count);
+
+/**
+ * @brief Wait until the count is above zero and decrease it
+ */
+void coreSemaphore_wait(CoreSemaphore *sem);
+
+/**
+ * @brief Monotonic time in microseconds, counted from an unspecified moment
+ */
+uint64_t coreSys_timeUs(void);
+
+/**
+ * @brief Suspend the calling thread for the given number of milliseconds
+ */
+void coreSys_sleep(uint32_t ms);
+
+/**
+ * @brief Identifier of the calling thread, only used to tell the threads apart in the logs
+ */
+unsigned long coreSys_threadId(void);
+
+/**
+ * @brief Number of the CPU cores, at least 1
+ */
+int coreSys_cpuCount(void);
+
+/**
+ * @brief Case-insensitive comparison of ASCII strings
+ */
+int coreSys_strcasecmp(const char *a, const char *b);
+
+#endif /* CORE_SYS_H */
@@ -0,0 +1,185 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "frame_delta.h"
+
+void frameDelta_init(FrameDelta *d)
+{
+    memset(d, 0, sizeof(FrameDelta));
+}
+
+void frameDelta_free(FrameDelta *d)
+{
+    if(d->ref)
+        free(d->ref);
+
+    memset(d, 0, sizeof(FrameDelta));
+}
+
+void frameDelta_reset(FrameDelta *d)
+{
+    /* The buffer stays for the next key frame of the same size */
+    d->sinceKey = 0;
+    d->w = 0;
+    d->h = 0;
+}
+
+static int takeKeyFrame(FrameDelta *d, const uint8_t *pixels, uint32_t w, uint32_t h, uint32_t bpp)
+{
+    size_t size = (size_t)w * h * bpp;
+
+    if(!d->ref || (size_t)d->w * d->h * d->bpp != size)
+    {
+        if(d->ref)
+            free(d->ref);
+
+        d->ref = (uint8_t *)malloc(size);
+    }
+
+    if(d->ref)
+    {
+        memcpy(d->ref, pixels, size);
+        d->w = w;
+        d->h = h;
+        d->bpp = bpp;
+    }
+    else
+        d->w = d->h = 0; /* Out of memory, all frames are saved whole */
+
+    d->sinceKey = 0;
+
+    return 1;
+}
+
+int frameDelta_compare(FrameDelta *d, const uint8_t *pixels, uint32_t w, uint32_t h, uint32_t bpp,
+                       uint32_t tile, uint32_t keyInterval, FrameDeltaRect *rect)
+{
+    uint32_t tilesX, tx, ty, x0, y0, y, tw, th, pitch, y_end;
+    uint32_t minX = 0xFFFFFFFF, minY = 0xFFFFFFFF, maxX = 0, maxY = 0;
+    const uint8_t *cur, *old;
+    int changed;
+
+    rect->x = 0;
+    rect->y = 0;
+    rect->w = w;
+    rect->h = h;
+    d->unchanged = 0;
+
+    if(!d->ref || d->w != w || d->h != h || d->bpp != bpp || (keyInterval > 0 && d->sinceKey + 1 >= keyInterval))
+        return takeKeyFrame(d, pixels, w, h, bpp);
+
+    if(tile < FRAME_DELTA_MIN_TILE)
+        tile = FRAME_DELTA_MIN_TILE;
+    if(tile > FRAME_DELTA_MAX_TILE)
+        tile = FRAME_DELTA_MAX_TILE;
+
+    pitch = w * bpp;
+    tilesX = (w + tile - 1) / tile;
+
+    for(ty = 0, y0 = 0; y0 < h; ++ty, y0 += tile)
+    {
+        th = h - y0 < tile ? h - y0 : tile;
+
+        for(tx = 0; tx < tilesX; ++tx)
+        {
+            x0 = tx * tile;
+            tw = w - x0 < tile ? w - x0 : tile;
+
+            /* The tiles inside of the already found box don't change it */
+            if(tx >= minX && tx <= maxX && ty >= minY && ty <= maxY)
+                continue;
+
+            cur = pixels + (size_t)y0 * pitch + (size_t)x0 * bpp;
+            old = d->ref + (size_t)y0 * pitch + (size_t)x0 * bpp;
+            changed = 0;
+
+            for(y = 0; y < th && !changed; ++y)
+                changed = memcmp(cur + (size_t)y * pitch, old + (size_t)y * pitch, (size_t)tw * bpp) != 0;
+
+            if(!changed)
+                continue;
+
+            if(tx < minX)
+                minX = tx;
+            if(tx > maxX)
+                maxX = tx;
+            if(ty < minY)
+                minY = ty;
+            if(ty > maxY)
+                maxY = ty;
+        }
+    }
+
+    d->sinceKey++;
+
+    /* Nothing has changed, the single pixel keeps the shot in the sequence */
+    if(minX == 0xFFFFFFFF)
+    {
+        rect->w = 1;
+        rect->h = 1;
+        d->unchanged = 1;
+        return 0;
+    }
+
+    rect->x = minX * tile;
+    rect->y = minY * tile;
+    rect->w = (maxX + 1) * tile > w ? w - rect->x : (maxX + 1 - minX) * tile;
+    rect->h = (maxY + 1) * tile > h ? h - rect->y : (maxY + 1 - minY) * tile;
+
+    /* Outside of the box the reference is already equal to the frame */
+    y_end = rect->y + rect->h;
+    for(y = rect->y; y < y_end; ++y)
+        memcpy(d->ref + (size_t)y * pitch + (size_t)rect->x * bpp,
+               pixels + (size_t)y * pitch + (size_t)rect->x * bpp, (size_t)rect->w * bpp);
+
+    return 0;
+}
+
+void frameDelta_crop(uint8_t *pixels, uint32_t pitch, uint32_t bpp, const FrameDeltaRect *rect)
+{
+    size_t rowLen = (size_t)rect->w * bpp;
+    uint32_t y;
+
+    /* Every row moves to the lower address, so the rows that are still needed never get overwritten */
+    for(y = 0; y < rect->h; ++y)
+        memmove(pixels + y * rowLen, pixels + (size_t)(rect->y + y) * pitch + (size_t)rect->x * bpp, rowLen);
+}
+
+void frameDelta_paste(uint8_t *frame, uint32_t w, uint32_t h, uint32_t bpp,
+                      const uint8_t *part, const FrameDeltaRect *rect)
+{
+    uint32_t y, cw, ch;
+
+    if(rect->x >= w || rect->y >= h)
+        return;
+
+    cw = rect->x + rect->w > w ? w - rect->x : rect->w;
+    ch = rect->y + rect->h > h ? h - rect->y : rect->h;
+
+    for(y = 0; y < ch; ++y)
+        memcpy(frame + ((size_t)(rect->y + y) * w + rect->x) * bpp, part + (size_t)y * rect->w * bpp, (size_t)cw * bpp);
+}
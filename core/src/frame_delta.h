@@ -0,0 +1,115 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef FRAME_DELTA_H
+#define FRAME_DELTA_H
+
+/*
+ * Delta capture: the frame is compared with the previous one by square tiles,
+ * and only the bounding box of the changed tiles gets saved. The saved delta
+ * is the PNG of that box with the oFFs chunk for its position, and with the
+ * FRAME_DELTA_KEYWORD text chunk that names the file of the previous shot.
+ * Every keyInterval shots, or when the screen size changes, the whole frame
+ * is saved as the key frame without these chunks.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Keyword of the PNG text chunk that has the file name of the previous shot */
+#define FRAME_DELTA_KEYWORD     "TinyShot-Delta"
+
+#define FRAME_DELTA_MIN_TILE    8
+#define FRAME_DELTA_MAX_TILE    1024
+
+struct FrameDeltaRect
+{
+    uint32_t x;
+    uint32_t y;
+    uint32_t w;
+    uint32_t h;
+};
+
+typedef struct FrameDeltaRect FrameDeltaRect;
+
+struct FrameDelta
+{
+    /* Copy of the previous frame, NULL until the first frame */
+    uint8_t *ref;
+    uint32_t w;
+    uint32_t h;
+    uint32_t bpp;
+    /* Number of the deltas since the last key frame */
+    uint32_t sinceKey;
+    /* The latest compared frame was equal to the previous one */
+    int unchanged;
+};
+
+typedef struct FrameDelta FrameDelta;
+
+void frameDelta_init(FrameDelta *d);
+void frameDelta_free(FrameDelta *d);
+
+/**
+ * @brief Forget the previous frame, so the next one becomes the key frame
+ */
+void frameDelta_reset(FrameDelta *d);
+
+/**
+ * @brief Compare the frame with the previous one and remember it for the next comparison
+ * @param d Delta state
+ * @param pixels Packed pixels of the frame, the row length is w * bpp
+ * @param w Width of the frame
+ * @param h Height of the frame
+ * @param bpp Bytes per pixel
+ * @param tile Size of the square tile in pixels
+ * @param keyInterval Make every this number of frames the key frame, 0 to make only the first one
+ * @param rect Receives the changed part of the frame, at least 1x1 even when nothing has changed
+ * @return 1 if the frame should be saved whole as the key frame, 0 if the rect part is enough
+ */
+int frameDelta_compare(FrameDelta *d, const uint8_t *pixels, uint32_t w, uint32_t h, uint32_t bpp,
+                       uint32_t tile, uint32_t keyInterval, FrameDeltaRect *rect);
+
+/**
+ * @brief Move the rows of the rect to the start of the buffer, so they make the packed image of rect->w x rect->h
+ * @param pixels Frame pixels, the data outside of the rect gets overwritten
+ * @param pitch Row length of the frame in bytes
+ * @param bpp Bytes per pixel
+ * @param rect Part to keep
+ */
+void frameDelta_crop(uint8_t *pixels, uint32_t pitch, uint32_t bpp, const FrameDeltaRect *rect);
+
+/**
+ * @brief Put the saved part back onto the frame, the part outside of the frame gets clipped
+ * @param frame Frame pixels
+ * @param w Width of the frame
+ * @param h Height of the frame
+ * @param bpp Bytes per pixel of both images
+ * @param part Packed pixels of the part, rect->w x rect->h
+ * @param rect Position and size of the part
+ */
+void frameDelta_paste(uint8_t *frame, uint32_t w, uint32_t h, uint32_t bpp,
+                      const uint8_t *part, const FrameDeltaRect *rect);
+
+#endif /* FRAME_DELTA_H */
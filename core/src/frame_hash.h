@@ -0,0 +1,46 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef FRAME_HASH_H
+#define FRAME_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Compute the 64-bit hash of the pixel data to find the identical frames
+ *
+ * This is XXH64 written in the portable C90 without SIMD, so it runs on any
+ * x86 down to the Pentium, it hashes the 1080p frame in a few milliseconds.
+ * The data is read in the byte order of the machine, so the value is equal
+ * to the reference XXH64 on the little-endian machines only.
+ *
+ * @param data Data to hash
+ * @param len Length of the data in bytes
+ * @param seed Seed, different seeds give unrelated hashes of the same data
+ * @return Hash value
+ */
+uint64_t frameHash_compute(const void *data, size_t len, uint64_t seed);
+
+#endif /* FRAME_HASH_H */
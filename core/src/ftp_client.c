@@ -0,0 +1,442 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "ftp_client.h"
+#include "core_sys.h"
+#include "shot_trace.h"
+
+
+/* How long the resolved address is trusted, in microseconds */
+#define FTP_RESOLVE_TTL         300000000
+/* Connect timeout of the new clients in milliseconds */
+#define FTP_CONNECT_TIMEOUT     5000
+
+static FtpLogFunc s_log = NULL;
+
+static char s_resolvedHost[120];
+static struct sockaddr_in s_resolvedAddr;
+static uint64_t s_resolvedAt = 0;
+static int s_resolved = 0;
+static CoreMutex s_resolveMutex;
+
+
+void ftpClient_setLog(FtpLogFunc log)
+{
+    s_log = log;
+}
+
+void ftpClient_initResolver(void)
+{
+    s_resolved = 0;
+    coreMutex_init(&s_resolveMutex);
+}
+
+void ftpClient_quitResolver(void)
+{
+    coreMutex_destroy(&s_resolveMutex);
+}
+
+int ftpClient_resolve(const char *host, uint16_t port, struct sockaddr_in *addr)
+{
+    const unsigned char *ip;
+    int ret = 1;
+
+    /* Parallel connections wait for the first one to resolve the name, and take its result */
+    coreMutex_lock(&s_resolveMutex);
+
+    if(s_resolved && strcmp(s_resolvedHost, host) == 0 && coreSys_timeUs() - s_resolvedAt < FTP_RESOLVE_TTL)
+    {
+        *addr = s_resolvedAddr;
+        addr->sin_port = htons(port);
+    }
+    else
+    {
+        s_resolved = 0;
+
+        if(coreNet_resolve(host, port, addr))
+        {
+            s_resolvedAddr = *addr;
+            s_resolvedHost[0] = '\0';
+            strncat(s_resolvedHost, host, sizeof(s_resolvedHost) - 1);
+            s_resolvedAt = coreSys_timeUs();
+            s_resolved = 1;
+
+            ip = (const unsigned char *)&addr->sin_addr;
+            if(s_log)
+                s_log("--FTP Resolved %s as %u.%u.%u.%u\n", host, ip[0], ip[1], ip[2], ip[3]);
+        }
+        else
+            ret = 0;
+    }
+
+    coreMutex_unlock(&s_resolveMutex);
+
+    return ret;
+}
+
+void ftpClient_forget(void)
+{
+    coreMutex_lock(&s_resolveMutex);
+    s_resolved = 0;
+    coreMutex_unlock(&s_resolveMutex);
+}
+
+/* Threads that have failed together shouldn't knock at the server at the same moment again */
+static uint32_t jitter(uint32_t range)
+{
+    uint32_t x = (uint32_t)coreSys_timeUs() ^ (uint32_t)(coreSys_threadId() * 2654435761UL);
+
+    x ^= x >> 15;
+    x *= 0x2C1B3C6DUL;
+    x ^= x >> 12;
+
+    return x % range;
+}
+
+CoreSocket ftpClient_connect(const struct sockaddr_in *addr, int sendBuffer, uint32_t timeout)
+{
+    CoreSocket sock;
+    uint32_t pause;
+    int i, timedOut, error;
+
+    for(i = 0; ; ++i)
+    {
+        sock = coreNet_connect(addr, sendBuffer, timeout, &timedOut);
+
+        /* The host that doesn't answer at all has already taken its time */
+        if(sock != CORE_INVALID_SOCKET || timedOut || i + 1 >= FTP_CONNECT_TRIES)
+            return sock;
+
+        error = coreNet_lastError();
+        pause = (FTP_CONNECT_BACKOFF << i) + jitter(FTP_CONNECT_BACKOFF);
+        if(s_log)
+            s_log("--FTP Connection to port %u failed: %d, retry in %lu ms\n",
+                  ntohs(addr->sin_port), error, (unsigned long)pause);
+        coreSys_sleep(pause);
+    }
+}
+
+static int clientRecv(void *user, char *buf, int size)
+{
+    return coreNet_recv(((FtpClient *)user)->ctrl, buf, size);
+}
+
+void ftpClient_init(FtpClient *client)
+{
+    memset(client, 0, sizeof(FtpClient));
+    client->ctrl = CORE_INVALID_SOCKET;
+    client->connectTimeout = FTP_CONNECT_TIMEOUT;
+}
+
+static int readReply(FtpClient *client, const char *what)
+{
+    client->replyCode = ftpProto_readReply(&client->reader, client->reply, sizeof(client->reply));
+
+    if(client->replyCode < 0)
+        client->error = coreNet_lastError();
+    else if(s_log)
+        s_log("--FTP [%u] %s: %s\n", (unsigned)client->index, what, client->reply);
+
+    return client->replyCode;
+}
+
+int ftpClient_command(FtpClient *client, const char *cmd, const char *data)
+{
+    char outBuffer[FTP_REPLY_SIZE];
+
+    outBuffer[0] = '\0';
+    strncat(outBuffer, cmd, sizeof(outBuffer) - 3);
+    if(data)
+    {
+        strncat(outBuffer, " ", sizeof(outBuffer) - 3 - strlen(outBuffer));
+        strncat(outBuffer, data, sizeof(outBuffer) - 3 - strlen(outBuffer));
+    }
+    strcat(outBuffer, "\r\n");
+
+    client->reply[0] = '\0';
+
+    if(coreNet_send(client->ctrl, outBuffer, (int)strlen(outBuffer)) < 0)
+    {
+        client->error = coreNet_lastError();
+        client->replyCode = -1;
+        return -1;
+    }
+
+    return readReply(client, cmd);
+}
+
+static void resetStep(FtpClient *client)
+{
+    client->step = FTP_STEP_NONE;
+    client->replyCode = 0;
+    client->error = 0;
+    client->reply[0] = '\0';
+}
+
+static int loginFailed(FtpClient *client, FtpClientStep step)
+{
+    client->step = step;
+    ftpClient_close(client, 0);
+    return 0;
+}
+
+int ftpClient_login(FtpClient *client, const char *host, uint16_t port,
+                    const char *user, const char *password, const char *dir)
+{
+    int reply;
+
+    ftpClient_close(client, 0);
+    resetStep(client);
+
+    if(!ftpClient_resolve(host, port, &client->addr))
+    {
+        client->error = coreNet_lastError();
+        return loginFailed(client, FTP_STEP_RESOLVE);
+    }
+
+    client->ctrl = ftpClient_connect(&client->addr, 0, client->connectTimeout);
+    if(client->ctrl == CORE_INVALID_SOCKET)
+    {
+        client->error = coreNet_lastError();
+        /* The server could move to another address */
+        ftpClient_forget();
+        return loginFailed(client, FTP_STEP_CONNECT);
+    }
+
+    shotTrace_point(TRACE_FTP_CONNECT, 0, client->index);
+    ftpProto_initReader(&client->reader, &clientRecv, client);
+
+    /* 220 (vsFTPd 3.0.5) */
+    if(readReply(client, "Greeting") != 220)
+        return loginFailed(client, FTP_STEP_GREETING);
+
+    if(user[0] != '\0')
+    {
+        reply = ftpClient_command(client, "USER", user);
+        /* 331 Please specify the password, or 230 when the password is not required */
+        if(reply != 331 && reply != 230)
+            return loginFailed(client, FTP_STEP_USER);
+
+        /* 230 Login successful. */
+        if(reply == 331 && password[0] != '\0' && ftpClient_command(client, "PASS", password) != 230)
+            return loginFailed(client, FTP_STEP_PASS);
+    }
+    else if(ftpClient_command(client, "USER", "anonymouse") < 0)
+        return loginFailed(client, FTP_STEP_USER);
+
+    /* 250 Directory successfully changed. */
+    if(ftpClient_command(client, "CWD", dir) != 250)
+        return loginFailed(client, FTP_STEP_CWD);
+
+    /* 200 Switching to Binary mode. */
+    if(ftpClient_command(client, "TYPE", "I") != 200)
+        return loginFailed(client, FTP_STEP_TYPE);
+
+    client->loggedIn = 1;
+
+    return 1;
+}
+
+int ftpClient_isAlive(FtpClient *client)
+{
+    if(client->ctrl == CORE_INVALID_SOCKET)
+        return 0;
+
+    /* Nothing is expected from the server between the commands, anything readable means 421 or the close */
+    return coreNet_waitReadable(client->ctrl, 0) == 0 && client->reader.len == 0;
+}
+
+int ftpClient_noop(FtpClient *client)
+{
+    return ftpClient_command(client, "NOOP", NULL) == 200;
+}
+
+void ftpClient_close(FtpClient *client, int sayQuit)
+{
+    if(client->ctrl != CORE_INVALID_SOCKET)
+    {
+        if(sayQuit && client->loggedIn && ftpClient_isAlive(client))
+            ftpClient_command(client, "QUIT", NULL);
+
+        coreNet_close(client->ctrl);
+        client->ctrl = CORE_INVALID_SOCKET;
+    }
+
+    client->loggedIn = 0;
+    client->reader.len = 0;
+}
+
+uint16_t ftpClient_passive(FtpClient *client)
+{
+    uint16_t port;
+    int reply, ok;
+
+    if(!client->noEpsv)
+    {
+        reply = ftpClient_command(client, "EPSV", NULL);
+        if(reply < 0)
+        {
+            client->step = FTP_STEP_PASSIVE;
+            return 0;
+        }
+
+        if(reply == 229)
+        {
+            port = ftpProto_parseExtPassivePort(client->reply, &ok);
+            if(ok)
+                return port;
+        }
+
+        /* Old server, don't ask it again */
+        client->noEpsv = 1;
+    }
+
+    /* 227 Entering Passive Mode (172,16,9,141,39,22). */
+    reply = ftpClient_command(client, "PASV", NULL);
+    if(reply != 227)
+    {
+        client->step = FTP_STEP_PASSIVE;
+        return 0;
+    }
+
+    port = ftpProto_parsePassivePort(client->reply, &ok);
+    if(!ok)
+    {
+        /* Corrupted reply, the code stays 227 */
+        client->step = FTP_STEP_PASSIVE;
+        return 0;
+    }
+
+    return port;
+}
+
+long ftpClient_remoteSize(FtpClient *client, const char *name)
+{
+    /* 213 12345 */
+    if(ftpClient_command(client, "SIZE", name) != 213)
+        return -1;
+
+    return ftpProto_parseSize(client->reply);
+}
+
+static int storeFailed(FtpClient *client, CoreSocket data, FtpClientStep step, int result)
+{
+    client->step = step;
+    coreNet_close(data);
+    return result;
+}
+
+int ftpClient_store(FtpClient *client, FtpUpload *upload)
+{
+    struct sockaddr_in dataAddr;
+    CoreSocket data;
+    uint16_t port;
+    long offset = 0;
+    char restPos[25];
+    int reply;
+
+    resetStep(client);
+    upload->offset = 0;
+
+    if(upload->resume)
+    {
+        offset = ftpClient_remoteSize(client, upload->name);
+
+        if(offset >= 0 && offset == upload->size)
+        {
+            /* Only the 226 reply was lost */
+            if(s_log)
+                s_log("--FTP File %s is already uploaded\n", upload->name);
+            shotTrace_point(TRACE_FTP_DONE, upload->trace, (uint32_t)upload->size);
+            upload->offset = offset;
+            return STORE_DONE;
+        }
+
+        if(offset < 0 || offset > upload->size)
+            offset = 0;
+    }
+
+    port = ftpClient_passive(client);
+    if(!port)
+        return STORE_FAILED;
+
+    /* The address in the PASV reply is often wrong behind NAT, the data goes to the same host as the control */
+    dataAddr = client->addr;
+    dataAddr.sin_port = htons(port);
+
+    data = ftpClient_connect(&dataAddr, client->sendBuffer, client->connectTimeout);
+    if(data == CORE_INVALID_SOCKET)
+    {
+        client->error = coreNet_lastError();
+        client->step = FTP_STEP_DATA_CONNECT;
+        return STORE_FAILED;
+    }
+
+    if(offset > 0)
+    {
+        sprintf(restPos, "%ld", offset);
+        reply = ftpClient_command(client, "REST", restPos);
+        if(reply < 0)
+            return storeFailed(client, data, FTP_STEP_REST, STORE_FAILED);
+
+        /* 350 Restart position accepted (12345). */
+        if(reply != 350)
+            offset = 0;
+    }
+
+    reply = ftpClient_command(client, "STOR", upload->name);
+    if(reply < 0)
+        return storeFailed(client, data, FTP_STEP_STOR, STORE_FAILED);
+
+    shotTrace_point(TRACE_FTP_STOR, upload->trace, (uint32_t)offset);
+
+    /* 150 Ok to send data. */
+    if(reply != 150 && reply != 125)
+        return storeFailed(client, data, FTP_STEP_STOR, reply >= 500 ? STORE_REJECTED : STORE_FAILED);
+
+    upload->offset = offset;
+
+    if(!upload->send(upload->user, data, offset))
+    {
+        client->error = coreNet_lastError();
+        return storeFailed(client, data, FTP_STEP_SEND, STORE_FAILED);
+    }
+
+    /* Closing of the data connection marks the end of file */
+    coreNet_close(data);
+
+    /* 226 Transfer complete. */
+    reply = readReply(client, "Transfer");
+    if(reply != 226 && reply != 250)
+    {
+        client->step = FTP_STEP_RESULT;
+        return reply >= 500 ? STORE_REJECTED : STORE_FAILED;
+    }
+
+    shotTrace_point(TRACE_FTP_DONE, upload->trace, (uint32_t)upload->size);
+
+    return STORE_DONE;
+}
@@ -0,0 +1,212 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef FTP_CLIENT_H
+#define FTP_CLIENT_H
+
+/*
+ * The FTP upload client: the logged-in control session, the passive data
+ * connection per file, and the resume of the interrupted uploads. Doesn't
+ * know the settings and doesn't show anything, the failed step and the
+ * reply of the server are left in the client for the caller to report.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core_net.h"
+#include "ftp_proto.h"
+
+/* Number of the attempts to connect when the server refuses the connection */
+#define FTP_CONNECT_TRIES       3
+/* The first pause between the attempts in milliseconds, it doubles every time */
+#define FTP_CONNECT_BACKOFF     250
+
+/* The step of the session that has failed */
+typedef enum FtpClientStep
+{
+    FTP_STEP_NONE = 0,
+    FTP_STEP_RESOLVE,
+    FTP_STEP_CONNECT,
+    FTP_STEP_GREETING,
+    FTP_STEP_USER,
+    FTP_STEP_PASS,
+    FTP_STEP_CWD,
+    FTP_STEP_TYPE,
+    FTP_STEP_PASSIVE,
+    FTP_STEP_DATA_CONNECT,
+    FTP_STEP_REST,
+    FTP_STEP_STOR,
+    FTP_STEP_SEND,
+    FTP_STEP_RESULT
+} FtpClientStep;
+
+/* Result of the file upload */
+enum FtpStoreResult
+{
+    STORE_FAILED = 0,
+    STORE_DONE,
+    /* Server refused the file itself, the retry won't help */
+    STORE_REJECTED
+};
+
+/* Prints the debug message, takes the printf() arguments */
+typedef void (*FtpLogFunc)(const char *format, ...);
+
+/* Sends the file into the connected data socket starting from the offset, returns 1 on success */
+typedef int (*FtpSendFunc)(void *user, CoreSocket sock, long offset);
+
+typedef struct tagFtpClient
+{
+    /* Control connection, CORE_INVALID_SOCKET while not connected */
+    CoreSocket ctrl;
+    /* Address of the server, also used for the passive data connections */
+    struct sockaddr_in addr;
+    int loggedIn;
+    /* Server doesn't understand EPSV, use PASV only */
+    int noEpsv;
+    /* Connect timeout of both the control and the data connections, in milliseconds */
+    uint32_t connectTimeout;
+    /* Send buffer of the data connections, 0 keeps the system one */
+    int sendBuffer;
+    /* Number of the connection, marks its trace points */
+    uint32_t index;
+    /* The step that has failed, and the reply of the server to it: the code, or -1 if the connection is broken */
+    FtpClientStep step;
+    int replyCode;
+    /* Socket error of the failed step */
+    int error;
+    char reply[FTP_REPLY_SIZE];
+    FtpReplyReader reader;
+} FtpClient;
+
+typedef struct tagFtpUpload
+{
+    /* Name of the file at the server */
+    const char *name;
+    /* Size of the local file */
+    long size;
+    /* The previous attempt has failed, continue from the size the server already has */
+    int resume;
+    /* Number of the shot in the trace, 0 for the files not made by this run */
+    uint32_t trace;
+    FtpSendFunc send;
+    void *user;
+    /* Receives the position the data was sent from */
+    long offset;
+} FtpUpload;
+
+/**
+ * @brief Set the function printing the commands and the replies, NULL to keep quiet
+ */
+void ftpClient_setLog(FtpLogFunc log);
+
+/**
+ * @brief Prepare the cache of the resolved host names, must be called before the sessions start
+ */
+void ftpClient_initResolver(void);
+void ftpClient_quitResolver(void);
+
+/**
+ * @brief Get the address of the FTP server, the host names are resolved once and kept for a while
+ * @return 1 on success, 0 if the host name can't be resolved
+ */
+int ftpClient_resolve(const char *host, uint16_t port, struct sockaddr_in *addr);
+
+/**
+ * @brief Drop the resolved address, so the next connection asks the DNS again
+ */
+void ftpClient_forget(void);
+
+/**
+ * @brief Connect the socket within the timeout, the refused connection gets
+ * a couple of retries after the short random pauses
+ * @param addr Address to connect
+ * @param sendBuffer Size of the send buffer, 0 to keep the system one
+ * @param timeout Timeout of every attempt in milliseconds
+ * @return Connected blocking socket, or CORE_INVALID_SOCKET with the error in coreNet_lastError()
+ */
+CoreSocket ftpClient_connect(const struct sockaddr_in *addr, int sendBuffer, uint32_t timeout);
+
+/**
+ * @brief Set up the client that isn't connected, with the default timeout of 5 seconds
+ */
+void ftpClient_init(FtpClient *client);
+
+/**
+ * @brief Connect to the server and log in: USER, PASS, CWD and TYPE I
+ * @param user User name, the empty one logs in as anonymous
+ * @param password Password, can be empty
+ * @param dir Directory to store the files at
+ * @return 1 on success, 0 on failure with the connection closed and the step set
+ */
+int ftpClient_login(FtpClient *client, const char *host, uint16_t port,
+                    const char *user, const char *password, const char *dir);
+
+/**
+ * @brief Send the command and wait for the reply, the text of the reply goes to the client->reply
+ * @param data Argument of the command, can be NULL
+ * @return The reply code, 0 if the reply is corrupted, or -1 if the connection is broken
+ */
+int ftpClient_command(FtpClient *client, const char *cmd, const char *data);
+
+/**
+ * @brief Check that the kept connection wasn't closed by the server, without waiting
+ */
+int ftpClient_isAlive(FtpClient *client);
+
+/**
+ * @brief Send the NOOP to keep the session, or to check it before the batch
+ * @return 1 if the server has answered 200
+ */
+int ftpClient_noop(FtpClient *client);
+
+/**
+ * @brief Close the control connection
+ * @param sayQuit Politely say goodbye to the server if the connection is still fine
+ */
+void ftpClient_close(FtpClient *client, int sayQuit);
+
+/**
+ * @brief Ask the server for the new data port: EPSV when supported, PASV otherwise
+ * @return The port, or 0 on failure
+ */
+uint16_t ftpClient_passive(FtpClient *client);
+
+/**
+ * @brief Ask the server how much of the file it already has
+ * @return The size, or -1 when it doesn't know
+ */
+long ftpClient_remoteSize(FtpClient *client, const char *name);
+
+/**
+ * @brief Upload one file: get the fresh data port, STOR, wait for 150, send the
+ * data, close the data connection and wait for 226. Every reply is read in its
+ * turn, so nothing piles up on the control connection.
+ * The file that has failed before is continued from the size the server
+ * already has by the REST command, when the server supports it.
+ * @return One of the FtpStoreResult, on failure the step and the reply are set
+ */
+int ftpClient_store(FtpClient *client, FtpUpload *upload);
+
+#endif /* FTP_CLIENT_H */
@@ -0,0 +1,195 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ftp_proto.h"
+
+
+void ftpProto_initReader(FtpReplyReader *reader, FtpRecvFunc receive, void *user)
+{
+    reader->len = 0;
+    reader->receive = receive;
+    reader->user = user;
+}
+
+int ftpProto_readLine(FtpReplyReader *reader, char *line, size_t lineSize)
+{
+    char *eol;
+    int len, res;
+    size_t copy;
+
+    for(;;)
+    {
+        eol = (char*)memchr(reader->buf, '\n', reader->len);
+
+        if(eol || reader->len == FTP_REPLY_SIZE)
+        {
+            len = eol ? (int)(eol - reader->buf) + 1 : reader->len;
+            copy = (size_t)len < lineSize - 1 ? (size_t)len : lineSize - 1;
+            memcpy(line, reader->buf, copy);
+            line[copy] = '\0';
+            reader->len -= len;
+            memmove(reader->buf, reader->buf + len, reader->len);
+            return 1;
+        }
+
+        res = reader->receive(reader->user, reader->buf + reader->len, FTP_REPLY_SIZE - reader->len);
+        if(res <= 0)
+            return 0;
+
+        reader->len += res;
+    }
+}
+
+int ftpProto_lineCode(const char *line)
+{
+    if(line[0] < '0' || line[0] > '9' || line[1] < '0' || line[1] > '9' || line[2] < '0' || line[2] > '9')
+        return 0;
+
+    if(line[3] != ' ' && line[3] != '-' && line[3] != '\r' && line[3] != '\n' && line[3] != '\0')
+        return 0;
+
+    return (line[0] - '0') * 100 + (line[1] - '0') * 10 + (line[2] - '0');
+}
+
+int ftpProto_readReply(FtpReplyReader *reader, char *inBuffer, size_t inBufferSize)
+{
+    char line[FTP_REPLY_SIZE];
+    int code = 0, lineCode;
+
+    inBuffer[0] = '\0';
+
+    for(;;)
+    {
+        if(!ftpProto_readLine(reader, line, sizeof(line)))
+            return -1;
+
+        if(strlen(inBuffer) + strlen(line) < inBufferSize)
+            strcat(inBuffer, line);
+
+        lineCode = ftpProto_lineCode(line);
+
+        if(code == 0)
+        {
+            if(lineCode == 0)
+                return 0;
+
+            code = lineCode;
+            if(line[3] != '-')
+                return code;
+        }
+        else if(lineCode == code && line[3] != '-')
+            return code; /* End of the multi-line reply */
+    }
+}
+
+uint16_t ftpProto_parsePassivePort(const char *reply, int *ok)
+{
+    unsigned long value[6];
+    const char *str_pos;
+    char *end;
+    int i;
+
+    *ok = 0;
+
+    str_pos = strchr(reply, '(');
+    if(!str_pos)
+        return 0;
+
+    str_pos++;
+
+    /* h1,h2,h3,h4,p1,p2 */
+    for(i = 0; i < 6; ++i)
+    {
+        value[i] = strtoul(str_pos, &end, 10);
+        if(end == str_pos || value[i] > 255 || (i < 5 && *end != ','))
+            return 0;
+        str_pos = end + 1;
+    }
+
+    *ok = 1;
+
+    return (uint16_t)(value[4] * 256 + value[5]);
+}
+
+uint16_t ftpProto_parseExtPassivePort(const char *reply, int *ok)
+{
+    const char *str_pos;
+    unsigned long p_port;
+    char *end;
+
+    *ok = 0;
+
+    str_pos = strstr(reply, "(|||");
+    if(!str_pos)
+        return 0;
+
+    /* Only the digits up to the closing delimiter, strtoul() would accept the sign too */
+    str_pos += 4;
+    if(*str_pos < '0' || *str_pos > '9')
+        return 0;
+
+    p_port = strtoul(str_pos, &end, 10);
+    if(*end != '|' || p_port == 0 || p_port > 0xFFFF)
+        return 0;
+
+    *ok = 1;
+
+    return (uint16_t)p_port;
+}
+
+long ftpProto_parseSize(const char *reply)
+{
+    unsigned long size;
+    char *end;
+
+    if(ftpProto_lineCode(reply) != 213 || reply[3] != ' ')
+        return -1;
+
+    /* Wrong size would resume the upload from the wrong place, so only the plain number is accepted */
+    if(reply[4] < '0' || reply[4] > '9')
+        return -1;
+
+    size = strtoul(reply + 4, &end, 10);
+    if(size > 0x7FFFFFFFUL || (*end != '\0' && *end != '\r' && *end != '\n' && *end != ' '))
+        return -1;
+
+    return (long)size;
+}
+
+const char *ftpProto_baseName(const char *path)
+{
+    const char *ret = strrchr(path, '\\');
+    const char *slash = strrchr(path, '/');
+
+    if(!ret || (slash && slash > ret))
+        ret = slash;
+
+    if(!ret)
+        return NULL;
+
+    return ++ret;
+}
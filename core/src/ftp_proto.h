@@ -0,0 +1,94 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef FTP_PROTO_H
+#define FTP_PROTO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * The transport-independent part of the FTP client: reading of the replies
+ * from the control connection and parsing of their contents.
+ */
+
+#define FTP_REPLY_SIZE  1000
+
+/* Receive the data like recv(), returns the number of bytes or <= 0 when the connection is closed */
+typedef int (*FtpRecvFunc)(void *user, char *buf, int size);
+
+typedef struct tagFtpReplyReader
+{
+    /* Received but not yet parsed data of the control connection */
+    char buf[FTP_REPLY_SIZE];
+    int len;
+    FtpRecvFunc receive;
+    void *user;
+} FtpReplyReader;
+
+void ftpProto_initReader(FtpReplyReader *reader, FtpRecvFunc receive, void *user);
+
+/**
+ * @brief Read one line of the reply, too long lines are cut into pieces
+ * @return 1 on success, 0 when the connection got closed
+ */
+int ftpProto_readLine(FtpReplyReader *reader, char *line, size_t lineSize);
+
+/**
+ * @brief Get the code of the reply line
+ * @return The code, or 0 if the line doesn't start with it
+ */
+int ftpProto_lineCode(const char *line);
+
+/**
+ * @brief Read the complete reply, lines of the multi-line reply are joined together
+ * @param inBuffer Receives the text of the reply
+ * @param inBufferSize Size of the buffer
+ * @return The reply code, 0 if the reply is corrupted, or -1 if the connection is broken
+ */
+int ftpProto_readReply(FtpReplyReader *reader, char *inBuffer, size_t inBufferSize);
+
+/**
+ * @brief Get the port from the PASV reply: 227 Entering Passive Mode (172,16,9,141,39,22).
+ */
+uint16_t ftpProto_parsePassivePort(const char *reply, int *ok);
+
+/**
+ * @brief Get the port from the EPSV reply: 229 Entering Extended Passive Mode (|||6446|)
+ */
+uint16_t ftpProto_parseExtPassivePort(const char *reply, int *ok);
+
+/**
+ * @brief Get the file size from the SIZE reply: 213 12345
+ * @return The size, or -1 if the reply is not 213 or has no valid number
+ */
+long ftpProto_parseSize(const char *reply);
+
+/**
+ * @brief Get the file name part of the local path
+ * @return Pointer into the path, or NULL if the path has no directory
+ */
+const char *ftpProto_baseName(const char *path);
+
+#endif /* FTP_PROTO_H */
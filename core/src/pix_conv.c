@@ -0,0 +1,172 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "pix_conv.h"
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#   define PIXCONV_X86
+#   include <emmintrin.h>
+#   if defined(_MSC_VER)
+#       include <intrin.h>
+#   elif defined(__i386__)
+#       include <cpuid.h>
+#   endif
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+#   define PIXCONV_NEON
+#   include <arm_neon.h>
+#endif
+
+/*
+ * All implementations are safe for the in-place conversion: every step reads
+ * the source before writing, and the write position (3 bytes per pixel) never
+ * overtakes the read position (4 bytes per pixel).
+ */
+
+static void bgraToRgbScalar(uint8_t *dst, const uint8_t *src, size_t pixels)
+{
+    size_t i;
+    uint8_t b, g, r;
+
+    for(i = 0; i < pixels; ++i)
+    {
+        b = src[0];
+        g = src[1];
+        r = src[2];
+        dst[0] = r;
+        dst[1] = g;
+        dst[2] = b;
+        src += 4;
+        dst += 3;
+    }
+}
+
+#if defined(PIXCONV_X86)
+
+#if defined(__GNUC__) && !defined(__x86_64__)
+__attribute__((target("sse2")))
+#endif
+static void bgraToRgbSSE2(uint8_t *dst, const uint8_t *src, size_t pixels)
+{
+    const __m128i mask_g = _mm_set1_epi32(0x0000FF00);
+    const __m128i mask_rb = _mm_set1_epi32(0x000000FF);
+    const __m128i mask_lo = _mm_set_epi32(0, 0x00FFFFFF, 0, 0x00FFFFFF);
+    const __m128i mask_hi = _mm_set_epi32(0x0000FFFF, (int)0xFF000000, 0x0000FFFF, (int)0xFF000000);
+    const __m128i mask_q0 = _mm_set_epi32(0, 0, 0x0000FFFF, (int)0xFFFFFFFF);
+    __m128i v, rgb, packed;
+    size_t i;
+    uint32_t tail;
+
+    for(i = 0; i + 4 <= pixels; i += 4)
+    {
+        v = _mm_loadu_si128((const __m128i *)src);
+
+        /* B G R A -> R G B 0 in each 32-bit lane */
+        rgb = _mm_or_si128(_mm_and_si128(v, mask_g),
+              _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 16), mask_rb),
+                           _mm_slli_epi32(_mm_and_si128(v, mask_rb), 16)));
+
+        /* Squeeze pairs of pixels into 48 bits of each 64-bit lane */
+        packed = _mm_or_si128(_mm_and_si128(rgb, mask_lo),
+                              _mm_and_si128(_mm_srli_epi64(rgb, 8), mask_hi));
+
+        /* Join both 6-byte halves into the solid 12 bytes */
+        packed = _mm_or_si128(_mm_and_si128(packed, mask_q0),
+                              _mm_srli_si128(_mm_andnot_si128(mask_q0, packed), 2));
+
+        _mm_storel_epi64((__m128i *)dst, packed);
+        tail = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(packed, 8));
+        memcpy(dst + 8, &tail, 4);
+
+        src += 16;
+        dst += 12;
+    }
+
+    bgraToRgbScalar(dst, src, pixels - i);
+}
+
+static int hasSSE2(void)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    return 1;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    unsigned int eax, ebx, ecx, edx;
+
+    /* Also fails on the ancient CPUs that don't support the CPUID itself */
+    if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return 0;
+
+    return (edx & bit_SSE2) != 0;
+#endif
+}
+
+#elif defined(PIXCONV_NEON)
+
+static void bgraToRgbNEON(uint8_t *dst, const uint8_t *src, size_t pixels)
+{
+    uint8x16x4_t in;
+    uint8x16x3_t out;
+    size_t i;
+
+    for(i = 0; i + 16 <= pixels; i += 16)
+    {
+        in = vld4q_u8(src);
+        out.val[0] = in.val[2];
+        out.val[1] = in.val[1];
+        out.val[2] = in.val[0];
+        vst3q_u8(dst, out);
+        src += 64;
+        dst += 48;
+    }
+
+    bgraToRgbScalar(dst, src, pixels - i);
+}
+
+#endif
+
+void pixConv_bgraToRgb(uint8_t *dst, const uint8_t *src, size_t pixels)
+{
+#if defined(PIXCONV_X86)
+    static int s_sse2 = -1;
+
+    if(s_sse2 < 0)
+        s_sse2 = hasSSE2();
+
+    if(s_sse2)
+    {
+        bgraToRgbSSE2(dst, src, pixels);
+        return;
+    }
+#elif defined(PIXCONV_NEON)
+    bgraToRgbNEON(dst, src, pixels);
+    return;
+#endif
+
+    bgraToRgbScalar(dst, src, pixels);
+}
@@ -0,0 +1,70 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef PNG_PRESET_H
+#define PNG_PRESET_H
+
+enum PngPresetId
+{
+    /* Generic zlib defaults: level 6, filtered strategy, try all filters */
+    PNG_PRESET_DEFAULT = 0,
+    /* For weak machines: single probe greedy matching, cheap filters only */
+    PNG_PRESET_FASTEST,
+    /* Tuned for the screen contents: flat colours, text and repeated UI parts */
+    PNG_PRESET_DESKTOP,
+    /* The best compression, useful when files are sent over the slow FTP */
+    PNG_PRESET_SMALLEST,
+    PNG_PRESET_COUNT
+};
+
+struct PngPreset
+{
+    /* Name used in the config file */
+    const char *name;
+    /* Compression level in terms of zlib/miniz, selects the number of probes and lazy/greedy parsing */
+    int level;
+    /* Compression strategy (MZ_DEFAULT_STRATEGY, MZ_FILTERED, MZ_RLE, etc.) */
+    int strategy;
+    /* Set of row filters to choose from, a mask of SPNG_FILTER_CHOICE_* flags */
+    int filters;
+};
+
+typedef struct PngPreset PngPreset;
+
+/**
+ * @brief Get the compression preset
+ * @param id Preset ID, one of PngPresetId values, invalid values are giving the desktop preset
+ * @return Preset parameters
+ */
+const PngPreset *pngPreset_get(int id);
+
+/**
+ * @brief Find the compression preset by name
+ * @param name Name of the preset (case-insensitive)
+ * @return Preset ID, or PNG_PRESET_DESKTOP if name is unknown
+ */
+int pngPreset_fromName(const char *name);
+
+#endif /* PNG_PRESET_H */
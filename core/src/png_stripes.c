@@ -0,0 +1,704 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Parallel PNG encoder: the image gets split into horizontal stripes, every
+ * stripe gets filtered and deflated by its own thread into the raw deflate
+ * stream terminated with the sync-flush marker (the last one gets finished).
+ * All pieces then being concatenated into a single zlib stream inside IDAT
+ * chunks with the Adler-32 combined from the checksums of every stripe.
+ * The helper threads are started by pngStripes_init() and when a call needs
+ * more of them, then they stay and take the stripes of any encoding call
+ * until pngStripes_quit().
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "png_stripes.h"
+#include "core_sys.h"
+
+#include "miniz.h"
+#include "spng.h"
+#include "png_preset.h"
+
+#define ADLER_BASE 65521U
+
+typedef struct tagStripeJob
+{
+    const uint8_t *pixels;
+    uint32_t pitch;
+    uint32_t row_bytes;
+    uint32_t bpp;
+    uint32_t y_begin;
+    uint32_t y_end;
+    int is_last;
+    const PngPreset *preset;
+
+    uint8_t *out;
+    size_t out_len;
+    size_t out_cap;
+    mz_ulong adler;
+    size_t in_len;
+    int error;
+
+    /* Posted once the stripe is done by the helper thread */
+    CoreSemaphore *done;
+    struct tagStripeJob *next;
+} StripeJob;
+
+typedef struct tagStripePool
+{
+    CoreMutex mutex;
+    /* Posted for every queued stripe and for every thread on the quit */
+    CoreSemaphore work;
+    CoreThread threads[PNG_STRIPES_MAX_WORKERS - 1];
+    int count;
+    int ready;
+    int quit;
+    /* Stripes waiting for a helper thread, the oldest first */
+    StripeJob *queue;
+} StripePool;
+
+static StripePool s_pool;
+
+
+static uint8_t paeth(uint8_t a, uint8_t b, uint8_t c)
+{
+    int p = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+
+    if(pa <= pb && pa <= pc)
+        return a;
+    else if(pb <= pc)
+        return b;
+
+    return c;
+}
+
+/* Same filter selection heuristic as spng does: minimum sum of absolute differences */
+static int32_t filterSum(const uint8_t *row, uint32_t len)
+{
+    uint32_t i;
+    int32_t sum = 0;
+
+    for(i = 0; i < len; ++i)
+        sum += 128 - abs((int)row[i] - 128);
+
+    return sum;
+}
+
+/* The loop of every filter is separate, so the compiler can vectorize the simple ones */
+static void filterRow(uint8_t *out, const uint8_t *prev, const uint8_t *cur, uint32_t len, uint32_t bpp, int filter)
+{
+    uint32_t i, first = bpp < len ? bpp : len;
+
+    switch(filter)
+    {
+    case 1:
+        memcpy(out, cur, first);
+        for(i = first; i < len; ++i)
+            out[i] = (uint8_t)(cur[i] - cur[i - bpp]);
+        break;
+    case 2:
+        for(i = 0; i < len; ++i)
+            out[i] = (uint8_t)(cur[i] - prev[i]);
+        break;
+    case 3:
+        for(i = 0; i < first; ++i)
+            out[i] = (uint8_t)(cur[i] - prev[i] / 2);
+        for(; i < len; ++i)
+            out[i] = (uint8_t)(cur[i] - (uint8_t)((cur[i - bpp] + prev[i]) / 2));
+        break;
+    case 4:
+        /* Paeth of (0, b, 0) is always b */
+        for(i = 0; i < first; ++i)
+            out[i] = (uint8_t)(cur[i] - prev[i]);
+        for(; i < len; ++i)
+            out[i] = (uint8_t)(cur[i] - paeth(cur[i - bpp], prev[i], prev[i - bpp]));
+        break;
+    default:
+        memcpy(out, cur, len);
+        break;
+    }
+}
+
+static mz_bool stripe_put_buf(const void *buf, int len, void *user)
+{
+    StripeJob *job = (StripeJob *)user;
+    uint8_t *n;
+    size_t new_cap;
+
+    if(job->out_len + len > job->out_cap)
+    {
+        new_cap = job->out_cap * 2;
+        if(new_cap < job->out_len + len)
+            new_cap = job->out_len + len;
+
+        n = (uint8_t *)realloc(job->out, new_cap);
+        if(!n)
+            return MZ_FALSE;
+
+        job->out = n;
+        job->out_cap = new_cap;
+    }
+
+    memcpy(job->out + job->out_len, buf, len);
+    job->out_len += len;
+
+    return MZ_TRUE;
+}
+
+static void stripe_process(StripeJob *job)
+{
+    tdefl_compressor *comp = NULL;
+    uint8_t *filtered = NULL, *zero_row = NULL, *best_row;
+    const uint8_t *cur, *prev;
+    uint32_t y, row_len = job->row_bytes + 1;
+    int32_t sum, best_sum;
+    int f, best;
+    mz_uint flags;
+
+    job->adler = MZ_ADLER32_INIT;
+    job->in_len = 0;
+    job->out_cap = (size_t)job->row_bytes * (job->y_end - job->y_begin) / 2 + 1024;
+    job->out = (uint8_t *)malloc(job->out_cap);
+
+    comp = (tdefl_compressor *)malloc(sizeof(tdefl_compressor));
+    /* Candidate for every filter type, the filter byte goes first */
+    filtered = (uint8_t *)malloc(row_len * 5);
+    zero_row = (uint8_t *)calloc(1, job->row_bytes);
+
+    if(!job->out || !comp || !filtered || !zero_row)
+    {
+        job->error = SPNG_EMEM;
+        goto cleanup;
+    }
+
+    flags = tdefl_create_comp_flags_from_zip_params(job->preset->level, -MZ_DEFAULT_WINDOW_BITS, job->preset->strategy);
+
+    if(tdefl_init(comp, stripe_put_buf, job, flags) != TDEFL_STATUS_OKAY)
+    {
+        job->error = SPNG_EZLIB_INIT;
+        goto cleanup;
+    }
+
+    for(y = job->y_begin; y < job->y_end; ++y)
+    {
+        cur = job->pixels + (size_t)y * job->pitch;
+        /* The first row of a stripe still gets filtered against the last row of the previous one */
+        prev = y > 0 ? cur - job->pitch : zero_row;
+
+        best = 0;
+        best_sum = INT32_MAX;
+
+        for(f = 0; f < 5; ++f)
+        {
+            if(!(job->preset->filters & (SPNG_FILTER_CHOICE_NONE << f)))
+                continue;
+
+            filtered[f * row_len] = (uint8_t)f;
+            filterRow(filtered + f * row_len + 1, prev, cur, job->row_bytes, job->bpp, f);
+            sum = abs(filterSum(filtered + f * row_len + 1, job->row_bytes));
+
+            if(sum < best_sum)
+            {
+                best_sum = sum;
+                best = f;
+            }
+        }
+
+        best_row = filtered + best * row_len;
+        job->adler = mz_adler32(job->adler, best_row, row_len);
+        job->in_len += row_len;
+
+        if(tdefl_compress_buffer(comp, best_row, row_len, TDEFL_NO_FLUSH) != TDEFL_STATUS_OKAY)
+        {
+            job->error = SPNG_EZLIB;
+            goto cleanup;
+        }
+    }
+
+    /* Non-final stripes are ending at the byte boundary, so the next stripe can be appended */
+    if(job->is_last)
+    {
+        if(tdefl_compress_buffer(comp, NULL, 0, TDEFL_FINISH) != TDEFL_STATUS_DONE)
+            job->error = SPNG_EZLIB;
+    }
+    else
+    {
+        if(tdefl_compress_buffer(comp, NULL, 0, TDEFL_SYNC_FLUSH) != TDEFL_STATUS_OKAY)
+            job->error = SPNG_EZLIB;
+    }
+
+cleanup:
+    if(zero_row)
+        free(zero_row);
+    if(filtered)
+        free(filtered);
+    if(comp)
+        free(comp);
+}
+
+/* Must be called with the locked mutex, takes the oldest stripe of the call that owns done, or of any call for NULL */
+static StripeJob *pool_take(CoreSemaphore *done)
+{
+    StripeJob **link, *job;
+
+    for(link = &s_pool.queue; *link; link = &(*link)->next)
+    {
+        if(!done || (*link)->done == done)
+        {
+            job = *link;
+            *link = job->next;
+            job->next = NULL;
+            return job;
+        }
+    }
+
+    return NULL;
+}
+
+static void stripe_pool_thread(void *arg)
+{
+    StripeJob *job;
+
+    (void)arg;
+
+    for(;;)
+    {
+        coreSemaphore_wait(&s_pool.work);
+
+        coreMutex_lock(&s_pool.mutex);
+        if(s_pool.quit)
+        {
+            coreMutex_unlock(&s_pool.mutex);
+            return;
+        }
+        /* The stripe may be already taken back by its caller */
+        job = pool_take(NULL);
+        coreMutex_unlock(&s_pool.mutex);
+
+        if(job)
+        {
+            stripe_process(job);
+            coreSemaphore_post(job->done, 1);
+        }
+    }
+}
+
+/* Queue the stripes for the helper threads, returns 0 if there are no threads to do them */
+static int pool_push(StripeJob *jobs, int count, CoreSemaphore *done)
+{
+    StripeJob **tail;
+    int i;
+
+    coreMutex_lock(&s_pool.mutex);
+
+    if(!s_pool.ready)
+    {
+        coreMutex_unlock(&s_pool.mutex);
+        return 0;
+    }
+
+    /* The threads are only added, a larger count once needed stays for the next calls */
+    while(s_pool.count < count && coreThread_start(&s_pool.threads[s_pool.count], &stripe_pool_thread, NULL))
+        s_pool.count++;
+
+    if(s_pool.count == 0)
+    {
+        coreMutex_unlock(&s_pool.mutex);
+        return 0;
+    }
+
+    for(tail = &s_pool.queue; *tail; tail = &(*tail)->next)
+        ;
+
+    for(i = 0; i < count; ++i)
+    {
+        jobs[i].done = done;
+        jobs[i].next = NULL;
+        *tail = &jobs[i];
+        tail = &jobs[i].next;
+    }
+
+    coreMutex_unlock(&s_pool.mutex);
+
+    coreSemaphore_post(&s_pool.work, (unsigned long)count);
+
+    return 1;
+}
+
+void pngStripes_init(int workers)
+{
+    if(s_pool.ready)
+        return;
+
+    memset(&s_pool, 0, sizeof(s_pool));
+    coreMutex_init(&s_pool.mutex);
+
+    if(!coreSemaphore_init(&s_pool.work, 0))
+    {
+        coreMutex_destroy(&s_pool.mutex);
+        return;
+    }
+
+    s_pool.ready = 1;
+
+    if(workers > PNG_STRIPES_MAX_WORKERS)
+        workers = PNG_STRIPES_MAX_WORKERS;
+
+    coreMutex_lock(&s_pool.mutex);
+    while(s_pool.count < workers - 1 && coreThread_start(&s_pool.threads[s_pool.count], &stripe_pool_thread, NULL))
+        s_pool.count++;
+    coreMutex_unlock(&s_pool.mutex);
+}
+
+void pngStripes_quit(void)
+{
+    int i;
+
+    if(!s_pool.ready)
+        return;
+
+    coreMutex_lock(&s_pool.mutex);
+    s_pool.quit = 1;
+    coreMutex_unlock(&s_pool.mutex);
+
+    coreSemaphore_post(&s_pool.work, (unsigned long)s_pool.count);
+
+    for(i = 0; i < s_pool.count; ++i)
+        coreThread_join(&s_pool.threads[i]);
+
+    coreSemaphore_destroy(&s_pool.work);
+    coreMutex_destroy(&s_pool.mutex);
+    memset(&s_pool, 0, sizeof(s_pool));
+}
+
+/* Equivalent of the zlib's adler32_combine() */
+static mz_ulong adlerCombine(mz_ulong adler1, mz_ulong adler2, size_t len2)
+{
+    mz_ulong sum1, sum2;
+    mz_ulong rem = (mz_ulong)(len2 % ADLER_BASE);
+
+    sum1 = adler1 & 0xFFFF;
+    sum2 = (rem * sum1) % ADLER_BASE;
+    sum1 += (adler2 & 0xFFFF) + ADLER_BASE - 1;
+    sum2 += ((adler1 >> 16) & 0xFFFF) + ((adler2 >> 16) & 0xFFFF) + ADLER_BASE - rem;
+
+    if(sum1 >= ADLER_BASE)
+        sum1 -= ADLER_BASE;
+    if(sum1 >= ADLER_BASE)
+        sum1 -= ADLER_BASE;
+    if(sum2 >= (ADLER_BASE << 1))
+        sum2 -= (ADLER_BASE << 1);
+    if(sum2 >= ADLER_BASE)
+        sum2 -= ADLER_BASE;
+
+    return sum1 | (sum2 << 16);
+}
+
+static void putU32(uint8_t *out, mz_ulong value)
+{
+    out[0] = (uint8_t)((value >> 24) & 0xFF);
+    out[1] = (uint8_t)((value >> 16) & 0xFF);
+    out[2] = (uint8_t)((value >> 8) & 0xFF);
+    out[3] = (uint8_t)(value & 0xFF);
+}
+
+/* Destination of the encoded PNG: the file, or the memory buffer allocated for the exact size */
+typedef struct PngSink
+{
+    FILE *f;
+    uint8_t *buf;
+    size_t len;
+} PngSink;
+
+static int sinkWrite(PngSink *sink, const void *data, size_t len)
+{
+    if(sink->f)
+        return fwrite(data, 1, len, sink->f) == len ? 0 : SPNG_IO_ERROR;
+
+    memcpy(sink->buf + sink->len, data, len);
+    sink->len += len;
+
+    return 0;
+}
+
+/* Write chunk which data is concatenated from up to three pieces */
+static int writeChunk(PngSink *sink, const char *type,
+                      const uint8_t *d1, size_t l1,
+                      const uint8_t *d2, size_t l2,
+                      const uint8_t *d3, size_t l3)
+{
+    uint8_t head[8];
+    uint8_t tail[4];
+    mz_ulong crc;
+
+    putU32(head, (mz_ulong)(l1 + l2 + l3));
+    memcpy(head + 4, type, 4);
+
+    crc = mz_crc32(MZ_CRC32_INIT, head + 4, 4);
+    if(l1)
+        crc = mz_crc32(crc, d1, l1);
+    if(l2)
+        crc = mz_crc32(crc, d2, l2);
+    if(l3)
+        crc = mz_crc32(crc, d3, l3);
+
+    putU32(tail, crc);
+
+    if(sinkWrite(sink, head, 8))
+        return SPNG_IO_ERROR;
+    if(l1 && sinkWrite(sink, d1, l1))
+        return SPNG_IO_ERROR;
+    if(l2 && sinkWrite(sink, d2, l2))
+        return SPNG_IO_ERROR;
+    if(l3 && sinkWrite(sink, d3, l3))
+        return SPNG_IO_ERROR;
+    if(sinkWrite(sink, tail, 4))
+        return SPNG_IO_ERROR;
+
+    return 0;
+}
+
+int pngStripes_workersCount(int setting, uint32_t h)
+{
+    int workers = setting;
+
+    if(workers <= 0)
+        workers = coreSys_cpuCount();
+
+    if(workers > PNG_STRIPES_MAX_WORKERS)
+        workers = PNG_STRIPES_MAX_WORKERS;
+
+    if((uint32_t)workers > h / PNG_STRIPES_MIN_ROWS)
+        workers = (int)(h / PNG_STRIPES_MIN_ROWS);
+
+    if(workers < 1)
+        workers = 1;
+
+    return workers;
+}
+
+static int encodeStripes(PngSink *sink, const uint8_t *pixels, uint32_t w, uint32_t h, uint32_t pitch, int channels, int workers,
+                         const PngPreset *preset)
+{
+    static const uint8_t png_signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    /* CMF: deflate with 32K window, FLG: compression level hint and the check bits */
+    uint8_t zlib_header[2] = {0x78, 0x9C};
+    StripeJob jobs[PNG_STRIPES_MAX_WORKERS];
+    StripeJob *job;
+    CoreSemaphore done;
+    uint8_t ihdr[13];
+    uint8_t adler_out[4];
+    uint32_t rows_per_stripe, y;
+    mz_ulong adler;
+    size_t png_size;
+    int i, ret = 0;
+
+    if(!pixels || !w || !h || (channels != 3 && channels != 4) || !preset)
+        return SPNG_EINVAL;
+
+    if(preset->level < 2)
+        zlib_header[1] = 0x01;
+    else if(preset->level < 6)
+        zlib_header[1] = 0x5E;
+    else if(preset->level > 6)
+        zlib_header[1] = 0xDA;
+
+    if(workers < 1)
+        workers = 1;
+    if(workers > PNG_STRIPES_MAX_WORKERS)
+        workers = PNG_STRIPES_MAX_WORKERS;
+    if((uint32_t)workers > h)
+        workers = (int)h;
+
+    memset(jobs, 0, sizeof(jobs));
+
+    rows_per_stripe = (h + workers - 1) / workers;
+
+    for(i = 0, y = 0; i < workers && y < h; ++i, y += rows_per_stripe)
+    {
+        jobs[i].pixels = pixels;
+        jobs[i].pitch = pitch;
+        jobs[i].row_bytes = w * channels;
+        jobs[i].bpp = channels;
+        jobs[i].y_begin = y;
+        jobs[i].y_end = y + rows_per_stripe < h ? y + rows_per_stripe : h;
+        jobs[i].preset = preset;
+    }
+
+    workers = i;
+    jobs[workers - 1].is_last = 1;
+
+    /* The first stripe gets processed by the calling thread itself, and then the ones no helper has taken yet */
+    if(workers > 1 && coreSemaphore_init(&done, 0))
+    {
+        if(pool_push(jobs + 1, workers - 1, &done))
+        {
+            stripe_process(&jobs[0]);
+
+            for(i = 1; i < workers; ++i)
+            {
+                coreMutex_lock(&s_pool.mutex);
+                job = pool_take(&done);
+                coreMutex_unlock(&s_pool.mutex);
+
+                if(!job)
+                    break;
+
+                stripe_process(job);
+                coreSemaphore_post(&done, 1);
+            }
+
+            for(i = 1; i < workers; ++i)
+                coreSemaphore_wait(&done);
+        }
+        else /* No helper threads, do all the work here */
+        {
+            for(i = 0; i < workers; ++i)
+                stripe_process(&jobs[i]);
+        }
+
+        coreSemaphore_destroy(&done);
+    }
+    else
+    {
+        for(i = 0; i < workers; ++i)
+            stripe_process(&jobs[i]);
+    }
+
+    for(i = 0; i < workers; ++i)
+    {
+        if(jobs[i].error)
+        {
+            ret = jobs[i].error;
+            goto cleanup;
+        }
+    }
+
+    adler = jobs[0].adler;
+    for(i = 1; i < workers; ++i)
+        adler = adlerCombine(adler, jobs[i].adler, jobs[i].in_len);
+
+    putU32(adler_out, adler);
+
+    putU32(ihdr, w);
+    putU32(ihdr + 4, h);
+    ihdr[8] = 8; /* Bit depth */
+    ihdr[9] = channels == 4 ? SPNG_COLOR_TYPE_TRUECOLOR_ALPHA : SPNG_COLOR_TYPE_TRUECOLOR;
+    ihdr[10] = 0; /* Compression method */
+    ihdr[11] = 0; /* Filter method */
+    ihdr[12] = 0; /* Interlace method */
+
+    if(!sink->f)
+    {
+        /* Signature, IHDR, IDATs with the zlib header and Adler-32, IEND */
+        png_size = 8 + (12 + 13) + 2 + 4 + 12;
+        for(i = 0; i < workers; ++i)
+            png_size += 12 + jobs[i].out_len;
+
+        sink->buf = (uint8_t *)malloc(png_size);
+        if(!sink->buf)
+        {
+            ret = SPNG_EMEM;
+            goto cleanup;
+        }
+    }
+
+    if(sinkWrite(sink, png_signature, 8))
+    {
+        ret = SPNG_IO_ERROR;
+        goto cleanup;
+    }
+
+    ret = writeChunk(sink, "IHDR", ihdr, 13, NULL, 0, NULL, 0);
+    if(ret)
+        goto cleanup;
+
+    /* One IDAT per stripe: zlib header goes into the first one, Adler-32 into the last */
+    for(i = 0; i < workers; ++i)
+    {
+        ret = writeChunk(sink, "IDAT",
+                         zlib_header, i == 0 ? 2 : 0,
+                         jobs[i].out, jobs[i].out_len,
+                         adler_out, jobs[i].is_last ? 4 : 0);
+        if(ret)
+            goto cleanup;
+    }
+
+    ret = writeChunk(sink, "IEND", NULL, 0, NULL, 0, NULL, 0);
+
+cleanup:
+    for(i = 0; i < workers; ++i)
+    {
+        if(jobs[i].out)
+            free(jobs[i].out);
+    }
+
+    if(ret && sink->buf)
+    {
+        free(sink->buf);
+        sink->buf = NULL;
+    }
+
+    return ret;
+}
+
+int pngStripes_encode(FILE *f, const uint8_t *pixels, uint32_t w, uint32_t h, uint32_t pitch, int channels, int workers,
+                      const PngPreset *preset)
+{
+    PngSink sink;
+
+    if(!f)
+        return SPNG_EINVAL;
+
+    memset(&sink, 0, sizeof(sink));
+    sink.f = f;
+
+    return encodeStripes(&sink, pixels, w, h, pitch, channels, workers, preset);
+}
+
+int pngStripes_encodeToBuffer(uint8_t **png, size_t *png_len,
+                              const uint8_t *pixels, uint32_t w, uint32_t h, uint32_t pitch, int channels, int workers,
+                              const PngPreset *preset)
+{
+    PngSink sink;
+    int ret;
+
+    if(!png || !png_len)
+        return SPNG_EINVAL;
+
+    memset(&sink, 0, sizeof(sink));
+
+    ret = encodeStripes(&sink, pixels, w, h, pitch, channels, workers, preset);
+
+    *png = sink.buf;
+    *png_len = sink.len;
+
+    return ret;
+}
@@ -0,0 +1,83 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PNG_STRIPES_H
+#define PNG_STRIPES_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "png_preset.h"
+
+/* Maximum number of the parallel encoding workers */
+#define PNG_STRIPES_MAX_WORKERS     16
+/* Don't make stripes shorter than this number of rows */
+#define PNG_STRIPES_MIN_ROWS        32
+
+/**
+ * @brief Start the helper threads that encode the stripes of all following calls, without them every stripe is encoded by the calling thread
+ * @param workers Number of workers to prepare for, more threads get started when a call needs them
+ */
+void pngStripes_init(int workers);
+
+/**
+ * @brief Stop the helper threads, no encoding call may run at this time
+ */
+void pngStripes_quit(void);
+
+/**
+ * @brief Resolve the number of encoding workers from the setting value
+ * @param setting Value of the setting: 0 - use number of CPUs, 1 - single-threaded, N - use N workers
+ * @param h Height of the image to encode
+ * @return Number of workers to use, 1 means the striped encoding is pointless
+ */
+int pngStripes_workersCount(int setting, uint32_t h);
+
+/**
+ * @brief Encode the 8-bit RGB or RGBA image into PNG file by splitting it into horizontal stripes that being compressed in parallel
+ * @param f Output file opened for writing
+ * @param pixels Pixel data
+ * @param w Width of the image
+ * @param h Height of the image
+ * @param pitch Length of one row in bytes
+ * @param channels Number of channels: 3 for RGB, or 4 for RGBA
+ * @param workers Number of workers (stripes) to use
+ * @param preset Compression preset
+ * @return 0 on success, or SPNG error code
+ */
+int pngStripes_encode(FILE *f, const uint8_t *pixels, uint32_t w, uint32_t h, uint32_t pitch, int channels, int workers,
+                      const PngPreset *preset);
+
+/**
+ * @brief Same as pngStripes_encode(), but puts the PNG file into the memory buffer
+ * @param png Receives the buffer allocated by malloc(), the caller should free() it
+ * @param png_len Receives the size of the PNG data
+ * @return 0 on success, or SPNG error code
+ */
+int pngStripes_encodeToBuffer(uint8_t **png, size_t *png_len,
+                              const uint8_t *pixels, uint32_t w, uint32_t h, uint32_t pitch, int channels, int workers,
+                              const PngPreset *preset);
+
+#endif /* PNG_STRIPES_H */
@@ -0,0 +1,96 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "rate_limit.h"
+
+static void setRate(RateLimit *limit, uint32_t rate, size_t minBurst)
+{
+    limit->rate = rate;
+    limit->burst = (double)(rate / RATE_LIMIT_BURST_DIV);
+    if(limit->burst < (double)minBurst)
+        limit->burst = (double)minBurst;
+    if(limit->tokens > limit->burst)
+        limit->tokens = limit->burst;
+}
+
+void rateLimit_init(RateLimit *limit, uint32_t rate, size_t minBurst, uint64_t now)
+{
+    limit->tokens = 0.0;
+    setRate(limit, rate, minBurst);
+    limit->refilled = now;
+    coreMutex_init(&limit->mutex);
+}
+
+void rateLimit_free(RateLimit *limit)
+{
+    coreMutex_destroy(&limit->mutex);
+}
+
+void rateLimit_setRate(RateLimit *limit, uint32_t rate, size_t minBurst)
+{
+    coreMutex_lock(&limit->mutex);
+    setRate(limit, rate, minBurst);
+    coreMutex_unlock(&limit->mutex);
+}
+
+size_t rateLimit_take(RateLimit *limit, size_t want, uint64_t now, uint64_t *wait)
+{
+    uint64_t elapsed;
+
+    *wait = 0;
+
+    coreMutex_lock(&limit->mutex);
+
+    if(limit->rate == 0)
+    {
+        coreMutex_unlock(&limit->mutex);
+        return want;
+    }
+
+    if((double)want > limit->burst)
+        want = (size_t)limit->burst;
+
+    /* Another thread may have refilled it a moment later */
+    elapsed = now > limit->refilled ? now - limit->refilled : 0;
+    if(now > limit->refilled)
+        limit->refilled = now;
+
+    /* The long idle time, like the sleep of the computer, gives no more than the capacity */
+    limit->tokens += (double)limit->rate * (double)elapsed / 1000000.0;
+    if(limit->tokens > limit->burst)
+        limit->tokens = limit->burst;
+
+    if(limit->tokens >= (double)want)
+    {
+        limit->tokens -= (double)want;
+        coreMutex_unlock(&limit->mutex);
+        return want;
+    }
+
+    *wait = (uint64_t)(((double)want - limit->tokens) * 1000000.0 / limit->rate) + 1;
+
+    coreMutex_unlock(&limit->mutex);
+
+    return 0;
+}
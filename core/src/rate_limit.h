@@ -0,0 +1,84 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef RATE_LIMIT_H
+#define RATE_LIMIT_H
+
+/*
+ * Token bucket of the upload rate limit, shared by all FTP connections. The
+ * bucket fills with the given rate and holds 100 ms of the traffic at most,
+ * so the link never gets the long bursts after the idle time. The time is
+ * given by the caller, so the sender passes coreSys_timeUs() and the tests
+ * may run the clock of their own.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core_sys.h"
+
+/* Part of the second of the traffic the bucket holds at most */
+#define RATE_LIMIT_BURST_DIV    10
+
+typedef struct tagRateLimit
+{
+    /* Bytes per second, 0 means unlimited */
+    uint32_t rate;
+    /* Capacity of the bucket in bytes */
+    double burst;
+    double tokens;
+    /* Time of the latest refill in microseconds */
+    uint64_t refilled;
+    CoreMutex mutex;
+} RateLimit;
+
+/**
+ * @brief Initialize the bucket, it starts empty
+ * @param limit Bucket
+ * @param rate Bytes per second, 0 means unlimited
+ * @param minBurst Smallest capacity of the bucket in bytes, it must hold at least one send() of the sender
+ * @param now Current time in microseconds
+ */
+void rateLimit_init(RateLimit *limit, uint32_t rate, size_t minBurst, uint64_t now);
+void rateLimit_free(RateLimit *limit);
+
+/**
+ * @brief Change the rate of the bucket in use, the tokens it has are kept up to the new capacity
+ * @param limit Bucket
+ * @param rate Bytes per second, 0 means unlimited
+ * @param minBurst Smallest capacity of the bucket in bytes
+ */
+void rateLimit_setRate(RateLimit *limit, uint32_t rate, size_t minBurst);
+
+/**
+ * @brief Take the tokens for sending the data
+ * @param limit Bucket
+ * @param want Number of bytes to send, more than the capacity of the bucket is cut to it
+ * @param now Current time in microseconds
+ * @param wait Receives the time in microseconds to wait before the next try, when nothing may be sent now
+ * @return Number of bytes that may be sent now, or 0 if the caller should wait
+ */
+size_t rateLimit_take(RateLimit *limit, size_t want, uint64_t now, uint64_t *wait);
+
+#endif /* RATE_LIMIT_H */
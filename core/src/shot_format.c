@@ -0,0 +1,629 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "shot_format.h"
+#include "png_stripes.h"
+#include "core_sys.h"
+
+#include "spng.h"
+
+#define QOI_OP_INDEX    0x00
+#define QOI_OP_DIFF     0x40
+#define QOI_OP_LUMA     0x80
+#define QOI_OP_RUN      0xc0
+#define QOI_OP_RGB      0xfe
+#define QOI_OP_RGBA     0xff
+#define QOI_MASK_2      0xc0
+#define QOI_HEADER_SIZE 14
+#define QOI_MAX_RUN     62
+
+#define QOI_HASH(r, g, b, a)   (((r) * 3 + (g) * 5 + (b) * 7 + (a) * 11) & 63)
+
+#define BMP_HEADER_SIZE 54
+#define TGA_HEADER_SIZE 18
+
+static const char *s_formatNames[SHOT_FORMAT_COUNT] =
+{
+    "png",
+    "qoi",
+    "bmp",
+    "tga"
+};
+
+static const char *s_formatExt[SHOT_FORMAT_COUNT] =
+{
+    ".png",
+    ".qoi",
+    ".bmp",
+    ".tga"
+};
+
+static const uint8_t s_qoiEnd[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+int shotFormat_fromName(const char *name)
+{
+    int i;
+
+    for(i = 0; i < SHOT_FORMAT_COUNT; ++i)
+    {
+        if(coreSys_strcasecmp(name, s_formatNames[i]) == 0)
+            return i;
+    }
+
+    return SHOT_FORMAT_PNG;
+}
+
+const char *shotFormat_name(int format)
+{
+    if(format < 0 || format >= SHOT_FORMAT_COUNT)
+        format = SHOT_FORMAT_PNG;
+
+    return s_formatNames[format];
+}
+
+const char *shotFormat_extension(int format)
+{
+    if(format < 0 || format >= SHOT_FORMAT_COUNT)
+        format = SHOT_FORMAT_PNG;
+
+    return s_formatExt[format];
+}
+
+static void putBe32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static void putLe16(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void putLe32(uint8_t *p, uint32_t v)
+{
+    putLe16(p, v);
+    putLe16(p + 2, v >> 16);
+}
+
+static uint32_t getBe32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint32_t getLe16(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+}
+
+static uint32_t getLe32(const uint8_t *p)
+{
+    return getLe16(p) | (getLe16(p + 2) << 16);
+}
+
+/* Refuse the sizes whose buffer of the given bytes per pixel doesn't fit into the memory */
+static int sizeFits(uint32_t w, uint32_t h, size_t bpp, size_t extra)
+{
+    if(w == 0 || h == 0)
+        return 0;
+
+    return ((size_t)-1 - extra) / bpp / w >= h;
+}
+
+static int encodeQoi(uint8_t **out, size_t *out_len, const uint8_t *pixels, uint32_t w, uint32_t h, uint32_t pitch)
+{
+    /* RGBA like in the decoders: the empty slot has the alpha of 0, so it doesn't match the opaque black */
+    uint8_t index[64][4];
+    uint8_t pr = 0, pg = 0, pb = 0, r, g, b;
+    const uint8_t *row, *px;
+    uint32_t x, y, run = 0;
+    uint8_t *buf, *o;
+    int vr, vg, vb, vg_r, vg_b, hash;
+
+    /* The worst case is QOI_OP_RGB for every pixel */
+    if(!sizeFits(w, h, 4, QOI_HEADER_SIZE + sizeof(s_qoiEnd)))
+        return SPNG_EOVERFLOW;
+
+    buf = (uint8_t *)malloc((size_t)w * h * 4 + QOI_HEADER_SIZE + sizeof(s_qoiEnd));
+    if(!buf)
+        return SPNG_EMEM;
+
+    memcpy(buf, "qoif", 4);
+    putBe32(buf + 4, w);
+    putBe32(buf + 8, h);
+    buf[12] = 3; /* RGB */
+    buf[13] = 0; /* sRGB with linear alpha */
+    o = buf + QOI_HEADER_SIZE;
+
+    memset(index, 0, sizeof(index));
+
+    for(y = 0; y < h; ++y)
+    {
+        row = pixels + (size_t)y * pitch;
+
+        for(x = 0, px = row; x < w; ++x, px += 3)
+        {
+            r = px[0];
+            g = px[1];
+            b = px[2];
+
+            if(r == pr && g == pg && b == pb)
+            {
+                if(++run == QOI_MAX_RUN)
+                {
+                    *o++ = (uint8_t)(QOI_OP_RUN | (run - 1));
+                    run = 0;
+                }
+                continue;
+            }
+
+            if(run > 0)
+            {
+                *o++ = (uint8_t)(QOI_OP_RUN | (run - 1));
+                run = 0;
+            }
+
+            hash = QOI_HASH(r, g, b, 255);
+
+            if(index[hash][0] == r && index[hash][1] == g && index[hash][2] == b && index[hash][3] == 255)
+                *o++ = (uint8_t)(QOI_OP_INDEX | hash);
+            else
+            {
+                index[hash][0] = r;
+                index[hash][1] = g;
+                index[hash][2] = b;
+                index[hash][3] = 255;
+
+                vr = (signed char)(r - pr);
+                vg = (signed char)(g - pg);
+                vb = (signed char)(b - pb);
+                vg_r = vr - vg;
+                vg_b = vb - vg;
+
+                if(vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2)
+                    *o++ = (uint8_t)(QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+                else if(vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8)
+                {
+                    *o++ = (uint8_t)(QOI_OP_LUMA | (vg + 32));
+                    *o++ = (uint8_t)((vg_r + 8) << 4 | (vg_b + 8));
+                }
+                else
+                {
+                    *o++ = QOI_OP_RGB;
+                    *o++ = r;
+                    *o++ = g;
+                    *o++ = b;
+                }
+            }
+
+            pr = r;
+            pg = g;
+            pb = b;
+        }
+    }
+
+    if(run > 0)
+        *o++ = (uint8_t)(QOI_OP_RUN | (run - 1));
+
+    memcpy(o, s_qoiEnd, sizeof(s_qoiEnd));
+    o += sizeof(s_qoiEnd);
+
+    *out = buf;
+    *out_len = (size_t)(o - buf);
+
+    return 0;
+}
+
+static int decodeQoi(const uint8_t *data, size_t len, uint8_t **pixels, uint32_t *w, uint32_t *h)
+{
+    uint8_t index[64][4];
+    uint8_t r = 0, g = 0, b = 0, a = 255, b1, b2;
+    size_t p = QOI_HEADER_SIZE, end, i, count;
+    uint32_t run = 0;
+    uint8_t *buf, *o;
+    int vg;
+
+    if(len < QOI_HEADER_SIZE + sizeof(s_qoiEnd) || memcmp(data, "qoif", 4) != 0)
+        return -1;
+
+    *w = getBe32(data + 4);
+    *h = getBe32(data + 8);
+
+    if(!sizeFits(*w, *h, 3, 0))
+        return -1;
+
+    count = (size_t)*w * *h;
+    buf = (uint8_t *)malloc(count * 3);
+    if(!buf)
+        return -1;
+
+    memset(index, 0, sizeof(index));
+    end = len - sizeof(s_qoiEnd);
+    o = buf;
+
+    for(i = 0; i < count; ++i)
+    {
+        if(run > 0)
+            run--;
+        else
+        {
+            if(p >= end)
+                break;
+
+            b1 = data[p++];
+
+            if(b1 == QOI_OP_RGB)
+            {
+                if(p + 3 > end)
+                    break;
+                r = data[p++];
+                g = data[p++];
+                b = data[p++];
+            }
+            else if(b1 == QOI_OP_RGBA)
+            {
+                if(p + 4 > end)
+                    break;
+                r = data[p++];
+                g = data[p++];
+                b = data[p++];
+                a = data[p++];
+            }
+            else if((b1 & QOI_MASK_2) == QOI_OP_INDEX)
+            {
+                r = index[b1][0];
+                g = index[b1][1];
+                b = index[b1][2];
+                a = index[b1][3];
+            }
+            else if((b1 & QOI_MASK_2) == QOI_OP_DIFF)
+            {
+                r += ((b1 >> 4) & 3) - 2;
+                g += ((b1 >> 2) & 3) - 2;
+                b += (b1 & 3) - 2;
+            }
+            else if((b1 & QOI_MASK_2) == QOI_OP_LUMA)
+            {
+                if(p >= end)
+                    break;
+                b2 = data[p++];
+                vg = (b1 & 0x3f) - 32;
+                r += vg - 8 + ((b2 >> 4) & 0x0f);
+                g += vg;
+                b += vg - 8 + (b2 & 0x0f);
+            }
+            else
+                run = b1 & 0x3f;
+
+            index[QOI_HASH(r, g, b, a)][0] = r;
+            index[QOI_HASH(r, g, b, a)][1] = g;
+            index[QOI_HASH(r, g, b, a)][2] = b;
+            index[QOI_HASH(r, g, b, a)][3] = a;
+        }
+
+        *o++ = r;
+        *o++ = g;
+        *o++ = b;
+    }
+
+    if(i < count)
+    {
+        free(buf);
+        return -1;
+    }
+
+    *pixels = buf;
+
+    return SHOT_FORMAT_QOI;
+}
+
+static int encodeBmp(uint8_t **out, size_t *out_len, const uint8_t *pixels, uint32_t w, uint32_t h, uint32_t pitch)
+{
+    size_t stride = ((size_t)w * 3 + 3) & ~(size_t)3, size;
+    const uint8_t *px;
+    uint8_t *buf, *o;
+    uint32_t x, y;
+
+    if(!sizeFits(w, h, 4, BMP_HEADER_SIZE) || (size_t)h * stride > 0xFFFFFFFF - BMP_HEADER_SIZE)
+        return SPNG_EOVERFLOW;
+
+    size = BMP_HEADER_SIZE + (size_t)h * stride;
+    buf = (uint8_t *)calloc(size, 1);
+    if(!buf)
+        return SPNG_EMEM;
+
+    /* BITMAPFILEHEADER */
+    buf[0] = 'B';
+    buf[1] = 'M';
+    putLe32(buf + 2, (uint32_t)size);
+    putLe32(buf + 10, BMP_HEADER_SIZE);
+
+    /* BITMAPINFOHEADER, the rows go from the bottom for the oldest viewers */
+    putLe32(buf + 14, 40);
+    putLe32(buf + 18, w);
+    putLe32(buf + 22, h);
+    putLe16(buf + 26, 1);
+    putLe16(buf + 28, 24);
+    putLe32(buf + 34, (uint32_t)(size - BMP_HEADER_SIZE));
+    putLe32(buf + 38, 2835); /* 72 DPI */
+    putLe32(buf + 42, 2835);
+
+    for(y = 0; y < h; ++y)
+    {
+        px = pixels + (size_t)(h - 1 - y) * pitch;
+        o = buf + BMP_HEADER_SIZE + (size_t)y * stride;
+
+        for(x = 0; x < w; ++x, px += 3)
+        {
+            *o++ = px[2];
+            *o++ = px[1];
+            *o++ = px[0];
+        }
+    }
+
+    *out = buf;
+    *out_len = size;
+
+    return 0;
+}
+
+static int decodeBmp(const uint8_t *data, size_t len, uint8_t **pixels, uint32_t *w, uint32_t *h)
+{
+    uint32_t x, y, offset, height;
+    size_t stride;
+    const uint8_t *px;
+    uint8_t *buf, *o;
+    int topDown;
+
+    if(len < BMP_HEADER_SIZE || data[0] != 'B' || data[1] != 'M')
+        return -1;
+
+    /* Only the uncompressed 24-bit files like the ones made above */
+    if(getLe32(data + 14) < 40 || getLe16(data + 26) != 1 || getLe16(data + 28) != 24 || getLe32(data + 30) != 0)
+        return -1;
+
+    offset = getLe32(data + 10);
+    *w = getLe32(data + 18);
+    height = getLe32(data + 22);
+    topDown = (height & 0x80000000) != 0;
+    *h = topDown ? (uint32_t)0 - height : height;
+
+    if(!sizeFits(*w, *h, 4, 0))
+        return -1;
+
+    stride = ((size_t)*w * 3 + 3) & ~(size_t)3;
+    if(offset > len || (len - offset) / stride < *h)
+        return -1;
+
+    buf = (uint8_t *)malloc((size_t)*w * *h * 3);
+    if(!buf)
+        return -1;
+
+    o = buf;
+    for(y = 0; y < *h; ++y)
+    {
+        px = data + offset + (size_t)(topDown ? y : *h - 1 - y) * stride;
+
+        for(x = 0; x < *w; ++x, px += 3)
+        {
+            *o++ = px[2];
+            *o++ = px[1];
+            *o++ = px[0];
+        }
+    }
+
+    *pixels = buf;
+
+    return SHOT_FORMAT_BMP;
+}
+
+static int encodeTga(uint8_t **out, size_t *out_len, const uint8_t *pixels, uint32_t w, uint32_t h, uint32_t pitch)
+{
+    const uint8_t *px;
+    uint8_t *buf, *o;
+    uint32_t x, y;
+
+    if(w > 0xFFFF || h > 0xFFFF)
+        return SPNG_EWIDTH;
+
+    if(!sizeFits(w, h, 3, TGA_HEADER_SIZE))
+        return SPNG_EOVERFLOW;
+
+    buf = (uint8_t *)calloc((size_t)w * h * 3 + TGA_HEADER_SIZE, 1);
+    if(!buf)
+        return SPNG_EMEM;
+
+    buf[2] = 2; /* Uncompressed true-colour */
+    putLe16(buf + 12, w);
+    putLe16(buf + 14, h);
+    buf[16] = 24;
+    buf[17] = 0x20; /* The rows go from the top */
+
+    o = buf + TGA_HEADER_SIZE;
+    for(y = 0; y < h; ++y)
+    {
+        px = pixels + (size_t)y * pitch;
+
+        for(x = 0; x < w; ++x, px += 3)
+        {
+            *o++ = px[2];
+            *o++ = px[1];
+            *o++ = px[0];
+        }
+    }
+
+    *out = buf;
+    *out_len = (size_t)w * h * 3 + TGA_HEADER_SIZE;
+
+    return 0;
+}
+
+static int decodeTga(const uint8_t *data, size_t len, uint8_t **pixels, uint32_t *w, uint32_t *h)
+{
+    const uint8_t *px, *start;
+    uint8_t *buf, *o;
+    uint32_t x, y;
+    int topDown;
+
+    if(len < TGA_HEADER_SIZE || data[1] != 0 || data[2] != 2 || data[16] != 24 || len < (size_t)TGA_HEADER_SIZE + data[0])
+        return -1;
+
+    *w = getLe16(data + 12);
+    *h = getLe16(data + 14);
+    topDown = (data[17] & 0x20) != 0;
+    start = data + TGA_HEADER_SIZE + data[0]; /* Skip the image ID */
+
+    if(!sizeFits(*w, *h, 3, 0) || (size_t)(data + len - start) / 3 / *w < *h)
+        return -1;
+
+    buf = (uint8_t *)malloc((size_t)*w * *h * 3);
+    if(!buf)
+        return -1;
+
+    o = buf;
+    for(y = 0; y < *h; ++y)
+    {
+        px = start + (size_t)(topDown ? y : *h - 1 - y) * *w * 3;
+
+        for(x = 0; x < *w; ++x, px += 3)
+        {
+            *o++ = px[2];
+            *o++ = px[1];
+            *o++ = px[0];
+        }
+    }
+
+    *pixels = buf;
+
+    return SHOT_FORMAT_TGA;
+}
+
+int shotFormat_encode(int format, uint8_t **out, size_t *out_len,
+                      const uint8_t *pixels, uint32_t w, uint32_t h, uint32_t pitch,
+                      int workers, const PngPreset *preset)
+{
+    *out = NULL;
+    *out_len = 0;
+
+    switch(format)
+    {
+    case SHOT_FORMAT_QOI:
+        return encodeQoi(out, out_len, pixels, w, h, pitch);
+    case SHOT_FORMAT_BMP:
+        return encodeBmp(out, out_len, pixels, w, h, pitch);
+    case SHOT_FORMAT_TGA:
+        return encodeTga(out, out_len, pixels, w, h, pitch);
+    default:
+        return pngStripes_encodeToBuffer(out, out_len, pixels, w, h, pitch, 3, workers, preset);
+    }
+}
+
+int shotFormat_decode(const uint8_t *data, size_t len, uint8_t **pixels, uint32_t *w, uint32_t *h)
+{
+    *pixels = NULL;
+
+    if(len >= 4 && memcmp(data, "qoif", 4) == 0)
+        return decodeQoi(data, len, pixels, w, h);
+
+    if(len >= 2 && data[0] == 'B' && data[1] == 'M')
+        return decodeBmp(data, len, pixels, w, h);
+
+    /* TGA has no signature, it goes the last */
+    return decodeTga(data, len, pixels, w, h);
+}
+
+/* Decode the PNG and compare it with the packed RGB rows */
+static int pngEquals(const uint8_t *png, size_t png_len, const uint8_t *pixels, uint32_t w, uint32_t h)
+{
+    struct spng_ihdr ihdr;
+    spng_ctx *ctx;
+    uint8_t *dec = NULL;
+    size_t len = 0;
+    int equal = 0;
+
+    ctx = spng_ctx_new(0);
+    if(!ctx)
+        return 0;
+
+    if(spng_set_png_buffer(ctx, png, png_len) == 0 && spng_get_ihdr(ctx, &ihdr) == 0 &&
+       ihdr.width == w && ihdr.height == h &&
+       spng_decoded_image_size(ctx, SPNG_FMT_RGB8, &len) == 0 && len == (size_t)w * h * 3)
+    {
+        dec = (uint8_t *)malloc(len);
+        equal = dec && spng_decode_image(ctx, dec, len, SPNG_FMT_RGB8, 0) == 0 && memcmp(dec, pixels, len) == 0;
+    }
+
+    if(dec)
+        free(dec);
+    spng_ctx_free(ctx);
+
+    return equal;
+}
+
+int shotFormat_convertToPng(const uint8_t *data, size_t len, uint8_t **png, size_t *png_len,
+                            int workers, const PngPreset *preset)
+{
+    uint8_t *pixels = NULL, *again = NULL;
+    size_t againLen = 0;
+    uint32_t w, h;
+    int format, ret;
+
+    *png = NULL;
+    *png_len = 0;
+
+    format = shotFormat_decode(data, len, &pixels, &w, &h);
+    if(format < 0)
+        return -1;
+
+    /* The bug in the decoder or the encoder that made the file would lose the original pixels */
+    ret = shotFormat_encode(format, &again, &againLen, pixels, w, h, w * 3, 1, NULL);
+    if(!ret && (againLen != len || memcmp(again, data, len) != 0))
+        ret = -2;
+
+    if(again)
+        free(again);
+
+    if(!ret)
+        ret = pngStripes_encodeToBuffer(png, png_len, pixels, w, h, w * 3, 3, workers, preset);
+
+    if(!ret && !pngEquals(*png, *png_len, pixels, w, h))
+        ret = -2;
+
+    free(pixels);
+
+    if(ret && *png)
+    {
+        free(*png);
+        *png = NULL;
+        *png_len = 0;
+    }
+
+    return ret;
+}
@@ -0,0 +1,118 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SHOT_FORMAT_H
+#define SHOT_FORMAT_H
+
+/*
+ * File formats the shot can be saved in. PNG takes the most of the CPU time
+ * to compress, the others are written almost at the speed of the disk:
+ * - QOI: the simple lossless compression, 2-4 times bigger than PNG on the
+ *   screen contents, but many times faster to make (https://qoiformat.org).
+ * - BMP and TGA: no compression at all, understood by any old image viewer.
+ *
+ * The files of the fast formats written by shotFormat_encode() can be read
+ * back by shotFormat_decode() to convert them into PNG later.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "png_preset.h"
+
+enum ShotFormat
+{
+    SHOT_FORMAT_PNG = 0,
+    SHOT_FORMAT_QOI,
+    SHOT_FORMAT_BMP,
+    SHOT_FORMAT_TGA,
+    SHOT_FORMAT_COUNT
+};
+
+/**
+ * @brief Find the format by name
+ * @param name Name of the format (case-insensitive), like "qoi"
+ * @return Format ID, or SHOT_FORMAT_PNG if name is unknown
+ */
+int shotFormat_fromName(const char *name);
+
+/**
+ * @brief Get the name of the format used in the config file
+ * @param format Format ID
+ * @return Name of the format, "png" for invalid values
+ */
+const char *shotFormat_name(int format);
+
+/**
+ * @brief Get the file name extension of the format
+ * @param format Format ID
+ * @return Extension with the dot, like ".qoi", ".png" for invalid values
+ */
+const char *shotFormat_extension(int format);
+
+/**
+ * @brief Encode the 8-bit RGB image into the memory buffer
+ * @param format Format ID
+ * @param out Receives the buffer allocated by malloc(), the caller should free() it
+ * @param out_len Receives the size of the data
+ * @param pixels Pixel data
+ * @param w Width of the image
+ * @param h Height of the image
+ * @param pitch Length of one row in bytes
+ * @param workers Number of the PNG encoding workers, unused by other formats
+ * @param preset PNG compression preset, unused by other formats
+ * @return 0 on success, or SPNG error code
+ */
+int shotFormat_encode(int format, uint8_t **out, size_t *out_len,
+                      const uint8_t *pixels, uint32_t w, uint32_t h, uint32_t pitch,
+                      int workers, const PngPreset *preset);
+
+/**
+ * @brief Decode the QOI, BMP or TGA file made by shotFormat_encode() into the 8-bit RGB image
+ * @param data Contents of the file
+ * @param len Size of the file
+ * @param pixels Receives the packed rows allocated by malloc(), the caller should free() it
+ * @param w Receives the width of the image
+ * @param h Receives the height of the image
+ * @return Format of the file, or -1 if the file is not recognized or damaged
+ */
+int shotFormat_decode(const uint8_t *data, size_t len, uint8_t **pixels, uint32_t *w, uint32_t *h);
+
+/**
+ * @brief Convert the QOI, BMP or TGA file made by shotFormat_encode() into PNG, checking every step,
+ * so the original file may be deleted afterwards: the decoded pixels must give the same file when
+ * encoded again, and the PNG must decode into the same pixels
+ * @param data Contents of the file
+ * @param len Size of the file
+ * @param png Receives the PNG file allocated by malloc(), the caller should free() it
+ * @param png_len Receives the size of the PNG file
+ * @param workers Number of the PNG encoding workers
+ * @param preset PNG compression preset
+ * @return 0 on success, -1 if the file is not recognized or damaged, -2 if the check has failed,
+ * or SPNG error code
+ */
+int shotFormat_convertToPng(const uint8_t *data, size_t len, uint8_t **png, size_t *png_len,
+                            int workers, const PngPreset *preset);
+
+#endif /* SHOT_FORMAT_H */
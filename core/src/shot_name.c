@@ -0,0 +1,91 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "shot_name.h"
+#include "shot_format.h"
+#include "core_sys.h"
+
+
+static int fileExists(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+
+    if(!f)
+        return 0;
+
+    fclose(f);
+    return 1;
+}
+
+/* The same name in any other format is taken too, the fast formats get converted into PNG later */
+static int nameTaken(char *out, const char *ext)
+{
+    size_t len = strlen(out), extLen = strlen(ext);
+    char *end = out + len - extLen;
+    int i, taken = 0;
+
+    if(len < extLen)
+        return fileExists(out);
+
+    for(i = 0; i < SHOT_FORMAT_COUNT && !taken; ++i)
+    {
+        /* The extension must fit into the place of the given one */
+        if(strlen(shotFormat_extension(i)) > extLen)
+            continue;
+
+        strcpy(end, shotFormat_extension(i));
+        taken = fileExists(out);
+    }
+
+    strcpy(end, ext);
+
+    return taken || fileExists(out);
+}
+
+void shotName_generate(char *out, size_t out_size, const char *dir, const ShotTime *time, const char *ext)
+{
+    unsigned diff = 0;
+    FILE *f;
+
+    snprintf(out, out_size, "%s%cScr_%04u-%02u-%02u_%02u-%02u-%02u%s",
+             dir, CORE_PATH_SEP,
+             time->year, time->month, time->day,
+             time->hour, time->minute, time->second, ext);
+
+    while(nameTaken(out, ext))
+    {
+        snprintf(out, out_size, "%s%cScr_%04u-%02u-%02u_%02u-%02u-%02u-%u%s",
+                 dir, CORE_PATH_SEP,
+                 time->year, time->month, time->day,
+                 time->hour, time->minute, time->second, ++diff, ext);
+    }
+
+    /* Truncate filename to avoid races */
+    f = fopen(out, "wb");
+    if(f)
+        fclose(f);
+}
@@ -0,0 +1,54 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SHOT_NAME_H
+#define SHOT_NAME_H
+
+#include <stddef.h>
+
+/* Local time of the shot */
+typedef struct tagShotTime
+{
+    unsigned year;
+    unsigned month;
+    unsigned day;
+    unsigned hour;
+    unsigned minute;
+    unsigned second;
+} ShotTime;
+
+/**
+ * @brief Make the unique file name like Scr_2025-01-31_23-59-59.png, the -N suffix is added when
+ * the file already exists. The empty file gets created to keep the name reserved.
+ * @param out Receives the full path
+ * @param out_size Size of the output buffer
+ * @param dir Directory to save the shot into
+ * @param time Time of the shot
+ * @param ext Extension of the file with the dot, like ".png". The name is taken when the file
+ * with it or with the extension of any other ShotFormat exists, so the file can be converted
+ * into PNG later
+ */
+void shotName_generate(char *out, size_t out_size, const char *dir, const ShotTime *time, const char *ext);
+
+#endif /* SHOT_NAME_H */
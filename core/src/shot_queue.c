@@ -0,0 +1,245 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "shot_queue.h"
+
+
+static const char *s_queuePolicyNames[QUEUE_POLICY_COUNT] =
+{
+    "drop-newest",
+    "drop-oldest",
+    "coalesce",
+    "degrade"
+};
+
+void shotQueue_init(ShotQueue *queue)
+{
+    memset(queue, 0, sizeof(ShotQueue));
+    coreMutex_init(&queue->mutex);
+    coreMutex_init(&queue->doneMutex);
+}
+
+void shotQueue_free(ShotQueue *queue)
+{
+    coreMutex_destroy(&queue->mutex);
+    coreMutex_destroy(&queue->doneMutex);
+}
+
+/* Must be called with the locked mutex */
+static ShotQueueItem *queue_unlinkHead(ShotQueue *queue)
+{
+    ShotQueueItem *ret = queue->begin;
+
+    queue->begin = ret->next;
+
+    if(!queue->begin) /* Reached end of queue */
+        queue->end = NULL;
+    else
+        queue->begin->prev = NULL;
+
+    ret->next = NULL;
+
+    return ret;
+}
+
+int shotQueue_insert(ShotQueue *queue, ShotQueueItem *item, size_t budget, int policy, ShotQueueItem **dropped)
+{
+    ShotQueueItem *next;
+    int accept = 1;
+
+    *dropped = NULL;
+    item->next = NULL;
+    item->prev = NULL;
+
+    coreMutex_lock(&queue->mutex);
+
+    if(budget > 0 && queue->begin && queue->bytes + item->bytes > budget)
+    {
+        switch(policy)
+        {
+        case QUEUE_DROP_OLDEST:
+            while(queue->begin && queue->bytes + item->bytes > budget)
+            {
+                next = queue_unlinkHead(queue);
+                queue->count--;
+                queue->bytes -= next->bytes;
+                next->next = *dropped;
+                *dropped = next;
+            }
+            break;
+
+        case QUEUE_COALESCE:
+            /* The burst of shots collapses into the latest one: all frames still waiting are dropped */
+            while(queue->begin)
+            {
+                next = queue_unlinkHead(queue);
+                queue->count--;
+                queue->bytes -= next->bytes;
+                next->next = *dropped;
+                *dropped = next;
+            }
+            break;
+
+        case QUEUE_DEGRADE:
+            /* Compress faster to drain the queue, allow it to grow up to twice of the budget */
+            queue->degraded = 1;
+            accept = queue->bytes + item->bytes <= budget * 2;
+            break;
+
+        default:
+        case QUEUE_DROP_NEWEST:
+            accept = 0;
+            break;
+        }
+    }
+
+    if(accept)
+    {
+        if(!queue->begin) /* First item */
+        {
+            queue->begin = item;
+            queue->end = item;
+        }
+        else
+        {
+            queue->end->next = item;
+            item->prev = queue->end;
+            queue->end = item;
+        }
+
+        queue->count++;
+        queue->bytes += item->bytes;
+    }
+
+    coreMutex_unlock(&queue->mutex);
+
+    return accept;
+}
+
+ShotQueueItem *shotQueue_get(ShotQueue *queue)
+{
+    ShotQueueItem *ret = NULL;
+
+    coreMutex_lock(&queue->mutex);
+
+    if(queue->begin)
+    {
+        ret = queue_unlinkHead(queue);
+        ret->degraded = queue->degraded;
+        ret->seq = queue->seqTaken++;
+    }
+
+    coreMutex_unlock(&queue->mutex);
+
+    return ret;
+}
+
+void shotQueue_done(ShotQueue *queue, ShotQueueItem *item, size_t budget)
+{
+    coreMutex_lock(&queue->mutex);
+
+    queue->count--;
+    queue->bytes -= item->bytes;
+
+    if(queue->bytes <= budget / 2)
+        queue->degraded = 0;
+
+    coreMutex_unlock(&queue->mutex);
+}
+
+/*
+ * Savers finish frames in any order, but files must reach the FTP sender
+ * in the order of shots. Every finished frame waits in the sorted list
+ * until all frames taken before it are also finished.
+ */
+void shotQueue_handOver(ShotQueue *queue, ShotQueueItem *item, ShotQueueHandOver handOver, void *user)
+{
+    ShotQueueItem **it;
+    ShotQueueItem *ready = NULL, *ready_end = NULL, *next;
+
+    coreMutex_lock(&queue->doneMutex);
+
+    it = &queue->done;
+    while(*it && (*it)->seq < item->seq)
+        it = &(*it)->next;
+    item->next = *it;
+    *it = item;
+
+    while(queue->done && queue->done->seq == queue->seqHanded)
+    {
+        next = queue->done;
+        queue->done = next->next;
+        next->next = NULL;
+        queue->seqHanded++;
+
+        if(ready_end)
+            ready_end->next = next;
+        else
+            ready = next;
+        ready_end = next;
+    }
+
+    /* Keep the mutex locked while passing the frames: an another saver must not overtake these */
+    while(ready)
+    {
+        next = ready->next;
+        handOver(ready, user);
+        ready = next;
+    }
+
+    coreMutex_unlock(&queue->doneMutex);
+}
+
+void shotQueue_status(ShotQueue *queue, int *count, size_t *bytes)
+{
+    coreMutex_lock(&queue->mutex);
+
+    *count = queue->count;
+    *bytes = queue->bytes;
+
+    coreMutex_unlock(&queue->mutex);
+}
+
+int shotQueue_policyFromName(const char *name)
+{
+    int i;
+
+    for(i = 0; i < QUEUE_POLICY_COUNT; ++i)
+    {
+        if(coreSys_strcasecmp(name, s_queuePolicyNames[i]) == 0)
+            return i;
+    }
+
+    return QUEUE_DROP_NEWEST;
+}
+
+const char *shotQueue_policyName(int policy)
+{
+    if(policy < 0 || policy >= QUEUE_POLICY_COUNT)
+        policy = QUEUE_DROP_NEWEST;
+
+    return s_queuePolicyNames[policy];
+}
@@ -0,0 +1,121 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SHOT_QUEUE_H
+#define SHOT_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core_sys.h"
+
+/* What to do when the save queue exceeds the memory budget */
+enum ShotQueuePolicy
+{
+    /* Refuse the new shot */
+    QUEUE_DROP_NEWEST = 0,
+    /* Throw away the oldest shots waiting in the queue */
+    QUEUE_DROP_OLDEST,
+    /* Replace all waiting shots with the new one, the shots being saved are kept */
+    QUEUE_COALESCE,
+    /* Switch to the fastest compression, and let the queue grow up to twice of the budget */
+    QUEUE_DEGRADE,
+    QUEUE_POLICY_COUNT
+};
+
+/* Link of the queued frame, must be the first member of the frame structure */
+typedef struct tagShotQueueItem
+{
+    /* Size of the frame in the memory, counted against the budget */
+    size_t bytes;
+    /* Queue was over the budget, use the fastest compression */
+    int degraded;
+    /* Order of taking from the queue, the frames are handed over in this order */
+    uint32_t seq;
+    struct tagShotQueueItem *next;
+    struct tagShotQueueItem *prev;
+} ShotQueueItem;
+
+typedef struct tagShotQueue
+{
+    ShotQueueItem *begin;
+    ShotQueueItem *end;
+    /* Frames in the queue plus the ones being saved right now */
+    int count;
+    size_t bytes;
+    int degraded;
+    CoreMutex mutex;
+
+    /* Saved frames waiting for their turn to be handed over, sorted by seq */
+    ShotQueueItem *done;
+    uint32_t seqTaken;
+    uint32_t seqHanded;
+    CoreMutex doneMutex;
+} ShotQueue;
+
+typedef void (*ShotQueueHandOver)(ShotQueueItem *item, void *user);
+
+void shotQueue_init(ShotQueue *queue);
+void shotQueue_free(ShotQueue *queue);
+
+/**
+ * @brief Put the frame into the queue, a frame is always accepted when nothing else waits for the saver
+ * @param queue Queue
+ * @param item Frame with the bytes field filled
+ * @param budget Memory budget in bytes, 0 means unlimited
+ * @param policy What to do when the budget is exceeded, one of ShotQueuePolicy values
+ * @param dropped Receives the list (linked by the next field) of the frames thrown away from the queue, the caller should free them
+ * @return 1 if the frame is accepted, 0 if the caller should drop it
+ */
+int shotQueue_insert(ShotQueue *queue, ShotQueueItem *item, size_t budget, int policy, ShotQueueItem **dropped);
+
+/**
+ * @brief Take the oldest frame to save, it's still counted by the queue until shotQueue_done()
+ * @return The frame or NULL if the queue is empty
+ */
+ShotQueueItem *shotQueue_get(ShotQueue *queue);
+
+/**
+ * @brief The saver has finished with the frame taken by shotQueue_get()
+ * @param budget Memory budget in bytes, the degraded mode ends once the queue drains to half of it
+ */
+void shotQueue_done(ShotQueue *queue, ShotQueueItem *item, size_t budget);
+
+/**
+ * @brief Pass the saved frames in the order of taking: the frame waits until all frames taken before it are passed too
+ * @param item Saved frame
+ * @param handOver Called for every frame whose turn has come, it takes the ownership of the frame
+ * @param user Argument of the callback
+ */
+void shotQueue_handOver(ShotQueue *queue, ShotQueueItem *item, ShotQueueHandOver handOver, void *user);
+
+/**
+ * @brief Get the number of frames waiting for the saver (including the ones being saved) and their size in memory
+ */
+void shotQueue_status(ShotQueue *queue, int *count, size_t *bytes);
+
+int shotQueue_policyFromName(const char *name);
+const char *shotQueue_policyName(int policy);
+
+#endif /* SHOT_QUEUE_H */
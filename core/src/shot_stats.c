@@ -0,0 +1,348 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "shot_stats.h"
+#include "core_sys.h"
+
+/* Upper limits of the histogram buckets in milliseconds, the last bucket takes everything above */
+static const uint32_t s_bucketLimits[SHOT_STATS_BUCKETS - 1] =
+{
+    1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000
+};
+
+static ShotStats s_stats;
+static uint64_t s_startTime = 0;
+static CoreMutex s_mutex;
+static int s_enabled = 0;
+
+void shotStats_init(void)
+{
+    if(s_enabled)
+        return;
+
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_startTime = coreSys_timeUs();
+    coreMutex_init(&s_mutex);
+    s_enabled = 1;
+}
+
+void shotStats_quit(void)
+{
+    if(!s_enabled)
+        return;
+
+    s_enabled = 0;
+    coreMutex_destroy(&s_mutex);
+}
+
+static void histogram_add(ShotStatsHistogram *h, uint32_t ms)
+{
+    int i;
+
+    for(i = 0; i < SHOT_STATS_BUCKETS - 1; ++i)
+    {
+        if(ms <= s_bucketLimits[i])
+            break;
+    }
+
+    h->buckets[i]++;
+    h->count++;
+    h->sumMs += ms;
+
+    if(ms > h->maxMs)
+        h->maxMs = ms;
+}
+
+void shotStats_shotTaken(void)
+{
+    if(!s_enabled)
+        return;
+
+    coreMutex_lock(&s_mutex);
+    s_stats.shotsTaken++;
+    coreMutex_unlock(&s_mutex);
+}
+
+void shotStats_shotDropped(void)
+{
+    if(!s_enabled)
+        return;
+
+    coreMutex_lock(&s_mutex);
+    s_stats.shotsDropped++;
+    coreMutex_unlock(&s_mutex);
+}
+
+void shotStats_shotSkipped(void)
+{
+    if(!s_enabled)
+        return;
+
+    coreMutex_lock(&s_mutex);
+    s_stats.shotsSkipped++;
+    coreMutex_unlock(&s_mutex);
+}
+
+void shotStats_shotSaved(uint32_t encodeMs, size_t bytes)
+{
+    if(!s_enabled)
+        return;
+
+    coreMutex_lock(&s_mutex);
+    s_stats.shotsSaved++;
+    s_stats.bytesWritten += (double)bytes;
+    histogram_add(&s_stats.encode, encodeMs);
+    coreMutex_unlock(&s_mutex);
+}
+
+void shotStats_uploaded(uint32_t uploadMs, size_t bytes)
+{
+    if(!s_enabled)
+        return;
+
+    coreMutex_lock(&s_mutex);
+    s_stats.uploadsDone++;
+    s_stats.bytesUploaded += (double)bytes;
+    histogram_add(&s_stats.upload, uploadMs);
+    coreMutex_unlock(&s_mutex);
+}
+
+void shotStats_uploadFailed(void)
+{
+    if(!s_enabled)
+        return;
+
+    coreMutex_lock(&s_mutex);
+    s_stats.uploadsFailed++;
+    coreMutex_unlock(&s_mutex);
+}
+
+void shotStats_burstStarted(uint32_t intervalMs)
+{
+    if(!s_enabled)
+        return;
+
+    coreMutex_lock(&s_mutex);
+    s_stats.bursts++;
+    s_stats.burstFrames = 0;
+    s_stats.burstDropped = 0;
+    s_stats.burstIntervalMs = intervalMs;
+    s_stats.burstElapsedMs = 0;
+    coreMutex_unlock(&s_mutex);
+}
+
+void shotStats_burstProgress(uint32_t frames, uint32_t dropped, uint32_t elapsedMs)
+{
+    if(!s_enabled)
+        return;
+
+    coreMutex_lock(&s_mutex);
+    s_stats.burstFrames = frames;
+    s_stats.burstDropped = dropped;
+    s_stats.burstElapsedMs = elapsedMs;
+    coreMutex_unlock(&s_mutex);
+}
+
+void shotStats_get(ShotStats *out)
+{
+    memset(out, 0, sizeof(ShotStats));
+
+    if(!s_enabled)
+        return;
+
+    coreMutex_lock(&s_mutex);
+    *out = s_stats;
+    coreMutex_unlock(&s_mutex);
+
+    out->uptime = (uint32_t)((coreSys_timeUs() - s_startTime) / 1000000);
+}
+
+uint32_t shotStats_average(const ShotStatsHistogram *h)
+{
+    return h->count > 0 ? (uint32_t)(h->sumMs / h->count + 0.5) : 0;
+}
+
+uint32_t shotStats_percentile(const ShotStatsHistogram *h, int pct)
+{
+    uint32_t rank, seen = 0, low, high;
+    int i;
+
+    if(h->count == 0)
+        return 0;
+
+    if(pct < 1)
+        pct = 1;
+    if(pct > 100)
+        pct = 100;
+
+    /* Rank of the value in the sorted list, counted from 1 */
+    rank = (uint32_t)(((double)h->count * pct + 99) / 100);
+
+    for(i = 0; i < SHOT_STATS_BUCKETS; ++i)
+    {
+        if(seen + h->buckets[i] >= rank)
+            break;
+        seen += h->buckets[i];
+    }
+
+    if(i >= SHOT_STATS_BUCKETS)
+        return h->maxMs;
+
+    /* The values are assumed to be spread evenly over the bucket */
+    low = i > 0 ? s_bucketLimits[i - 1] : 0;
+    high = i < SHOT_STATS_BUCKETS - 1 ? s_bucketLimits[i] : h->maxMs;
+    if(high > h->maxMs)
+        high = h->maxMs;
+    if(high < low)
+        return high;
+
+    return low + (uint32_t)((double)(high - low) * (rank - seen) / h->buckets[i] + 0.5);
+}
+
+void shotStats_formatTip(const ShotStats *s, char *out, size_t size)
+{
+    char buf[128];
+
+    sprintf(buf, "TinyShot: %lu shots, enc %lu/%lu ms, queue %d",
+            (unsigned long)s->shotsTaken,
+            (unsigned long)shotStats_average(&s->encode),
+            (unsigned long)shotStats_percentile(&s->encode, 95),
+            s->queueDepth);
+
+    if(s->uploadsPending > 0 || s->uploadsFailed > 0)
+        sprintf(buf + strlen(buf), ", up %d, %lu failed", s->uploadsPending, (unsigned long)s->uploadsFailed);
+
+    if(size == 0)
+        return;
+
+    strncpy(out, buf, size - 1);
+    out[size - 1] = '\0';
+}
+
+void shotStats_burstRate(const ShotStats *s, double *requested, double *achieved)
+{
+    *requested = s->burstIntervalMs > 0 ? 1000.0 / s->burstIntervalMs : 0.0;
+    *achieved = s->burstElapsedMs > 0 ? (s->burstFrames - s->burstDropped) * 1000.0 / s->burstElapsedMs : 0.0;
+}
+
+void shotStats_formatBurstTip(const ShotStats *s, char *out, size_t size)
+{
+    char buf[128];
+    double requested, achieved;
+
+    shotStats_burstRate(s, &requested, &achieved);
+
+    sprintf(buf, "TinyShot: burst %lu frames, %.1f of %.1f fps, %lu dropped",
+            (unsigned long)s->burstFrames, achieved, requested, (unsigned long)s->burstDropped);
+
+    if(size == 0)
+        return;
+
+    strncpy(out, buf, size - 1);
+    out[size - 1] = '\0';
+}
+
+static void writeHistogram(FILE *f, const char *name, const ShotStatsHistogram *h)
+{
+    int i;
+
+    fprintf(f, "  \"%s\": {\"count\": %lu, \"avg_ms\": %lu, \"p50_ms\": %lu, \"p95_ms\": %lu, \"max_ms\": %lu,\n",
+            name, (unsigned long)h->count, (unsigned long)shotStats_average(h),
+            (unsigned long)shotStats_percentile(h, 50), (unsigned long)shotStats_percentile(h, 95),
+            (unsigned long)h->maxMs);
+
+    fprintf(f, "    \"buckets\": [");
+    for(i = 0; i < SHOT_STATS_BUCKETS; ++i)
+    {
+        if(i < SHOT_STATS_BUCKETS - 1)
+            fprintf(f, "%s{\"le_ms\": %lu, \"count\": %lu}", i > 0 ? ", " : "",
+                    (unsigned long)s_bucketLimits[i], (unsigned long)h->buckets[i]);
+        else
+            fprintf(f, ", {\"le_ms\": null, \"count\": %lu}", (unsigned long)h->buckets[i]);
+    }
+    fprintf(f, "]}");
+}
+
+int shotStats_writeJson(const ShotStats *s, const char *path)
+{
+    char tmpPath[1024];
+    double requested, achieved;
+    FILE *f;
+    int ok;
+
+    if(strlen(path) + 5 > sizeof(tmpPath))
+        return 0;
+
+    /* Readers never see the half-written file */
+    sprintf(tmpPath, "%s.tmp", path);
+
+    f = fopen(tmpPath, "w");
+    if(!f)
+        return 0;
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"uptime_s\": %lu,\n", (unsigned long)s->uptime);
+    fprintf(f, "  \"shots_taken\": %lu,\n", (unsigned long)s->shotsTaken);
+    fprintf(f, "  \"shots_dropped\": %lu,\n", (unsigned long)s->shotsDropped);
+    fprintf(f, "  \"shots_skipped\": %lu,\n", (unsigned long)s->shotsSkipped);
+    fprintf(f, "  \"shots_saved\": %lu,\n", (unsigned long)s->shotsSaved);
+    fprintf(f, "  \"bytes_written\": %.0f,\n", s->bytesWritten);
+    fprintf(f, "  \"queue_depth\": %d,\n", s->queueDepth);
+    fprintf(f, "  \"queue_bytes\": %lu,\n", (unsigned long)s->queueBytes);
+    fprintf(f, "  \"uploads_done\": %lu,\n", (unsigned long)s->uploadsDone);
+    fprintf(f, "  \"uploads_failed\": %lu,\n", (unsigned long)s->uploadsFailed);
+    fprintf(f, "  \"uploads_pending\": %d,\n", s->uploadsPending);
+    fprintf(f, "  \"bytes_uploaded\": %.0f,\n", s->bytesUploaded);
+    fprintf(f, "  \"bursts\": %lu,\n", (unsigned long)s->bursts);
+    if(s->bursts > 0)
+    {
+        shotStats_burstRate(s, &requested, &achieved);
+        fprintf(f, "  \"last_burst\": {\"frames\": %lu, \"dropped\": %lu, \"elapsed_ms\": %lu, "
+                   "\"requested_fps\": %.2f, \"achieved_fps\": %.2f},\n",
+                (unsigned long)s->burstFrames, (unsigned long)s->burstDropped, (unsigned long)s->burstElapsedMs,
+                requested, achieved);
+    }
+    writeHistogram(f, "encode", &s->encode);
+    fprintf(f, ",\n");
+    writeHistogram(f, "upload", &s->upload);
+    fprintf(f, "\n}\n");
+
+    ok = !ferror(f);
+    if(fclose(f) != 0)
+        ok = 0;
+
+    if(!ok)
+    {
+        remove(tmpPath);
+        return 0;
+    }
+
+    /* Windows can't rename over the existing file */
+    remove(path);
+
+    return rename(tmpPath, path) == 0;
+}
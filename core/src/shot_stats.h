@@ -0,0 +1,172 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SHOT_STATS_H
+#define SHOT_STATS_H
+
+/*
+ * Counters of the saved and uploaded shots with the histograms of the encode
+ * and upload times. They are updated by the saver and the sender threads,
+ * and read as the consistent snapshot by shotStats_get().
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Number of the histogram buckets, see s_bucketLimits at shot_stats.c */
+#define SHOT_STATS_BUCKETS  14
+
+struct ShotStatsHistogram
+{
+    uint32_t count;
+    /* Sum of all values in milliseconds, for the average */
+    double sumMs;
+    uint32_t maxMs;
+    uint32_t buckets[SHOT_STATS_BUCKETS];
+};
+
+typedef struct ShotStatsHistogram ShotStatsHistogram;
+
+struct ShotStats
+{
+    /* Seconds since shotStats_init() */
+    uint32_t uptime;
+
+    /* Captured shots, including the dropped ones */
+    uint32_t shotsTaken;
+    /* Shots thrown away because of the full frame pool or the save queue budget */
+    uint32_t shotsDropped;
+    /* Shots not encoded because they are equal to one of the previous shots */
+    uint32_t shotsSkipped;
+    uint32_t shotsSaved;
+    /* Total size of the encoded PNG files */
+    double bytesWritten;
+    ShotStatsHistogram encode;
+
+    uint32_t uploadsDone;
+    /* Failed attempts, including the files that get retried later */
+    uint32_t uploadsFailed;
+    double bytesUploaded;
+    ShotStatsHistogram upload;
+
+    uint32_t bursts;
+    /* The latest burst: frames captured and dropped, the requested interval between them and the time it took */
+    uint32_t burstFrames;
+    uint32_t burstDropped;
+    uint32_t burstIntervalMs;
+    uint32_t burstElapsedMs;
+
+    /* Current state, filled by the caller of shotStats_get() */
+    int queueDepth;
+    size_t queueBytes;
+    int uploadsPending;
+};
+
+typedef struct ShotStats ShotStats;
+
+void shotStats_init(void);
+void shotStats_quit(void);
+
+void shotStats_shotTaken(void);
+void shotStats_shotDropped(void);
+void shotStats_shotSkipped(void);
+
+/**
+ * @brief Count the encoded shot
+ * @param encodeMs Encoding time in milliseconds
+ * @param bytes Size of the PNG file
+ */
+void shotStats_shotSaved(uint32_t encodeMs, size_t bytes);
+
+/**
+ * @brief Count the uploaded file
+ * @param uploadMs Time from the STOR command until the 226 reply in milliseconds
+ * @param bytes Size of the file
+ */
+void shotStats_uploaded(uint32_t uploadMs, size_t bytes);
+
+void shotStats_uploadFailed(void);
+
+/**
+ * @brief Count the new burst and reset the numbers of the latest burst
+ * @param intervalMs Requested interval between the frames in milliseconds
+ */
+void shotStats_burstStarted(uint32_t intervalMs);
+
+/**
+ * @brief Update the numbers of the running burst
+ * @param frames Number of the captured frames, including the dropped ones
+ * @param dropped Number of the frames dropped because of the full ring or the save queue budget
+ * @param elapsedMs Time since the start of the burst in milliseconds
+ */
+void shotStats_burstProgress(uint32_t frames, uint32_t dropped, uint32_t elapsedMs);
+
+/**
+ * @brief Get the rate of the latest burst
+ * @param s Snapshot of the statistics
+ * @param requested Requested rate in frames per second
+ * @param achieved Rate of the frames that were not dropped, in frames per second
+ */
+void shotStats_burstRate(const ShotStats *s, double *requested, double *achieved);
+
+/**
+ * @brief Take the snapshot of the counters, the current state fields are set to zero
+ */
+void shotStats_get(ShotStats *out);
+
+uint32_t shotStats_average(const ShotStatsHistogram *h);
+
+/**
+ * @brief Estimate the percentile of the values from the histogram
+ * @param h Histogram
+ * @param pct Percentile, from 1 to 100
+ * @return Value in milliseconds, 0 for the empty histogram
+ */
+uint32_t shotStats_percentile(const ShotStatsHistogram *h, int pct);
+
+/**
+ * @brief Make the short one-line summary for the tray icon tooltip
+ * @param s Snapshot of the statistics
+ * @param out Output buffer
+ * @param size Size of the output buffer, the text gets cut to fit it
+ */
+void shotStats_formatTip(const ShotStats *s, char *out, size_t size);
+
+/**
+ * @brief Make the tooltip line with the numbers of the latest burst
+ * @param s Snapshot of the statistics
+ * @param out Output buffer
+ * @param size Size of the output buffer, the text gets cut to fit it
+ */
+void shotStats_formatBurstTip(const ShotStats *s, char *out, size_t size);
+
+/**
+ * @brief Write the statistics into the JSON file, the file is replaced at once
+ * @param s Snapshot of the statistics
+ * @param path Path of the file
+ * @return 1 on success, 0 if the file can't be written
+ */
+int shotStats_writeJson(const ShotStats *s, const char *path);
+
+#endif /* SHOT_STATS_H */
@@ -0,0 +1,221 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "shot_trace.h"
+#include "core_sys.h"
+
+static const char *s_pointNames[TRACE_POINT_COUNT] =
+{
+    "hook",
+    "capture",
+    "bitblt",
+    "getdibits",
+    "swizzle",
+    "enqueue",
+    "encode",
+    "encode",
+    "file-written",
+    "ftp-connect",
+    "ftp-stor",
+    "ftp-226",
+    "hash"
+};
+
+static ShotTraceEvent s_ring[SHOT_TRACE_EVENTS];
+/* Total number of the recorded events, the ring position is its remainder */
+static uint32_t s_written = 0;
+static uint32_t s_lastShot = 0;
+static CoreMutex s_mutex;
+static int s_enabled = 0;
+
+void shotTrace_init(void)
+{
+    if(s_enabled)
+        return;
+
+    coreMutex_init(&s_mutex);
+    s_written = 0;
+    s_enabled = 1;
+}
+
+void shotTrace_quit(void)
+{
+    if(!s_enabled)
+        return;
+
+    s_enabled = 0;
+    coreMutex_destroy(&s_mutex);
+}
+
+uint32_t shotTrace_newShot(void)
+{
+    uint32_t shot;
+
+    if(!s_enabled)
+        return 0;
+
+    coreMutex_lock(&s_mutex);
+    shot = ++s_lastShot;
+    coreMutex_unlock(&s_mutex);
+
+    return shot;
+}
+
+void shotTrace_point(int point, uint32_t shot, uint32_t arg)
+{
+    ShotTraceEvent *e;
+    uint64_t now;
+
+    if(!s_enabled)
+        return;
+
+    /* Taken outside of the lock, so the events of different threads may be slightly out of order */
+    now = coreSys_timeUs();
+
+    coreMutex_lock(&s_mutex);
+    e = &s_ring[s_written % SHOT_TRACE_EVENTS];
+    e->time = now;
+    e->shot = shot;
+    e->arg = arg;
+    e->thread = (uint32_t)coreSys_threadId();
+    e->point = (uint16_t)point;
+    e->reserved = 0;
+    ++s_written;
+    coreMutex_unlock(&s_mutex);
+}
+
+const char *shotTrace_pointName(int point)
+{
+    if(point < 0 || point >= TRACE_POINT_COUNT)
+        return "unknown";
+
+    return s_pointNames[point];
+}
+
+/* Copy the ring into the buffer, from the oldest event to the newest */
+static ShotTraceEvent *takeEvents(uint32_t *count)
+{
+    ShotTraceEvent *events;
+    uint32_t first, i;
+
+    events = (ShotTraceEvent *)malloc(sizeof(s_ring));
+    if(!events)
+        return NULL;
+
+    coreMutex_lock(&s_mutex);
+
+    *count = s_written < SHOT_TRACE_EVENTS ? s_written : SHOT_TRACE_EVENTS;
+    first = s_written - *count;
+
+    for(i = 0; i < *count; ++i)
+        events[i] = s_ring[(first + i) % SHOT_TRACE_EVENTS];
+
+    coreMutex_unlock(&s_mutex);
+
+    return events;
+}
+
+static int writeBinary(FILE *f, const ShotTraceEvent *events, uint32_t count)
+{
+    uint32_t header[2];
+
+    header[0] = count;
+    header[1] = (uint32_t)sizeof(ShotTraceEvent);
+
+    if(fwrite(SHOT_TRACE_MAGIC, 1, 8, f) != 8 || fwrite(header, sizeof(header), 1, f) != 1)
+        return 0;
+
+    return count == 0 || fwrite(events, sizeof(ShotTraceEvent), count, f) == count;
+}
+
+static int writeJson(FILE *f, const ShotTraceEvent *events, uint32_t count)
+{
+    const ShotTraceEvent *e;
+    const char *phase;
+    uint64_t start = count > 0 ? events[0].time : 0;
+    uint32_t i;
+
+    fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+
+    for(i = 0; i < count; ++i)
+    {
+        e = &events[i];
+
+        /* Encoding is shown as the slice, other points as the instant marks */
+        if(e->point == TRACE_ENCODE_BEGIN)
+            phase = "\"ph\": \"B\"";
+        else if(e->point == TRACE_ENCODE_END)
+            phase = "\"ph\": \"E\"";
+        else
+            phase = "\"ph\": \"i\", \"s\": \"t\"";
+
+        fprintf(f, "%s{\"name\": \"%s\", %s, \"ts\": %.0f, \"pid\": 1, \"tid\": %lu, "
+                   "\"args\": {\"shot\": %lu, \"arg\": %lu}}",
+                i > 0 ? ",\n" : "",
+                shotTrace_pointName(e->point), phase, (double)(e->time - start),
+                (unsigned long)e->thread, (unsigned long)e->shot, (unsigned long)e->arg);
+    }
+
+    fprintf(f, "\n]}\n");
+
+    return !ferror(f);
+}
+
+int shotTrace_dump(const char *path, int format)
+{
+    ShotTraceEvent *events;
+    uint32_t count = 0;
+    FILE *f;
+    int ok;
+
+    if(!s_enabled)
+        return -1;
+
+    events = takeEvents(&count);
+    if(!events)
+        return -1;
+
+    f = fopen(path, format == TRACE_FORMAT_BINARY ? "wb" : "w");
+    if(!f)
+    {
+        free(events);
+        return -1;
+    }
+
+    if(format == TRACE_FORMAT_BINARY)
+        ok = writeBinary(f, events, count);
+    else
+        ok = writeJson(f, events, count);
+
+    if(fclose(f) != 0)
+        ok = 0;
+
+    free(events);
+
+    return ok ? (int)count : -1;
+}
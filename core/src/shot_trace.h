@@ -0,0 +1,127 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SHOT_TRACE_H
+#define SHOT_TRACE_H
+
+/*
+ * Timestamped trace points of the shot pipeline, from the key press to the
+ * file on disk and the finished upload. The points go into the fixed ring
+ * buffer that keeps the latest SHOT_TRACE_EVENTS of them, and can be dumped
+ * to a file at any moment. Adding a point costs one timer read and one
+ * uncontended lock.
+ */
+
+#include <stdint.h>
+
+/* Number of the events kept in the ring buffer */
+#define SHOT_TRACE_EVENTS   4096
+
+/* Trace points, the values are stored in the binary dump and must not be changed */
+enum ShotTracePoint
+{
+    /* Print Screen key got caught by the hook or the hot key */
+    TRACE_HOOK = 0,
+    /* Screen copy began, the shot gets its number here */
+    TRACE_CAPTURE,
+    TRACE_BITBLT,
+    TRACE_GETDIBITS,
+    /* BGRA pixels were converted into RGB */
+    TRACE_SWIZZLE,
+    /* Frame was put into the save queue, or arg is 0 when it was dropped */
+    TRACE_ENQUEUE,
+    TRACE_ENCODE_BEGIN,
+    TRACE_ENCODE_END,
+    /* PNG file was written and closed */
+    TRACE_FILE_WRITTEN,
+    /* FTP control connection was established */
+    TRACE_FTP_CONNECT,
+    /* STOR command was sent */
+    TRACE_FTP_STOR,
+    /* Server confirmed the upload by 226 reply, arg is the number of bytes */
+    TRACE_FTP_DONE,
+    /* Frame was hashed to find the duplicates, arg is 1 when it repeats one of the previous shots */
+    TRACE_HASH,
+    TRACE_POINT_COUNT
+};
+
+/* One event of the binary dump, stored in the byte order of the machine */
+struct ShotTraceEvent
+{
+    /* Monotonic time in microseconds */
+    uint64_t time;
+    /* Number of the shot, 0 when it's not known yet */
+    uint32_t shot;
+    /* Point specific value */
+    uint32_t arg;
+    uint32_t thread;
+    uint16_t point;
+    uint16_t reserved;
+};
+
+typedef struct ShotTraceEvent ShotTraceEvent;
+
+/*
+ * Binary dump: the 8 bytes SHOT_TRACE_MAGIC, the 32-bit number of events,
+ * the 32-bit size of one event, then the events from the oldest to the newest.
+ */
+#define SHOT_TRACE_MAGIC    "TSTRACE1"
+
+enum ShotTraceFormat
+{
+    /* Chrome trace event JSON, opens by chrome://tracing or ui.perfetto.dev */
+    TRACE_FORMAT_JSON = 0,
+    TRACE_FORMAT_BINARY
+};
+
+void shotTrace_init(void);
+void shotTrace_quit(void);
+
+/**
+ * @brief Get the number for the new shot, to mark its further trace points
+ */
+uint32_t shotTrace_newShot(void);
+
+/**
+ * @brief Record the trace point, does nothing until shotTrace_init() is called
+ * @param point One of ShotTracePoint values
+ * @param shot Number of the shot given by shotTrace_newShot(), or 0
+ * @param arg Point specific value
+ */
+void shotTrace_point(int point, uint32_t shot, uint32_t arg);
+
+/**
+ * @brief Name of the trace point
+ */
+const char *shotTrace_pointName(int point);
+
+/**
+ * @brief Write the recorded events into the file
+ * @param path Path of the file to write
+ * @param format One of ShotTraceFormat values
+ * @return Number of the written events, or -1 if the file can't be written
+ */
+int shotTrace_dump(const char *path, int format);
+
+#endif /* SHOT_TRACE_H */
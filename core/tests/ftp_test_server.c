@@ -0,0 +1,488 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ftp_test_server.h"
+
+/* How often the waiting threads look at the quit flag, in milliseconds */
+#define POLL_SLICE          20
+/* How long to wait for the data connection after STOR, in milliseconds */
+#define DATA_TIMEOUT        5000
+
+enum SessionState
+{
+    SESSION_FREE = 0,
+    SESSION_RUNNING,
+    SESSION_FINISHED
+};
+
+typedef struct tagLineReader
+{
+    char buf[1024];
+    int len;
+} LineReader;
+
+/* Wait for the data, returns 1 when readable, 0 when the server is quitting or the socket is broken */
+static int waitData(FtpTestServer *server, CoreSocket sock, uint32_t timeout)
+{
+    uint32_t waited = 0;
+    int res;
+
+    while(!server->quit)
+    {
+        res = coreNet_waitReadable(sock, POLL_SLICE);
+        if(res != 0)
+            return res > 0;
+
+        waited += POLL_SLICE;
+        if(timeout && waited >= timeout)
+            return 0;
+    }
+
+    return 0;
+}
+
+static int readLine(FtpTestServer *server, CoreSocket sock, LineReader *reader, char *line, size_t lineSize)
+{
+    char *end;
+    size_t len;
+    int got;
+
+    for(;;)
+    {
+        end = (char *)memchr(reader->buf, '\n', (size_t)reader->len);
+        if(end)
+        {
+            len = (size_t)(end - reader->buf);
+            if(len > 0 && reader->buf[len - 1] == '\r')
+                --len;
+            if(len >= lineSize)
+                len = lineSize - 1;
+
+            memcpy(line, reader->buf, len);
+            line[len] = '\0';
+
+            len = (size_t)(end - reader->buf) + 1;
+            memmove(reader->buf, reader->buf + len, (size_t)reader->len - len);
+            reader->len -= (int)len;
+
+            return 1;
+        }
+
+        if(reader->len >= (int)sizeof(reader->buf) || !waitData(server, sock, 0))
+            return 0;
+
+        got = coreNet_recv(sock, reader->buf + reader->len, (int)sizeof(reader->buf) - reader->len);
+        if(got <= 0)
+            return 0;
+
+        reader->len += got;
+    }
+}
+
+static void sendReply(FtpTestServer *server, CoreSocket sock, const char *text)
+{
+    char line[256];
+
+    if(server->replyDelay)
+        coreSys_sleep(server->replyDelay);
+
+    sprintf(line, "%.250s\r\n", text);
+    coreNet_send(sock, line, (int)strlen(line));
+}
+
+static FtpTestFile *findFile(FtpTestServer *server, const char *name)
+{
+    int i;
+
+    for(i = 0; i < server->fileCount; ++i)
+    {
+        if(strcmp(server->files[i].name, name) == 0)
+            return &server->files[i];
+    }
+
+    return NULL;
+}
+
+/* Replace the contents of the file from the position, the mutex must be locked */
+static void storeData(FtpTestServer *server, const char *name, size_t pos, const uint8_t *data, size_t size)
+{
+    FtpTestFile *file = findFile(server, name);
+    uint8_t *joined;
+
+    if(!file)
+    {
+        if(server->fileCount >= FTP_TEST_MAX_FILES)
+            return;
+
+        file = &server->files[server->fileCount++];
+        memset(file, 0, sizeof(FtpTestFile));
+        strncat(file->name, name, sizeof(file->name) - 1);
+    }
+
+    if(pos > file->size)
+        pos = file->size;
+
+    joined = (uint8_t *)malloc(pos + size + 1);
+    if(!joined)
+        return;
+
+    if(pos > 0)
+        memcpy(joined, file->data, pos);
+    if(size > 0)
+        memcpy(joined + pos, data, size);
+
+    free(file->data);
+    file->data = joined;
+    file->size = pos + size;
+}
+
+/* Receive the file by the data connection, returns the reply to the STOR */
+static const char *receiveFile(FtpTestServer *server, CoreSocket *dataListener, const char *name, long rest)
+{
+    CoreSocket data;
+    uint8_t *buf = NULL, *grown;
+    size_t size = 0, capacity = 0, breakAfter;
+    int got, broken = 0;
+
+    if(!waitData(server, *dataListener, DATA_TIMEOUT))
+        return "425 No data connection";
+
+    data = coreNet_accept(*dataListener);
+    coreNet_close(*dataListener);
+    *dataListener = CORE_INVALID_SOCKET;
+
+    if(data == CORE_INVALID_SOCKET)
+        return "425 No data connection";
+
+    coreMutex_lock(&server->mutex);
+    breakAfter = server->breakAfter;
+    server->breakAfter = 0;
+    coreMutex_unlock(&server->mutex);
+
+    for(;;)
+    {
+        if(capacity - size < 65536)
+        {
+            capacity = capacity * 2 + 65536;
+            grown = (uint8_t *)realloc(buf, capacity);
+            if(!grown)
+            {
+                broken = 1;
+                break;
+            }
+            buf = grown;
+        }
+
+        if(!waitData(server, data, DATA_TIMEOUT))
+        {
+            broken = 1;
+            break;
+        }
+
+        got = coreNet_recv(data, (char *)buf + size, (int)(capacity - size));
+        if(got < 0)
+            broken = 1;
+        if(got <= 0)
+            break;
+
+        size += (size_t)got;
+
+        if(breakAfter && size >= breakAfter)
+        {
+            /* The link went down in the middle of the file */
+            size = breakAfter;
+            broken = 1;
+            break;
+        }
+    }
+
+    /* Store it before the client sees the closed connection */
+    coreMutex_lock(&server->mutex);
+    storeData(server, name, rest > 0 ? (size_t)rest : 0, buf, size);
+    coreMutex_unlock(&server->mutex);
+
+    coreNet_close(data);
+
+    free(buf);
+
+    return broken ? "426 Connection closed; transfer aborted." : "226 Transfer complete.";
+}
+
+static int openDataPort(FtpTestServer *server, CoreSocket *dataListener, uint16_t *port)
+{
+    (void)server;
+
+    coreNet_close(*dataListener);
+    *dataListener = coreNet_listenLocal(port, 1);
+
+    return *dataListener != CORE_INVALID_SOCKET;
+}
+
+static void sessionThread(void *arg)
+{
+    FtpTestSession *session = (FtpTestSession *)arg;
+    FtpTestServer *server = session->server;
+    CoreSocket dataListener = CORE_INVALID_SOCKET;
+    LineReader reader;
+    FtpTestFile *file;
+    char line[512], out[300], *param;
+    uint16_t port;
+    long rest = 0;
+    int commands = 0;
+
+    reader.len = 0;
+
+    if(server->greetingDelay)
+        coreSys_sleep(server->greetingDelay);
+
+    sendReply(server, session->ctrl, "220 TinyScreenshoter test server");
+
+    while(readLine(server, session->ctrl, &reader, line, sizeof(line)))
+    {
+        param = strchr(line, ' ');
+        if(param)
+            *param++ = '\0';
+        else
+            param = line + strlen(line);
+
+        coreMutex_lock(&server->mutex);
+        server->commands++;
+        coreMutex_unlock(&server->mutex);
+
+        /* Like the server that has restarted, or the NAT that has forgotten the connection */
+        if(server->dropAfter && ++commands > server->dropAfter)
+            break;
+
+        if(strcmp(line, "USER") == 0)
+            sendReply(server, session->ctrl, strcmp(param, "nobody") == 0 ? "530 Not allowed" : "331 Please specify the password.");
+        else if(strcmp(line, "PASS") == 0)
+        {
+            if(strcmp(param, "wrong") == 0)
+                sendReply(server, session->ctrl, "530 Login incorrect.");
+            else
+            {
+                coreMutex_lock(&server->mutex);
+                server->logins++;
+                coreMutex_unlock(&server->mutex);
+                sendReply(server, session->ctrl, "230 Login successful.");
+            }
+        }
+        else if(strcmp(line, "CWD") == 0)
+            sendReply(server, session->ctrl, "250 Directory successfully changed.");
+        else if(strcmp(line, "TYPE") == 0)
+            sendReply(server, session->ctrl, "200 Switching to Binary mode.");
+        else if(strcmp(line, "NOOP") == 0)
+        {
+            coreMutex_lock(&server->mutex);
+            server->noops++;
+            coreMutex_unlock(&server->mutex);
+            sendReply(server, session->ctrl, "200 NOOP ok.");
+        }
+        else if(strcmp(line, "QUIT") == 0)
+        {
+            sendReply(server, session->ctrl, "221 Goodbye.");
+            break;
+        }
+        else if(strcmp(line, "SIZE") == 0)
+        {
+            coreMutex_lock(&server->mutex);
+            file = findFile(server, param);
+            if(file)
+                sprintf(out, "213 %lu", (unsigned long)file->size);
+            else
+                strcpy(out, "550 Could not get file size.");
+            coreMutex_unlock(&server->mutex);
+            sendReply(server, session->ctrl, out);
+        }
+        else if(strcmp(line, "EPSV") == 0 && !server->noEpsv)
+        {
+            if(openDataPort(server, &dataListener, &port))
+            {
+                sprintf(out, "229 Entering Extended Passive Mode (|||%u|)", (unsigned)port);
+                sendReply(server, session->ctrl, out);
+            }
+            else
+                sendReply(server, session->ctrl, "425 Can't open data connection.");
+        }
+        else if(strcmp(line, "PASV") == 0)
+        {
+            if(openDataPort(server, &dataListener, &port))
+            {
+                sprintf(out, "227 Entering Passive Mode (127,0,0,1,%u,%u).", (unsigned)(port >> 8), (unsigned)(port & 0xFF));
+                sendReply(server, session->ctrl, out);
+            }
+            else
+                sendReply(server, session->ctrl, "425 Can't open data connection.");
+        }
+        else if(strcmp(line, "REST") == 0 && !server->noRest)
+        {
+            rest = atol(param);
+            sprintf(out, "350 Restart position accepted (%ld).", rest);
+            sendReply(server, session->ctrl, out);
+        }
+        else if(strcmp(line, "STOR") == 0)
+        {
+            if(dataListener == CORE_INVALID_SOCKET)
+                sendReply(server, session->ctrl, "425 Use PORT or PASV first.");
+            else
+            {
+                sendReply(server, session->ctrl, "150 Ok to send data.");
+                sendReply(server, session->ctrl, receiveFile(server, &dataListener, param, rest));
+            }
+
+            rest = 0;
+        }
+        else
+            sendReply(server, session->ctrl, "502 Command not implemented.");
+    }
+
+    coreNet_close(dataListener);
+    coreNet_close(session->ctrl);
+    session->ctrl = CORE_INVALID_SOCKET;
+    session->state = SESSION_FINISHED;
+}
+
+static void acceptThread(void *arg)
+{
+    FtpTestServer *server = (FtpTestServer *)arg;
+    CoreSocket sock;
+    int i;
+
+    while(waitData(server, server->listener, 0))
+    {
+        sock = coreNet_accept(server->listener);
+        if(sock == CORE_INVALID_SOCKET)
+            continue;
+
+        for(i = 0; i < FTP_TEST_MAX_SESSIONS; ++i)
+        {
+            if(server->sessions[i].state == SESSION_FINISHED)
+            {
+                coreThread_join(&server->sessions[i].thread);
+                server->sessions[i].state = SESSION_FREE;
+            }
+
+            if(server->sessions[i].state == SESSION_FREE)
+                break;
+        }
+
+        coreMutex_lock(&server->mutex);
+        server->connections++;
+        coreMutex_unlock(&server->mutex);
+
+        if(i == FTP_TEST_MAX_SESSIONS)
+        {
+            coreNet_close(sock);
+            continue;
+        }
+
+        /* Like the real servers do, otherwise the 226 after the 150 waits for the delayed ACK */
+        coreNet_setNoDelay(sock);
+
+        server->sessions[i].server = server;
+        server->sessions[i].ctrl = sock;
+        server->sessions[i].state = SESSION_RUNNING;
+
+        if(!coreThread_start(&server->sessions[i].thread, &sessionThread, &server->sessions[i]))
+        {
+            coreNet_close(sock);
+            server->sessions[i].state = SESSION_FREE;
+        }
+    }
+}
+
+void ftpTestServer_init(FtpTestServer *server)
+{
+    memset(server, 0, sizeof(FtpTestServer));
+    server->listener = CORE_INVALID_SOCKET;
+}
+
+int ftpTestServer_start(FtpTestServer *server)
+{
+    server->quit = 0;
+    coreMutex_init(&server->mutex);
+
+    server->listener = coreNet_listenLocal(&server->port, 16);
+    if(server->listener == CORE_INVALID_SOCKET)
+        return 0;
+
+    if(!coreThread_start(&server->thread, &acceptThread, server))
+    {
+        coreNet_close(server->listener);
+        server->listener = CORE_INVALID_SOCKET;
+        return 0;
+    }
+
+    return 1;
+}
+
+void ftpTestServer_stop(FtpTestServer *server)
+{
+    int i;
+
+    server->quit = 1;
+    coreThread_join(&server->thread);
+
+    for(i = 0; i < FTP_TEST_MAX_SESSIONS; ++i)
+    {
+        if(server->sessions[i].state != SESSION_FREE)
+        {
+            coreThread_join(&server->sessions[i].thread);
+            server->sessions[i].state = SESSION_FREE;
+        }
+    }
+
+    coreNet_close(server->listener);
+    server->listener = CORE_INVALID_SOCKET;
+
+    for(i = 0; i < server->fileCount; ++i)
+    {
+        free(server->files[i].data);
+        server->files[i].data = NULL;
+    }
+
+    server->fileCount = 0;
+    coreMutex_destroy(&server->mutex);
+}
+
+const FtpTestFile *ftpTestServer_file(FtpTestServer *server, const char *name)
+{
+    FtpTestFile *file;
+
+    coreMutex_lock(&server->mutex);
+    file = findFile(server, name);
+    coreMutex_unlock(&server->mutex);
+
+    return file;
+}
+
+void ftpTestServer_putFile(FtpTestServer *server, const char *name, const uint8_t *data, size_t size)
+{
+    coreMutex_lock(&server->mutex);
+    storeData(server, name, 0, data, size);
+    coreMutex_unlock(&server->mutex);
+}
@@ -0,0 +1,116 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef FTP_TEST_SERVER_H
+#define FTP_TEST_SERVER_H
+
+/*
+ * The scripted FTP server at 127.0.0.1 for the tests and the benchmarks of
+ * the FTP client: keeps the stored files in the memory, and can pretend to
+ * be slow, old or broken in the ways the real servers are.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core_sys.h"
+#include "core_net.h"
+
+#define FTP_TEST_MAX_FILES      128
+#define FTP_TEST_MAX_SESSIONS   16
+
+typedef struct tagFtpTestFile
+{
+    char name[64];
+    uint8_t *data;
+    size_t size;
+} FtpTestFile;
+
+typedef struct tagFtpTestSession
+{
+    struct tagFtpTestServer *server;
+    CoreSocket ctrl;
+    CoreThread thread;
+    volatile int state;
+} FtpTestSession;
+
+typedef struct tagFtpTestServer
+{
+    CoreSocket listener;
+    uint16_t port;
+    CoreThread thread;
+    volatile int quit;
+
+    /* Pause before every reply in milliseconds, the latency of the link */
+    uint32_t replyDelay;
+    /* Pause before the greeting in milliseconds, the busy server */
+    uint32_t greetingDelay;
+    /* Answer 500 to EPSV, like the old servers do */
+    int noEpsv;
+    /* Answer 502 to REST */
+    int noRest;
+    /* Close the data connection and answer 426 after this number of bytes of the next STOR, 0 to never */
+    size_t breakAfter;
+    /* Close the control connection after this number of the commands, 0 to never */
+    int dropAfter;
+
+    /* Counters, read them after ftpTestServer_stop() or under the mutex */
+    int connections;
+    int logins;
+    int commands;
+    int noops;
+
+    CoreMutex mutex;
+    FtpTestFile files[FTP_TEST_MAX_FILES];
+    int fileCount;
+    FtpTestSession sessions[FTP_TEST_MAX_SESSIONS];
+} FtpTestServer;
+
+/**
+ * @brief Start listening at the random port, the behaviour fields can be changed before the start
+ * @return 1 on success
+ */
+int ftpTestServer_start(FtpTestServer *server);
+
+/**
+ * @brief Set up the server with the default behaviour, call before the fields get changed
+ */
+void ftpTestServer_init(FtpTestServer *server);
+
+/**
+ * @brief Stop the server, wait for its sessions to end and free the files
+ */
+void ftpTestServer_stop(FtpTestServer *server);
+
+/**
+ * @brief Find the stored file
+ * @return The file, or NULL if there is no such
+ */
+const FtpTestFile *ftpTestServer_file(FtpTestServer *server, const char *name);
+
+/**
+ * @brief Put the file to the server, like the previous upload has left it
+ */
+void ftpTestServer_putFile(FtpTestServer *server, const char *name, const uint8_t *data, size_t size);
+
+#endif /* FTP_TEST_SERVER_H */
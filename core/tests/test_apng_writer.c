@@ -0,0 +1,365 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "apng_writer.h"
+#include "png_stripes.h"
+
+#include "miniz.h"
+#include "spng.h"
+
+#define CANVAS_W    67
+#define CANVAS_H    41
+#define FRAMES      6
+
+static const char s_path[] = "test_apng_writer.png";
+static const uint8_t s_pngSignature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+
+/* Canvas after every frame and the part of it changed by the frame */
+static uint8_t s_canvas[FRAMES][CANVAS_W * CANVAS_H * 3];
+static const FrameDeltaRect s_rects[FRAMES] =
+{
+    {0, 0, CANVAS_W, CANVAS_H},
+    {10, 5, 20, 7},
+    {0, 0, 1, 1},
+    {CANVAS_W - 1, CANVAS_H - 1, 1, 1},
+    {0, 20, CANVAS_W, 3},
+    {0, 0, CANVAS_W, CANVAS_H}
+};
+/* The delay of the frame is the time until the next one, the long one gets cut to 16 bits */
+static const uint32_t s_times[FRAMES] = {0, 100, 250, 251, 70000, 70040};
+static const uint32_t s_delays[FRAMES] = {100, 150, 1, 65535, 40, 500};
+
+static uint32_t getU32(const uint8_t *in)
+{
+    return ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | in[3];
+}
+
+static void putU32(uint8_t *out, uint32_t value)
+{
+    out[0] = (uint8_t)(value >> 24);
+    out[1] = (uint8_t)(value >> 16);
+    out[2] = (uint8_t)(value >> 8);
+    out[3] = (uint8_t)value;
+}
+
+static uint8_t *readFile(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    uint8_t *data;
+    long size;
+
+    if(!f)
+        return NULL;
+
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    data = (uint8_t *)malloc((size_t)size);
+    if(data && fread(data, 1, (size_t)size, f) != (size_t)size)
+    {
+        free(data);
+        data = NULL;
+    }
+
+    fclose(f);
+    *len = (size_t)size;
+
+    return data;
+}
+
+static uint8_t *putChunk(uint8_t *out, const char *type, const uint8_t *data, uint32_t len)
+{
+    putU32(out, len);
+    memcpy(out + 4, type, 4);
+    if(len)
+        memcpy(out + 8, data, len);
+    putU32(out + 8 + len, (uint32_t)mz_crc32(MZ_CRC32_INIT, out + 4, len + 4));
+    return out + 12 + len;
+}
+
+/* Decode the frame by making the plain PNG of its image data, the way the APNG decoders do */
+static int decodeFrame(const uint8_t *data, uint32_t len, uint32_t w, uint32_t h, uint8_t **out)
+{
+    uint8_t ihdr[13] = {0, 0, 0, 0, 0, 0, 0, 0, 8, SPNG_COLOR_TYPE_TRUECOLOR, 0, 0, 0};
+    uint8_t *png, *end;
+    size_t outLen;
+    spng_ctx *ctx;
+    int ret;
+
+    *out = NULL;
+
+    png = (uint8_t *)malloc(8 + 25 + 12 + len + 12);
+    if(!png)
+        return SPNG_EMEM;
+
+    putU32(ihdr, w);
+    putU32(ihdr + 4, h);
+
+    memcpy(png, s_pngSignature, 8);
+    end = putChunk(png + 8, "IHDR", ihdr, 13);
+    end = putChunk(end, "IDAT", data, len);
+    end = putChunk(end, "IEND", NULL, 0);
+
+    ctx = spng_ctx_new(0);
+    ret = ctx ? spng_set_png_buffer(ctx, png, (size_t)(end - png)) : SPNG_EMEM;
+    if(!ret)
+        ret = spng_decoded_image_size(ctx, SPNG_FMT_RGB8, &outLen);
+    if(!ret && outLen != (size_t)w * h * 3)
+        ret = SPNG_EINTERNAL;
+    if(!ret)
+    {
+        *out = (uint8_t *)malloc(outLen);
+        ret = *out ? spng_decode_image(ctx, *out, outLen, SPNG_FMT_RGB8, 0) : SPNG_EMEM;
+    }
+
+    spng_ctx_free(ctx);
+    free(png);
+
+    return ret;
+}
+
+static int writeAnimation(int workers)
+{
+    unsigned long rnd = 99;
+    const FrameDeltaRect *r;
+    ApngWriter a;
+    uint32_t x, y;
+    size_t i;
+    int f;
+
+    TEST_CHECK(apngWriter_open(&a, s_path, CANVAS_W, CANVAS_H) == 0);
+
+    for(f = 0; f < FRAMES; ++f)
+    {
+        r = &s_rects[f];
+
+        /* Only the pixels inside of the rectangle change */
+        if(f)
+            memcpy(s_canvas[f], s_canvas[f - 1], sizeof(s_canvas[f]));
+        for(y = r->y; y < r->y + r->h; ++y)
+            for(x = r->x; x < r->x + r->w; ++x)
+                for(i = 0; i < 3; ++i)
+                    s_canvas[f][(y * CANVAS_W + x) * 3 + i] = (uint8_t)(f * 40 + (TEST_RND_NEXT(rnd) & 15));
+
+        TEST_CHECK(apngWriter_encodeFrame(&a, s_canvas[f], CANVAS_W * 3, r, workers,
+                                          pngPreset_get(PNG_PRESET_DEFAULT), s_times[f], s_delays[f]) == 0);
+    }
+
+    TEST_CHECK(apngWriter_close(&a) == 0);
+
+    return 0;
+}
+
+/* Walk all chunks, check the APNG structure and compose every frame over the previous one */
+static int checkAnimation(const uint8_t *file, size_t fileLen)
+{
+    static uint8_t canvas[CANVAS_W * CANVAS_H * 3];
+    const uint8_t *chunk, *end = file + fileLen, *fctl = NULL;
+    uint8_t *data = NULL, *pixels;
+    size_t dataLen = 0;
+    uint32_t len, seq = 0, fw = 0, fh = 0, fx = 0, fy = 0, y, delay;
+    int frame = -1, seenActl = 0, seenIend = 0;
+
+    TEST_CHECK(fileLen > 8 && memcmp(file, s_pngSignature, 8) == 0);
+
+    data = (uint8_t *)malloc(fileLen);
+    TEST_CHECK(data != NULL);
+
+    for(chunk = file + 8; chunk < end; chunk += 12 + len)
+    {
+        TEST_CHECK(chunk + 12 <= end);
+        len = getU32(chunk);
+        TEST_CHECK(len <= (size_t)(end - chunk) - 12);
+        TEST_CHECK(getU32(chunk + 8 + len) == mz_crc32(MZ_CRC32_INIT, chunk + 4, len + 4));
+        TEST_CHECK(!seenIend);
+
+        /* The frame ends where the next fcTL or IEND starts */
+        if(fctl && (memcmp(chunk + 4, "fcTL", 4) == 0 || memcmp(chunk + 4, "IEND", 4) == 0))
+        {
+            TEST_CHECK(dataLen > 0);
+            TEST_CHECK(decodeFrame(data, (uint32_t)dataLen, fw, fh, &pixels) == 0);
+            for(y = 0; y < fh; ++y)
+                memcpy(canvas + ((fy + y) * CANVAS_W + fx) * 3, pixels + (size_t)y * fw * 3, (size_t)fw * 3);
+            free(pixels);
+
+            TEST_CHECK(memcmp(canvas, s_canvas[frame], sizeof(canvas)) == 0);
+            dataLen = 0;
+        }
+
+        if(memcmp(chunk + 4, "IHDR", 4) == 0)
+        {
+            TEST_CHECK(chunk == file + 8 && len == 13);
+            TEST_CHECK(getU32(chunk + 8) == CANVAS_W && getU32(chunk + 12) == CANVAS_H);
+        }
+        else if(memcmp(chunk + 4, "acTL", 4) == 0)
+        {
+            /* Number of frames and of the plays, 0 is forever */
+            TEST_CHECK(len == 8 && frame < 0);
+            TEST_CHECK(getU32(chunk + 8) == FRAMES);
+            TEST_CHECK(getU32(chunk + 12) == 0);
+            seenActl = 1;
+        }
+        else if(memcmp(chunk + 4, "fcTL", 4) == 0)
+        {
+            TEST_CHECK(len == 26 && seenActl);
+            fctl = chunk + 8;
+            frame++;
+            TEST_CHECK(frame < FRAMES);
+
+            TEST_CHECK(getU32(fctl) == seq++);
+            fw = getU32(fctl + 4);
+            fh = getU32(fctl + 8);
+            fx = getU32(fctl + 12);
+            fy = getU32(fctl + 16);
+            TEST_CHECK(fw == s_rects[frame].w && fh == s_rects[frame].h);
+            TEST_CHECK(fx == s_rects[frame].x && fy == s_rects[frame].y);
+
+            /* The delay in milliseconds, dispose op NONE and blend op SOURCE */
+            delay = frame + 1 < FRAMES ? s_times[frame + 1] - s_times[frame] : s_delays[frame];
+            if(delay > APNG_MAX_DELAY)
+                delay = APNG_MAX_DELAY;
+            TEST_CHECK(((uint32_t)fctl[20] << 8 | fctl[21]) == delay);
+            TEST_CHECK(((uint32_t)fctl[22] << 8 | fctl[23]) == 1000);
+            TEST_CHECK(fctl[24] == 0 && fctl[25] == 0);
+        }
+        else if(memcmp(chunk + 4, "IDAT", 4) == 0)
+        {
+            /* The default image is the first frame */
+            TEST_CHECK(frame == 0);
+            memcpy(data + dataLen, chunk + 8, len);
+            dataLen += len;
+        }
+        else if(memcmp(chunk + 4, "fdAT", 4) == 0)
+        {
+            TEST_CHECK(frame > 0 && len > 4);
+            TEST_CHECK(getU32(chunk + 8) == seq++);
+            memcpy(data + dataLen, chunk + 12, len - 4);
+            dataLen += len - 4;
+        }
+        else if(memcmp(chunk + 4, "IEND", 4) == 0)
+            seenIend = 1;
+    }
+
+    TEST_CHECK(seenIend && frame == FRAMES - 1);
+
+    free(data);
+
+    return 0;
+}
+
+static int testFrames(void)
+{
+    uint8_t *file;
+    size_t fileLen;
+    int workers;
+
+    for(workers = 1; workers <= 3; ++workers)
+    {
+        TEST_CHECK(writeAnimation(workers) == 0);
+
+        file = readFile(s_path, &fileLen);
+        TEST_CHECK(file != NULL);
+        TEST_CHECK(checkAnimation(file, fileLen) == 0);
+        free(file);
+    }
+
+    remove(s_path);
+
+    return 0;
+}
+
+/* The viewers without the APNG support show the first frame */
+static int testDefaultImage(void)
+{
+    uint8_t *file, *pixels = NULL;
+    size_t fileLen, outLen = 0;
+    spng_ctx *ctx;
+
+    TEST_CHECK(writeAnimation(1) == 0);
+    file = readFile(s_path, &fileLen);
+    TEST_CHECK(file != NULL);
+
+    ctx = spng_ctx_new(0);
+    TEST_CHECK(ctx != NULL);
+    TEST_CHECK(spng_set_png_buffer(ctx, file, fileLen) == 0);
+    TEST_CHECK(spng_decoded_image_size(ctx, SPNG_FMT_RGB8, &outLen) == 0);
+    TEST_CHECK(outLen == sizeof(s_canvas[0]));
+    pixels = (uint8_t *)malloc(outLen);
+    TEST_CHECK(pixels != NULL);
+    TEST_CHECK(spng_decode_image(ctx, pixels, outLen, SPNG_FMT_RGB8, 0) == 0);
+    TEST_CHECK(memcmp(pixels, s_canvas[0], outLen) == 0);
+
+    spng_ctx_free(ctx);
+    free(pixels);
+    free(file);
+    remove(s_path);
+
+    return 0;
+}
+
+static int testBadFrames(void)
+{
+    const FrameDeltaRect part = {1, 1, 2, 2}, outside = {CANVAS_W - 1, 0, 2, 1}, whole = {0, 0, CANVAS_W, CANVAS_H};
+    uint8_t *png = NULL;
+    size_t pngLen = 0;
+    ApngWriter a;
+
+    TEST_CHECK(apngWriter_open(&a, s_path, 0, CANVAS_H) == SPNG_EINVAL);
+    TEST_CHECK(apngWriter_open(&a, s_path, CANVAS_W, CANVAS_H) == 0);
+
+    /* The first frame must cover the whole canvas */
+    TEST_CHECK(pngStripes_encodeToBuffer(&png, &pngLen, s_canvas[0], 2, 2, CANVAS_W * 3, 3, 1,
+                                         pngPreset_get(PNG_PRESET_DEFAULT)) == 0);
+    TEST_CHECK(apngWriter_addFrame(&a, png, pngLen, &part, 0, 100) == SPNG_EINVAL);
+    TEST_CHECK(apngWriter_encodeFrame(&a, s_canvas[0], CANVAS_W * 3, &whole, 1,
+                                      pngPreset_get(PNG_PRESET_DEFAULT), 0, 100) == 0);
+
+    /* The frame must fit the canvas and its PNG must be of the rectangle size */
+    TEST_CHECK(apngWriter_addFrame(&a, png, pngLen, &outside, 10, 100) == SPNG_EINVAL);
+    TEST_CHECK(apngWriter_addFrame(&a, png, pngLen, &whole, 10, 100) == SPNG_EINVAL);
+    TEST_CHECK(apngWriter_addFrame(&a, png, 7, &part, 10, 100) == SPNG_EINVAL);
+    TEST_CHECK(apngWriter_addFrame(&a, png, pngLen, &part, 10, 100) == 0);
+
+    TEST_CHECK(apngWriter_close(&a) == 0);
+    TEST_CHECK(apngWriter_close(&a) == SPNG_EINVAL);
+
+    free(png);
+    remove(s_path);
+
+    return 0;
+}
+
+int main(void)
+{
+    TEST_RUN(testFrames);
+    TEST_RUN(testDefaultImage);
+    TEST_RUN(testBadFrames);
+    return 0;
+}
@@ -0,0 +1,213 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <string.h>
+
+#include "test_util.h"
+#include "burst_ring.h"
+#include "shot_stats.h"
+
+#define FRAME_SIZE  1000
+
+static int testAccounting(void)
+{
+    BurstRing ring;
+    uint8_t *bufs[4], *extra;
+    int i;
+
+    burstRing_init(&ring);
+
+    /* Nothing is given before the burst starts */
+    TEST_CHECK(burstRing_acquire(&ring, &extra, FRAME_SIZE) == BURST_RING_FULL && extra == NULL);
+    TEST_CHECK(ring.drops == 1);
+    TEST_CHECK(burstRing_begin(&ring, 4, FRAME_SIZE) == BURST_RING_OK);
+
+    for(i = 0; i < 4; ++i)
+    {
+        TEST_CHECK(burstRing_acquire(&ring, &bufs[i], FRAME_SIZE) == BURST_RING_OK);
+        memset(bufs[i], i, FRAME_SIZE);
+    }
+
+    /* Every buffer waits for the saver: the frame is dropped, nothing gets allocated */
+    TEST_CHECK(burstRing_acquire(&ring, &extra, FRAME_SIZE) == BURST_RING_FULL);
+    TEST_CHECK(ring.taken == 4 && ring.drops == 2);
+
+    /* The savers finish out of order, the freed slots are found past the busy ones */
+    TEST_CHECK(burstRing_release(&ring, bufs[2]));
+    TEST_CHECK(burstRing_acquire(&ring, &extra, FRAME_SIZE) == BURST_RING_OK && extra == bufs[2]);
+    TEST_CHECK(burstRing_release(&ring, bufs[0]));
+    TEST_CHECK(burstRing_release(&ring, bufs[1]));
+    TEST_CHECK(burstRing_acquire(&ring, &extra, FRAME_SIZE) == BURST_RING_OK && extra == bufs[0]);
+    TEST_CHECK(burstRing_acquire(&ring, &extra, FRAME_SIZE) == BURST_RING_OK && extra == bufs[1]);
+
+    /* The larger frame doesn't fit, the foreign buffer isn't taken */
+    TEST_CHECK(burstRing_release(&ring, bufs[3]));
+    TEST_CHECK(burstRing_acquire(&ring, &extra, FRAME_SIZE + 1) == BURST_RING_FULL);
+    TEST_CHECK(!burstRing_release(&ring, (uint8_t *)&ring));
+    TEST_CHECK(!burstRing_release(&ring, NULL));
+    TEST_CHECK(ring.taken == 7 && ring.drops == 3);
+
+    /* The next burst can't start while the frames of this one are being saved */
+    burstRing_end(&ring);
+    TEST_CHECK(burstRing_acquire(&ring, &extra, FRAME_SIZE) == BURST_RING_FULL);
+    TEST_CHECK(ring.slots[3].data == NULL);
+    TEST_CHECK(burstRing_begin(&ring, 2, FRAME_SIZE) == BURST_RING_FULL);
+
+    for(i = 0; i < 3; ++i)
+    {
+        TEST_CHECK(burstRing_release(&ring, bufs[i]));
+        TEST_CHECK(ring.slots[i].data == NULL);
+    }
+
+    /* The slots count is clamped */
+    TEST_CHECK(burstRing_begin(&ring, 1000, FRAME_SIZE) == BURST_RING_OK);
+    TEST_CHECK(ring.count == BURST_RING_MAX_SLOTS);
+    TEST_CHECK(burstRing_begin(&ring, 0, FRAME_SIZE) == BURST_RING_OK);
+    TEST_CHECK(ring.count == 1);
+
+    burstRing_free(&ring);
+
+    return 0;
+}
+
+/*
+ * The burst on the virtual clock: the frame is taken every interval, and the savers
+ * return the buffer after saveMs. The achieved rate must come to the rate of the savers
+ * when they are slower than the capture, and to the requested one otherwise.
+ */
+static int runBurst(int slots, int savers, uint32_t interval, uint32_t saveMs, uint32_t duration, double expectFps)
+{
+    BurstRing ring;
+    ShotStats s;
+    uint8_t *buf, *saving[BURST_RING_MAX_SLOTS];
+    uint32_t doneAt[BURST_RING_MAX_SLOTS], saverFree[8], now, frames = 0, dropped = 0;
+    double requested, achieved;
+    int i, pending = 0, best;
+    char tip[96];
+
+    burstRing_init(&ring);
+    TEST_CHECK(burstRing_begin(&ring, slots, FRAME_SIZE) == BURST_RING_OK);
+    memset(saverFree, 0, sizeof(saverFree));
+
+    shotStats_init();
+    shotStats_burstStarted(interval);
+
+    for(now = 0; now < duration; now += interval)
+    {
+        /* Return the buffers of the frames saved by now */
+        for(i = 0; i < pending; )
+        {
+            if(doneAt[i] <= now)
+            {
+                TEST_CHECK(burstRing_release(&ring, saving[i]));
+                saving[i] = saving[pending - 1];
+                doneAt[i] = doneAt[pending - 1];
+                --pending;
+            }
+            else
+                ++i;
+        }
+
+        frames++;
+
+        if(burstRing_acquire(&ring, &buf, FRAME_SIZE) != BURST_RING_OK)
+        {
+            dropped++;
+            shotStats_burstProgress(frames, dropped, now + interval);
+            continue;
+        }
+
+        /* The frame goes to the saver that gets free first */
+        for(i = 1, best = 0; i < savers; ++i)
+        {
+            if(saverFree[i] < saverFree[best])
+                best = i;
+        }
+
+        saverFree[best] = (saverFree[best] > now ? saverFree[best] : now) + saveMs;
+        saving[pending] = buf;
+        doneAt[pending] = saverFree[best];
+        pending++;
+
+        shotStats_burstProgress(frames, dropped, now + interval);
+    }
+
+    burstRing_end(&ring);
+    for(i = 0; i < pending; ++i)
+        TEST_CHECK(burstRing_release(&ring, saving[i]));
+
+    shotStats_get(&s);
+    shotStats_burstRate(&s, &requested, &achieved);
+    shotStats_formatBurstTip(&s, tip, sizeof(tip));
+    printf("%d slots, %d savers, %lu ms per frame: %s\n", slots, savers, (unsigned long)saveMs, tip);
+
+    TEST_CHECK(s.bursts == 1 && s.burstFrames == frames && s.burstDropped == dropped);
+    TEST_CHECK(s.burstElapsedMs == duration && frames == duration / interval);
+    TEST_CHECK(ring.drops == dropped && ring.taken == frames - dropped);
+    TEST_CHECK(requested == 1000.0 / interval);
+    TEST_CHECK(achieved == (frames - dropped) * 1000.0 / duration);
+    /* The frames still waiting in the ring at the end are counted too, so the rate is up to slots above the savers */
+    TEST_CHECK(achieved >= expectFps * 0.98 && achieved <= expectFps + (slots + 1) * 1000.0 / duration);
+
+    shotStats_quit();
+    burstRing_free(&ring);
+
+    return 0;
+}
+
+static int testAchievedRate(void)
+{
+    ShotStats s;
+    double requested, achieved;
+    char tip[96];
+
+    /* Savers keep up: 5 fps of 5 fps, nothing dropped */
+    TEST_CHECK(runBurst(8, 2, 200, 300, 10000, 5.0) == 0);
+    /* One saver of 400 ms: 2.5 of 10 fps */
+    TEST_CHECK(runBurst(8, 1, 100, 400, 20000, 2.5) == 0);
+    /* Four savers of 400 ms: 10 of 20 fps */
+    TEST_CHECK(runBurst(4, 4, 50, 400, 20000, 10.0) == 0);
+
+    /* The tooltip and the rate of the burst that hasn't made a frame yet */
+    shotStats_init();
+    shotStats_burstStarted(250);
+    shotStats_get(&s);
+    shotStats_burstRate(&s, &requested, &achieved);
+    TEST_CHECK(requested == 4.0 && achieved == 0.0);
+
+    shotStats_burstProgress(10, 4, 2000);
+    shotStats_get(&s);
+    shotStats_formatBurstTip(&s, tip, sizeof(tip));
+    TEST_CHECK(strcmp(tip, "TinyShot: burst 10 frames, 3.0 of 4.0 fps, 4 dropped") == 0);
+    shotStats_quit();
+
+    return 0;
+}
+
+int main(void)
+{
+    TEST_RUN(testAccounting);
+    TEST_RUN(testAchievedRate);
+
+    return 0;
+}
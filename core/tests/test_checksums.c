@@ -0,0 +1,195 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_util.h"
+
+#include "miniz.h"
+
+/* Bit by bit CRC-32 of zlib, the reference for the table, slicing and PCLMULQDQ code */
+static mz_ulong refCrc32(mz_ulong crc, const uint8_t *p, size_t len)
+{
+    uint32_t c = (uint32_t)crc ^ 0xFFFFFFFFU;
+    size_t i;
+    int k;
+
+    for(i = 0; i < len; ++i)
+    {
+        c ^= p[i];
+        for(k = 0; k < 8; ++k)
+            c = (c >> 1) ^ (0xEDB88320U & (0U - (c & 1)));
+    }
+
+    return c ^ 0xFFFFFFFFU;
+}
+
+/* Byte by byte Adler-32 with the modulo at every step */
+static mz_ulong refAdler32(mz_ulong adler, const uint8_t *p, size_t len)
+{
+    uint32_t s1 = (uint32_t)adler & 0xFFFF, s2 = (uint32_t)(adler >> 16);
+    size_t i;
+
+    for(i = 0; i < len; ++i)
+    {
+        s1 = (s1 + p[i]) % 65521U;
+        s2 = (s2 + s1) % 65521U;
+    }
+
+    return ((mz_ulong)s2 << 16) | s1;
+}
+
+static int testKnownAnswers(void)
+{
+    static const struct
+    {
+        const char *data;
+        mz_ulong crc;
+        mz_ulong adler;
+    } vectors[] =
+    {
+        {"", 0x00000000, 0x00000001},
+        {"a", 0xE8B7BE43, 0x00620062},
+        {"123456789", 0xCBF43926, 0x091E01DE},
+        {"Wikipedia", 0xADAAC02E, 0x11E60398},
+        {"The quick brown fox jumps over the lazy dog", 0x414FA339, 0x5BDC0FDA}
+    };
+    uint8_t *buf;
+    size_t i;
+
+    for(i = 0; i < sizeof(vectors) / sizeof(vectors[0]); ++i)
+    {
+        const uint8_t *d = (const uint8_t *)vectors[i].data;
+        size_t len = strlen(vectors[i].data);
+
+        TEST_CHECK(mz_crc32(MZ_CRC32_INIT, d, len) == vectors[i].crc);
+        TEST_CHECK(mz_adler32(MZ_ADLER32_INIT, d, len) == vectors[i].adler);
+    }
+
+    /* Long enough for the SIMD paths, the values are from zlib */
+    buf = (uint8_t *)malloc(100000);
+    TEST_CHECK(buf != NULL);
+
+    for(i = 0; i < 1000; ++i)
+        buf[i] = (uint8_t)(i * 7 + 3);
+    TEST_CHECK(mz_crc32(MZ_CRC32_INIT, buf, 1000) == 0x17BC2A46);
+    TEST_CHECK(mz_adler32(MZ_ADLER32_INIT, buf, 1000) == 0x38ADEDFC);
+
+    /* All bytes 0xFF make the largest sums of Adler-32 between the modulo steps */
+    memset(buf, 0xFF, 100000);
+    TEST_CHECK(mz_crc32(MZ_CRC32_INIT, buf, 100000) == 0x68C6CEC4);
+    TEST_CHECK(mz_adler32(MZ_ADLER32_INIT, buf, 100000) == 0x149A302C);
+
+    free(buf);
+
+    return 0;
+}
+
+/* Every length around the 16 and 64 byte steps from every start inside of the 16 bytes */
+static int testLengthsAndOffsets(void)
+{
+    static const size_t lengths[] = {0, 1, 2, 3, 7, 8, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 128, 129,
+                                     255, 256, 1000, 4096, 5552, 5553, 65536, 70001};
+    unsigned long rnd = 31337;
+    uint8_t *buf;
+    size_t i, l, offset;
+
+    buf = (uint8_t *)malloc(70001 + 16);
+    TEST_CHECK(buf != NULL);
+
+    for(i = 0; i < 70001 + 16; ++i)
+        buf[i] = (uint8_t)TEST_RND_NEXT(rnd);
+
+    for(l = 0; l < sizeof(lengths) / sizeof(lengths[0]); ++l)
+    {
+        for(offset = 0; offset < 16; ++offset)
+        {
+            TEST_CHECK(mz_crc32(MZ_CRC32_INIT, buf + offset, lengths[l]) == refCrc32(MZ_CRC32_INIT, buf + offset, lengths[l]));
+            TEST_CHECK(mz_adler32(MZ_ADLER32_INIT, buf + offset, lengths[l]) == refAdler32(MZ_ADLER32_INIT, buf + offset, lengths[l]));
+        }
+    }
+
+    free(buf);
+
+    return 0;
+}
+
+/* The random lengths, starts and initial values, as the checksums get continued from piece to piece */
+static int testRandomPieces(void)
+{
+    unsigned long rnd = 777;
+    mz_ulong crc, adler, refCrc, refAdler;
+    size_t i, len, offset, total;
+    uint8_t *buf;
+    int n;
+
+    buf = (uint8_t *)malloc(20000);
+    TEST_CHECK(buf != NULL);
+
+    for(i = 0; i < 20000; ++i)
+        buf[i] = (uint8_t)TEST_RND_NEXT(rnd);
+
+    for(n = 0; n < 500; ++n)
+    {
+        offset = TEST_RND_NEXT(rnd) % 64;
+        len = (TEST_RND_NEXT(rnd) * 32768UL + TEST_RND_NEXT(rnd)) % (20000 - 64);
+
+        /* Random starting values, like the checksum of the earlier piece */
+        crc = ((mz_ulong)TEST_RND_NEXT(rnd) << 17) ^ TEST_RND_NEXT(rnd);
+        adler = ((mz_ulong)(TEST_RND_NEXT(rnd) % 65521U) << 16) | (TEST_RND_NEXT(rnd) % 65521U);
+
+        TEST_CHECK(mz_crc32(crc, buf + offset, len) == refCrc32(crc, buf + offset, len));
+        TEST_CHECK(mz_adler32(adler, buf + offset, len) == refAdler32(adler, buf + offset, len));
+    }
+
+    /* The checksum made by pieces is equal to the checksum of the whole */
+    crc = MZ_CRC32_INIT;
+    adler = MZ_ADLER32_INIT;
+    for(total = 0; total < 20000; total += len)
+    {
+        len = TEST_RND_NEXT(rnd) % 300;
+        if(total + len > 20000)
+            len = 20000 - total;
+        crc = mz_crc32(crc, buf + total, len);
+        adler = mz_adler32(adler, buf + total, len);
+    }
+
+    refCrc = refCrc32(MZ_CRC32_INIT, buf, 20000);
+    refAdler = refAdler32(MZ_ADLER32_INIT, buf, 20000);
+    TEST_CHECK(crc == refCrc);
+    TEST_CHECK(adler == refAdler);
+
+    free(buf);
+
+    return 0;
+}
+
+int main(void)
+{
+    TEST_RUN(testKnownAnswers);
+    TEST_RUN(testLengthsAndOffsets);
+    TEST_RUN(testRandomPieces);
+    return 0;
+}
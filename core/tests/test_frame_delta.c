@@ -0,0 +1,253 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "frame_delta.h"
+
+#define W       203
+#define H       117
+#define BPP     3
+#define TILE    32
+#define FRAMES  60
+
+/* Change the block of pixels, every byte gets the different value */
+static void drawBlock(uint8_t *frame, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t seed)
+{
+    uint32_t i, j;
+
+    for(j = y; j < y + h && j < H; ++j)
+    {
+        for(i = x * BPP; i < (x + w) * BPP && i < W * BPP; ++i)
+            frame[(size_t)j * W * BPP + i] ^= (uint8_t)(seed | 1);
+    }
+}
+
+/* All changed pixels are inside of the rect, and the rect is cut by the tiles */
+static int checkBox(const uint8_t *prev, const uint8_t *cur, const FrameDeltaRect *r)
+{
+    uint32_t x, y;
+
+    TEST_CHECK(r->x % TILE == 0 && r->y % TILE == 0);
+    TEST_CHECK(r->w > 0 && r->h > 0 && r->x + r->w <= W && r->y + r->h <= H);
+    TEST_CHECK((r->x + r->w) % TILE == 0 || r->x + r->w == W);
+    TEST_CHECK((r->y + r->h) % TILE == 0 || r->y + r->h == H);
+
+    for(y = 0; y < H; ++y)
+    {
+        for(x = 0; x < W; ++x)
+        {
+            if(memcmp(prev + ((size_t)y * W + x) * BPP, cur + ((size_t)y * W + x) * BPP, BPP) != 0)
+                TEST_CHECK(x >= r->x && x < r->x + r->w && y >= r->y && y < r->y + r->h);
+        }
+    }
+
+    return 0;
+}
+
+static int testBoundingBox(void)
+{
+    static uint8_t prev[W * H * BPP], cur[W * H * BPP];
+    FrameDelta d;
+    FrameDeltaRect r;
+    uint32_t i;
+
+    for(i = 0; i < sizeof(prev); ++i)
+        prev[i] = (uint8_t)(i * 7);
+
+    frameDelta_init(&d);
+    TEST_CHECK(frameDelta_compare(&d, prev, W, H, BPP, TILE, 0, &r) == 1);
+    TEST_CHECK(r.x == 0 && r.y == 0 && r.w == W && r.h == H && !d.unchanged);
+
+    /* Nothing has changed */
+    memcpy(cur, prev, sizeof(cur));
+    TEST_CHECK(frameDelta_compare(&d, cur, W, H, BPP, TILE, 0, &r) == 0);
+    TEST_CHECK(r.w == 1 && r.h == 1 && d.unchanged);
+
+    /* The single pixel inside of the tile makes the whole tile */
+    cur[((size_t)40 * W + 70) * BPP + 2] ^= 0xFF;
+    TEST_CHECK(frameDelta_compare(&d, cur, W, H, BPP, TILE, 0, &r) == 0);
+    TEST_CHECK(r.x == 64 && r.y == 32 && r.w == TILE && r.h == TILE && !d.unchanged);
+
+    /* Two far changes give the box over both, clipped at the right and bottom edges */
+    memcpy(prev, cur, sizeof(cur));
+    drawBlock(cur, 5, 3, 2, 2, 0x11);
+    drawBlock(cur, W - 1, H - 1, 1, 1, 0x22);
+    TEST_CHECK(frameDelta_compare(&d, cur, W, H, BPP, TILE, 0, &r) == 0);
+    TEST_CHECK(r.x == 0 && r.y == 0 && r.w == W && r.h == H);
+    TEST_CHECK(checkBox(prev, cur, &r) == 0);
+
+    /* The change across the tile corner takes all four tiles */
+    memcpy(prev, cur, sizeof(cur));
+    drawBlock(cur, 95, 60, 2, 10, 0x33);
+    TEST_CHECK(frameDelta_compare(&d, cur, W, H, BPP, TILE, 0, &r) == 0);
+    TEST_CHECK(r.x == 64 && r.y == 32 && r.w == 2 * TILE && r.h == 2 * TILE);
+    TEST_CHECK(checkBox(prev, cur, &r) == 0);
+
+    /* The tile size is clamped */
+    memcpy(prev, cur, sizeof(cur));
+    drawBlock(cur, 20, 20, 1, 1, 0x44);
+    TEST_CHECK(frameDelta_compare(&d, cur, W, H, BPP, 1, 0, &r) == 0);
+    TEST_CHECK(r.x == 16 && r.y == 16 && r.w == FRAME_DELTA_MIN_TILE && r.h == FRAME_DELTA_MIN_TILE);
+
+    frameDelta_free(&d);
+
+    return 0;
+}
+
+static int testKeyFrames(void)
+{
+    static uint8_t frame[W * H * BPP];
+    FrameDelta d;
+    FrameDeltaRect r;
+    int i, keys = 0;
+
+    memset(frame, 0x80, sizeof(frame));
+    frameDelta_init(&d);
+
+    /* Every 5th frame is the key frame, counting the first one */
+    for(i = 0; i < 20; ++i)
+    {
+        if(frameDelta_compare(&d, frame, W, H, BPP, TILE, 5, &r))
+        {
+            TEST_CHECK(i % 5 == 0);
+            TEST_CHECK(r.w == W && r.h == H && d.sinceKey == 0);
+            ++keys;
+        }
+        else
+            TEST_CHECK(i % 5 != 0 && d.sinceKey == (uint32_t)(i % 5));
+    }
+    TEST_CHECK(keys == 4);
+
+    /* Without the interval only the first frame is the key frame */
+    frameDelta_reset(&d);
+    TEST_CHECK(frameDelta_compare(&d, frame, W, H, BPP, TILE, 0, &r) == 1);
+    for(i = 0; i < 50; ++i)
+        TEST_CHECK(frameDelta_compare(&d, frame, W, H, BPP, TILE, 0, &r) == 0);
+
+    /* The new screen size or pixel format restarts the chain */
+    TEST_CHECK(frameDelta_compare(&d, frame, W - 1, H, BPP, TILE, 0, &r) == 1);
+    TEST_CHECK(r.w == W - 1 && r.h == H);
+    TEST_CHECK(frameDelta_compare(&d, frame, W - 1, H, BPP, TILE, 0, &r) == 0);
+    TEST_CHECK(frameDelta_compare(&d, frame, W / 2, H / 2, 4, TILE, 0, &r) == 1);
+
+    frameDelta_free(&d);
+    TEST_CHECK(d.ref == NULL);
+
+    return 0;
+}
+
+/*
+ * Crop every delta the way the saver does, and paste it onto the rebuilt frame the way
+ * delta_rebuild does: the rebuilt frame must always be equal to the captured one.
+ */
+static int testRoundTrip(void)
+{
+    static uint8_t frame[W * H * BPP], saved[W * H * BPP], rebuilt[W * H * BPP];
+    unsigned long seed = 3;
+    FrameDelta d;
+    FrameDeltaRect r;
+    uint32_t x, y, w, h, saveW, saveH;
+    int i, n, blocks, keys = 0, deltaBytes = 0;
+
+    for(i = 0; i < (int)sizeof(frame); ++i)
+        frame[i] = (uint8_t)TEST_RND_NEXT(seed);
+
+    frameDelta_init(&d);
+
+    for(n = 0; n < FRAMES; ++n)
+    {
+        /* Some frames stay the same, others get a few windows moved */
+        blocks = n % 7 == 3 ? 0 : (int)(TEST_RND_NEXT(seed) % 4) + 1;
+        for(i = 0; i < blocks; ++i)
+        {
+            x = (uint32_t)TEST_RND_NEXT(seed) % W;
+            y = (uint32_t)TEST_RND_NEXT(seed) % H;
+            w = (uint32_t)TEST_RND_NEXT(seed) % 40 + 1;
+            h = (uint32_t)TEST_RND_NEXT(seed) % 40 + 1;
+            drawBlock(frame, x, y, w, h, (uint8_t)TEST_RND_NEXT(seed));
+        }
+
+        memcpy(saved, frame, sizeof(frame));
+
+        if(frameDelta_compare(&d, saved, W, H, BPP, TILE, 16, &r))
+        {
+            memcpy(rebuilt, saved, sizeof(saved));
+            ++keys;
+            continue;
+        }
+
+        TEST_CHECK(d.unchanged == (blocks == 0));
+
+        saveW = r.w;
+        saveH = r.h;
+        frameDelta_crop(saved, W * BPP, BPP, &r);
+        frameDelta_paste(rebuilt, W, H, BPP, saved, &r);
+        deltaBytes += (int)(saveW * saveH * BPP);
+
+        TEST_CHECK(memcmp(rebuilt, frame, sizeof(frame)) == 0);
+    }
+
+    TEST_CHECK(keys == (FRAMES + 15) / 16);
+    printf("%d frames: %d key frames, deltas are %d%% of the whole frames\n",
+           FRAMES, keys, (int)((double)deltaBytes * 100 / ((double)(FRAMES - keys) * sizeof(frame))));
+
+    frameDelta_free(&d);
+
+    return 0;
+}
+
+/* The part that goes past the frame is clipped */
+static int testPasteClip(void)
+{
+    static const uint8_t part[4 * 3] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+    uint8_t frame[3 * 3];
+    FrameDeltaRect r;
+
+    memset(frame, 0, sizeof(frame));
+    r.x = 2;
+    r.y = 1;
+    r.w = 4;
+    r.h = 3;
+    frameDelta_paste(frame, 3, 3, 1, part, &r);
+    TEST_CHECK(frame[5] == 1 && frame[8] == 5);
+    TEST_CHECK(frame[0] == 0 && frame[4] == 0 && frame[7] == 0);
+
+    r.x = 3;
+    frameDelta_paste(frame, 3, 3, 1, part, &r);
+    TEST_CHECK(frame[5] == 1);
+
+    return 0;
+}
+
+int main(void)
+{
+    TEST_RUN(testBoundingBox);
+    TEST_RUN(testKeyFrames);
+    TEST_RUN(testRoundTrip);
+    TEST_RUN(testPasteClip);
+
+    return 0;
+}
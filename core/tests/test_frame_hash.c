@@ -0,0 +1,132 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "frame_hash.h"
+
+#define HASH_U64(hi, lo) (((uint64_t)(hi) << 32) | (uint64_t)(lo))
+
+static int checkHash(const void *data, size_t len, uint64_t seed, uint32_t hi, uint32_t lo)
+{
+    return frameHash_compute(data, len, seed) == HASH_U64(hi, lo);
+}
+
+/* The values from the specification, the hash must stay equal to the reference XXH64 */
+static int testReference(void)
+{
+    TEST_CHECK(checkHash("", 0, 0, 0xEF46DB37, 0x51D8E999));
+    TEST_CHECK(checkHash("a", 1, 0, 0xD24EC4F1, 0xA98C6E5B));
+    TEST_CHECK(checkHash("abc", 3, 0, 0x44BC2CF5, 0xAD770999));
+    return 0;
+}
+
+/* Every tail of the algorithm: 1-3 bytes, 4-7, 8-31 and the 32 byte stripes, with and without the seed */
+static int testLengths(void)
+{
+    static const struct
+    {
+        size_t len;
+        uint32_t hi, lo;
+        uint32_t seededHi, seededLo;
+    } vectors[] =
+    {
+        {  0, 0xEF46DB37, 0x51D8E999, 0xC4349FC9, 0x3C010000},
+        {  1, 0xA96C7F0C, 0xE858BBB7, 0x58588242, 0x2A6165E7},
+        {  2, 0xC22C6A70, 0xAD56BBA6, 0x44C43596, 0xA6307BB0},
+        {  3, 0xBED43740, 0xEE6332BB, 0x45FA1406, 0x538FA168},
+        {  4, 0xFA212AE4, 0x4B3BB23D, 0xA65107F2, 0x2943365A},
+        {  5, 0xD339DCC9, 0xAC8E6776, 0xF51EDA3A, 0x20DE9B88},
+        {  7, 0x2744460D, 0xD675D2C0, 0xC9B637E2, 0xC4599DE2},
+        {  8, 0x994B676B, 0x71CE94DD, 0xCE592D5F, 0x53E192EC},
+        {  9, 0x572B84C1, 0x8B983AF8, 0x5495AA79, 0x6DE8AB73},
+        { 15, 0x09E6451E, 0xD2FF8B1D, 0x47A857D1, 0xF90C35E1},
+        { 16, 0x94AD0095, 0xE72B24D5, 0x3F8FEA7C, 0x86A04013},
+        { 31, 0x6711D55E, 0x306B5D8F, 0x24C4E99A, 0xB0404B5E},
+        { 32, 0x07F7B8E3, 0xBC5D6E25, 0x046E99BB, 0xDA1A814B},
+        { 33, 0x09F85EEB, 0x4E1CBE9F, 0xD7FE2BFE, 0xE6E4CDED},
+        { 63, 0xB7C9968C, 0x066CB6A5, 0xBD457F9E, 0xA47180C8},
+        { 64, 0x50D4159A, 0x0411632E, 0xA768F350, 0xA8E4FCF6},
+        {100, 0x9DDADA11, 0xD3DC2D8F, 0x35546BD9, 0xA4779AE4},
+        {256, 0xA2DBE913, 0x965256FC, 0x0FDD97B3, 0xE0F22D80}
+    };
+    const uint64_t seed = HASH_U64(0x9E3779B9, 0x7F4A7C15);
+    uint8_t data[256];
+    size_t i;
+
+    for(i = 0; i < sizeof(data); ++i)
+        data[i] = (uint8_t)(i * 131 + 7);
+
+    for(i = 0; i < sizeof(vectors) / sizeof(vectors[0]); ++i)
+    {
+        TEST_CHECK(checkHash(data, vectors[i].len, 0, vectors[i].hi, vectors[i].lo));
+        TEST_CHECK(checkHash(data, vectors[i].len, seed, vectors[i].seededHi, vectors[i].seededLo));
+    }
+
+    /* The small seed changes the hash of the empty input too */
+    TEST_CHECK(checkHash("", 0, 1, 0xD5AFBA13, 0x36A3BE4B));
+    TEST_CHECK(checkHash("abc", 3, 1, 0xBEA9CA81, 0x99328908));
+
+    return 0;
+}
+
+/* The frames start at any address, the hash doesn't depend on it */
+static int testUnaligned(void)
+{
+    uint8_t data[200], *copy;
+    uint64_t hash;
+    size_t i, len, offset;
+    unsigned long rnd = 4242;
+
+    copy = (uint8_t *)malloc(sizeof(data) + 8);
+    TEST_CHECK(copy != NULL);
+
+    for(i = 0; i < sizeof(data); ++i)
+        data[i] = (uint8_t)TEST_RND_NEXT(rnd);
+
+    for(len = 0; len < 200; len += 1 + len / 8)
+    {
+        hash = frameHash_compute(data, len, 7);
+
+        for(offset = 1; offset < 8; ++offset)
+        {
+            memcpy(copy + offset, data, len);
+            TEST_CHECK(frameHash_compute(copy + offset, len, 7) == hash);
+        }
+    }
+
+    free(copy);
+
+    return 0;
+}
+
+int main(void)
+{
+    TEST_RUN(testReference);
+    TEST_RUN(testLengths);
+    TEST_RUN(testUnaligned);
+    return 0;
+}
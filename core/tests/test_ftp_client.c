@@ -0,0 +1,466 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "ftp_client.h"
+#include "ftp_test_server.h"
+#include "core_sys.h"
+
+typedef struct tagTestData
+{
+    const uint8_t *data;
+    size_t size;
+} TestData;
+
+static int sendMemory(void *user, CoreSocket sock, long offset)
+{
+    TestData *d = (TestData *)user;
+    size_t pos = (size_t)offset, chunk;
+    int sent;
+
+    while(pos < d->size)
+    {
+        chunk = d->size - pos < 65536 ? d->size - pos : 65536;
+        sent = coreNet_send(sock, (const char *)d->data + pos, (int)chunk);
+        if(sent <= 0)
+            return 0;
+        pos += (size_t)sent;
+    }
+
+    return 1;
+}
+
+static uint8_t *makeData(size_t size, unsigned long seed)
+{
+    uint8_t *data = (uint8_t *)malloc(size + 1);
+    size_t i;
+
+    for(i = 0; data && i < size; ++i)
+        data[i] = (uint8_t)TEST_RND_NEXT(seed);
+
+    return data;
+}
+
+static int store(FtpClient *client, const char *name, const uint8_t *data, size_t size, int resume, long *offset)
+{
+    FtpUpload upload;
+    TestData d;
+    int res;
+
+    d.data = data;
+    d.size = size;
+
+    memset(&upload, 0, sizeof(upload));
+    upload.name = name;
+    upload.size = (long)size;
+    upload.resume = resume;
+    upload.send = &sendMemory;
+    upload.user = &d;
+
+    res = ftpClient_store(client, &upload);
+    if(offset)
+        *offset = upload.offset;
+
+    return res;
+}
+
+static int sameFile(FtpTestServer *server, const char *name, const uint8_t *data, size_t size)
+{
+    const FtpTestFile *file = ftpTestServer_file(server, name);
+
+    return file && file->size == size && (size == 0 || memcmp(file->data, data, size) == 0);
+}
+
+static int testLoginAndStore(void)
+{
+    FtpTestServer server;
+    FtpClient client;
+    uint8_t *data = makeData(100000, 1);
+
+    ftpTestServer_init(&server);
+    TEST_CHECK(data && ftpTestServer_start(&server));
+
+    ftpClient_init(&client);
+    TEST_CHECK(ftpClient_login(&client, "127.0.0.1", server.port, "user", "pass", "/shots"));
+    TEST_CHECK(client.loggedIn && ftpClient_isAlive(&client));
+
+    TEST_CHECK(store(&client, "a.png", data, 100000, 0, NULL) == STORE_DONE);
+    TEST_CHECK(store(&client, "empty.png", data, 0, 0, NULL) == STORE_DONE);
+    TEST_CHECK(ftpClient_noop(&client));
+    TEST_CHECK(ftpClient_remoteSize(&client, "a.png") == 100000);
+    TEST_CHECK(ftpClient_remoteSize(&client, "missing.png") == -1);
+    ftpClient_close(&client, 1);
+    TEST_CHECK(client.ctrl == CORE_INVALID_SOCKET && !client.loggedIn);
+
+    ftpTestServer_stop(&server);
+    TEST_CHECK(server.logins == 1);
+
+    /* The files stay readable until the next start */
+    ftpTestServer_start(&server);
+    ftpTestServer_putFile(&server, "a.png", data, 100000);
+    TEST_CHECK(sameFile(&server, "a.png", data, 100000));
+    ftpTestServer_stop(&server);
+
+    free(data);
+
+    return 0;
+}
+
+static int testLoginRejected(void)
+{
+    FtpTestServer server;
+    FtpClient client;
+
+    ftpTestServer_init(&server);
+    TEST_CHECK(ftpTestServer_start(&server));
+
+    ftpClient_init(&client);
+    TEST_CHECK(!ftpClient_login(&client, "127.0.0.1", server.port, "nobody", "pass", "/"));
+    TEST_CHECK(client.step == FTP_STEP_USER && client.replyCode == 530);
+    TEST_CHECK(client.ctrl == CORE_INVALID_SOCKET && !client.loggedIn);
+
+    TEST_CHECK(!ftpClient_login(&client, "127.0.0.1", server.port, "user", "wrong", "/"));
+    TEST_CHECK(client.step == FTP_STEP_PASS && client.replyCode == 530);
+    TEST_CHECK(strstr(client.reply, "Login incorrect") != NULL);
+
+    TEST_CHECK(ftpClient_login(&client, "127.0.0.1", server.port, "user", "pass", "/"));
+    TEST_CHECK(client.step == FTP_STEP_NONE);
+    ftpClient_close(&client, 1);
+
+    ftpTestServer_stop(&server);
+
+    return 0;
+}
+
+/* The server without EPSV gets asked once, then only PASV */
+static int testOldServer(void)
+{
+    FtpTestServer server;
+    FtpClient client;
+    uint8_t *data = makeData(5000, 2);
+    int commands;
+
+    ftpTestServer_init(&server);
+    server.noEpsv = 1;
+    TEST_CHECK(data && ftpTestServer_start(&server));
+
+    ftpClient_init(&client);
+    TEST_CHECK(ftpClient_login(&client, "127.0.0.1", server.port, "user", "pass", "/"));
+    TEST_CHECK(store(&client, "1.png", data, 5000, 0, NULL) == STORE_DONE);
+    TEST_CHECK(client.noEpsv);
+
+    coreMutex_lock(&server.mutex);
+    commands = server.commands;
+    coreMutex_unlock(&server.mutex);
+
+    /* PASV and STOR */
+    TEST_CHECK(store(&client, "2.png", data, 5000, 0, NULL) == STORE_DONE);
+    coreMutex_lock(&server.mutex);
+    commands = server.commands - commands;
+    coreMutex_unlock(&server.mutex);
+    TEST_CHECK(commands == 2);
+
+    ftpClient_close(&client, 1);
+    ftpTestServer_stop(&server);
+
+    free(data);
+
+    return 0;
+}
+
+/* Batches go out by one session, and every reply gets read in its turn */
+static int testBatches(void)
+{
+    static const int counts[] = {1, 10, 100};
+    FtpTestServer server;
+    FtpClient client;
+    uint8_t *data[100];
+    size_t sizes[100];
+    char name[32];
+    uint64_t started;
+    int i, j;
+
+    for(i = 0; i < 100; ++i)
+    {
+        /* From nothing to a couple of the socket buffers */
+        sizes[i] = i == 0 ? 0 : (size_t)(i * 2719) % 300000;
+        data[i] = makeData(sizes[i], (unsigned long)i + 10);
+        TEST_CHECK(data[i] != NULL);
+    }
+
+    for(j = 0; j < 3; ++j)
+    {
+        ftpTestServer_init(&server);
+        TEST_CHECK(ftpTestServer_start(&server));
+
+        ftpClient_init(&client);
+        TEST_CHECK(ftpClient_login(&client, "127.0.0.1", server.port, "user", "pass", "/"));
+
+        started = coreSys_timeUs();
+
+        for(i = 0; i < counts[j]; ++i)
+        {
+            sprintf(name, "Scr_%03d.png", i);
+            TEST_CHECK(store(&client, name, data[i], sizes[i], 0, NULL) == STORE_DONE);
+            TEST_CHECK(client.replyCode == 226);
+        }
+
+        printf("batch of %d files: %.1f ms\n", counts[j], (double)(coreSys_timeUs() - started) / 1000.0);
+
+        /* Nothing is left unread on the control connection */
+        TEST_CHECK(ftpClient_isAlive(&client));
+        TEST_CHECK(ftpClient_noop(&client));
+        ftpClient_close(&client, 1);
+
+        for(i = 0; i < counts[j]; ++i)
+        {
+            sprintf(name, "Scr_%03d.png", i);
+            TEST_CHECK(sameFile(&server, name, data[i], sizes[i]));
+        }
+
+        ftpTestServer_stop(&server);
+
+        TEST_CHECK(server.logins == 1 && server.connections == 1);
+        /* USER, PASS, CWD, TYPE, EPSV and STOR per file, NOOP and QUIT */
+        TEST_CHECK(server.commands == 4 + counts[j] * 2 + 2);
+    }
+
+    for(i = 0; i < 100; ++i)
+        free(data[i]);
+
+    return 0;
+}
+
+static int commandCount(FtpTestServer *server)
+{
+    int count;
+
+    coreMutex_lock(&server->mutex);
+    count = server->commands;
+    coreMutex_unlock(&server->mutex);
+
+    return count;
+}
+
+/* The upload broken in the middle gets continued from the part the server has */
+static int testResume(void)
+{
+    FtpTestServer server;
+    FtpClient client;
+    uint8_t *data = makeData(300000, 3);
+    long offset;
+    int res, commands;
+
+    ftpTestServer_init(&server);
+    server.breakAfter = 100000;
+    TEST_CHECK(data && ftpTestServer_start(&server));
+
+    ftpClient_init(&client);
+    TEST_CHECK(ftpClient_login(&client, "127.0.0.1", server.port, "user", "pass", "/"));
+    res = store(&client, "part.png", data, 300000, 0, NULL);
+    TEST_CHECK(res == STORE_FAILED);
+    TEST_CHECK(client.step == FTP_STEP_SEND || (client.step == FTP_STEP_RESULT && client.replyCode == 426));
+    TEST_CHECK(sameFile(&server, "part.png", data, 100000));
+
+    /* The sender drops the session after the failure */
+    ftpClient_close(&client, 0);
+    TEST_CHECK(ftpClient_login(&client, "127.0.0.1", server.port, "user", "pass", "/"));
+    TEST_CHECK(store(&client, "part.png", data, 300000, 1, &offset) == STORE_DONE);
+    TEST_CHECK(offset == 100000);
+    TEST_CHECK(sameFile(&server, "part.png", data, 300000));
+
+    /* Only the 226 was lost: SIZE tells it's all there, nothing gets sent */
+    commands = commandCount(&server);
+    TEST_CHECK(store(&client, "part.png", data, 300000, 1, &offset) == STORE_DONE);
+    TEST_CHECK(offset == 300000 && commandCount(&server) - commands == 1);
+
+    /* The server has a different file that is longer, it gets replaced */
+    TEST_CHECK(store(&client, "part.png", data, 200000, 1, &offset) == STORE_DONE);
+    TEST_CHECK(offset == 0 && sameFile(&server, "part.png", data, 200000));
+
+    /* The file the server doesn't have goes from the start */
+    TEST_CHECK(store(&client, "new.png", data, 1000, 1, &offset) == STORE_DONE);
+    TEST_CHECK(offset == 0 && sameFile(&server, "new.png", data, 1000));
+
+    ftpClient_close(&client, 1);
+    ftpTestServer_stop(&server);
+
+    /* The server without REST gets the whole file again */
+    ftpTestServer_init(&server);
+    server.noRest = 1;
+    TEST_CHECK(ftpTestServer_start(&server));
+    ftpTestServer_putFile(&server, "part.png", data, 100000);
+
+    TEST_CHECK(ftpClient_login(&client, "127.0.0.1", server.port, "user", "pass", "/"));
+    TEST_CHECK(store(&client, "part.png", data, 300000, 1, &offset) == STORE_DONE);
+    TEST_CHECK(offset == 0 && sameFile(&server, "part.png", data, 300000));
+
+    ftpClient_close(&client, 1);
+    ftpTestServer_stop(&server);
+
+    free(data);
+
+    return 0;
+}
+
+static double elapsedMs(uint64_t since)
+{
+    return (double)(coreSys_timeUs() - since) / 1000.0;
+}
+
+/* Nobody listens at the port: the retries after the growing pauses, then the failure */
+static int testRefused(void)
+{
+    struct sockaddr_in addr;
+    FtpClient client;
+    CoreSocket sock;
+    uint64_t started;
+    uint16_t port;
+    double ms;
+
+    sock = coreNet_listenLocal(&port, 1);
+    TEST_CHECK(sock != CORE_INVALID_SOCKET);
+    coreNet_close(sock);
+
+    TEST_CHECK(coreNet_resolve("127.0.0.1", port, &addr));
+
+    started = coreSys_timeUs();
+    TEST_CHECK(ftpClient_connect(&addr, 0, 1000) == CORE_INVALID_SOCKET);
+    ms = elapsedMs(started);
+    printf("refused after %d tries: %.1f ms\n", FTP_CONNECT_TRIES, ms);
+
+    /* 250 + 500 ms of the pauses and up to 250 ms of the jitter each */
+    TEST_CHECK(ms >= 750.0 && ms < 2000.0);
+
+    ftpClient_init(&client);
+    TEST_CHECK(!ftpClient_login(&client, "127.0.0.1", port, "user", "pass", "/"));
+    TEST_CHECK(client.step == FTP_STEP_CONNECT && client.error != 0);
+
+    return 0;
+}
+
+/*
+ * The host that doesn't answer: the listener that never accepts drops the
+ * new connections once its queue is full, like the dead host drops the SYN.
+ * Some systems refuse them instead, that is the case above.
+ */
+static int testTimeout(void)
+{
+    struct sockaddr_in addr;
+    CoreSocket listener, queued[8];
+    FtpClient client;
+    uint64_t started;
+    uint16_t port;
+    int i, count = 0, timedOut = 0;
+    double ms = 0.0;
+
+    listener = coreNet_listenLocal(&port, 0);
+    TEST_CHECK(listener != CORE_INVALID_SOCKET);
+    TEST_CHECK(coreNet_resolve("127.0.0.1", port, &addr));
+
+    for(i = 0; i < 8; ++i)
+    {
+        started = coreSys_timeUs();
+        queued[count] = coreNet_connect(&addr, 0, 300, &timedOut);
+        ms = elapsedMs(started);
+
+        if(queued[count] == CORE_INVALID_SOCKET)
+            break;
+
+        ++count;
+    }
+
+    TEST_CHECK(i < 8);
+    printf("queue full after %d connections, %s in %.1f ms\n", count, timedOut ? "timed out" : "refused", ms);
+
+    if(timedOut)
+    {
+        TEST_CHECK(ms >= 290.0 && ms < 1000.0);
+
+        /* The host that has taken its time gets no retries */
+        ftpClient_init(&client);
+        client.connectTimeout = 300;
+        started = coreSys_timeUs();
+        TEST_CHECK(!ftpClient_login(&client, "127.0.0.1", port, "user", "pass", "/"));
+        ms = elapsedMs(started);
+        TEST_CHECK(client.step == FTP_STEP_CONNECT);
+        TEST_CHECK(ms >= 290.0 && ms < 1000.0);
+    }
+
+    for(i = 0; i < count; ++i)
+        coreNet_close(queued[i]);
+    coreNet_close(listener);
+
+    return 0;
+}
+
+/* The busy server accepts the connection, but greets a lot later: the client waits for it */
+static int testSlowAccept(void)
+{
+    FtpTestServer server;
+    FtpClient client;
+    uint64_t started;
+    double ms;
+
+    ftpTestServer_init(&server);
+    server.greetingDelay = 500;
+    TEST_CHECK(ftpTestServer_start(&server));
+
+    ftpClient_init(&client);
+    client.connectTimeout = 300;
+    started = coreSys_timeUs();
+    TEST_CHECK(ftpClient_login(&client, "127.0.0.1", server.port, "user", "pass", "/"));
+    ms = elapsedMs(started);
+    printf("greeting after %.1f ms\n", ms);
+    TEST_CHECK(ms >= 490.0);
+
+    ftpClient_close(&client, 1);
+    ftpTestServer_stop(&server);
+    TEST_CHECK(server.connections == 1);
+
+    return 0;
+}
+
+int main(void)
+{
+    TEST_CHECK(coreNet_init() == 0);
+    ftpClient_initResolver();
+
+    TEST_RUN(testLoginAndStore);
+    TEST_RUN(testLoginRejected);
+    TEST_RUN(testOldServer);
+    TEST_RUN(testBatches);
+    TEST_RUN(testResume);
+    TEST_RUN(testRefused);
+    TEST_RUN(testTimeout);
+    TEST_RUN(testSlowAccept);
+
+    ftpClient_quitResolver();
+    coreNet_quit();
+
+    return 0;
+}
@@ -0,0 +1,242 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "test_util.h"
+#include "ftp_proto.h"
+
+/* The control connection that gives the script by the pieces of the given size */
+typedef struct tagFakeConn
+{
+    const char *data;
+    size_t pos;
+    size_t len;
+    int chunk;
+} FakeConn;
+
+static int fakeRecv(void *user, char *buf, int size)
+{
+    FakeConn *c = (FakeConn *)user;
+    int len = (int)(c->len - c->pos);
+
+    if(len > c->chunk)
+        len = c->chunk;
+    if(len > size)
+        len = size;
+
+    memcpy(buf, c->data + c->pos, (size_t)len);
+    c->pos += (size_t)len;
+
+    return len;
+}
+
+static void fakeInit(FakeConn *c, FtpReplyReader *reader, const char *data, int chunk)
+{
+    c->data = data;
+    c->pos = 0;
+    c->len = strlen(data);
+    c->chunk = chunk;
+    ftpProto_initReader(reader, &fakeRecv, c);
+}
+
+static int testLineCode(void)
+{
+    TEST_CHECK(ftpProto_lineCode("220 Welcome\r\n") == 220);
+    TEST_CHECK(ftpProto_lineCode("230-More\r\n") == 230);
+    TEST_CHECK(ftpProto_lineCode("200") == 200);
+    TEST_CHECK(ftpProto_lineCode("2000 x") == 0);
+    TEST_CHECK(ftpProto_lineCode(" 220 x") == 0);
+    TEST_CHECK(ftpProto_lineCode("Hello") == 0);
+    return 0;
+}
+
+static int testReplies(void)
+{
+    FtpReplyReader reader;
+    FakeConn conn;
+    char reply[256];
+    int chunk;
+
+    /* Same result however the replies are split by the network */
+    for(chunk = 1; chunk <= 64; ++chunk)
+    {
+        fakeInit(&conn, &reader, "220 Ready\r\n331 Password required\r\n230 Logged in\r\n", chunk);
+
+        TEST_CHECK(ftpProto_readReply(&reader, reply, sizeof(reply)) == 220);
+        TEST_CHECK(strcmp(reply, "220 Ready\r\n") == 0);
+        TEST_CHECK(ftpProto_readReply(&reader, reply, sizeof(reply)) == 331);
+        TEST_CHECK(ftpProto_readReply(&reader, reply, sizeof(reply)) == 230);
+        TEST_CHECK(strcmp(reply, "230 Logged in\r\n") == 0);
+
+        /* The connection is closed */
+        TEST_CHECK(ftpProto_readReply(&reader, reply, sizeof(reply)) == -1);
+    }
+
+    fakeInit(&conn, &reader, "Garbage\r\n", 100);
+    TEST_CHECK(ftpProto_readReply(&reader, reply, sizeof(reply)) == 0);
+
+    return 0;
+}
+
+static int testMultiLineReplies(void)
+{
+    static const char script[] =
+        "230-Welcome\r\n"
+        " 230 the indented line is the text\r\n"
+        "200 the other code is the text too\r\n"
+        "230-still the text\r\n"
+        "230 Logged in\r\n"
+        "211-Features:\r\n"
+        " EPSV\r\n"
+        " SIZE\r\n"
+        "211 End\r\n"
+        "250 Done\r\n";
+    FtpReplyReader reader;
+    FakeConn conn;
+    char reply[512], small[32];
+    int chunk;
+
+    for(chunk = 1; chunk <= 64; ++chunk)
+    {
+        fakeInit(&conn, &reader, script, chunk);
+
+        /* Only the line with the same code and the space ends the reply */
+        TEST_CHECK(ftpProto_readReply(&reader, reply, sizeof(reply)) == 230);
+        TEST_CHECK(strcmp(reply, "230-Welcome\r\n"
+                                 " 230 the indented line is the text\r\n"
+                                 "200 the other code is the text too\r\n"
+                                 "230-still the text\r\n"
+                                 "230 Logged in\r\n") == 0);
+
+        /* The text that doesn't fit is skipped, the next reply is not affected */
+        TEST_CHECK(ftpProto_readReply(&reader, small, sizeof(small)) == 211);
+        TEST_CHECK(strcmp(small, "211-Features:\r\n EPSV\r\n SIZE\r\n") == 0);
+
+        TEST_CHECK(ftpProto_readReply(&reader, reply, sizeof(reply)) == 250);
+        TEST_CHECK(strcmp(reply, "250 Done\r\n") == 0);
+    }
+
+    /* The connection is closed in the middle of the reply */
+    fakeInit(&conn, &reader, "230-Welcome\r\n230-more\r\n", 7);
+    TEST_CHECK(ftpProto_readReply(&reader, reply, sizeof(reply)) == -1);
+
+    /* The line without the code can't start the reply */
+    fakeInit(&conn, &reader, " 230 Logged in\r\n", 100);
+    TEST_CHECK(ftpProto_readReply(&reader, reply, sizeof(reply)) == 0);
+
+    return 0;
+}
+
+static int testPassive(void)
+{
+    int ok;
+
+    TEST_CHECK(ftpProto_parsePassivePort("227 Entering Passive Mode (172,16,9,141,39,22).\r\n", &ok) == 39 * 256 + 22);
+    TEST_CHECK(ok);
+    TEST_CHECK(ftpProto_parsePassivePort("227 Entering Passive Mode (10,0,0,1,0,21)", &ok) == 21 && ok);
+
+    ftpProto_parsePassivePort("227 Entering Passive Mode 10,0,0,1,0,21", &ok);
+    TEST_CHECK(!ok);
+    ftpProto_parsePassivePort("227 Entering Passive Mode (10,0,0,1,300,21)", &ok);
+    TEST_CHECK(!ok);
+    ftpProto_parsePassivePort("227 Entering Passive Mode (10,0,0,1,21)", &ok);
+    TEST_CHECK(!ok);
+
+    return 0;
+}
+
+static int testExtPassive(void)
+{
+    int ok;
+
+    TEST_CHECK(ftpProto_parseExtPassivePort("229 Entering Extended Passive Mode (|||6446|)\r\n", &ok) == 6446);
+    TEST_CHECK(ok);
+
+    TEST_CHECK(ftpProto_parseExtPassivePort("229 Extended Passive Mode OK (|||65535|)", &ok) == 65535 && ok);
+    TEST_CHECK(ftpProto_parseExtPassivePort("229 (|||1|)", &ok) == 1 && ok);
+
+    ftpProto_parseExtPassivePort("229 Entering Extended Passive Mode", &ok);
+    TEST_CHECK(!ok);
+    ftpProto_parseExtPassivePort("229 Entering Extended Passive Mode (|||0|)", &ok);
+    TEST_CHECK(!ok);
+    ftpProto_parseExtPassivePort("229 Entering Extended Passive Mode (|||65536|)", &ok);
+    TEST_CHECK(!ok);
+    ftpProto_parseExtPassivePort("229 Entering Extended Passive Mode (|||99999999999999999999|)", &ok);
+    TEST_CHECK(!ok);
+    ftpProto_parseExtPassivePort("229 Entering Extended Passive Mode (|||-21|)", &ok);
+    TEST_CHECK(!ok);
+    ftpProto_parseExtPassivePort("229 Entering Extended Passive Mode (|||port|)", &ok);
+    TEST_CHECK(!ok);
+    ftpProto_parseExtPassivePort("229 Entering Extended Passive Mode (|||)", &ok);
+    TEST_CHECK(!ok);
+    ftpProto_parseExtPassivePort("229 Entering Extended Passive Mode (|||6446", &ok);
+    TEST_CHECK(!ok);
+    ftpProto_parseExtPassivePort("229 Entering Extended Passive Mode (||6446|)", &ok);
+    TEST_CHECK(!ok);
+
+    return 0;
+}
+
+static int testSize(void)
+{
+    TEST_CHECK(ftpProto_parseSize("213 12345\r\n") == 12345);
+    TEST_CHECK(ftpProto_parseSize("213 0\r\n") == 0);
+    TEST_CHECK(ftpProto_parseSize("550 No such file\r\n") == -1);
+    TEST_CHECK(ftpProto_parseSize("213 2147483647") == 2147483647L);
+
+    TEST_CHECK(ftpProto_parseSize("550") == -1);
+    TEST_CHECK(ftpProto_parseSize("213") == -1);
+    TEST_CHECK(ftpProto_parseSize("213\r\n") == -1);
+    TEST_CHECK(ftpProto_parseSize("213 \r\n") == -1);
+    TEST_CHECK(ftpProto_parseSize("213 abc\r\n") == -1);
+    TEST_CHECK(ftpProto_parseSize("213 -5\r\n") == -1);
+    TEST_CHECK(ftpProto_parseSize("213 +5\r\n") == -1);
+    TEST_CHECK(ftpProto_parseSize("213 12x\r\n") == -1);
+    TEST_CHECK(ftpProto_parseSize("213 2147483648\r\n") == -1);
+    TEST_CHECK(ftpProto_parseSize("213 99999999999999999999999\r\n") == -1);
+    TEST_CHECK(ftpProto_parseSize("213-12345\r\n") == -1);
+    return 0;
+}
+
+static int testBaseName(void)
+{
+    TEST_CHECK(strcmp(ftpProto_baseName("C:\\Shots\\Scr_1.png"), "Scr_1.png") == 0);
+    TEST_CHECK(strcmp(ftpProto_baseName("/home/user/Scr_2.png"), "Scr_2.png") == 0);
+    TEST_CHECK(strcmp(ftpProto_baseName("C:\\Shots/sub\\Scr_3.png"), "Scr_3.png") == 0);
+    TEST_CHECK(ftpProto_baseName("Scr_4.png") == NULL);
+    return 0;
+}
+
+int main(void)
+{
+    TEST_RUN(testLineCode);
+    TEST_RUN(testReplies);
+    TEST_RUN(testMultiLineReplies);
+    TEST_RUN(testPassive);
+    TEST_RUN(testExtPassive);
+    TEST_RUN(testSize);
+    TEST_RUN(testBaseName);
+    return 0;
+}
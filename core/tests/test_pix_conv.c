@@ -0,0 +1,180 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "pix_conv.h"
+
+static int testKnownPixels(void)
+{
+    const uint8_t src[4 * 5] =
+    {
+        0x01, 0x02, 0x03, 0xFF,
+        0x10, 0x20, 0x30, 0x00,
+        0xFF, 0x00, 0x80, 0x7F,
+        0x00, 0x00, 0x00, 0x00,
+        0xAB, 0xCD, 0xEF, 0x12
+    };
+    const uint8_t expected[3 * 5] =
+    {
+        0x03, 0x02, 0x01,
+        0x30, 0x20, 0x10,
+        0x80, 0x00, 0xFF,
+        0x00, 0x00, 0x00,
+        0xEF, 0xCD, 0xAB
+    };
+    uint8_t dst[3 * 5 + 1];
+
+    dst[15] = 0x5A;
+    pixConv_bgraToRgb(dst, src, 5);
+    TEST_CHECK(memcmp(dst, expected, sizeof(expected)) == 0);
+    /* Nothing is written past the last pixel */
+    TEST_CHECK(dst[15] == 0x5A);
+
+    return 0;
+}
+
+static int testInPlace(void)
+{
+    uint8_t buf[4 * 40], copy[4 * 40];
+    size_t pixels, i;
+
+    for(pixels = 0; pixels <= 40; ++pixels)
+    {
+        for(i = 0; i < sizeof(buf); ++i)
+            buf[i] = (uint8_t)(i * 7 + pixels);
+        memcpy(copy, buf, sizeof(buf));
+
+        pixConv_bgraToRgb(buf, buf, pixels);
+
+        for(i = 0; i < pixels; ++i)
+        {
+            TEST_CHECK(buf[i * 3 + 0] == copy[i * 4 + 2]);
+            TEST_CHECK(buf[i * 3 + 1] == copy[i * 4 + 1]);
+            TEST_CHECK(buf[i * 3 + 2] == copy[i * 4 + 0]);
+        }
+    }
+
+    return 0;
+}
+
+/* The loop the capture used before the SIMD conversion, the reference for the bit-exact checks */
+static void referenceBgraToRgb(uint8_t *dst, const uint8_t *src, size_t pixels)
+{
+    size_t i;
+
+    for(i = 0; i < pixels; ++i)
+    {
+        dst[i * 3 + 0] = src[i * 4 + 2];
+        dst[i * 3 + 1] = src[i * 4 + 1];
+        dst[i * 3 + 2] = src[i * 4 + 0];
+    }
+}
+
+/*
+ * Every width from 1 to 67 covers all remainders of the 4 and 16 pixel
+ * steps, so the scalar tail runs with every length. The rows are converted
+ * one by one from the padded source into the packed destination, at the
+ * unaligned addresses.
+ */
+static int testMatchesScalar(void)
+{
+    unsigned long rnd = 12345;
+    uint8_t *src, *dst, *ref;
+    size_t w, h, y, i, pad, offset, srcPitch;
+
+    src = (uint8_t *)malloc(4 * 80 * 9 + 64);
+    dst = (uint8_t *)malloc(3 * 80 * 9 + 64);
+    ref = (uint8_t *)malloc(3 * 80 * 9 + 64);
+    TEST_CHECK(src && dst && ref);
+
+    for(w = 1; w <= 67; ++w)
+    {
+        for(pad = 0; pad <= 12; pad += 4)
+        {
+            for(offset = 0; offset < 4; ++offset)
+            {
+                h = 1 + w % 9;
+                srcPitch = w * 4 + pad;
+
+                for(i = 0; i < srcPitch * h + offset; ++i)
+                    src[i] = (uint8_t)TEST_RND_NEXT(rnd);
+
+                memset(dst, 0xA5, 3 * w * h + 64);
+                memset(ref, 0xA5, 3 * w * h + 64);
+
+                for(y = 0; y < h; ++y)
+                {
+                    pixConv_bgraToRgb(dst + offset + y * w * 3, src + offset + y * srcPitch, w);
+                    referenceBgraToRgb(ref + offset + y * w * 3, src + offset + y * srcPitch, w);
+                }
+
+                /* Also checks that nothing is written past the end */
+                TEST_CHECK(memcmp(dst, ref, 3 * w * h + 64) == 0);
+            }
+        }
+    }
+
+    free(src);
+    free(dst);
+    free(ref);
+
+    return 0;
+}
+
+/* The whole frame in place, the way the capture converts it */
+static int testFrameInPlace(void)
+{
+    const size_t w = 1366, h = 77;
+    unsigned long rnd = 777;
+    uint8_t *buf, *ref;
+    size_t i;
+
+    buf = (uint8_t *)malloc(w * h * 4);
+    ref = (uint8_t *)malloc(w * h * 3);
+    TEST_CHECK(buf && ref);
+
+    for(i = 0; i < w * h * 4; ++i)
+        buf[i] = (uint8_t)TEST_RND_NEXT(rnd);
+
+    referenceBgraToRgb(ref, buf, w * h);
+    pixConv_bgraToRgb(buf, buf, w * h);
+    TEST_CHECK(memcmp(buf, ref, w * h * 3) == 0);
+
+    free(buf);
+    free(ref);
+
+    return 0;
+}
+
+int main(void)
+{
+    TEST_RUN(testKnownPixels);
+    TEST_RUN(testInPlace);
+    TEST_RUN(testMatchesScalar);
+    TEST_RUN(testFrameInPlace);
+    return 0;
+}
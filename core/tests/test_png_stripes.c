@@ -0,0 +1,357 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "png_stripes.h"
+#include "png_preset.h"
+#include "core_sys.h"
+
+#include "spng.h"
+
+static unsigned long s_rnd = 1;
+
+/* Flat areas with the noisy parts, like the screen */
+static uint8_t *makeImage(uint32_t w, uint32_t h, uint32_t pitch)
+{
+    uint8_t *img = (uint8_t *)malloc((size_t)pitch * h);
+    uint32_t x, y;
+
+    if(!img)
+        return NULL;
+
+    for(y = 0; y < h; ++y)
+    {
+        for(x = 0; x < pitch; ++x)
+        {
+            if((x / 24 + y / 16) % 3 == 0)
+                img[(size_t)y * pitch + x] = (uint8_t)TEST_RND_NEXT(s_rnd);
+            else
+                img[(size_t)y * pitch + x] = (uint8_t)(x / 32 * 40 + y / 8);
+        }
+    }
+
+    return img;
+}
+
+static int decodePng(const uint8_t *png, size_t len, int fmt, uint8_t **out, size_t *out_len, uint32_t *w, uint32_t *h)
+{
+    struct spng_ihdr ihdr;
+    spng_ctx *ctx = spng_ctx_new(0);
+    int ret;
+
+    *out = NULL;
+
+    if(!ctx)
+        return SPNG_EMEM;
+
+    ret = spng_set_png_buffer(ctx, png, len);
+    if(!ret)
+        ret = spng_get_ihdr(ctx, &ihdr);
+    if(!ret)
+        ret = spng_decoded_image_size(ctx, fmt, out_len);
+    if(!ret)
+    {
+        *out = (uint8_t *)malloc(*out_len);
+        ret = *out ? spng_decode_image(ctx, *out, *out_len, fmt, 0) : SPNG_EMEM;
+    }
+
+    if(!ret)
+    {
+        *w = ihdr.width;
+        *h = ihdr.height;
+    }
+
+    spng_ctx_free(ctx);
+
+    return ret;
+}
+
+static int roundTrip(uint32_t w, uint32_t h, uint32_t pad, int channels, int workers, int presetId)
+{
+    uint32_t pitch = w * (uint32_t)channels + pad, dw = 0, dh = 0, y;
+    uint8_t *img, *png = NULL, *dec = NULL;
+    size_t png_len = 0, dec_len = 0;
+    int ret;
+
+    img = makeImage(w, h, pitch);
+    TEST_CHECK(img != NULL);
+
+    ret = pngStripes_encodeToBuffer(&png, &png_len, img, w, h, pitch, channels, workers, pngPreset_get(presetId));
+    TEST_CHECK(ret == 0);
+
+    ret = decodePng(png, png_len, channels == 4 ? SPNG_FMT_RGBA8 : SPNG_FMT_RGB8, &dec, &dec_len, &dw, &dh);
+    TEST_CHECK(ret == 0);
+    TEST_CHECK(dw == w && dh == h);
+    TEST_CHECK(dec_len == (size_t)w * h * channels);
+
+    /* The padding at the end of the rows is not a part of the image */
+    for(y = 0; y < h; ++y)
+        TEST_CHECK(memcmp(dec + (size_t)y * w * channels, img + (size_t)y * pitch, (size_t)w * channels) == 0);
+
+    free(img);
+    free(png);
+    free(dec);
+
+    return 0;
+}
+
+static int testRoundTripRgb(void)
+{
+    int workers, preset;
+
+    for(workers = 1; workers <= 7; ++workers)
+    {
+        for(preset = 0; preset < PNG_PRESET_COUNT; ++preset)
+            TEST_CHECK(roundTrip(257, 301, 0, 3, workers, preset) == 0);
+    }
+
+    return 0;
+}
+
+static int testRoundTripRgba(void)
+{
+    int workers;
+
+    for(workers = 1; workers <= 4; ++workers)
+        TEST_CHECK(roundTrip(100, 130, 0, 4, workers, PNG_PRESET_DESKTOP) == 0);
+
+    return 0;
+}
+
+static int testRowPadding(void)
+{
+    TEST_CHECK(roundTrip(33, 97, 5, 3, 3, PNG_PRESET_DESKTOP) == 0);
+    TEST_CHECK(roundTrip(33, 97, 12, 4, 2, PNG_PRESET_FASTEST) == 0);
+    return 0;
+}
+
+/* More workers than the rows, and the single row */
+static int testShortImages(void)
+{
+    TEST_CHECK(roundTrip(64, 3, 0, 3, 8, PNG_PRESET_DESKTOP) == 0);
+    TEST_CHECK(roundTrip(1, 1, 0, 3, 4, PNG_PRESET_DESKTOP) == 0);
+    TEST_CHECK(roundTrip(5000, 1, 0, 3, 2, PNG_PRESET_SMALLEST) == 0);
+    return 0;
+}
+
+/* The plain libspng stream, the way the saver encodes with one worker */
+static int encodeSingle(uint8_t **png, size_t *png_len, const uint8_t *img, uint32_t w, uint32_t h, const PngPreset *preset)
+{
+    struct spng_ihdr ihdr;
+    spng_ctx *ctx = spng_ctx_new(SPNG_CTX_ENCODER);
+    int ret;
+
+    if(!ctx)
+        return SPNG_EMEM;
+
+    memset(&ihdr, 0, sizeof(ihdr));
+    ihdr.width = w;
+    ihdr.height = h;
+    ihdr.bit_depth = 8;
+    ihdr.color_type = SPNG_COLOR_TYPE_TRUECOLOR;
+
+    spng_set_ihdr(ctx, &ihdr);
+    spng_set_option(ctx, SPNG_ENCODE_TO_BUFFER, 1);
+    spng_set_option(ctx, SPNG_IMG_COMPRESSION_LEVEL, preset->level);
+    spng_set_option(ctx, SPNG_IMG_COMPRESSION_STRATEGY, preset->strategy);
+    spng_set_option(ctx, SPNG_FILTER_CHOICE, preset->filters);
+
+    ret = spng_encode_image(ctx, img, (size_t)w * h * 3, SPNG_FMT_PNG, SPNG_ENCODE_FINALIZE);
+    if(ret == 0)
+        *png = (uint8_t *)spng_get_png_buffer(ctx, png_len, &ret);
+
+    spng_ctx_free(ctx);
+
+    return ret;
+}
+
+/* The stripes give the same image as the single stream, and the size stays close to it */
+static int testMatchesSingleStream(void)
+{
+    const uint32_t w = 640, h = 480;
+    uint8_t *img, *single = NULL, *striped = NULL, *decSingle = NULL, *decStriped = NULL;
+    size_t singleLen = 0, stripedLen = 0, decLen = 0;
+    const PngPreset *preset;
+    uint32_t dw, dh;
+    int workers, p;
+
+    img = makeImage(w, h, w * 3);
+    TEST_CHECK(img != NULL);
+
+    for(p = 0; p < PNG_PRESET_COUNT; ++p)
+    {
+        preset = pngPreset_get(p);
+
+        TEST_CHECK(encodeSingle(&single, &singleLen, img, w, h, preset) == 0);
+        TEST_CHECK(decodePng(single, singleLen, SPNG_FMT_RGB8, &decSingle, &decLen, &dw, &dh) == 0);
+        TEST_CHECK(decLen == (size_t)w * h * 3 && memcmp(decSingle, img, decLen) == 0);
+
+        for(workers = 2; workers <= 8; workers *= 2)
+        {
+            TEST_CHECK(pngStripes_encodeToBuffer(&striped, &stripedLen, img, w, h, w * 3, 3, workers, preset) == 0);
+            TEST_CHECK(decodePng(striped, stripedLen, SPNG_FMT_RGB8, &decStriped, &decLen, &dw, &dh) == 0);
+            TEST_CHECK(decLen == (size_t)w * h * 3 && memcmp(decStriped, decSingle, decLen) == 0);
+
+            /* Every stripe restarts the compression, that costs a little only */
+            TEST_CHECK(stripedLen < singleLen + singleLen / 10 + 1024);
+
+            free(striped);
+            free(decStriped);
+        }
+
+        free(single);
+        free(decSingle);
+    }
+
+    free(img);
+
+    return 0;
+}
+
+static int testWorkersCount(void)
+{
+    TEST_CHECK(pngStripes_workersCount(1, 1080) == 1);
+    TEST_CHECK(pngStripes_workersCount(4, 1080) == 4);
+    TEST_CHECK(pngStripes_workersCount(100, 100000) == PNG_STRIPES_MAX_WORKERS);
+    /* Stripes are never shorter than PNG_STRIPES_MIN_ROWS */
+    TEST_CHECK(pngStripes_workersCount(8, PNG_STRIPES_MIN_ROWS * 3) == 3);
+    TEST_CHECK(pngStripes_workersCount(8, 1) == 1);
+    TEST_CHECK(pngStripes_workersCount(0, 1080) >= 1);
+    return 0;
+}
+
+#define CALLERS         4
+#define CALLER_ROUNDS   10
+
+typedef struct tagCaller
+{
+    CoreThread thread;
+    const uint8_t *img;
+    const uint8_t *expect;
+    size_t expectLen;
+    int failures;
+} Caller;
+
+static void callerThread(void *arg)
+{
+    Caller *c = (Caller *)arg;
+    uint8_t *png;
+    size_t len;
+    int i;
+
+    for(i = 0; i < CALLER_ROUNDS; ++i)
+    {
+        if(pngStripes_encodeToBuffer(&png, &len, c->img, 320, 256, 320 * 3, 3, 4 + i % 3,
+                                     pngPreset_get(PNG_PRESET_FASTEST)) != 0)
+        {
+            c->failures++;
+            continue;
+        }
+
+        /* The stripe count changes the file, only 4 stripes are compared byte by byte */
+        if(i % 3 == 0 && (len != c->expectLen || memcmp(png, c->expect, len) != 0))
+            c->failures++;
+
+        free(png);
+    }
+}
+
+/* Several savers share the helper threads at once, and get the same files as alone */
+static int testSharedHelpers(void)
+{
+    Caller callers[CALLERS];
+    uint8_t *img, *expect;
+    size_t expectLen;
+    int i;
+
+    img = makeImage(320, 256, 320 * 3);
+    TEST_CHECK(img != NULL);
+    TEST_CHECK(pngStripes_encodeToBuffer(&expect, &expectLen, img, 320, 256, 320 * 3, 3, 4,
+                                         pngPreset_get(PNG_PRESET_FASTEST)) == 0);
+
+    memset(callers, 0, sizeof(callers));
+
+    for(i = 0; i < CALLERS; ++i)
+    {
+        callers[i].img = img;
+        callers[i].expect = expect;
+        callers[i].expectLen = expectLen;
+        TEST_CHECK(coreThread_start(&callers[i].thread, &callerThread, &callers[i]));
+    }
+
+    for(i = 0; i < CALLERS; ++i)
+    {
+        coreThread_join(&callers[i].thread);
+        TEST_CHECK(callers[i].failures == 0);
+    }
+
+    free(expect);
+    free(img);
+
+    return 0;
+}
+
+/* Without the helpers the caller encodes every stripe itself, the file stays the same */
+static int testWithoutHelpers(void)
+{
+    uint8_t *img, *pooled, *alone;
+    size_t pooledLen, aloneLen;
+
+    img = makeImage(320, 256, 320 * 3);
+    TEST_CHECK(img != NULL);
+    TEST_CHECK(pngStripes_encodeToBuffer(&pooled, &pooledLen, img, 320, 256, 320 * 3, 3, 8,
+                                         pngPreset_get(PNG_PRESET_DESKTOP)) == 0);
+
+    pngStripes_quit();
+    TEST_CHECK(pngStripes_encodeToBuffer(&alone, &aloneLen, img, 320, 256, 320 * 3, 3, 8,
+                                         pngPreset_get(PNG_PRESET_DESKTOP)) == 0);
+    TEST_CHECK(aloneLen == pooledLen && memcmp(alone, pooled, aloneLen) == 0);
+    pngStripes_init(4);
+
+    free(alone);
+    free(pooled);
+    free(img);
+
+    return 0;
+}
+
+int main(void)
+{
+    pngStripes_init(4);
+
+    TEST_RUN(testRoundTripRgb);
+    TEST_RUN(testRoundTripRgba);
+    TEST_RUN(testRowPadding);
+    TEST_RUN(testShortImages);
+    TEST_RUN(testMatchesSingleStream);
+    TEST_RUN(testWorkersCount);
+    TEST_RUN(testSharedHelpers);
+    TEST_RUN(testWithoutHelpers);
+
+    pngStripes_quit();
+    return 0;
+}
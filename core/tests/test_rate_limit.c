@@ -0,0 +1,198 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+
+#include "test_util.h"
+#include "rate_limit.h"
+#include "core_sys.h"
+
+static int testUnlimited(void)
+{
+    RateLimit limit;
+    uint64_t wait = 1;
+
+    rateLimit_init(&limit, 0, 4096, 0);
+    TEST_CHECK(rateLimit_take(&limit, 123456789, 0, &wait) == 123456789 && wait == 0);
+    rateLimit_free(&limit);
+
+    return 0;
+}
+
+/* Sending as fast as the bucket allows for 10 seconds of the simulated clock */
+static int testSimulatedRate(void)
+{
+    static const uint32_t rates[] = {1000, 50000, 100000, 1048576, 10485760};
+    RateLimit limit;
+    uint64_t now, wait, sent;
+    size_t got;
+    int i;
+
+    for(i = 0; i < (int)(sizeof(rates) / sizeof(rates[0])); ++i)
+    {
+        now = 1000000;
+        sent = 0;
+        rateLimit_init(&limit, rates[i], 4096, now);
+
+        while(now < 11000000)
+        {
+            got = rateLimit_take(&limit, 65536, now, &wait);
+            if(got)
+                sent += got;
+            else
+            {
+                TEST_CHECK(wait > 0);
+                now += wait;
+            }
+        }
+
+        /* The bucket starts empty, so nothing goes above the rate, and the waits lose no more than the last piece */
+        TEST_CHECK(sent <= (uint64_t)rates[i] * 10);
+        TEST_CHECK(sent + (uint64_t)limit.burst >= (uint64_t)rates[i] * 10);
+
+        rateLimit_free(&limit);
+    }
+
+    return 0;
+}
+
+/* After the idle time the bucket gives 100 ms of the traffic at once, not more */
+static int testBurstCap(void)
+{
+    RateLimit limit;
+    uint64_t wait, sent = 0;
+    size_t got;
+
+    rateLimit_init(&limit, 1000000, 4096, 0);
+    TEST_CHECK(limit.burst == 100000.0);
+
+    /* More than the bucket holds is cut to it */
+    TEST_CHECK(rateLimit_take(&limit, 500000, 5000000, &wait) == 100000);
+    TEST_CHECK(rateLimit_take(&limit, 1, 5000000, &wait) == 0 && wait > 0);
+
+    /* The small pieces after the idle time add up to the capacity too */
+    while((got = rateLimit_take(&limit, 1000, 60000000, &wait)) > 0)
+        sent += got;
+    TEST_CHECK(sent == 100000);
+    TEST_CHECK(wait >= 1000 && wait <= 1001);
+
+    /* The slow rate still lets one chunk of the sender through */
+    rateLimit_free(&limit);
+    rateLimit_init(&limit, 1000, 4096, 0);
+    TEST_CHECK(limit.burst == 4096.0);
+    TEST_CHECK(rateLimit_take(&limit, 65536, 10000000, &wait) == 4096);
+    rateLimit_free(&limit);
+
+    /* The lower rate cuts the tokens to its capacity */
+    rateLimit_init(&limit, 1000000, 4096, 0);
+    TEST_CHECK(rateLimit_take(&limit, 1000, 1000000, &wait) == 1000);
+    rateLimit_setRate(&limit, 100000, 4096);
+    TEST_CHECK(limit.burst == 10000.0 && limit.tokens == 10000.0);
+    TEST_CHECK(rateLimit_take(&limit, 20000, 1000000, &wait) == 10000);
+    rateLimit_free(&limit);
+
+    /* The clock that went back doesn't add the tokens */
+    rateLimit_init(&limit, 1000000, 4096, 1000000);
+    TEST_CHECK(rateLimit_take(&limit, 1000, 500000, &wait) == 0);
+    rateLimit_free(&limit);
+
+    return 0;
+}
+
+#define REAL_RATE       2000000
+#define REAL_SENDERS    3
+#define REAL_BYTES      200000
+
+typedef struct tagRealSender
+{
+    CoreThread thread;
+    RateLimit *limit;
+} RealSender;
+
+static void waitUs(uint64_t us)
+{
+    uint64_t until = coreSys_timeUs() + us;
+
+    while(coreSys_timeUs() < until)
+        ;
+}
+
+static void realSender(void *arg)
+{
+    RealSender *sender = (RealSender *)arg;
+    uint64_t wait;
+    size_t left = REAL_BYTES, got;
+
+    while(left > 0)
+    {
+        got = rateLimit_take(sender->limit, left < 16384 ? left : 16384, coreSys_timeUs(), &wait);
+        if(got)
+            left -= got;
+        else
+            waitUs(wait);
+    }
+}
+
+/* The connections share the bucket, so together they keep the rate of the real clock */
+static int testRealClock(void)
+{
+    RealSender senders[REAL_SENDERS];
+    RateLimit limit;
+    uint64_t start, elapsed;
+    double rate;
+    int i;
+
+    start = coreSys_timeUs();
+    rateLimit_init(&limit, REAL_RATE, 4096, start);
+
+    for(i = 0; i < REAL_SENDERS; ++i)
+    {
+        senders[i].limit = &limit;
+        TEST_CHECK(coreThread_start(&senders[i].thread, &realSender, &senders[i]));
+    }
+
+    for(i = 0; i < REAL_SENDERS; ++i)
+        coreThread_join(&senders[i].thread);
+
+    elapsed = coreSys_timeUs() - start;
+    rate = (double)REAL_SENDERS * REAL_BYTES * 1000000.0 / (double)elapsed;
+    printf("achieved %.0f bytes/s of %d in %.3f s\n", rate, REAL_RATE, (double)elapsed / 1000000.0);
+
+    /* Never above the limit, and not much below it on the idle machine */
+    TEST_CHECK(rate <= REAL_RATE * 1.01);
+    TEST_CHECK(rate >= REAL_RATE * 0.5);
+
+    rateLimit_free(&limit);
+
+    return 0;
+}
+
+int main(void)
+{
+    TEST_RUN(testUnlimited);
+    TEST_RUN(testSimulatedRate);
+    TEST_RUN(testBurstCap);
+    TEST_RUN(testRealClock);
+    return 0;
+}
@@ -0,0 +1,228 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "shot_format.h"
+
+#include "spng.h"
+
+static int roundTrip(int format, const uint8_t *pixels, uint32_t w, uint32_t h, uint32_t pitch)
+{
+    uint8_t *data = NULL, *dec = NULL;
+    size_t len = 0;
+    uint32_t dw = 0, dh = 0, y;
+
+    TEST_CHECK(shotFormat_encode(format, &data, &len, pixels, w, h, pitch, 1, NULL) == 0);
+    TEST_CHECK(shotFormat_decode(data, len, &dec, &dw, &dh) == format);
+    TEST_CHECK(dw == w && dh == h);
+
+    for(y = 0; y < h; ++y)
+        TEST_CHECK(memcmp(dec + (size_t)y * w * 3, pixels + (size_t)y * pitch, (size_t)w * 3) == 0);
+
+    free(data);
+    free(dec);
+
+    return 0;
+}
+
+static int allFormats(const uint8_t *pixels, uint32_t w, uint32_t h, uint32_t pitch)
+{
+    TEST_CHECK(roundTrip(SHOT_FORMAT_QOI, pixels, w, h, pitch) == 0);
+    TEST_CHECK(roundTrip(SHOT_FORMAT_BMP, pixels, w, h, pitch) == 0);
+    TEST_CHECK(roundTrip(SHOT_FORMAT_TGA, pixels, w, h, pitch) == 0);
+    return 0;
+}
+
+/* The black pixel hashes into the slot that is empty at the start, the empty slot has the alpha of 0 */
+static int testBlackPixels(void)
+{
+    static const uint8_t sequence[8 * 3] =
+    {
+        255, 0, 0,   0, 0, 0,   255, 0, 0,   0, 0, 0,
+        50, 60, 70,  1, 2, 3,   0, 0, 0,     50, 60, 70
+    };
+    static const uint8_t blackFirst[4 * 3] =
+    {
+        0, 0, 0,   10, 10, 10,   0, 0, 0,   0, 0, 0
+    };
+
+    TEST_CHECK(allFormats(sequence, 8, 1, sizeof(sequence)) == 0);
+    TEST_CHECK(allFormats(sequence, 4, 2, 4 * 3) == 0);
+    TEST_CHECK(allFormats(blackFirst, 4, 1, sizeof(blackFirst)) == 0);
+
+    return 0;
+}
+
+/* Every QOI operation: the runs longer than 62, the small and the luma differences, the index and the full colour */
+static int testRandomImages(void)
+{
+    static const uint32_t sizes[][2] = {{1, 1}, {2, 3}, {7, 5}, {63, 2}, {64, 64}, {129, 17}, {333, 3}};
+    unsigned long rnd = 2024;
+    uint8_t *img, *px, prev[3] = {0, 0, 0};
+    uint32_t w, h, pitch, pad, x, y, i, s, kind;
+
+    for(s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        for(pad = 0; pad <= 5; pad += 5)
+        {
+            w = sizes[s][0];
+            h = sizes[s][1];
+            pitch = w * 3 + pad;
+            img = (uint8_t *)malloc((size_t)pitch * h);
+            TEST_CHECK(img != NULL);
+
+            for(y = 0; y < h; ++y)
+            {
+                px = img + (size_t)y * pitch;
+                for(x = 0; x < w; ++x, px += 3)
+                {
+                    kind = TEST_RND_NEXT(rnd) % 8;
+                    for(i = 0; i < 3; ++i)
+                    {
+                        if(kind < 2)
+                            px[i] = 0; /* Black, like the most of the screen */
+                        else if(kind < 4)
+                            px[i] = prev[i]; /* Run */
+                        else if(kind == 4)
+                            px[i] = (uint8_t)(prev[i] + TEST_RND_NEXT(rnd) % 4 - 2); /* Small difference */
+                        else if(kind == 5)
+                            px[i] = (uint8_t)(prev[i] + TEST_RND_NEXT(rnd) % 16 - 8); /* Luma */
+                        else if(kind == 6)
+                            px[i] = (uint8_t)(TEST_RND_NEXT(rnd) % 4 * 85); /* Often repeated colours */
+                        else
+                            px[i] = (uint8_t)TEST_RND_NEXT(rnd);
+                        prev[i] = px[i];
+                    }
+                }
+                for(i = 0; i < pad; ++i)
+                    img[(size_t)y * pitch + w * 3 + i] = 0xA5;
+            }
+
+            TEST_CHECK(allFormats(img, w, h, pitch) == 0);
+            free(img);
+        }
+    }
+
+    return 0;
+}
+
+static int testLongRuns(void)
+{
+    uint8_t *img = (uint8_t *)calloc(300 * 3 * 3, 1);
+    uint32_t i;
+
+    TEST_CHECK(img != NULL);
+
+    /* Black from the start, the single white pixel, and the long runs of the same colour */
+    img[150 * 3] = img[150 * 3 + 1] = img[150 * 3 + 2] = 255;
+    for(i = 400 * 3; i < 900 * 3; ++i)
+        img[i] = 0x33;
+
+    TEST_CHECK(allFormats(img, 300, 3, 300 * 3) == 0);
+    free(img);
+
+    return 0;
+}
+
+static int testDamagedFiles(void)
+{
+    uint8_t img[4 * 4 * 3], *data = NULL, *dec = NULL;
+    size_t len = 0;
+    uint32_t w, h;
+    int format;
+
+    memset(img, 0x5A, sizeof(img));
+    img[7] = 1;
+
+    for(format = SHOT_FORMAT_QOI; format < SHOT_FORMAT_COUNT; ++format)
+    {
+        TEST_CHECK(shotFormat_encode(format, &data, &len, img, 4, 4, 4 * 3, 1, NULL) == 0);
+        /* Cut in the middle of the pixels */
+        TEST_CHECK(shotFormat_decode(data, len / 2 + 2, &dec, &w, &h) == -1);
+        TEST_CHECK(dec == NULL);
+        free(data);
+    }
+
+    TEST_CHECK(shotFormat_decode((const uint8_t *)"qoif", 4, &dec, &w, &h) == -1);
+
+    return 0;
+}
+
+static int testConvertToPng(void)
+{
+    uint8_t img[5 * 3 * 3], *data = NULL, *png = NULL, *dec = NULL;
+    size_t len = 0, pngLen = 0, decLen = 0;
+    spng_ctx *ctx;
+    int format;
+    size_t i;
+
+    for(i = 0; i < sizeof(img); ++i)
+        img[i] = (uint8_t)(i % 3 ? i * 5 : 0);
+
+    for(format = SHOT_FORMAT_QOI; format < SHOT_FORMAT_COUNT; ++format)
+    {
+        TEST_CHECK(shotFormat_encode(format, &data, &len, img, 5, 3, 5 * 3, 1, NULL) == 0);
+        TEST_CHECK(shotFormat_convertToPng(data, len, &png, &pngLen, 1, pngPreset_get(PNG_PRESET_DEFAULT)) == 0);
+
+        ctx = spng_ctx_new(0);
+        TEST_CHECK(ctx != NULL);
+        TEST_CHECK(spng_set_png_buffer(ctx, png, pngLen) == 0);
+        TEST_CHECK(spng_decoded_image_size(ctx, SPNG_FMT_RGB8, &decLen) == 0 && decLen == sizeof(img));
+        dec = (uint8_t *)malloc(decLen);
+        TEST_CHECK(dec && spng_decode_image(ctx, dec, decLen, SPNG_FMT_RGB8, 0) == 0);
+        TEST_CHECK(memcmp(dec, img, sizeof(img)) == 0);
+        spng_ctx_free(ctx);
+        free(dec);
+        free(png);
+
+        /* The file that doesn't come back the same is kept as it is */
+        if(format == SHOT_FORMAT_BMP)
+        {
+            data[6] = 1; /* Reserved field of the header */
+            TEST_CHECK(shotFormat_convertToPng(data, len, &png, &pngLen, 1, pngPreset_get(PNG_PRESET_DEFAULT)) == -2);
+            TEST_CHECK(png == NULL && pngLen == 0);
+        }
+
+        /* The damaged file is not converted */
+        TEST_CHECK(shotFormat_convertToPng(data, len / 2, &png, &pngLen, 1, pngPreset_get(PNG_PRESET_DEFAULT)) == -1);
+        TEST_CHECK(png == NULL);
+
+        free(data);
+    }
+
+    return 0;
+}
+
+int main(void)
+{
+    TEST_RUN(testBlackPixels);
+    TEST_RUN(testRandomImages);
+    TEST_RUN(testLongRuns);
+    TEST_RUN(testDamagedFiles);
+    TEST_RUN(testConvertToPng);
+    return 0;
+}
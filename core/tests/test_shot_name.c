@@ -0,0 +1,147 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "shot_name.h"
+#include "core_sys.h"
+
+/* The files are made in the working directory of the test, at the date nobody takes the shots on */
+static const ShotTime s_time = {1990, 1, 2, 3, 4, 5};
+
+static int fileSize(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    long size;
+
+    if(!f)
+        return -1;
+
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fclose(f);
+
+    return (int)size;
+}
+
+static void expectedName(char *out, size_t size, const char *suffix, const char *ext)
+{
+    snprintf(out, size, ".%cScr_1990-01-02_03-04-05%s%s", CORE_PATH_SEP, suffix, ext);
+}
+
+static int testCollisions(void)
+{
+    char path[3][256], expected[256];
+
+    shotName_generate(path[0], sizeof(path[0]), ".", &s_time, ".png");
+    expectedName(expected, sizeof(expected), "", ".png");
+    TEST_CHECK(strcmp(path[0], expected) == 0);
+    /* The empty placeholder keeps the name reserved */
+    TEST_CHECK(fileSize(path[0]) == 0);
+
+    shotName_generate(path[1], sizeof(path[1]), ".", &s_time, ".png");
+    expectedName(expected, sizeof(expected), "-1", ".png");
+    TEST_CHECK(strcmp(path[1], expected) == 0);
+
+    shotName_generate(path[2], sizeof(path[2]), ".", &s_time, ".png");
+    expectedName(expected, sizeof(expected), "-2", ".png");
+    TEST_CHECK(strcmp(path[2], expected) == 0);
+
+    remove(path[0]);
+    remove(path[1]);
+    remove(path[2]);
+
+    return 0;
+}
+
+/* The shot in the other format takes the name too, as it gets converted into PNG later */
+static int testOtherFormats(void)
+{
+    char path[3][256], expected[256];
+
+    shotName_generate(path[0], sizeof(path[0]), ".", &s_time, ".qoi");
+    expectedName(expected, sizeof(expected), "", ".qoi");
+    TEST_CHECK(strcmp(path[0], expected) == 0);
+
+    shotName_generate(path[1], sizeof(path[1]), ".", &s_time, ".png");
+    expectedName(expected, sizeof(expected), "-1", ".png");
+    TEST_CHECK(strcmp(path[1], expected) == 0);
+
+    shotName_generate(path[2], sizeof(path[2]), ".", &s_time, ".bmp");
+    expectedName(expected, sizeof(expected), "-2", ".bmp");
+    TEST_CHECK(strcmp(path[2], expected) == 0);
+
+    remove(path[0]);
+    remove(path[1]);
+    remove(path[2]);
+
+    return 0;
+}
+
+/* The first free suffix is taken, so the name removed by the user gets used again */
+static int testSuffixes(void)
+{
+    char path[12][256], expected[256], suffix[8];
+    int i;
+
+    /* Two digit suffixes after the ten collisions */
+    for(i = 0; i < 12; ++i)
+    {
+        shotName_generate(path[i], sizeof(path[i]), ".", &s_time, ".png");
+        if(i)
+            snprintf(suffix, sizeof(suffix), "-%d", i);
+        else
+            suffix[0] = '\0';
+        expectedName(expected, sizeof(expected), suffix, ".png");
+        TEST_CHECK(strcmp(path[i], expected) == 0);
+    }
+
+    /* The gap in the middle gets filled before the next number */
+    remove(path[1]);
+    remove(path[5]);
+
+    shotName_generate(expected, sizeof(expected), ".", &s_time, ".png");
+    TEST_CHECK(strcmp(expected, path[1]) == 0);
+    shotName_generate(expected, sizeof(expected), ".", &s_time, ".png");
+    TEST_CHECK(strcmp(expected, path[5]) == 0);
+
+    shotName_generate(expected, sizeof(expected), ".", &s_time, ".png");
+    TEST_CHECK(strcmp(expected + strlen(expected) - 7, "-12.png") == 0);
+    remove(expected);
+
+    for(i = 0; i < 12; ++i)
+        remove(path[i]);
+
+    return 0;
+}
+
+int main(void)
+{
+    TEST_RUN(testCollisions);
+    TEST_RUN(testOtherFormats);
+    TEST_RUN(testSuffixes);
+    return 0;
+}
@@ -0,0 +1,393 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "shot_queue.h"
+#include "core_sys.h"
+#include "png_stripes.h"
+
+typedef struct tagTestFrame
+{
+    ShotQueueItem link;
+    int id;
+} TestFrame;
+
+#define MAX_FRAMES  16
+
+static TestFrame s_frames[MAX_FRAMES];
+
+static ShotQueueItem *frame(int id, size_t bytes)
+{
+    memset(&s_frames[id], 0, sizeof(TestFrame));
+    s_frames[id].id = id;
+    s_frames[id].link.bytes = bytes;
+    return &s_frames[id].link;
+}
+
+static int frameId(ShotQueueItem *item)
+{
+    return ((TestFrame *)item)->id;
+}
+
+static int listLength(ShotQueueItem *list)
+{
+    int len = 0;
+
+    for(; list; list = list->next)
+        len++;
+
+    return len;
+}
+
+static int testDropNewest(void)
+{
+    ShotQueue q;
+    ShotQueueItem *dropped;
+    int count;
+    size_t bytes;
+
+    shotQueue_init(&q);
+
+    /* The single frame is always accepted, even when it exceeds the budget alone */
+    TEST_CHECK(shotQueue_insert(&q, frame(0, 500), 100, QUEUE_DROP_NEWEST, &dropped) == 1);
+    TEST_CHECK(dropped == NULL);
+    TEST_CHECK(shotQueue_get(&q) == &s_frames[0].link);
+    shotQueue_done(&q, &s_frames[0].link, 100);
+
+    TEST_CHECK(shotQueue_insert(&q, frame(1, 60), 100, QUEUE_DROP_NEWEST, &dropped) == 1);
+    TEST_CHECK(shotQueue_insert(&q, frame(2, 40), 100, QUEUE_DROP_NEWEST, &dropped) == 1);
+    TEST_CHECK(shotQueue_insert(&q, frame(3, 1), 100, QUEUE_DROP_NEWEST, &dropped) == 0);
+    TEST_CHECK(dropped == NULL);
+
+    shotQueue_status(&q, &count, &bytes);
+    TEST_CHECK(count == 2 && bytes == 100);
+
+    /* No budget, no limit */
+    TEST_CHECK(shotQueue_insert(&q, frame(4, 1000), 0, QUEUE_DROP_NEWEST, &dropped) == 1);
+
+    shotQueue_free(&q);
+
+    return 0;
+}
+
+static int testDropOldest(void)
+{
+    ShotQueue q;
+    ShotQueueItem *dropped;
+    int count;
+    size_t bytes;
+
+    shotQueue_init(&q);
+
+    shotQueue_insert(&q, frame(0, 60), 100, QUEUE_DROP_OLDEST, &dropped);
+    shotQueue_insert(&q, frame(1, 30), 100, QUEUE_DROP_OLDEST, &dropped);
+    TEST_CHECK(shotQueue_insert(&q, frame(2, 50), 100, QUEUE_DROP_OLDEST, &dropped) == 1);
+    TEST_CHECK(listLength(dropped) == 1 && frameId(dropped) == 0);
+
+    shotQueue_status(&q, &count, &bytes);
+    TEST_CHECK(count == 2 && bytes == 80);
+    TEST_CHECK(frameId(shotQueue_get(&q)) == 1);
+    TEST_CHECK(frameId(shotQueue_get(&q)) == 2);
+    TEST_CHECK(shotQueue_get(&q) == NULL);
+
+    shotQueue_free(&q);
+
+    return 0;
+}
+
+static int testCoalesce(void)
+{
+    ShotQueue q;
+    ShotQueueItem *dropped, *a;
+    int count;
+    size_t bytes;
+
+    shotQueue_init(&q);
+
+    shotQueue_insert(&q, frame(0, 40), 100, QUEUE_COALESCE, &dropped);
+    shotQueue_insert(&q, frame(1, 30), 100, QUEUE_COALESCE, &dropped);
+    shotQueue_insert(&q, frame(2, 20), 100, QUEUE_COALESCE, &dropped);
+
+    /* All waiting frames get replaced by the new one, even if dropping one would be enough */
+    TEST_CHECK(shotQueue_insert(&q, frame(3, 20), 100, QUEUE_COALESCE, &dropped) == 1);
+    TEST_CHECK(listLength(dropped) == 3);
+
+    shotQueue_status(&q, &count, &bytes);
+    TEST_CHECK(count == 1 && bytes == 20);
+    a = shotQueue_get(&q);
+    TEST_CHECK(frameId(a) == 3);
+    TEST_CHECK(shotQueue_get(&q) == NULL);
+
+    /* The frame being saved is not replaced, but still counts against the budget */
+    shotQueue_insert(&q, frame(4, 50), 100, QUEUE_COALESCE, &dropped);
+    TEST_CHECK(shotQueue_insert(&q, frame(5, 40), 100, QUEUE_COALESCE, &dropped) == 1);
+    TEST_CHECK(listLength(dropped) == 1 && frameId(dropped) == 4);
+
+    shotQueue_status(&q, &count, &bytes);
+    TEST_CHECK(count == 2 && bytes == 60);
+    TEST_CHECK(frameId(shotQueue_get(&q)) == 5);
+    TEST_CHECK(shotQueue_get(&q) == NULL);
+
+    shotQueue_free(&q);
+
+    return 0;
+}
+
+static int testDegrade(void)
+{
+    ShotQueue q;
+    ShotQueueItem *dropped, *a, *b, *c;
+
+    shotQueue_init(&q);
+
+    shotQueue_insert(&q, frame(0, 60), 100, QUEUE_DEGRADE, &dropped);
+    shotQueue_insert(&q, frame(1, 30), 100, QUEUE_DEGRADE, &dropped);
+
+    a = shotQueue_get(&q);
+    TEST_CHECK(a->degraded == 0);
+
+    /* Over the budget, but under the twice of it */
+    TEST_CHECK(shotQueue_insert(&q, frame(2, 50), 100, QUEUE_DEGRADE, &dropped) == 1);
+    TEST_CHECK(dropped == NULL);
+    TEST_CHECK(shotQueue_insert(&q, frame(3, 100), 100, QUEUE_DEGRADE, &dropped) == 0);
+
+    b = shotQueue_get(&q);
+    TEST_CHECK(b->degraded == 1);
+
+    /* The degraded mode ends once the queue drains to the half of the budget */
+    shotQueue_done(&q, a, 100);
+    c = shotQueue_get(&q);
+    TEST_CHECK(c->degraded == 1);
+    shotQueue_done(&q, b, 100);
+    shotQueue_done(&q, c, 100);
+
+    TEST_CHECK(shotQueue_insert(&q, frame(4, 10), 100, QUEUE_DEGRADE, &dropped) == 1);
+    TEST_CHECK(shotQueue_get(&q)->degraded == 0);
+
+    shotQueue_free(&q);
+
+    return 0;
+}
+
+static int testPolicyNames(void)
+{
+    int i;
+
+    for(i = 0; i < QUEUE_POLICY_COUNT; ++i)
+        TEST_CHECK(shotQueue_policyFromName(shotQueue_policyName(i)) == i);
+
+    TEST_CHECK(shotQueue_policyFromName("DROP-OLDEST") == QUEUE_DROP_OLDEST);
+    TEST_CHECK(shotQueue_policyFromName("bogus") == QUEUE_DROP_NEWEST);
+    TEST_CHECK(strcmp(shotQueue_policyName(-1), "drop-newest") == 0);
+
+    return 0;
+}
+
+static int s_handed[MAX_FRAMES];
+static int s_handedCount = 0;
+
+static void recordHandOver(ShotQueueItem *item, void *user)
+{
+    (void)user;
+    s_handed[s_handedCount++] = frameId(item);
+}
+
+static int testHandOverOrder(void)
+{
+    const int finishOrder[5] = {3, 1, 0, 4, 2};
+    ShotQueueItem *taken[5];
+    ShotQueueItem *dropped;
+    ShotQueue q;
+    int i;
+
+    shotQueue_init(&q);
+
+    for(i = 0; i < 5; ++i)
+        shotQueue_insert(&q, frame(i, 10), 0, QUEUE_DROP_NEWEST, &dropped);
+
+    for(i = 0; i < 5; ++i)
+        taken[i] = shotQueue_get(&q);
+
+    s_handedCount = 0;
+
+    shotQueue_handOver(&q, taken[finishOrder[0]], &recordHandOver, NULL);
+    shotQueue_handOver(&q, taken[finishOrder[1]], &recordHandOver, NULL);
+    TEST_CHECK(s_handedCount == 0);
+
+    shotQueue_handOver(&q, taken[finishOrder[2]], &recordHandOver, NULL);
+    TEST_CHECK(s_handedCount == 2);
+
+    shotQueue_handOver(&q, taken[finishOrder[3]], &recordHandOver, NULL);
+    TEST_CHECK(s_handedCount == 2);
+
+    shotQueue_handOver(&q, taken[finishOrder[4]], &recordHandOver, NULL);
+    TEST_CHECK(s_handedCount == 5);
+
+    for(i = 0; i < 5; ++i)
+        TEST_CHECK(s_handed[i] == i);
+
+    shotQueue_free(&q);
+
+    return 0;
+}
+
+#define STRESS_FRAMES   100
+#define STRESS_SAVERS   8
+#define STRESS_W        320
+#define STRESS_H        200
+
+static TestFrame s_stressFrames[STRESS_FRAMES];
+static int s_stressHanded[STRESS_FRAMES];
+static int s_stressHandedCount = 0;
+static uint8_t s_stressPixels[STRESS_W * STRESS_H * 3];
+
+typedef struct tagStressSaver
+{
+    CoreThread thread;
+    ShotQueue *queue;
+    unsigned long rnd;
+    int failures;
+} StressSaver;
+
+static void recordStressHandOver(ShotQueueItem *item, void *user)
+{
+    (void)user;
+    /* The callbacks go under the queue mutex, one at a time */
+    if(s_stressHandedCount < STRESS_FRAMES)
+        s_stressHanded[s_stressHandedCount] = frameId(item);
+    s_stressHandedCount++;
+}
+
+/* Takes the frames like the saver threads do: encodes every one in 2 stripes, and waits a random time up to 0.5 ms */
+static void stressSaver(void *arg)
+{
+    StressSaver *saver = (StressSaver *)arg;
+    ShotQueueItem *item;
+    uint64_t until;
+    uint8_t *png;
+    size_t len;
+
+    while((item = shotQueue_get(saver->queue)) != NULL)
+    {
+        if(pngStripes_encodeToBuffer(&png, &len, s_stressPixels, STRESS_W, STRESS_H, STRESS_W * 3, 3, 2,
+                                     pngPreset_get(PNG_PRESET_DESKTOP)) == 0)
+            free(png);
+        else
+            saver->failures++;
+
+        until = coreSys_timeUs() + TEST_RND_NEXT(saver->rnd) % 500;
+        while(coreSys_timeUs() < until)
+            ;
+
+        shotQueue_done(saver->queue, item, 0);
+        shotQueue_handOver(saver->queue, item, &recordStressHandOver, NULL);
+    }
+}
+
+static int runStress(int saversCount)
+{
+    StressSaver savers[STRESS_SAVERS];
+    ShotQueueItem *dropped;
+    ShotQueue q;
+    uint64_t start;
+    int i, count;
+    size_t bytes;
+
+    shotQueue_init(&q);
+
+    for(i = 0; i < STRESS_FRAMES; ++i)
+    {
+        memset(&s_stressFrames[i], 0, sizeof(TestFrame));
+        s_stressFrames[i].id = i;
+        s_stressFrames[i].link.bytes = 10;
+        TEST_CHECK(shotQueue_insert(&q, &s_stressFrames[i].link, 0, QUEUE_DROP_NEWEST, &dropped) == 1);
+    }
+
+    s_stressHandedCount = 0;
+    start = coreSys_timeUs();
+
+    for(i = 0; i < saversCount; ++i)
+    {
+        savers[i].queue = &q;
+        savers[i].rnd = 1000 + i;
+        savers[i].failures = 0;
+        TEST_CHECK(coreThread_start(&savers[i].thread, &stressSaver, &savers[i]));
+    }
+
+    for(i = 0; i < saversCount; ++i)
+    {
+        coreThread_join(&savers[i].thread);
+        TEST_CHECK(savers[i].failures == 0);
+    }
+
+    printf("%d savers: %d frames in %.1f ms\n", saversCount, STRESS_FRAMES, (double)(coreSys_timeUs() - start) / 1000.0);
+
+    /* Every frame is handed over once, in the order of the queue */
+    TEST_CHECK(s_stressHandedCount == STRESS_FRAMES);
+    for(i = 0; i < STRESS_FRAMES; ++i)
+        TEST_CHECK(s_stressHanded[i] == i);
+
+    shotQueue_status(&q, &count, &bytes);
+    TEST_CHECK(count == 0 && bytes == 0);
+
+    shotQueue_free(&q);
+
+    return 0;
+}
+
+/* The wall time of 100 frames against the number of the savers, all of them share the stripe helpers */
+static int testHandOverStress(void)
+{
+    unsigned long rnd = 5;
+    int savers;
+    size_t i;
+
+    for(i = 0; i < sizeof(s_stressPixels); ++i)
+        s_stressPixels[i] = (uint8_t)((i / 300) % 7 == 0 ? TEST_RND_NEXT(rnd) : i / 960);
+
+    printf("%d CPU cores\n", coreSys_cpuCount());
+    pngStripes_init(2);
+
+    for(savers = 1; savers <= STRESS_SAVERS; savers *= 2)
+        TEST_CHECK(runStress(savers) == 0);
+
+    pngStripes_quit();
+
+    return 0;
+}
+
+int main(void)
+{
+    TEST_RUN(testDropNewest);
+    TEST_RUN(testDropOldest);
+    TEST_RUN(testCoalesce);
+    TEST_RUN(testDegrade);
+    TEST_RUN(testPolicyNames);
+    TEST_RUN(testHandOverOrder);
+    TEST_RUN(testHandOverStress);
+    return 0;
+}
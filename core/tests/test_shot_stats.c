@@ -0,0 +1,230 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "shot_stats.h"
+
+#define VALUES      2000
+
+static const char s_jsonPath[] = "test_shot_stats.json";
+
+/* Upper limits of the buckets, the same as s_bucketLimits at shot_stats.c */
+static const uint32_t s_limits[SHOT_STATS_BUCKETS - 1] =
+{
+    1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000
+};
+
+static int compareU32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static void addValue(ShotStatsHistogram *h, uint32_t ms)
+{
+    int i;
+
+    for(i = 0; i < SHOT_STATS_BUCKETS - 1 && ms > s_limits[i]; ++i)
+        ;
+
+    h->buckets[i]++;
+    h->count++;
+    h->sumMs += ms;
+    if(ms > h->maxMs)
+        h->maxMs = ms;
+}
+
+/* Limits of the bucket that holds the value */
+static void bucketOf(uint32_t ms, uint32_t maxMs, uint32_t *low, uint32_t *high)
+{
+    int i;
+
+    for(i = 0; i < SHOT_STATS_BUCKETS - 1 && ms > s_limits[i]; ++i)
+        ;
+
+    *low = i > 0 ? s_limits[i - 1] : 0;
+    *high = i < SHOT_STATS_BUCKETS - 1 ? s_limits[i] : maxMs;
+}
+
+static int testEdges(void)
+{
+    ShotStatsHistogram h;
+
+    memset(&h, 0, sizeof(h));
+    TEST_CHECK(shotStats_percentile(&h, 95) == 0);
+    TEST_CHECK(shotStats_average(&h) == 0);
+
+    /* One value comes back exactly, the bucket is cut by the maximum */
+    addValue(&h, 7);
+    TEST_CHECK(shotStats_percentile(&h, 50) == 7);
+    TEST_CHECK(shotStats_percentile(&h, 95) == 7);
+
+    /* The percentile out of the range is clamped */
+    addValue(&h, 0);
+    TEST_CHECK(shotStats_percentile(&h, 0) == shotStats_percentile(&h, 1));
+    TEST_CHECK(shotStats_percentile(&h, 500) == 7);
+
+    /* The values above the last limit are interpolated up to the maximum */
+    memset(&h, 0, sizeof(h));
+    addValue(&h, 30000);
+    addValue(&h, 60000);
+    TEST_CHECK(shotStats_percentile(&h, 100) == 60000);
+    TEST_CHECK(shotStats_percentile(&h, 50) == 35000);
+
+    /* 1 to 100 ms once each: the 95th value of the even spread is exactly 95 */
+    memset(&h, 0, sizeof(h));
+    for(h.maxMs = 0; h.count < 100; )
+        addValue(&h, h.count + 1);
+    TEST_CHECK(shotStats_percentile(&h, 95) == 95);
+    TEST_CHECK(shotStats_percentile(&h, 50) == 50);
+    TEST_CHECK(shotStats_average(&h) == 51);
+
+    return 0;
+}
+
+/* The estimate stays in the bucket of the true percentile, whatever the distribution is */
+static int testDistributions(void)
+{
+    static uint32_t values[VALUES];
+    static const int pcts[] = {50, 90, 95, 99, 100};
+    ShotStatsHistogram h;
+    unsigned long seed = 7;
+    uint32_t estimate, exact, low, high, r;
+    int d, i, p;
+
+    for(d = 0; d < 4; ++d)
+    {
+        memset(&h, 0, sizeof(h));
+
+        for(i = 0; i < VALUES; ++i)
+        {
+            r = (uint32_t)TEST_RND_NEXT(seed);
+
+            switch(d)
+            {
+            case 0: /* Encode times of the same screen */
+                values[i] = 40 + r % 30;
+                break;
+            case 1: /* Long tail: most shots are fast, some are slowed down by the disk */
+                values[i] = r % 100 < 90 ? 5 + r % 20 : 300 + r % 3000;
+                break;
+            case 2: /* Uniform over the whole range */
+                values[i] = r % 20000;
+                break;
+            default: /* Two modes: the memory uploads and the reconnects */
+                values[i] = r % 2 ? 15 + r % 5 : 900 + r % 200;
+                break;
+            }
+
+            addValue(&h, values[i]);
+        }
+
+        qsort(values, VALUES, sizeof(values[0]), &compareU32);
+
+        for(p = 0; p < (int)(sizeof(pcts) / sizeof(pcts[0])); ++p)
+        {
+            exact = values[(VALUES * pcts[p] + 99) / 100 - 1];
+            estimate = shotStats_percentile(&h, pcts[p]);
+            bucketOf(exact, h.maxMs, &low, &high);
+
+            if(d == 1 && pcts[p] == 95)
+                printf("long tail p95: exact %lu ms, estimate %lu ms\n", (unsigned long)exact, (unsigned long)estimate);
+
+            TEST_CHECK(estimate >= low && estimate <= high);
+        }
+
+        TEST_CHECK(shotStats_percentile(&h, 100) == values[VALUES - 1]);
+    }
+
+    return 0;
+}
+
+/* The counters keep the histogram, the tooltip and the JSON file show its p95 */
+static int testCounters(void)
+{
+    ShotStats s;
+    char tip[128], *json, expect[64];
+    FILE *f;
+    long len;
+    int i;
+
+    shotStats_get(&s);
+    TEST_CHECK(s.shotsSaved == 0);
+
+    shotStats_init();
+
+    for(i = 1; i <= 100; ++i)
+    {
+        shotStats_shotTaken();
+        shotStats_shotSaved((uint32_t)i, 1000);
+    }
+
+    shotStats_uploaded(30, 500);
+    shotStats_uploadFailed();
+    shotStats_get(&s);
+
+    TEST_CHECK(s.shotsTaken == 100 && s.shotsSaved == 100 && s.bytesWritten == 100000.0);
+    TEST_CHECK(s.encode.count == 100 && s.encode.maxMs == 100);
+    TEST_CHECK(shotStats_percentile(&s.encode, 95) == 95);
+    TEST_CHECK(s.upload.count == 1 && s.uploadsDone == 1 && s.uploadsFailed == 1);
+
+    shotStats_formatTip(&s, tip, sizeof(tip));
+    TEST_CHECK(strcmp(tip, "TinyShot: 100 shots, enc 51/95 ms, queue 0, up 0, 1 failed") == 0);
+
+    shotStats_formatTip(&s, tip, 10);
+    TEST_CHECK(strcmp(tip, "TinyShot:") == 0);
+
+    TEST_CHECK(shotStats_writeJson(&s, s_jsonPath));
+    f = fopen(s_jsonPath, "rb");
+    TEST_CHECK(f != NULL);
+    fseek(f, 0, SEEK_END);
+    len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    json = (char *)calloc((size_t)len + 1, 1);
+    TEST_CHECK(json && fread(json, 1, (size_t)len, f) == (size_t)len);
+    fclose(f);
+
+    sprintf(expect, "\"p95_ms\": %d", 95);
+    TEST_CHECK(strstr(json, expect) != NULL);
+    TEST_CHECK(strstr(json, "{\"le_ms\": 100, \"count\": 50}") != NULL);
+
+    free(json);
+    remove(s_jsonPath);
+    shotStats_quit();
+
+    return 0;
+}
+
+int main(void)
+{
+    TEST_RUN(testEdges);
+    TEST_RUN(testDistributions);
+    TEST_RUN(testCounters);
+
+    return 0;
+}
@@ -0,0 +1,287 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "shot_trace.h"
+#include "core_sys.h"
+
+#define THREADS             4
+#define THREAD_POINTS       20000
+#define OVERHEAD_POINTS     200000
+
+static const char s_binPath[] = "test_shot_trace.bin";
+static const char s_jsonPath[] = "test_shot_trace.json";
+
+/* Read the whole file, NULL if it can't be read */
+static char *readFile(const char *path, size_t *size)
+{
+    FILE *f = fopen(path, "rb");
+    char *data;
+    long len;
+
+    if(!f)
+        return NULL;
+
+    fseek(f, 0, SEEK_END);
+    len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    data = (char *)malloc((size_t)len + 1);
+    if(data && fread(data, 1, (size_t)len, f) != (size_t)len)
+    {
+        free(data);
+        data = NULL;
+    }
+
+    fclose(f);
+
+    if(data)
+    {
+        data[len] = '\0';
+        *size = (size_t)len;
+    }
+
+    return data;
+}
+
+/* Load the binary dump, returns the events and their number, NULL if the dump is broken */
+static ShotTraceEvent *loadBinary(uint32_t *count)
+{
+    ShotTraceEvent *events;
+    uint32_t header[2];
+    size_t size = 0;
+    char *data = readFile(s_binPath, &size);
+
+    if(!data || size < 16 || memcmp(data, SHOT_TRACE_MAGIC, 8) != 0)
+    {
+        free(data);
+        return NULL;
+    }
+
+    memcpy(header, data + 8, sizeof(header));
+    if(header[1] != sizeof(ShotTraceEvent) || size != 16 + (size_t)header[0] * sizeof(ShotTraceEvent))
+    {
+        free(data);
+        return NULL;
+    }
+
+    events = (ShotTraceEvent *)malloc((size_t)header[0] * sizeof(ShotTraceEvent) + 1);
+    if(events)
+        memcpy(events, data + 16, (size_t)header[0] * sizeof(ShotTraceEvent));
+
+    *count = header[0];
+    free(data);
+
+    return events;
+}
+
+static int testDisabled(void)
+{
+    TEST_CHECK(shotTrace_newShot() == 0);
+    shotTrace_point(TRACE_HOOK, 0, 0);
+    TEST_CHECK(shotTrace_dump(s_binPath, TRACE_FORMAT_BINARY) == -1);
+
+    return 0;
+}
+
+/* The ring keeps the latest events, from the oldest to the newest */
+static int testWrap(void)
+{
+    ShotTraceEvent *events;
+    uint32_t i, count = 0, total = SHOT_TRACE_EVENTS + 1000;
+
+    shotTrace_init();
+
+    for(i = 0; i < 10; ++i)
+        shotTrace_point(TRACE_CAPTURE, i, i);
+
+    TEST_CHECK(shotTrace_dump(s_binPath, TRACE_FORMAT_BINARY) == 10);
+    events = loadBinary(&count);
+    TEST_CHECK(events && count == 10 && events[9].arg == 9 && events[9].point == TRACE_CAPTURE);
+    free(events);
+
+    for(i = 10; i < total; ++i)
+        shotTrace_point(i % TRACE_POINT_COUNT, i, i);
+
+    TEST_CHECK(shotTrace_dump(s_binPath, TRACE_FORMAT_BINARY) == SHOT_TRACE_EVENTS);
+    events = loadBinary(&count);
+    TEST_CHECK(events && count == SHOT_TRACE_EVENTS);
+
+    for(i = 0; i < count; ++i)
+    {
+        TEST_CHECK(events[i].arg == total - SHOT_TRACE_EVENTS + i);
+        TEST_CHECK(events[i].point == events[i].arg % TRACE_POINT_COUNT);
+        TEST_CHECK(events[i].thread == (uint32_t)coreSys_threadId());
+        TEST_CHECK(i == 0 || events[i].time >= events[i - 1].time);
+    }
+
+    free(events);
+    shotTrace_quit();
+    remove(s_binPath);
+
+    return 0;
+}
+
+static void pointThread(void *arg)
+{
+    uint32_t n = (uint32_t)(size_t)arg, i;
+
+    for(i = 0; i < THREAD_POINTS; ++i)
+        shotTrace_point(TRACE_ENQUEUE, n, n * THREAD_POINTS + i);
+}
+
+/* The events of the parallel threads don't tear each other */
+static int testThreads(void)
+{
+    CoreThread threads[THREADS];
+    ShotTraceEvent *events;
+    uint32_t i, count = 0, last[THREADS];
+
+    shotTrace_init();
+
+    for(i = 0; i < THREADS; ++i)
+        TEST_CHECK(coreThread_start(&threads[i], &pointThread, (void *)(size_t)i));
+
+    for(i = 0; i < THREADS; ++i)
+        coreThread_join(&threads[i]);
+
+    TEST_CHECK(shotTrace_dump(s_binPath, TRACE_FORMAT_BINARY) == SHOT_TRACE_EVENTS);
+    events = loadBinary(&count);
+    TEST_CHECK(events && count == SHOT_TRACE_EVENTS);
+
+    memset(last, 0, sizeof(last));
+
+    for(i = 0; i < count; ++i)
+    {
+        TEST_CHECK(events[i].shot < THREADS);
+        TEST_CHECK(events[i].arg / THREAD_POINTS == events[i].shot);
+        /* Every thread's own events stay in their order */
+        TEST_CHECK(events[i].arg >= last[events[i].shot]);
+        last[events[i].shot] = events[i].arg;
+    }
+
+    /* The newest event of the ring is the last one of some thread */
+    TEST_CHECK(events[count - 1].arg % THREAD_POINTS == THREAD_POINTS - 1);
+
+    free(events);
+    shotTrace_quit();
+    remove(s_binPath);
+
+    return 0;
+}
+
+/* Chrome trace event format: the encoding is the slice, the rest are the instant marks */
+static int testJson(void)
+{
+    size_t size = 0;
+    char *json, *p;
+    int braces = 0, brackets = 0, events = 0;
+    uint32_t shot;
+
+    shotTrace_init();
+    shot = shotTrace_newShot();
+    TEST_CHECK(shot != 0);
+
+    shotTrace_point(TRACE_HOOK, 0, 0);
+    shotTrace_point(TRACE_CAPTURE, shot, 0);
+    shotTrace_point(TRACE_ENCODE_BEGIN, shot, 0);
+    shotTrace_point(TRACE_ENCODE_END, shot, 12345);
+    shotTrace_point(TRACE_FTP_DONE, shot, 4000000000UL);
+
+    TEST_CHECK(shotTrace_dump(s_jsonPath, TRACE_FORMAT_JSON) == 5);
+    json = readFile(s_jsonPath, &size);
+    TEST_CHECK(json != NULL);
+
+    TEST_CHECK(strncmp(json, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n", 42) == 0);
+    TEST_CHECK(size > 4 && strcmp(json + size - 4, "\n]}\n") == 0);
+
+    for(p = json; *p; ++p)
+    {
+        braces += *p == '{' ? 1 : *p == '}' ? -1 : 0;
+        brackets += *p == '[' ? 1 : *p == ']' ? -1 : 0;
+        TEST_CHECK(braces >= 0 && brackets >= 0);
+    }
+
+    TEST_CHECK(braces == 0 && brackets == 0);
+
+    for(p = strstr(json, "\"name\""); p; p = strstr(p + 1, "\"name\""))
+        ++events;
+
+    TEST_CHECK(events == 5);
+    TEST_CHECK(strstr(json, "{\"name\": \"hook\", \"ph\": \"i\", \"s\": \"t\", \"ts\": 0, \"pid\": 1,") != NULL);
+    TEST_CHECK(strstr(json, "{\"name\": \"encode\", \"ph\": \"B\",") != NULL);
+    TEST_CHECK(strstr(json, "{\"name\": \"encode\", \"ph\": \"E\",") != NULL);
+    TEST_CHECK(strstr(json, "\"arg\": 12345}}") != NULL);
+    TEST_CHECK(strstr(json, "{\"name\": \"ftp-226\",") != NULL);
+    TEST_CHECK(strstr(json, "\"arg\": 4000000000}}") != NULL);
+
+    free(json);
+    shotTrace_quit();
+    remove(s_jsonPath);
+
+    return 0;
+}
+
+/* The point costs one timer read and one uncontended lock, well under a microsecond */
+static int testOverhead(void)
+{
+    uint64_t start, elapsed, idle;
+    double ns;
+    uint32_t i;
+
+    /* The disabled trace costs nothing but the check */
+    start = coreSys_timeUs();
+    for(i = 0; i < OVERHEAD_POINTS; ++i)
+        shotTrace_point(TRACE_HASH, i, i);
+    idle = coreSys_timeUs() - start;
+
+    shotTrace_init();
+
+    start = coreSys_timeUs();
+    for(i = 0; i < OVERHEAD_POINTS; ++i)
+        shotTrace_point(TRACE_HASH, i, i);
+    elapsed = coreSys_timeUs() - start;
+
+    shotTrace_quit();
+
+    ns = (double)elapsed * 1000.0 / OVERHEAD_POINTS;
+    printf("trace point: %.1f ns, disabled: %.1f ns\n", ns, (double)idle * 1000.0 / OVERHEAD_POINTS);
+    TEST_CHECK(ns < 1000.0);
+
+    return 0;
+}
+
+int main(void)
+{
+    TEST_RUN(testDisabled);
+    TEST_RUN(testWrap);
+    TEST_RUN(testThreads);
+    TEST_RUN(testJson);
+    TEST_RUN(testOverhead);
+
+    return 0;
+}
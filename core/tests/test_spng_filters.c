@@ -0,0 +1,215 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * The encoder filters of libspng through the SIMD and the scalar paths
+ * against the straightforward filters of the PNG specification. The
+ * functions are internal, so the library source is compiled right here.
+ */
+
+#include <stdlib.h>
+
+#include "spng.c"
+
+#include "test_util.h"
+
+static uint8_t refPaeth(int a, int b, int c)
+{
+    int p = a + b - c, pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+
+    if(pa <= pb && pa <= pc)
+        return (uint8_t)a;
+
+    return (uint8_t)(pb <= pc ? b : c);
+}
+
+static uint8_t refFilter(const uint8_t *prev, const uint8_t *cur, size_t i, unsigned bpp, unsigned filter)
+{
+    int a = i >= bpp ? cur[i - bpp] : 0;
+    int b = prev[i];
+    int c = i >= bpp ? prev[i - bpp] : 0;
+
+    switch(filter)
+    {
+    case 1:
+        return (uint8_t)(cur[i] - a);
+    case 2:
+        return (uint8_t)(cur[i] - b);
+    case 3:
+        return (uint8_t)(cur[i] - (a + b) / 2);
+    case 4:
+        return (uint8_t)(cur[i] - refPaeth(a, b, c));
+    default:
+        return cur[i];
+    }
+}
+
+static int32_t refSum(const uint8_t *prev, const uint8_t *cur, size_t len, unsigned bpp, unsigned filter)
+{
+    uint32_t sum = 0;
+    size_t i;
+    int x;
+
+    for(i = 0; i < len; ++i)
+    {
+        x = refFilter(prev, cur, i, bpp, filter);
+        sum += 128 - abs(x - 128);
+    }
+
+    return (int32_t)sum;
+}
+
+#define MAX_ROW 2100
+
+/* Both rows start at the odd offsets, so the loads are never aligned */
+static uint8_t s_prev[MAX_ROW + 16];
+static uint8_t s_cur[MAX_ROW + 16];
+static uint8_t s_out[MAX_ROW + 16];
+
+static int checkRow(size_t len, unsigned bpp, size_t offset)
+{
+    const uint8_t *prev = s_prev + offset, *cur = s_cur + offset;
+    uint8_t *out = s_out + offset;
+    unsigned filter;
+    size_t i;
+
+    for(filter = 1; filter <= 4; ++filter)
+    {
+        memset(s_out, 0xA5, sizeof(s_out));
+
+        if(len > 0)
+        {
+            /* The width counts the filter type byte */
+            TEST_CHECK(filter_scanline(out, prev, cur, len + 1, bpp, filter) == 0);
+
+            /* The SIMD steps and the scalar code of libspng give the same bytes */
+            for(i = 0; i < len; ++i)
+            {
+                TEST_CHECK(out[i] == refFilter(prev, cur, i, bpp, filter));
+                TEST_CHECK(filter_byte(prev, cur, i, bpp, filter) == out[i]);
+            }
+        }
+
+        /* Nothing is written past the row */
+        TEST_CHECK(out[len] == 0xA5);
+    }
+
+    for(filter = 0; filter <= 4; ++filter)
+        TEST_CHECK(filter_sum(prev, cur, len, bpp, filter) == refSum(prev, cur, len, bpp, filter));
+
+    return 0;
+}
+
+static int fillRows(unsigned long *rnd, int flat)
+{
+    size_t i;
+
+    /* The flat rows give the small differences, the noisy ones give all byte values */
+    for(i = 0; i < sizeof(s_cur); ++i)
+    {
+        s_prev[i] = (uint8_t)(flat ? 100 + TEST_RND_NEXT(*rnd) % 5 : TEST_RND_NEXT(*rnd));
+        s_cur[i] = (uint8_t)(flat ? 100 + TEST_RND_NEXT(*rnd) % 5 : TEST_RND_NEXT(*rnd));
+    }
+
+    return 0;
+}
+
+static int testAllWidths(void)
+{
+    static const unsigned bpps[] = {1, 2, 3, 4, 6, 8};
+    unsigned long rnd = 4242;
+    size_t len, b;
+    int flat;
+
+    for(flat = 0; flat < 2; ++flat)
+    {
+        for(b = 0; b < sizeof(bpps) / sizeof(bpps[0]); ++b)
+        {
+            for(len = 0; len <= 100; ++len)
+            {
+                fillRows(&rnd, flat);
+                TEST_CHECK(checkRow(len, bpps[b], 1 + len % 15) == 0);
+            }
+        }
+    }
+
+    return 0;
+}
+
+/* The widths of the real screens, 3 and 4 bytes per pixel */
+static int testScreenRows(void)
+{
+    static const size_t widths[] = {640, 641, 700, 699};
+    unsigned long rnd = 99;
+    size_t w;
+
+    for(w = 0; w < sizeof(widths) / sizeof(widths[0]); ++w)
+    {
+        fillRows(&rnd, (int)w & 1);
+        TEST_CHECK(checkRow(widths[w] * 3, 3, 3) == 0);
+        TEST_CHECK(checkRow(widths[w] * 3, 4, 7) == 0);
+    }
+
+    return 0;
+}
+
+static int testBestFilter(void)
+{
+    unsigned long rnd = 2024;
+    int32_t sum, best;
+    unsigned f, expected;
+    size_t len;
+
+    for(len = 1; len < 300; len += 7)
+    {
+        fillRows(&rnd, len & 1);
+
+        best = INT32_MAX;
+        expected = 0;
+        for(f = 0; f <= 4; ++f)
+        {
+            sum = abs(refSum(s_prev, s_cur, len, 3, f));
+            if(sum < best)
+            {
+                best = sum;
+                expected = f;
+            }
+        }
+
+        TEST_CHECK(get_best_filter(s_prev, s_cur, len + 1, 3, SPNG_FILTER_CHOICE_ALL) == expected);
+    }
+
+    return 0;
+}
+
+int main(void)
+{
+#ifndef SPNG_DISABLE_OPT
+    printf("SIMD filters: %s\n", simd_filters_supported() ? "yes" : "no");
+#endif
+    TEST_RUN(testAllWidths);
+    TEST_RUN(testScreenRows);
+    TEST_RUN(testBestFilter);
+    return 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+/*
+ * The minimal checks for the unit tests of the core library: every test is
+ * the separate executable run by ctest, it returns 1 on the first failure.
+ */
+
+#include <stdio.h>
+
+#define TEST_CHECK(cond) \
+    do { \
+        if(!(cond)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            return 1; \
+        } \
+    } while(0)
+
+/* Run the test function, returns from the caller when it fails */
+#define TEST_RUN(func) \
+    do { \
+        if(func() != 0) \
+        { \
+            fprintf(stderr, "FAILED: %s\n", #func); \
+            return 1; \
+        } \
+        printf("ok: %s\n", #func); \
+    } while(0)
+
+/* Deterministic pseudo-random numbers, the failures are reproducible */
+#define TEST_RND_NEXT(state) ((state) = (state) * 1103515245UL + 12345UL, ((state) >> 16) & 0x7FFF)
+
+#endif /* TEST_UTIL_H */
@@ -0,0 +1,315 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Rebuilds the full frames from the shots saved by the delta capture mode.
+ *
+ * Usage: delta_rebuild OUTPUT_DIR Scr_*.png
+ *
+ * The files may be given in any order: every delta names the file of the previous shot,
+ * so the chains are followed from their key frames. Every rebuilt frame is written
+ * into the output directory under the name of its original file, the key frames too.
+ * Deltas whose chain is broken (a missing or dropped file) are reported and skipped.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "spng.h"
+#include "png_preset.h"
+#include "frame_delta.h"
+#include "core_sys.h"
+
+struct ShotFile
+{
+    const char *path;
+    const char *name;
+    /* Part of the frame for the delta, the whole frame for the key frame */
+    FrameDeltaRect rect;
+    int isDelta;
+    /* Name of the previous shot for the delta */
+    char prev[260];
+    int used;
+};
+
+typedef struct ShotFile ShotFile;
+
+static const char *baseName(const char *path)
+{
+    const char *p, *base = path;
+
+    for(p = path; *p; ++p)
+    {
+        if(*p == '/' || *p == '\\')
+            base = p + 1;
+    }
+
+    return base;
+}
+
+/* Read the size, position and the previous shot name, and optionally decode the pixels as RGB */
+static int readShot(ShotFile *shot, uint8_t **pixels)
+{
+    struct spng_ihdr ihdr;
+    struct spng_offs offs;
+    struct spng_text *text = NULL;
+    uint32_t i, n_text = 0;
+    spng_ctx *ctx;
+    size_t size;
+    FILE *f;
+    int ret;
+
+    f = fopen(shot->path, "rb");
+    if(!f)
+    {
+        fprintf(stderr, "%s: can't open the file\n", shot->path);
+        return 0;
+    }
+
+    ctx = spng_ctx_new(0);
+    if(!ctx)
+    {
+        fclose(f);
+        return 0;
+    }
+
+    spng_set_png_file(ctx, f);
+
+    ret = spng_get_ihdr(ctx, &ihdr);
+    if(ret)
+    {
+        fprintf(stderr, "%s: %s\n", shot->path, spng_strerror(ret));
+        goto fail;
+    }
+
+    shot->rect.x = 0;
+    shot->rect.y = 0;
+    shot->rect.w = ihdr.width;
+    shot->rect.h = ihdr.height;
+    shot->isDelta = 0;
+    shot->prev[0] = '\0';
+
+    if(spng_get_text(ctx, NULL, &n_text) == 0 && n_text > 0)
+    {
+        text = (struct spng_text *)malloc(sizeof(struct spng_text) * n_text);
+        if(text && spng_get_text(ctx, text, &n_text) == 0)
+        {
+            for(i = 0; i < n_text; ++i)
+            {
+                if(strcmp(text[i].keyword, FRAME_DELTA_KEYWORD) == 0 && text[i].length < sizeof(shot->prev))
+                {
+                    memcpy(shot->prev, text[i].text, text[i].length);
+                    shot->prev[text[i].length] = '\0';
+                    shot->isDelta = 1;
+                }
+            }
+        }
+        free(text);
+    }
+
+    if(shot->isDelta && spng_get_offs(ctx, &offs) == 0 && offs.x >= 0 && offs.y >= 0)
+    {
+        shot->rect.x = (uint32_t)offs.x;
+        shot->rect.y = (uint32_t)offs.y;
+    }
+
+    if(pixels)
+    {
+        ret = spng_decoded_image_size(ctx, SPNG_FMT_RGB8, &size);
+        if(!ret)
+        {
+            *pixels = (uint8_t *)malloc(size);
+            ret = *pixels ? spng_decode_image(ctx, *pixels, size, SPNG_FMT_RGB8, 0) : SPNG_EMEM;
+        }
+
+        if(ret)
+        {
+            fprintf(stderr, "%s: %s\n", shot->path, spng_strerror(ret));
+            if(*pixels)
+                free(*pixels);
+            *pixels = NULL;
+            goto fail;
+        }
+    }
+
+    spng_ctx_free(ctx);
+    fclose(f);
+    return 1;
+
+fail:
+    spng_ctx_free(ctx);
+    fclose(f);
+    return 0;
+}
+
+static int writeFrame(const char *dir, const char *name, const uint8_t *pixels, uint32_t w, uint32_t h)
+{
+    const PngPreset *preset = pngPreset_get(PNG_PRESET_DESKTOP);
+    struct spng_ihdr ihdr;
+    char path[1024];
+    spng_ctx *ctx;
+    FILE *f;
+    int ret;
+
+    sprintf(path, "%.700s%c%.300s", dir, CORE_PATH_SEP, name);
+
+    f = fopen(path, "wb");
+    if(!f)
+    {
+        fprintf(stderr, "%s: can't write the file\n", path);
+        return 0;
+    }
+
+    ctx = spng_ctx_new(SPNG_CTX_ENCODER);
+    if(!ctx)
+    {
+        fclose(f);
+        return 0;
+    }
+
+    memset(&ihdr, 0, sizeof(ihdr));
+    ihdr.width = w;
+    ihdr.height = h;
+    ihdr.bit_depth = 8;
+    ihdr.color_type = SPNG_COLOR_TYPE_TRUECOLOR;
+
+    spng_set_ihdr(ctx, &ihdr);
+    spng_set_png_file(ctx, f);
+    spng_set_option(ctx, SPNG_IMG_COMPRESSION_LEVEL, preset->level);
+    spng_set_option(ctx, SPNG_IMG_COMPRESSION_STRATEGY, preset->strategy);
+    spng_set_option(ctx, SPNG_FILTER_CHOICE, preset->filters);
+
+    ret = spng_encode_image(ctx, pixels, (size_t)w * h * 3, SPNG_FMT_PNG, SPNG_ENCODE_FINALIZE);
+
+    spng_ctx_free(ctx);
+
+    if(fclose(f) != 0 && !ret)
+        ret = SPNG_IO_ERROR;
+
+    if(ret)
+    {
+        fprintf(stderr, "%s: %s\n", path, spng_strerror(ret));
+        return 0;
+    }
+
+    return 1;
+}
+
+/* Follow the chain of deltas that starts from the key frame */
+static int rebuildChain(const char *outDir, ShotFile *shots, int count, int key)
+{
+    uint8_t *frame = NULL, *part = NULL;
+    uint32_t w, h;
+    int cur = key, next, i, written = 0;
+
+    if(!readShot(&shots[key], &frame))
+        return 0;
+
+    w = shots[key].rect.w;
+    h = shots[key].rect.h;
+
+    while(cur >= 0)
+    {
+        if(cur != key)
+        {
+            if(!readShot(&shots[cur], &part))
+                break;
+
+            frameDelta_paste(frame, w, h, 3, part, &shots[cur].rect);
+            free(part);
+            part = NULL;
+        }
+
+        shots[cur].used = 1;
+
+        if(!writeFrame(outDir, shots[cur].name, frame, w, h))
+            break;
+
+        ++written;
+
+        next = -1;
+        for(i = 0; i < count; ++i)
+        {
+            if(!shots[i].used && shots[i].isDelta && coreSys_strcasecmp(shots[i].prev, shots[cur].name) == 0)
+            {
+                next = i;
+                break;
+            }
+        }
+
+        cur = next;
+    }
+
+    free(frame);
+
+    return written;
+}
+
+int main(int argc, char **argv)
+{
+    ShotFile *shots;
+    int i, count, written = 0, orphans = 0;
+
+    if(argc < 3)
+    {
+        fprintf(stderr, "Usage: delta_rebuild OUTPUT_DIR Scr_*.png\n");
+        return 1;
+    }
+
+    count = argc - 2;
+    shots = (ShotFile *)calloc((size_t)count, sizeof(ShotFile));
+    if(!shots)
+        return 1;
+
+    for(i = 0; i < count; ++i)
+    {
+        shots[i].path = argv[i + 2];
+        shots[i].name = baseName(argv[i + 2]);
+
+        if(!readShot(&shots[i], NULL))
+            shots[i].used = 1;
+    }
+
+    for(i = 0; i < count; ++i)
+    {
+        if(!shots[i].used && !shots[i].isDelta)
+            written += rebuildChain(argv[1], shots, count, i);
+    }
+
+    for(i = 0; i < count; ++i)
+    {
+        if(!shots[i].used && shots[i].isDelta)
+        {
+            fprintf(stderr, "%s: the previous shot %s is missing\n", shots[i].path, shots[i].prev);
+            ++orphans;
+        }
+    }
+
+    fprintf(stderr, "%d frames written, %d deltas skipped\n", written, orphans);
+
+    free(shots);
+
+    return orphans > 0 ? 2 : 0;
+}
@@ -42,6 +42,12 @@
             #define SPNG_X86_64
         #endif
 
+        #if defined(_MSC_VER)
+            #include <intrin.h>
+        #elif defined(__GNUC__)
+            #include <cpuid.h>
+        #endif
+
     #elif defined(__aarch64__) || defined(_M_ARM64) /* || defined(__ARM_NEON) */
         #define SPNG_ARM /* NOTE: only arm64 builds are tested! */
     #else
@@ -64,6 +70,9 @@
         static void defilter_paeth3(size_t rowbytes, unsigned char *row, const unsigned char *prev);
         static void defilter_paeth4(size_t rowbytes, unsigned char *row, const unsigned char *prev);
 
+        static size_t filter_row_simd(unsigned char *filtered, const unsigned char *prev_scanline, const unsigned char *scanline,
+                                      size_t i, size_t size, unsigned bytes_per_pixel, unsigned filter, uint32_t *sum);
+
         #if defined(SPNG_ARM)
         static uint32_t expand_palette_rgba8_neon(unsigned char *row, const unsigned char *scanline, const unsigned char *plte, uint32_t width);
         static uint32_t expand_palette_rgb8_neon(unsigned char *row, const unsigned char *scanline, const unsigned char *plte, uint32_t width);
@@ -1588,10 +1597,97 @@ no_opt:
     return 0;
 }
 
+static uint8_t filter_byte(const unsigned char *prev_scanline, const unsigned char *scanline,
+                           size_t i, unsigned bytes_per_pixel, const unsigned filter)
+{
+    uint8_t x, a, b, c;
+
+    if(i >= bytes_per_pixel)
+    {
+        a = scanline[i - bytes_per_pixel];
+        b = prev_scanline[i];
+        c = prev_scanline[i - bytes_per_pixel];
+    }
+    else /* first pixel in row */
+    {
+        a = 0;
+        b = prev_scanline[i];
+        c = 0;
+    }
+
+    x = scanline[i];
+
+    switch(filter)
+    {
+        case SPNG_FILTER_NONE:
+        {
+            break;
+        }
+        case SPNG_FILTER_SUB:
+        {
+            x = x - a;
+            break;
+        }
+        case SPNG_FILTER_UP:
+        {
+            x = x - b;
+            break;
+        }
+        case SPNG_FILTER_AVERAGE:
+        {
+            uint16_t avg = (a + b) / 2;
+            x = x - avg;
+            break;
+        }
+        case SPNG_FILTER_PAETH:
+        {
+            x = x - paeth(a,b,c);
+            break;
+        }
+    }
+
+    return x;
+}
+
+#ifndef SPNG_DISABLE_OPT
+/* Unlike the decoder the encoder can't assume the SIMD extensions are present,
+   check them once before using filter_row_simd() */
+static int simd_filters_supported(void)
+{
+#if defined(SPNG_X86)
+    static int supported = -1;
+
+    if(supported < 0)
+    {
+        unsigned int info[4] = { 0, 0, 0, 0 };
+
+    #if defined(_MSC_VER)
+        __cpuid((int*)info, 1);
+    #elif defined(__GNUC__)
+        /* Fails on the old CPUs without the CPUID instruction */
+        __get_cpuid(1, &info[0], &info[1], &info[2], &info[3]);
+    #endif
+
+    #if defined(SPNG_SSE) && SPNG_SSE == 4
+        supported = (info[2] >> 19) & 1; /* SSE4.1 */
+    #elif defined(SPNG_SSE) && SPNG_SSE == 3
+        supported = (info[2] >> 9) & 1; /* SSSE3 */
+    #else
+        supported = (info[3] >> 26) & 1; /* SSE2 */
+    #endif
+    }
+
+    return supported;
+#else
+    return 1;
+#endif
+}
+#endif
+
 static int filter_scanline(unsigned char *filtered, const unsigned char *prev_scanline, const unsigned char *scanline,
                            size_t scanline_width, unsigned bytes_per_pixel, const unsigned filter)
 {
-    uint32_t i;
+    size_t i;
 
     if(prev_scanline == NULL || scanline == NULL || scanline_width <= 1) return SPNG_EINTERNAL;
 
@@ -1600,51 +1696,21 @@ static int filter_scanline(unsigned char *filtered, const unsigned char *prev_sc
 
     scanline_width--;
 
-    for(i=0; i < scanline_width; i++)
+    for(i=0; i < scanline_width && i < bytes_per_pixel; i++)
     {
-        uint8_t x, a, b, c;
-
-        if(i >= bytes_per_pixel)
-        {
-            a = scanline[i - bytes_per_pixel];
-            b = prev_scanline[i];
-            c = prev_scanline[i - bytes_per_pixel];
-        }
-        else /* first pixel in row */
-        {
-            a = 0;
-            b = prev_scanline[i];
-            c = 0;
-        }
-
-        x = scanline[i];
+        filtered[i] = filter_byte(prev_scanline, scanline, i, bytes_per_pixel, filter);
+    }
 
-        switch(filter)
-        {
-            case SPNG_FILTER_SUB:
-            {
-                x = x - a;
-                break;
-            }
-            case SPNG_FILTER_UP:
-            {
-                x = x - b;
-                break;
-            }
-            case SPNG_FILTER_AVERAGE:
-            {
-                uint16_t avg = (a + b) / 2;
-                x = x - avg;
-                break;
-            }
-            case SPNG_FILTER_PAETH:
-            {
-                x = x - paeth(a,b,c);
-                break;
-            }
-        }
+#ifndef SPNG_DISABLE_OPT
+    if(simd_filters_supported())
+    {
+        i = filter_row_simd(filtered, prev_scanline, scanline, i, scanline_width, bytes_per_pixel, filter, NULL);
+    }
+#endif
 
-        filtered[i] = x;
+    for(; i < scanline_width; i++)
+    {
+        filtered[i] = filter_byte(prev_scanline, scanline, i, bytes_per_pixel, filter);
     }
 
     return 0;
@@ -1653,63 +1719,33 @@ static int filter_scanline(unsigned char *filtered, const unsigned char *prev_sc
 static int32_t filter_sum(const unsigned char *prev_scanline, const unsigned char *scanline,
                           size_t size, unsigned bytes_per_pixel, const unsigned filter)
 {
-    uint32_t i;
-    int32_t sum = 0;
-    uint8_t x, a, b, c;
+    size_t i;
+    uint32_t sum = 0;
+    uint8_t x;
 
     /* prevent potential over/underflow, bails out at a width of ~8M pixels for RGBA8 */
     if(size > (INT32_MAX / 128)) return INT32_MAX;
 
-    for(i=0; i < size; i++)
+    for(i=0; i < size && i < bytes_per_pixel; i++)
     {
-        if(i >= bytes_per_pixel)
-        {
-            a = scanline[i - bytes_per_pixel];
-            b = prev_scanline[i];
-            c = prev_scanline[i - bytes_per_pixel];
-        }
-        else /* first pixel in row */
-        {
-            a = 0;
-            b = prev_scanline[i];
-            c = 0;
-        }
-
-        x = scanline[i];
+        x = filter_byte(prev_scanline, scanline, i, bytes_per_pixel, filter);
+        sum += 128 - abs((int)x - 128);
+    }
 
-        switch(filter)
-        {
-            case SPNG_FILTER_NONE:
-            {
-                break;
-            }
-            case SPNG_FILTER_SUB:
-            {
-                x = x - a;
-                break;
-            }
-            case SPNG_FILTER_UP:
-            {
-                x = x - b;
-                break;
-            }
-            case SPNG_FILTER_AVERAGE:
-            {
-                uint16_t avg = (a + b) / 2;
-                x = x - avg;
-                break;
-            }
-            case SPNG_FILTER_PAETH:
-            {
-                x = x - paeth(a,b,c);
-                break;
-            }
-        }
+#ifndef SPNG_DISABLE_OPT
+    if(simd_filters_supported())
+    {
+        i = filter_row_simd(NULL, prev_scanline, scanline, i, size, bytes_per_pixel, filter, &sum);
+    }
+#endif
 
+    for(; i < size; i++)
+    {
+        x = filter_byte(prev_scanline, scanline, i, bytes_per_pixel, filter);
         sum += 128 - abs((int)x - 128);
     }
 
-    return sum;
+    return (int32_t)sum;
 }
 
 static unsigned get_best_filter(const unsigned char *prev_scanline, const unsigned char *scanline,
@@ -6733,6 +6769,104 @@ static void defilter_paeth4(size_t rowbytes, unsigned char *row, const unsigned
     }
 }
 
+/* Paeth predictor for the 16-bit lanes */
+static __m128i paeth_predict(__m128i a, __m128i b, __m128i c)
+{
+    __m128i pa, pb, pc, smallest;
+
+    pa = _mm_sub_epi16(b, c);   /* (p-a) == (b-c) */
+    pb = _mm_sub_epi16(a, c);   /* (p-b) == (a-c) */
+    pc = _mm_add_epi16(pa, pb); /* (p-c) == (a+b-c-c) */
+
+    pa = abs_i16(pa);
+    pb = abs_i16(pb);
+    pc = abs_i16(pc);
+
+    smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+    return if_then_else(_mm_cmpeq_epi16(smallest, pa), a,
+                        if_then_else(_mm_cmpeq_epi16(smallest, pb), b, c));
+}
+
+/* Filters the bytes of a scanline starting from "i" in blocks of 16,
+ * optionally storing them to "filtered" and adding their score to "sum",
+ * returns the index of the first byte left for the scalar code.
+ *
+ * The forward filters only look at the unfiltered rows, there is no dependency
+ * between the outputs and any pixel size can be handled with unaligned loads.
+ */
+static size_t filter_row_simd(unsigned char *filtered, const unsigned char *prev_scanline, const unsigned char *scanline,
+                              size_t i, size_t size, unsigned bytes_per_pixel, unsigned filter, uint32_t *sum)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    __m128i a, b, c, d, x, acc = zero;
+
+    if(i < bytes_per_pixel) return i;
+
+    for(; i + 16 <= size; i += 16)
+    {
+        d = _mm_loadu_si128((const __m128i*)(scanline + i));
+
+        switch(filter)
+        {
+            case SPNG_FILTER_SUB:
+            {
+                a = _mm_loadu_si128((const __m128i*)(scanline + i - bytes_per_pixel));
+                x = _mm_sub_epi8(d, a);
+                break;
+            }
+            case SPNG_FILTER_UP:
+            {
+                b = _mm_loadu_si128((const __m128i*)(prev_scanline + i));
+                x = _mm_sub_epi8(d, b);
+                break;
+            }
+            case SPNG_FILTER_AVERAGE:
+            {
+                a = _mm_loadu_si128((const __m128i*)(scanline + i - bytes_per_pixel));
+                b = _mm_loadu_si128((const __m128i*)(prev_scanline + i));
+
+                /* _mm_avg_epu8() rounds up, (a+b)/2 rounds down */
+                x = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+                x = _mm_sub_epi8(d, x);
+                break;
+            }
+            case SPNG_FILTER_PAETH:
+            {
+                a = _mm_loadu_si128((const __m128i*)(scanline + i - bytes_per_pixel));
+                b = _mm_loadu_si128((const __m128i*)(prev_scanline + i));
+                c = _mm_loadu_si128((const __m128i*)(prev_scanline + i - bytes_per_pixel));
+
+                x = _mm_packus_epi16(paeth_predict(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(c, zero)),
+                                     paeth_predict(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(c, zero)));
+                x = _mm_sub_epi8(d, x);
+                break;
+            }
+            default:
+            {
+                x = d;
+                break;
+            }
+        }
+
+        if(filtered != NULL) _mm_storeu_si128((__m128i*)(filtered + i), x);
+
+        if(sum != NULL)
+        {/* 128 - |x - 128| is min(x, 256 - x) for an unsigned byte */
+            x = _mm_min_epu8(x, _mm_sub_epi8(zero, x));
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(x, zero));
+        }
+    }
+
+    if(sum != NULL)
+    {
+        *sum += (uint32_t)_mm_cvtsi128_si32(acc) + (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+    }
+
+    return i;
+}
+
 #endif /* SPNG_X86 */
 
 
@@ -7145,4 +7279,77 @@ static uint32_t expand_palette_rgb8_neon(unsigned char *row, const unsigned char
     return count * scanline_stride;
 }
 
+/* Filters the bytes of a scanline starting from "i" in blocks of 16,
+ * optionally storing them to "filtered" and adding their score to "sum",
+ * returns the index of the first byte left for the scalar code.
+ */
+static size_t filter_row_simd(unsigned char *filtered, const unsigned char *prev_scanline, const unsigned char *scanline,
+                              size_t i, size_t size, unsigned bytes_per_pixel, unsigned filter, uint32_t *sum)
+{
+    const uint8x16_t zero = vdupq_n_u8(0);
+    uint8x16_t a, b, c, d, x;
+    uint32x4_t acc = vdupq_n_u32(0);
+
+    if(i < bytes_per_pixel) return i;
+
+    for(; i + 16 <= size; i += 16)
+    {
+        d = vld1q_u8(scanline + i);
+
+        switch(filter)
+        {
+            case SPNG_FILTER_SUB:
+            {
+                a = vld1q_u8(scanline + i - bytes_per_pixel);
+                x = vsubq_u8(d, a);
+                break;
+            }
+            case SPNG_FILTER_UP:
+            {
+                b = vld1q_u8(prev_scanline + i);
+                x = vsubq_u8(d, b);
+                break;
+            }
+            case SPNG_FILTER_AVERAGE:
+            {
+                a = vld1q_u8(scanline + i - bytes_per_pixel);
+                b = vld1q_u8(prev_scanline + i);
+                x = vsubq_u8(d, vhaddq_u8(a, b));
+                break;
+            }
+            case SPNG_FILTER_PAETH:
+            {
+                a = vld1q_u8(scanline + i - bytes_per_pixel);
+                b = vld1q_u8(prev_scanline + i);
+                c = vld1q_u8(prev_scanline + i - bytes_per_pixel);
+
+                x = vcombine_u8(paeth_arm(vget_low_u8(a), vget_low_u8(b), vget_low_u8(c)),
+                                paeth_arm(vget_high_u8(a), vget_high_u8(b), vget_high_u8(c)));
+                x = vsubq_u8(d, x);
+                break;
+            }
+            default:
+            {
+                x = d;
+                break;
+            }
+        }
+
+        if(filtered != NULL) vst1q_u8(filtered + i, x);
+
+        if(sum != NULL)
+        {/* 128 - |x - 128| is min(x, 256 - x) for an unsigned byte */
+            x = vminq_u8(x, vsubq_u8(zero, x));
+            acc = vpadalq_u16(acc, vpaddlq_u8(x));
+        }
+    }
+
+    if(sum != NULL)
+    {
+        *sum += vgetq_lane_u32(acc, 0) + vgetq_lane_u32(acc, 1) + vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+    }
+
+    return i;
+}
+
 #endif /* SPNG_ARM */
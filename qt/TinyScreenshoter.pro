@@ -29,14 +29,18 @@ RC_FILE = res/res.rc
 
 LIBS += -static-libgcc -static-libstdc++ -static -pthread
 
-INCLUDEPATH += src/ ../lib/
+INCLUDEPATH += src/ ../lib/ ../core/src/
 
 SOURCES += \
         src/main.cpp \
-        src/tiny_screenshoter.cpp
+        src/tiny_screenshoter.cpp \
+        ../core/src/png_preset.c \
+        ../core/src/core_sys.c
 
 HEADERS += \
-        src/tiny_screenshoter.h
+        src/tiny_screenshoter.h \
+        ../core/src/png_preset.h \
+        ../core/src/core_sys.h
 
 win32:{
     DEFINES += SPNG_STATIC SPNG_SSE=0 SPNG_USE_MINIZ
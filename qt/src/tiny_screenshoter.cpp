@@ -36,13 +36,29 @@
 #include <QFtp>
 #include <QtDebug>
 
+#include "spng.h"
+
+extern "C" {
+#include "png_preset.h"
+}
 
 #ifdef _WIN32
 #   include <windows.h>
 #   include <mmsystem.h>
-#   include "spng.h"
 #endif
 
+/* The compression presets are shared with the WinAPI version by the core library */
+static const PngPreset &findPngPreset(const QString &name)
+{
+    return *pngPreset_get(pngPreset_fromName(name.toLatin1().constData()));
+}
+
+/* QImage maps the quality into the compression level as (100 - quality) * 9 / 91 */
+static int pngSaveQuality(const PngPreset &preset)
+{
+    return 100 - (preset.level * 91 + 8) / 9;
+}
+
 #ifdef _WIN32
 #define GLOBAL_SCREENSHOT 1000
 TinyScreenshoter* TinyScreenshoter::m_this = nullptr;
@@ -185,6 +201,8 @@ void TinyScreenshoter::makeScreenshot()
             .arg(m_savePath)
             .arg(fName);
 
+    const PngPreset &preset = findPngPreset(m_compression);
+
 #ifdef _WIN32
     struct spng_ihdr ihdr;
     spng_ctx *ctx;
@@ -206,6 +224,9 @@ void TinyScreenshoter::makeScreenshot()
 
             spng_set_ihdr(ctx, &ihdr);
             spng_set_png_file(ctx, f);
+            spng_set_option(ctx, SPNG_IMG_COMPRESSION_LEVEL, preset.level);
+            spng_set_option(ctx, SPNG_IMG_COMPRESSION_STRATEGY, preset.strategy);
+            spng_set_option(ctx, SPNG_FILTER_CHOICE, preset.filters);
 
             ret = spng_encode_image(ctx, m_pixels.data(), m_pixels.size(), SPNG_FMT_PNG, SPNG_ENCODE_FINALIZE);
 
@@ -220,7 +241,7 @@ void TinyScreenshoter::makeScreenshot()
 
     MessageBeep(MB_ICONEXCLAMATION);
 #else
-    okno.save(saveWhere, "PNG");
+    okno.save(saveWhere, "PNG", pngSaveQuality(preset));
 #endif
 
     if(ui->uploadToFtp->isChecked())
@@ -263,7 +284,7 @@ void TinyScreenshoter::on_saveImageClipboard_clicked()
             .arg(m_savePath)
             .arg(fName);
 
-    okno.save(saveWhere, "PNG");
+    okno.save(saveWhere, "PNG", pngSaveQuality(findPngPreset(m_compression)));
 
 #ifdef _WIN32
     MessageBeep(MB_ICONEXCLAMATION);
@@ -322,6 +343,7 @@ void TinyScreenshoter::loadSetup()
     QSettings setup(QString("%1/tinyscr.ini").arg(qApp->applicationDirPath()), QSettings::IniFormat);
     setup.beginGroup("main");
     m_savePath = setup.value("save-path", qApp->applicationDirPath()).toString();
+    m_compression = setup.value("compression", "desktop").toString();
     setup.endGroup();
 
     setup.beginGroup("ftp");
@@ -340,6 +362,7 @@ void TinyScreenshoter::saveSetup()
     QSettings setup(QString("%1/tinyscr.ini").arg(qApp->applicationDirPath()), QSettings::IniFormat);
     setup.beginGroup("main");
     setup.setValue("save-path", m_savePath);
+    setup.setValue("compression", QString::fromLatin1(findPngPreset(m_compression).name));
     setup.endGroup();
 
     setup.beginGroup("ftp");
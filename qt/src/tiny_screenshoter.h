@@ -92,6 +92,7 @@ private:
 #endif
 
     QString m_savePath;
+    QString m_compression;
     QFile m_uploadingFile;
 
     Ui::TinyScreenshoter *ui;
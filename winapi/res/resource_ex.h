@@ -1,9 +1,15 @@
 #define IDM_SETTINGS                            32770
 #define IDM_SAVECLIP                            (IDM_SETTINGS + 1)
 #define IDM_QUIT                                (IDM_SETTINGS + 2)
+#define IDM_TRACE_JSON                          (IDM_SETTINGS + 3)
+#define IDM_TRACE_BINARY                        (IDM_SETTINGS + 4)
 #define ID_HOOK_TIMER                           50000
 #define ID_ICON_STATUS_TIMER                    50001
+#define ID_STATS_TIMER                          50002
+#define ID_BURST_TIMER                          50003
 #define ID_CMD_MAKE_SHOT                        60000
+#define ID_CMD_BURST                            60001
 
 #define ID_HOTKEY_SHOT                          1000
 #define ID_HOTKEY_ALT_SHOT                      1001
+#define ID_HOTKEY_BURST                         1002
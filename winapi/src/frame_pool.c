@@ -0,0 +1,313 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <stdlib.h>
+#include <windows.h>
+
+#include "frame_pool.h"
+#include "misc.h"
+#include "burst_ring.h"
+
+typedef struct tagFrameSlot
+{
+    uint8_t *data;
+    size_t size;
+    BOOL busy;
+} FrameSlot;
+
+static FrameSlot s_slots[FRAME_POOL_MAX_DEPTH];
+static int s_depth = 0;
+/* Ring of the burst capture, allocated once at the burst start */
+static BurstRing s_burst;
+static int s_policy = FRAME_POOL_SPILL;
+static FramePoolStats s_stats;
+static HANDLE s_pool_mutex = 0;
+/* Auto-reset event signaled every time a buffer returns into the pool */
+static HANDLE s_pool_released = 0;
+
+static const char *s_policyNames[FRAME_POOL_POLICY_COUNT] =
+{
+    "spill",
+    "block",
+    "drop"
+};
+
+static void pool_lock()
+{
+    if(s_pool_mutex)
+        WaitForSingleObject(s_pool_mutex, INFINITE);
+}
+
+static void pool_unlock()
+{
+    if(s_pool_mutex)
+        ReleaseMutex(s_pool_mutex);
+}
+
+void framePool_init(int depth, int policy)
+{
+    if(depth < 0)
+        depth = 0;
+    if(depth > FRAME_POOL_MAX_DEPTH)
+        depth = FRAME_POOL_MAX_DEPTH;
+
+    if(policy < 0 || policy >= FRAME_POOL_POLICY_COUNT)
+        policy = FRAME_POOL_SPILL;
+
+    ZeroMemory(s_slots, sizeof(s_slots));
+    ZeroMemory(&s_stats, sizeof(s_stats));
+    s_depth = depth;
+    s_policy = policy;
+    burstRing_init(&s_burst);
+
+    if(!s_pool_mutex)
+        s_pool_mutex = CreateMutexA(NULL, FALSE, NULL);
+
+    if(!s_pool_released)
+        s_pool_released = CreateEventA(NULL, FALSE, FALSE, NULL);
+}
+
+void framePool_quit()
+{
+    int i;
+
+    pool_lock();
+
+    for(i = 0; i < FRAME_POOL_MAX_DEPTH; ++i)
+    {
+        if(s_slots[i].data)
+            free(s_slots[i].data);
+    }
+
+    ZeroMemory(s_slots, sizeof(s_slots));
+    s_depth = 0;
+
+    debugLog("--Frame pool: hits=%lu, misses=%lu, spills=%lu, waits=%lu, drops=%lu\n",
+             s_stats.hits, s_stats.misses, s_stats.spills, s_stats.waits, s_stats.drops);
+
+    pool_unlock();
+
+    burstRing_free(&s_burst);
+
+    if(s_pool_released)
+    {
+        CloseHandle(s_pool_released);
+        s_pool_released = 0;
+    }
+
+    if(s_pool_mutex)
+    {
+        CloseHandle(s_pool_mutex);
+        s_pool_mutex = 0;
+    }
+}
+
+/* Must be called with the locked mutex, returns -1 if all buffers are busy */
+static int pool_findFree(size_t size)
+{
+    int i, ret = -1;
+
+    for(i = 0; i < s_depth; ++i)
+    {
+        if(s_slots[i].busy)
+            continue;
+
+        if(s_slots[i].size >= size)
+            return i; /* Reuse as-is */
+
+        if(ret < 0)
+            ret = i; /* Will need to grow */
+    }
+
+    return ret;
+}
+
+int framePool_acquire(uint8_t **out, size_t size)
+{
+    FrameSlot *slot;
+    DWORD start = 0, waited = 0;
+    BOOL waiting = FALSE, timedOut = FALSE;
+    int i;
+
+    *out = NULL;
+
+    pool_lock();
+
+    if(s_depth == 0)
+    {
+        s_stats.misses++;
+        pool_unlock();
+        *out = (uint8_t *)malloc(size);
+        return *out ? FRAME_POOL_OK : FRAME_POOL_NOMEM;
+    }
+
+    while((i = pool_findFree(size)) < 0)
+    {
+        if(s_policy == FRAME_POOL_SPILL)
+        {
+            s_stats.misses++;
+            s_stats.spills++;
+            pool_unlock();
+            *out = (uint8_t *)malloc(size);
+            return *out ? FRAME_POOL_OK : FRAME_POOL_NOMEM;
+        }
+
+        if(s_policy == FRAME_POOL_DROP || timedOut)
+        {
+            s_stats.drops++;
+            pool_unlock();
+            return FRAME_POOL_FULL;
+        }
+
+        /* FRAME_POOL_BLOCK: wait for the saver and try again. Another thread may take
+           the released buffer first, so the timeout is counted from the first wait */
+        s_stats.waits++;
+        if(!waiting)
+        {
+            start = GetTickCount();
+            waiting = TRUE;
+        }
+        else
+            waited = GetTickCount() - start;
+        pool_unlock();
+        timedOut = waited >= FRAME_POOL_WAIT_TIMEOUT ||
+                   WaitForSingleObject(s_pool_released, FRAME_POOL_WAIT_TIMEOUT - waited) != WAIT_OBJECT_0;
+        pool_lock();
+    }
+
+    slot = &s_slots[i];
+
+    if(slot->size < size)
+    {
+        s_stats.misses++;
+
+        if(slot->data)
+            free(slot->data);
+
+        /* The old content is not needed, so don't use realloc() to avoid the copy */
+        slot->data = (uint8_t *)malloc(size);
+        slot->size = slot->data ? size : 0;
+
+        if(!slot->data)
+        {
+            pool_unlock();
+            return FRAME_POOL_NOMEM;
+        }
+    }
+    else
+        s_stats.hits++;
+
+    slot->busy = TRUE;
+    *out = slot->data;
+
+    pool_unlock();
+
+    return FRAME_POOL_OK;
+}
+
+void framePool_release(uint8_t *buf)
+{
+    int i;
+
+    if(!buf || burstRing_release(&s_burst, buf))
+        return;
+
+    pool_lock();
+
+    for(i = 0; i < s_depth; ++i)
+    {
+        if(s_slots[i].data == buf)
+        {
+            s_slots[i].busy = FALSE;
+            pool_unlock();
+
+            if(s_pool_released)
+                SetEvent(s_pool_released);
+            return;
+        }
+    }
+
+    pool_unlock();
+
+    /* Spilled or allocated while the pool is disabled */
+    free(buf);
+}
+
+int framePool_beginBurst(int slots, size_t size)
+{
+    int ret = burstRing_begin(&s_burst, slots, size);
+
+    if(ret == BURST_RING_FULL)
+        return FRAME_POOL_FULL;
+
+    return ret == BURST_RING_OK ? FRAME_POOL_OK : FRAME_POOL_NOMEM;
+}
+
+int framePool_acquireBurst(uint8_t **out, size_t size)
+{
+    int ret = burstRing_acquire(&s_burst, out, size);
+
+    pool_lock();
+    if(ret == BURST_RING_OK)
+        s_stats.hits++;
+    else
+        s_stats.drops++;
+    pool_unlock();
+
+    return ret == BURST_RING_OK ? FRAME_POOL_OK : FRAME_POOL_FULL;
+}
+
+void framePool_endBurst()
+{
+    burstRing_end(&s_burst);
+}
+
+void framePool_getStats(FramePoolStats *stats)
+{
+    pool_lock();
+    *stats = s_stats;
+    pool_unlock();
+}
+
+int framePool_policyFromName(const char *name)
+{
+    int i;
+
+    for(i = 0; i < FRAME_POOL_POLICY_COUNT; ++i)
+    {
+        if(lstrcmpiA(name, s_policyNames[i]) == 0)
+            return i;
+    }
+
+    return FRAME_POOL_SPILL;
+}
+
+const char *framePool_policyName(int policy)
+{
+    if(policy < 0 || policy >= FRAME_POOL_POLICY_COUNT)
+        policy = FRAME_POOL_SPILL;
+
+    return s_policyNames[policy];
+}
@@ -0,0 +1,147 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "burst_ring.h"
+
+/* Maximum number of the pooled frame buffers */
+#define FRAME_POOL_MAX_DEPTH    8
+/* Maximum number of the burst ring slots */
+#define FRAME_POOL_MAX_BURST    BURST_RING_MAX_SLOTS
+/* How long the "block" policy waits for a free buffer in total, in milliseconds.
+   The capture runs on the window thread that the keyboard hook calls into, so the
+   wait must stay short, after it the frame gets dropped */
+#define FRAME_POOL_WAIT_TIMEOUT 300
+
+enum FramePoolPolicy
+{
+    /* Allocate a temporary buffer outside of the pool, it gets freed on release */
+    FRAME_POOL_SPILL = 0,
+    /* Wait until the saver returns any buffer into the pool */
+    FRAME_POOL_BLOCK,
+    /* Refuse to give a buffer, the frame gets skipped */
+    FRAME_POOL_DROP,
+    FRAME_POOL_POLICY_COUNT
+};
+
+enum FramePoolResult
+{
+    FRAME_POOL_OK = 0,
+    /* All buffers are busy and the policy didn't allow to get another one */
+    FRAME_POOL_FULL,
+    /* Failed to allocate memory */
+    FRAME_POOL_NOMEM
+};
+
+struct FramePoolStats
+{
+    /* A free buffer of a suitable size was reused */
+    unsigned long hits;
+    /* A buffer had to be allocated (first use, size change, or spill) */
+    unsigned long misses;
+    /* Buffers allocated outside of the pool by the "spill" policy */
+    unsigned long spills;
+    /* Times the "block" policy had to wait */
+    unsigned long waits;
+    /* Frames refused because the pool was full */
+    unsigned long drops;
+};
+
+typedef struct FramePoolStats FramePoolStats;
+
+/**
+ * @brief Initialize the pool of the frame buffers
+ * @param depth Number of buffers to keep, 0 disables the pool: every frame gets allocated and freed
+ * @param policy What to do when all buffers are busy, one of FramePoolPolicy values
+ */
+void framePool_init(int depth, int policy);
+
+/**
+ * @brief Free all buffers and the pool itself, all buffers should be released before
+ */
+void framePool_quit();
+
+/**
+ * @brief Take the frame buffer from the pool, it gets owned by the caller until release
+ * @param out Pointer to the buffer
+ * @param size Required size of the buffer in bytes
+ * @return FRAME_POOL_OK on success, or FRAME_POOL_FULL / FRAME_POOL_NOMEM error code
+ */
+int framePool_acquire(uint8_t **out, size_t size);
+
+/**
+ * @brief Return the buffer into the pool, can be called from any thread
+ * @param buf Buffer given by framePool_acquire()
+ */
+void framePool_release(uint8_t *buf);
+
+/**
+ * @brief Allocate the ring of the frame buffers for the burst capture, so no memory gets allocated while it goes
+ * @param slots Number of buffers, up to FRAME_POOL_MAX_BURST
+ * @param size Size of every buffer in bytes
+ * @return FRAME_POOL_OK on success, FRAME_POOL_FULL if buffers of the previous burst are still being saved,
+ *         or FRAME_POOL_NOMEM
+ */
+int framePool_beginBurst(int slots, size_t size);
+
+/**
+ * @brief Take the next free buffer of the burst ring, it gets returned by framePool_release() as usual
+ * @param out Pointer to the buffer
+ * @param size Required size of the buffer in bytes
+ * @return FRAME_POOL_OK on success, or FRAME_POOL_FULL if all buffers are busy or smaller than size
+ */
+int framePool_acquireBurst(uint8_t **out, size_t size);
+
+/**
+ * @brief Free the burst ring, the buffers that are still being saved get freed on their release
+ */
+void framePool_endBurst();
+
+/**
+ * @brief Get the usage counters of the pool
+ * @param stats Output structure
+ */
+void framePool_getStats(FramePoolStats *stats);
+
+/**
+ * @brief Convert the policy name from the config file into the FramePoolPolicy value
+ * @param name Name of the policy: "spill", "block", or "drop" (case-insensitive)
+ * @return Policy value, or FRAME_POOL_SPILL if name is unknown
+ */
+int framePool_policyFromName(const char *name);
+
+/**
+ * @brief Get the name of the policy for the config file
+ * @param policy One of FramePoolPolicy values
+ * @return Name of the policy
+ */
+const char *framePool_policyName(int policy);
+
+#endif /* FRAME_POOL_H */
@@ -0,0 +1,228 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+
+#include "ftp_journal.h"
+#include "misc.h"
+
+
+typedef struct tagJournalItem
+{
+    char filePath[MAX_PATH];
+    struct tagJournalItem *next;
+} JournalItem;
+
+static char s_journalPath[MAX_PATH];
+static FILE *s_journal = NULL;
+static HANDLE s_journalMutex = 0;
+/* Number of the files recorded by this run and not done yet */
+static int s_journalPending = 0;
+
+
+void ftpJournal_init(const char *dir)
+{
+    snprintf(s_journalPath, MAX_PATH, "%s\\tinyscr_w.journal", dir);
+
+    if(!s_journalMutex)
+        s_journalMutex = CreateMutexA(NULL, FALSE, NULL);
+}
+
+void ftpJournal_quit()
+{
+    if(s_journal)
+    {
+        fclose(s_journal);
+        s_journal = NULL;
+    }
+
+    if(s_journalMutex)
+    {
+        CloseHandle(s_journalMutex);
+        s_journalMutex = 0;
+    }
+}
+
+static JournalItem *journalFind(JournalItem *list, const char *filePath, JournalItem **prev)
+{
+    *prev = NULL;
+
+    while(list)
+    {
+        if(lstrcmpiA(list->filePath, filePath) == 0)
+            return list;
+
+        *prev = list;
+        list = list->next;
+    }
+
+    return NULL;
+}
+
+static void journalWrite(char op, const char *filePath)
+{
+    if(!s_journal)
+        s_journal = fopen(s_journalPath, "a");
+
+    if(!s_journal)
+    {
+        debugLog("--FTP Journal: can't open %s\n", s_journalPath);
+        return;
+    }
+
+    fprintf(s_journal, "%c%s\n", op, filePath);
+    fflush(s_journal);
+}
+
+void ftpJournal_replay(BOOL (*callback)(const char *filePath))
+{
+    char line[MAX_PATH + 4];
+    JournalItem *begin = NULL, *end = NULL, *item, *prev;
+    size_t len;
+    FILE *f;
+
+    f = fopen(s_journalPath, "r");
+    if(!f)
+        return;
+
+    while(fgets(line, sizeof(line), f))
+    {
+        len = strlen(line);
+
+        /* The last line could be cut by the crash */
+        if(len < 3 || line[len - 1] != '\n')
+            continue;
+
+        line[len - 1] = '\0';
+
+        item = journalFind(begin, line + 1, &prev);
+
+        if(line[0] == '+' && !item)
+        {
+            item = (JournalItem *)malloc(sizeof(JournalItem));
+            if(!item)
+                break;
+
+            ZeroMemory(item, sizeof(JournalItem));
+            strncpy(item->filePath, line + 1, MAX_PATH - 1);
+
+            if(end)
+                end->next = item;
+            else
+                begin = item;
+            end = item;
+        }
+        else if(line[0] == '-' && item)
+        {
+            if(prev)
+                prev->next = item->next;
+            else
+                begin = item->next;
+
+            if(end == item)
+                end = prev;
+
+            free(item);
+        }
+    }
+
+    fclose(f);
+
+    while(begin)
+    {
+        item = begin;
+        begin = begin->next;
+        debugLog("--FTP Journal: resuming the upload of %s\n", item->filePath);
+
+        if(!callback(item->filePath))
+        {
+            /* The old record stays in the file, so it must be closed there */
+            if(s_journalMutex)
+                WaitForSingleObject(s_journalMutex, INFINITE);
+            journalWrite('-', item->filePath);
+            if(s_journalMutex)
+                ReleaseMutex(s_journalMutex);
+        }
+
+        free(item);
+    }
+
+    if(s_journalMutex)
+        WaitForSingleObject(s_journalMutex, INFINITE);
+
+    /* Nothing left to resume, the old records aren't needed anymore */
+    if(s_journalPending == 0)
+    {
+        if(s_journal)
+        {
+            fclose(s_journal);
+            s_journal = NULL;
+        }
+
+        DeleteFileA(s_journalPath);
+    }
+
+    if(s_journalMutex)
+        ReleaseMutex(s_journalMutex);
+}
+
+void ftpJournal_add(const char *filePath)
+{
+    if(s_journalMutex)
+        WaitForSingleObject(s_journalMutex, INFINITE);
+
+    journalWrite('+', filePath);
+    s_journalPending++;
+
+    if(s_journalMutex)
+        ReleaseMutex(s_journalMutex);
+}
+
+void ftpJournal_done(const char *filePath)
+{
+    if(s_journalMutex)
+        WaitForSingleObject(s_journalMutex, INFINITE);
+
+    if(s_journalPending > 0)
+        s_journalPending--;
+
+    if(s_journalPending == 0)
+    {
+        /* Everything is delivered, start the new journal from scratch */
+        if(s_journal)
+        {
+            fclose(s_journal);
+            s_journal = NULL;
+        }
+
+        DeleteFileA(s_journalPath);
+    }
+    else
+        journalWrite('-', filePath);
+
+    if(s_journalMutex)
+        ReleaseMutex(s_journalMutex);
+}
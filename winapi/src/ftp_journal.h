@@ -0,0 +1,63 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef FTP_JOURNAL_H
+#define FTP_JOURNAL_H
+
+#include <windef.h>
+
+/*
+ * The journal is the append-only text file next to the config file: the line
+ * "+path" is written when the file gets queued for the upload, and "-path"
+ * when it is uploaded or given up. Every line is flushed at once, so after
+ * the crash the files whose last line is "+" are still pending.
+ */
+
+/**
+ * @brief Open the journal, must be called after settingsInit()
+ * @param dir Directory of the config file
+ */
+void ftpJournal_init(const char *dir);
+void ftpJournal_quit();
+
+/**
+ * @brief Read the files that were left pending by the previous run
+ * @param callback Called for every pending file in the order they were queued, returns FALSE
+ * to drop the file from the journal without the upload
+ */
+void ftpJournal_replay(BOOL (*callback)(const char *filePath));
+
+/**
+ * @brief Record the queued file
+ * @param filePath Local path of the file
+ */
+void ftpJournal_add(const char *filePath);
+
+/**
+ * @brief Record the file that doesn't need the upload anymore, the journal gets emptied once nothing is pending
+ * @param filePath Local path of the file
+ */
+void ftpJournal_done(const char *filePath);
+
+#endif /* FTP_JOURNAL_H */
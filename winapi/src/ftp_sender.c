@@ -21,8 +21,8 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  */
-
 #include <stdio.h>
+#include <stdarg.h>
 #include <windef.h>
 #include <windows.h>
 #include <winsock.h>
@@ -31,15 +31,51 @@
 #include "shot_hooks.h"
 #include "settings.h"
 #include "ftp_sender.h"
+#include "ftp_transfer.h"
+#include "ftp_journal.h"
+#include "ftp_client.h"
+#include "ftp_proto.h"
+#include "shot_trace.h"
+#include "shot_stats.h"
+
 
+/* The first pause after the failure in milliseconds, every next failure in a row doubles it */
+#define FTP_RETRY_FIRST     2000
+#define FTP_PAUSE_SLICE     500
+/* How often to check whether the fullscreen application has gone, in milliseconds */
+#define FTP_DEFER_SLICE     1000
 
 typedef struct tagFileSend
 {
     char filePath[MAX_PATH];
+    /* Encoded file to upload from the memory, NULL to read it from the filePath */
+    uint8_t *data;
+    size_t dataSize;
+    /* The data is also written to the filePath */
+    BOOL onDisk;
+    /* The previous attempt has failed, the server may keep the part of the file */
+    BOOL resume;
+    /* Number of the shot in the trace, 0 for the files not made by this run */
+    uint32_t trace;
     struct tagFileSend *b_next;
     struct tagFileSend *b_prev;
 } FileSend;
 
+/* Logged-in control connection that survives between the upload batches */
+typedef struct tagFtpSession
+{
+    FtpClient client;
+    /* GetTickCount() of the last upload, used for the idle timeout */
+    DWORD lastUpload;
+    /* Number of the connection, 0 is the main one, others only help it with the long queue */
+    int index;
+    /* Connection has failed and rests until GetTickCount() reaches this */
+    BOOL paused;
+    DWORD pausedUntil;
+    /* Number of the failures in a row, only the first one gets reported */
+    int failures;
+} FtpSession;
+
 static FileSend* s_queue_begin = NULL;
 static FileSend* s_queue_end = NULL;
 static HANDLE s_queue_mutex = 0;
@@ -89,464 +125,646 @@ static FileSend *queue_get()
     return ret;
 }
 
-static void queue_clear()
+/* Return the file to the head of the queue */
+static void queue_putBack(FileSend *item)
 {
-    FileSend *fileToSend = NULL;
+    if(s_queue_mutex)
+        WaitForSingleObject(s_queue_mutex, INFINITE);
 
-    while((fileToSend = queue_get()) != NULL)
-    {
-        free(fileToSend);
-    }
-}
+    item->b_prev = NULL;
+    item->b_next = s_queue_begin;
 
+    if(s_queue_begin)
+        s_queue_begin->b_prev = item;
+    else
+        s_queue_end = item;
 
-static HANDLE s_senderThread = NULL;
-static DWORD s_senderThreadId = 0;
+    s_queue_begin = item;
 
-static int sendFtpCommand(char *outBuffer, size_t outBufferSize,
-                          char *inBuffer, size_t inBufferSize,
-                          SOCKET ftp_sock, const char *cmd, const char *data)
+    if(s_queue_mutex)
+        ReleaseMutex(s_queue_mutex);
+}
+
+static int queue_count()
 {
-    int ret;
-    outBuffer[0] = '\0';
-    strncat(outBuffer, cmd, outBufferSize);
-    strncat(outBuffer, " ", outBufferSize);
-    strncat(outBuffer, data, outBufferSize);
-    strncat(outBuffer, "\r\n", outBufferSize);
-    ret = send(ftp_sock, outBuffer, strlen(outBuffer), 0);
-    if(ret == SOCKET_ERROR)
-        return ret;
+    FileSend *item;
+    int count = 0;
+
+    if(s_queue_mutex)
+        WaitForSingleObject(s_queue_mutex, INFINITE);
+
+    for(item = s_queue_begin; item; item = item->b_next)
+        ++count;
+
+    if(s_queue_mutex)
+        ReleaseMutex(s_queue_mutex);
 
-    ZeroMemory(inBuffer, inBufferSize);
-    return recv(ftp_sock, inBuffer, inBufferSize - 1, 0);
+    return count;
 }
 
-static int sendFtpCommandNR(char *outBuffer, size_t outBufferSize,
-                            SOCKET ftp_sock, const char *cmd, const char *data)
+static BOOL queue_isEmpty()
 {
-    outBuffer[0] = '\0';
-    strncat(outBuffer, cmd, outBufferSize);
-    strncat(outBuffer, " ", outBufferSize);
-    strncat(outBuffer, data, outBufferSize);
-    strncat(outBuffer, "\r\n", outBufferSize);
-    return send(ftp_sock, outBuffer, strlen(outBuffer), 0);
+    BOOL ret;
+
+    if(s_queue_mutex)
+        WaitForSingleObject(s_queue_mutex, INFINITE);
+
+    ret = s_queue_begin == NULL;
+
+    if(s_queue_mutex)
+        ReleaseMutex(s_queue_mutex);
+
+    return ret;
 }
 
-static int sendFtpCommandND(char *outBuffer, size_t outBufferSize,
-                            char *inBuffer, size_t inBufferSize,
-                            SOCKET ftp_sock, const char *cmd)
+/* Don't lose the shot that exists in the memory only */
+static void fileSend_spill(FileSend *fileToSend)
 {
-    int ret;
-    outBuffer[0] = '\0';
-    strncat(outBuffer, cmd, outBufferSize);
-    strncat(outBuffer, "\r\n", outBufferSize);
-    ret = send(ftp_sock, outBuffer, strlen(outBuffer), 0);
-    if(ret == SOCKET_ERROR)
-        return ret;
+    FILE *f;
+
+    if(!fileToSend->data || fileToSend->onDisk || !g_settings.ftpRemoveUploaded)
+        return;
 
-    ZeroMemory(inBuffer, inBufferSize);
-    return recv(ftp_sock, inBuffer, inBufferSize, 0);
+    f = fopen(fileToSend->filePath, "wb");
+    if(f)
+    {
+        fwrite(fileToSend->data, 1, fileToSend->dataSize, f);
+        fclose(f);
+        fileToSend->onDisk = TRUE;
+    }
 }
 
-static uint16_t ftpParseReplyCode(const char *inBuffer, int *ok)
+static void fileSend_free(FileSend *fileToSend, BOOL uploaded)
 {
-    uint16_t ret;
-    const char *space;
-    char out[5];
+    if(fileToSend->data)
+    {
+        if(!uploaded)
+            fileSend_spill(fileToSend);
+
+        free(fileToSend->data);
+    }
 
-    ZeroMemory(out, 5);
+    free(fileToSend);
+}
 
-    space = strchr(inBuffer, ' ');
-    if(!space)
+static void queue_clear()
+{
+    FileSend *fileToSend = NULL;
+
+    while((fileToSend = queue_get()) != NULL)
     {
-        *ok = FALSE;
-        return 0;
+        fileSend_free(fileToSend, FALSE);
     }
+}
 
-    memcpy(out, inBuffer, min(space - inBuffer, 5));
 
-    ret = (uint16_t)strtol(out, NULL, 10);
+static HANDLE s_senderThreads[FTP_MAX_CONNECTIONS];
+static HANDLE s_senderSemaphore = 0;
+static volatile LONG s_senderQuit = 0;
+/* Number of the connections in the middle of the upload batch */
+static volatile LONG s_senderUploading = 0;
+/* Files taken from the queue by the connections and being uploaded right now */
+static volatile LONG s_filesUploading = 0;
+/* Number of the logged-in connections */
+static volatile LONG s_sessionsOnline = 0;
 
-    *ok = TRUE;
+/*
+ * Errors of the connection are the user's business only when it works alone:
+ * helpers may be refused by the server's connection limit, and the other
+ * working connections will deliver the files anyway.
+ */
+static BOOL ftpIsHelping(FtpSession *session)
+{
+    return session->index > 0 || s_sessionsOnline - (session->client.loggedIn ? 1 : 0) > 0;
+}
 
-    return ret;
+static void ftpError(FtpSession *session, const char *msgBoxTitle, const char *errorFormat, ...)
+{
+    char outBuffer[2048];
+    va_list args;
+
+    va_start(args, errorFormat);
+    vsnprintf(outBuffer, 2048, errorFormat, args);
+    va_end(args);
+
+    debugLog("--FTP [%d] %s: %s\n", session->index, msgBoxTitle, outBuffer);
+
+    /* The retries of the same trouble are quiet until something gets uploaded */
+    if(!ftpIsHelping(session) && session->failures == 0)
+        MessageBoxA(NULL, outBuffer, msgBoxTitle, MB_OK|MB_ICONERROR);
 }
 
-static uint16_t ftpParsePassivePort(char *inBuffer, int *ok)
+/* Report the failed step of the client */
+static void ftpReportFailure(FtpSession *session, const char *fileName)
 {
-    uint16_t p_port, num_commas;
-    char *str_pos = NULL, *str_tok_ptr = NULL, *str_seek;
+    FtpClient *client = &session->client;
+    BOOL broken = client->replyCode < 0;
 
-    str_pos = strstr(inBuffer, "(");
-    if(!str_pos)
+    switch(client->step)
     {
-        *ok = FALSE;
-        return 0;
+    case FTP_STEP_RESOLVE:
+        ftpError(session, "Can't connect FTP server", "Failed to find the FTP server %s, with error %d",
+                 g_settings.ftpHost, client->error);
+        break;
+    case FTP_STEP_CONNECT:
+        ftpError(session, "Can't connect FTP server", "Failed to connect to FTP server %s:%u, with error %d",
+                 g_settings.ftpHost, g_settings.ftpPort, client->error);
+        break;
+    case FTP_STEP_GREETING:
+        if(broken)
+            ftpError(session, "Can't connect to FTP server", "Failed to receive greeting: %d", client->error);
+        else
+            ftpError(session, "Can't connect FTP server", "Failed to connect to FTP server %s:%u, server reply error:\n%s",
+                     g_settings.ftpHost, g_settings.ftpPort, client->reply);
+        break;
+    case FTP_STEP_USER:
+        if(broken)
+            ftpError(session, "Can't connect to FTP server", "Failed to send USER command: %d", client->error);
+        else
+            ftpError(session, "Can't connect FTP server", "Failed to send login %s to FTP server %s:%u, server reply error:\n%s",
+                     g_settings.ftpUser, g_settings.ftpHost, g_settings.ftpPort, client->reply);
+        break;
+    case FTP_STEP_PASS:
+        if(broken)
+            ftpError(session, "Can't connect to FTP server", "Failed to send PASS command: %d", client->error);
+        else
+            ftpError(session, "Can't connect FTP server", "Incorrect password for user %s to FTP server %s:%u, server reply error:\n%s",
+                     g_settings.ftpUser, g_settings.ftpHost, g_settings.ftpPort, client->reply);
+        break;
+    case FTP_STEP_CWD:
+        if(broken)
+            ftpError(session, "Can't connect to FTP server", "Failed to send CWD command: %d", client->error);
+        else
+            ftpError(session, "Can't connect FTP server", "Can't open directory %s at the FTP server %s:%u, server reply error:\n%s",
+                     g_settings.ftpSavePath, g_settings.ftpHost, g_settings.ftpPort, client->reply);
+        break;
+    case FTP_STEP_TYPE:
+        if(broken)
+            ftpError(session, "Can't connect to FTP server", "Failed to send Type I command: %d", client->error);
+        else
+            ftpError(session, "Can't connect FTP server", "Can't enter binary mode at the FTP server %s:%u, server reply error:\n%s",
+                     g_settings.ftpHost, g_settings.ftpPort, client->reply);
+        break;
+    case FTP_STEP_PASSIVE:
+        if(broken)
+            ftpError(session, "Can't connect to FTP server", "Failed to send PASV command: %d", client->error);
+        else if(client->replyCode == 227)
+            ftpError(session, "Failed to send via FTP", "Failed to detect FTP mode (corrupted data received): %s", client->reply);
+        else
+            ftpError(session, "Can't connect FTP server", "Can't enter the passive mode at the FTP server %s:%u, server reply error:\n%s",
+                     g_settings.ftpHost, g_settings.ftpPort, client->reply);
+        break;
+    case FTP_STEP_DATA_CONNECT:
+        ftpError(session, "Can't run FTP sender", "Failed to connect passive port: %d", client->error);
+        break;
+    case FTP_STEP_REST:
+        ftpError(session, "Can't connect to FTP server", "Failed to send REST command: %d", client->error);
+        break;
+    case FTP_STEP_STOR:
+        if(broken)
+            ftpError(session, "Can't connect to FTP server", "Failed to send STOR command: %d", client->error);
+        else
+            ftpError(session, "Failed to send via FTP", "Can't store the file %s at the FTP server %s:%u, server reply error:\n%s",
+                     fileName, g_settings.ftpHost, g_settings.ftpPort, client->reply);
+        break;
+    case FTP_STEP_SEND:
+        ftpError(session, "Failes to send data to FTP server", "Failed to send data by passive port: %d", client->error);
+        break;
+    case FTP_STEP_RESULT:
+        if(broken)
+            ftpError(session, "Can't connect to FTP server", "Failed to receive the transfer result: %d", client->error);
+        else
+            ftpError(session, "Failed to send via FTP", "Failed to upload the file %s to the FTP server %s:%u, server reply error:\n%s",
+                     fileName, g_settings.ftpHost, g_settings.ftpPort, client->reply);
+        break;
+    default:
+        break;
     }
+}
 
-    str_pos++;
-    num_commas = 0;
-    p_port = 0;
+/* Close the control connection, politely say goodbye to the server if possible */
+static void ftpDisconnect(FtpSession *session, BOOL sayQuit)
+{
+    if(session->client.loggedIn)
+        InterlockedDecrement(&s_sessionsOnline);
+
+    ftpClient_close(&session->client, sayQuit);
+}
 
-    str_seek = shot_strtokr(str_pos, ",", &str_tok_ptr);
-    while(str_seek)
+static uint32_t connectTimeout()
+{
+    int timeout = g_settings.ftpConnectTimeout;
+
+    if(timeout < 1)
+        timeout = 1;
+
+    return (uint32_t)timeout * 1000;
+}
+
+static BOOL ftpLogin(FtpSession *session)
+{
+    /* The settings could be changed since the last time */
+    session->client.index = (uint32_t)session->index;
+    session->client.connectTimeout = connectTimeout();
+    session->client.sendBuffer = ftpTransfer_sendBufferSize();
+
+    if(!ftpClient_login(&session->client, g_settings.ftpHost, g_settings.ftpPort,
+                        g_settings.ftpUser, g_settings.ftpPassword, g_settings.ftpSavePath))
     {
-        if(num_commas == 4)
-            p_port = (uint16_t)strtoul(str_seek, NULL, 10) * 256;
-        else if(num_commas == 5)
-            p_port += (uint16_t)strtoul(str_seek, NULL, 10);
-        str_seek = shot_strtokr(NULL, ",", &str_tok_ptr);
-        num_commas++;
+        ftpReportFailure(session, NULL);
+        return FALSE;
     }
 
-    *ok = TRUE;
+    session->lastUpload = GetTickCount();
+    InterlockedIncrement(&s_sessionsOnline);
 
-    return p_port;
+    return TRUE;
 }
 
-static const char *ftpGetBaseName(const char* str)
+/*
+ * Make sure the session is logged in and ready for the transfer. The session
+ * kept from the previous batch could be closed by the server at any moment,
+ * so the failure on it means reconnect, and only the failure on the fresh
+ * connection gets reported.
+ */
+static BOOL ftpPrepareBatch(FtpSession *session)
 {
-    const char *ret = strrchr(str, '\\');
+    if(session->client.loggedIn)
+    {
+        if(ftpClient_isAlive(&session->client) && ftpClient_noop(&session->client))
+            return TRUE;
 
-    if(!ret)
-        return NULL;
+        debugLog("--FTP Kept session is dead, reconnecting\n");
+        ftpDisconnect(session, FALSE);
+    }
 
-    return ++ret;
+    return ftpLogin(session);
 }
 
-static void ftpCleanUp(SOCKET *ftp_sock, SOCKET *p_sock)
+static void ftpKeepAlive(FtpSession *session)
 {
-    if(*p_sock)
+    if(!session->client.loggedIn)
+        return;
+
+    if(g_settings.ftpIdleTimeout > 0 &&
+       GetTickCount() - session->lastUpload >= (DWORD)g_settings.ftpIdleTimeout * 1000)
     {
-        closesocket(*p_sock);
-        *p_sock = 0;
+        debugLog("--FTP Session is idle for too long, closing\n");
+        ftpDisconnect(session, TRUE);
+        return;
     }
 
-    if(*ftp_sock)
+    if(!ftpClient_isAlive(&session->client))
     {
-        closesocket(*ftp_sock);
-        *ftp_sock = 0;
+        ftpDisconnect(session, FALSE);
+        return;
     }
 
-    WSACleanup();
-    queue_clear();
+    if(!ftpClient_noop(&session->client))
+    {
+        debugLog("--FTP Keep-alive failed: %d\n", session->client.error);
+        ftpDisconnect(session, FALSE);
+    }
 }
 
-static DWORD WINAPI ftp_sender_thread(LPVOID lpParameter)
+static int ftpSendData(void *user, CoreSocket sock, long offset)
 {
-    WSADATA w_data;
-    SOCKET ftp_sock = 0, p_sock = 0;
-    SOCKADDR_IN server, p_server;
-    int try_count = 0, conn_error, res;
-    uint16_t p_port = 0, reply;
-    const size_t bufSizes = 1000;
-    char serverMessage[1000], sendBuffer[1000];
-    const char *send_file_name = NULL;
-    FileSend *fileToSend = NULL;
-    size_t    p_read = 0;
-    FILE     *p_file = NULL;
+    FileSend *fileToSend = (FileSend *)user;
 
-    (void)lpParameter;
+    if(fileToSend->data)
+        return ftpTransfer_sendBuffer(sock, fileToSend->data + offset, fileToSend->dataSize - offset);
 
-    res = WSAStartup(MAKEWORD(2, 2), &w_data);
-    if(res != NO_ERROR)
-    {
-        msgBoxPr(NULL, MB_OK|MB_ICONERROR, "Can't initialize WinSock for FTP sender", "Failed to initialize WinSock: Error %d", res);
-        WSACleanup();
-        queue_clear();
-        return 0;
-    }
+    return ftpTransfer_sendFile(sock, fileToSend->filePath, offset);
+}
+
+/*
+ * Upload one file by the session, the file that has failed before gets
+ * continued from the part the server already has. On failure reports the error.
+ */
+static int ftpStoreFile(FtpSession *session, FileSend *fileToSend)
+{
+    FtpUpload upload;
+    long localSize;
+    int res;
+
+    ZeroMemory(&upload, sizeof(upload));
 
-    ftp_sock = socket(2, SOCK_STREAM, IPPROTO_TCP);
-    if(ftp_sock == INVALID_SOCKET)
+    upload.name = ftpProto_baseName(fileToSend->filePath);
+    if(!upload.name)
     {
-        msgBoxPr(NULL, MB_OK|MB_ICONERROR, "Can't create socket for FTP sender", "Failed to create TCP socket: %ld", WSAGetLastError());
-        ftpCleanUp(&ftp_sock, &p_sock);
-        return 0;
+        ftpError(session, "Can't run FTP sender", "Failed to figure filename in the send file path: %s", fileToSend->filePath);
+        return STORE_REJECTED;
     }
 
-    server.sin_family = 2;
-    server.sin_port = htons(g_settings.ftpPort);
-    server.sin_addr.s_addr = inet_addr(g_settings.ftpHost);
+    localSize = fileToSend->data ? (long)fileToSend->dataSize : ftpTransfer_fileSize(fileToSend->filePath);
 
-    conn_error = connect(ftp_sock, (LPSOCKADDR)&server, sizeof(struct sockaddr));
-    while(conn_error == SOCKET_ERROR)
+    /* The file removed before the upload would be stored empty, the retry won't help */
+    if(localSize < 0)
     {
-        conn_error = connect(ftp_sock, (LPSOCKADDR)&server, sizeof(struct sockaddr));
-        try_count++;
-        if(try_count >= 10)
-        {
-            msgBoxPr(NULL, MB_OK|MB_ICONERROR, "Can't connect FTP server", "Failed to connect to FTP server %s:%u, with error %ld",
-                     g_settings.ftpHost, g_settings.ftpPort, WSAGetLastError());
-            ftpCleanUp(&ftp_sock, &p_sock);
-            return 0;
-        }
+        debugLog("--FTP File %s is missing\n", fileToSend->filePath);
+        return STORE_REJECTED;
     }
 
-    ZeroMemory(serverMessage, sizeof(serverMessage));
-    res = recv(ftp_sock, serverMessage, sizeof(serverMessage) - 1, 0);
-    if(res < 0)
+    if(fileToSend->resume && localSize == 0)
     {
-        msgBoxPr(NULL, MB_OK|MB_ICONERROR, "Can't connect to FTP server", "Failed to receive greeting: %ld", WSAGetLastError());
-        ftpCleanUp(&ftp_sock, &p_sock);
-        return 0;
+        /* Nothing to continue from, keep the part the server has */
+        debugLog("--FTP File %s is empty, not resumed\n", upload.name);
+        return STORE_REJECTED;
     }
 
-    debugLog("--FTP connected: %s\n", serverMessage);
-    /* 220 (vsFTPd 3.0.5) */
-    reply = ftpParseReplyCode(serverMessage, &res);
-    if(reply != 220 || !res)
+    upload.size = localSize;
+    upload.resume = fileToSend->resume;
+    upload.trace = fileToSend->trace;
+    upload.send = &ftpSendData;
+    upload.user = fileToSend;
+
+    res = ftpClient_store(&session->client, &upload);
+    if(res != STORE_DONE)
+        ftpReportFailure(session, upload.name);
+    else if(upload.offset > 0)
+        debugLog("--FTP File %s is continued from %ld\n", upload.name, upload.offset);
+
+    return res;
+}
+
+/*
+ * The failed connection gives its file back to the queue and rests, every
+ * failure in a row makes the pause twice longer. Nothing gets dropped: the
+ * other connections continue the work meanwhile, and the files stay in the
+ * journal in case the program gets closed before the server comes back.
+ */
+static void ftpFailed(FtpSession *session, FileSend *fileToSend)
+{
+    DWORD pause = FTP_RETRY_FIRST, pauseMax = (DWORD)g_settings.ftpRetryMax * 1000;
+
+    ftpDisconnect(session, FALSE);
+
+    if(fileToSend)
     {
-        msgBoxPr(NULL, MB_OK|MB_ICONERROR, "Can't connect FTP server", "Failed to connect to FTP server %s:%u, server reply error:\n%s",
-                 g_settings.ftpHost, g_settings.ftpPort, serverMessage);
-        ftpCleanUp(&ftp_sock, &p_sock);
-        return 0;
+        fileToSend->resume = TRUE;
+        /* The outage may last until the exit */
+        fileSend_spill(fileToSend);
+        queue_putBack(fileToSend);
     }
 
+    /* Give back the wake-up that was taken for this batch */
+    ReleaseSemaphore(s_senderSemaphore, 1, NULL);
+
+    if(session->failures < 16)
+        pause <<= session->failures;
+
+    if(pause > pauseMax)
+        pause = max(pauseMax, FTP_RETRY_FIRST);
+
+    session->failures++;
+    session->paused = TRUE;
+    session->pausedUntil = GetTickCount() + pause;
+
+    debugLog("--FTP [%d] Retry in %lu ms\n", session->index, (unsigned long)pause);
+}
+
+/* Don't take the network from the running game, the desktop covers the whole screen too, but it doesn't count */
+static BOOL ftpIsDeferred()
+{
+    char className[32];
+    HWND window;
+
+    if(!g_settings.ftpDeferFullscreen)
+        return FALSE;
+
+    /* Nothing is active for a moment while the windows get switched */
+    window = GetForegroundWindow();
+    if(!window || !isWindowFullscreen(window))
+        return FALSE;
+
+    if(GetClassNameA(window, className, sizeof(className)) > 0 &&
+       (lstrcmpiA(className, "Progman") == 0 || lstrcmpiA(className, "WorkerW") == 0))
+        return FALSE;
+
+    return TRUE;
+}
+
+static void ftpUploadQueue(FtpSession *session)
+{
+    FileSend *fileToSend = NULL;
+    DWORD started;
+    size_t fileSize;
+    int res;
+
+    if(queue_isEmpty())
+        return;
 
-    if(g_settings.ftpUser[0] != '\0')
+    if(!ftpPrepareBatch(session))
     {
-        res = sendFtpCommand(sendBuffer, bufSizes, serverMessage, bufSizes, ftp_sock, "USER", g_settings.ftpUser);
-        if(res < 0)
+        ftpFailed(session, NULL);
+        return;
+    }
+
+    for(;;)
+    {
+        if(ftpIsDeferred())
         {
-            msgBoxPr(NULL, MB_OK|MB_ICONERROR, "Can't connect to FTP server", "Failed to send USER command: %ld", WSAGetLastError());
-            ftpCleanUp(&ftp_sock, &p_sock);
-            return 0;
+            /* The rest waits until the fullscreen application goes away */
+            ReleaseSemaphore(s_senderSemaphore, 1, NULL);
+            break;
         }
 
-        debugLog("--FTP Login: %s\n", serverMessage);
-        /* 331 Please specify the password. */
-        reply = ftpParseReplyCode(serverMessage, &res);
-        if(reply != 331 || !res)
+        fileToSend = queue_get();
+        if(!fileToSend)
+            break;
+
+        InterlockedIncrement(&s_filesUploading);
+        started = GetTickCount();
+        res = ftpStoreFile(session, fileToSend);
+        InterlockedDecrement(&s_filesUploading);
+
+        if(res == STORE_FAILED)
         {
-            msgBoxPr(NULL, MB_OK|MB_ICONERROR, "Can't connect FTP server", "Failed to send login %s to FTP server %s:%u, server reply error:\n%s",
-                     g_settings.ftpUser, g_settings.ftpHost, g_settings.ftpPort, serverMessage);
-            ftpCleanUp(&ftp_sock, &p_sock);
-            return 0;
+            shotStats_uploadFailed();
+            ftpFailed(session, fileToSend);
+            return;
         }
 
-        if(g_settings.ftpPassword[0] != '\0')
-        {
-            res = sendFtpCommand(sendBuffer, bufSizes, serverMessage, bufSizes, ftp_sock, "PASS", g_settings.ftpPassword);
-            if(res < 0)
-            {
-                msgBoxPr(NULL, MB_OK|MB_ICONERROR, "Can't connect to FTP server", "Failed to send PASS command: %ld", WSAGetLastError());
-                ftpCleanUp(&ftp_sock, &p_sock);
-                return 0;
-            }
+        ftpJournal_done(fileToSend->filePath);
 
-            debugLog("--FTP Password: %s\n", serverMessage);
-            /* 230 Login successful. */
-            reply = ftpParseReplyCode(serverMessage, &res);
-            if(reply != 230 || !res)
-            {
-                msgBoxPr(NULL, MB_OK|MB_ICONERROR, "Can't connect FTP server", "Incorrect password for user %s to FTP server %s:%u, server reply error:\n%s",
-                         g_settings.ftpUser, g_settings.ftpHost, g_settings.ftpPort, serverMessage);
-                ftpCleanUp(&ftp_sock, &p_sock);
-                return 0;
-            }
-        }
-    }
-    else
-    {
-        res = sendFtpCommand(sendBuffer, bufSizes, serverMessage, bufSizes, ftp_sock, "USER", "anonymouse");
-        if(res < 0)
+        if(res == STORE_REJECTED)
         {
-            msgBoxPr(NULL, MB_OK|MB_ICONERROR, "Can't connect to FTP server", "Failed to send anonymous USER command: %ld", WSAGetLastError());
-            ftpCleanUp(&ftp_sock, &p_sock);
-            return 0;
+            /* Keep the local file, the session itself is fine */
+            shotStats_uploadFailed();
+            fileSend_free(fileToSend, FALSE);
+            continue;
         }
 
-        debugLog("--FTP Anonymouse login: %s\n", serverMessage);
-    }
+        session->failures = 0;
 
+        fileSize = fileToSend->data ? fileToSend->dataSize : (size_t)ftpTransfer_fileSize(fileToSend->filePath);
+        shotStats_uploaded(GetTickCount() - started, fileSize);
 
-    res = sendFtpCommand(sendBuffer, bufSizes, serverMessage, bufSizes, ftp_sock, "CWD", g_settings.ftpSavePath);
-    if(res < 0)
-    {
-        msgBoxPr(NULL, MB_OK|MB_ICONERROR, "Can't connect to FTP server", "Failed to send CWD command: %ld", WSAGetLastError());
-        ftpCleanUp(&ftp_sock, &p_sock);
-        return 0;
-    }
+        if(g_settings.ftpRemoveUploaded)
+            DeleteFileA(fileToSend->filePath);
 
-    debugLog("--FTP Change dir to %s: %s\n", g_settings.ftpSavePath, serverMessage);
-    /* 250 Directory successfully changed. */
-    reply = ftpParseReplyCode(serverMessage, &res);
-    if(reply != 250 || !res)
-    {
-        msgBoxPr(NULL, MB_OK|MB_ICONERROR, "Can't connect FTP server", "Can't open directory %s at the FTP server %s:%u, server reply error:\n%s",
-                 g_settings.ftpSavePath, g_settings.ftpHost, g_settings.ftpPort, serverMessage);
-        ftpCleanUp(&ftp_sock, &p_sock);
-        return 0;
+        fileSend_free(fileToSend, TRUE);
     }
 
+    session->lastUpload = GetTickCount();
+}
 
-    res = sendFtpCommand(sendBuffer, bufSizes, serverMessage, bufSizes, ftp_sock, "TYPE", "I");
-    if(res < 0)
-    {
-        msgBoxPr(NULL, MB_OK|MB_ICONERROR, "Can't connect to FTP server", "Failed to send Type I command: %ld", WSAGetLastError());
-        ftpCleanUp(&ftp_sock, &p_sock);
-        return 0;
-    }
+static BOOL ftpStartWinSock()
+{
+    int res;
 
-    debugLog("--FTP Type I: %s\n", serverMessage);
-    /* 200 Switching to Binary mode. */
-    reply = ftpParseReplyCode(serverMessage, &res);
-    if(reply != 200 || !res)
+    res = coreNet_init();
+    if(res != NO_ERROR)
     {
-        msgBoxPr(NULL, MB_OK|MB_ICONERROR, "Can't connect FTP server", "Can't enter binary mode at the FTP server %s:%u, server reply error:\n%s",
-                 g_settings.ftpHost, g_settings.ftpPort, serverMessage);
-        ftpCleanUp(&ftp_sock, &p_sock);
-        return 0;
+        msgBoxPr(NULL, MB_OK|MB_ICONERROR, "Can't initialize WinSock for FTP sender", "Failed to initialize WinSock: Error %d", res);
+        queue_clear();
+        return FALSE;
     }
 
+    return TRUE;
+}
 
-    res = sendFtpCommandND(sendBuffer, bufSizes, serverMessage, bufSizes, ftp_sock, "PASV");
-    if(res < 0)
-    {
-        msgBoxPr(NULL, MB_OK|MB_ICONERROR, "Can't connect to FTP server", "Failed to send PASV command: %ld", WSAGetLastError());
-        ftpCleanUp(&ftp_sock, &p_sock);
-        return 0;
-    }
+static DWORD WINAPI ftp_sender_thread(LPVOID lpParameter)
+{
+    FtpSession session;
+    DWORD wait;
 
-    debugLog("--FTP PASV: %s\n", serverMessage);
-    /* 227 Entering Passive Mode (172,16,9,141,39,22). */
-    reply = ftpParseReplyCode(serverMessage, &res);
-    if(reply != 227 || !res)
-    {
-        msgBoxPr(NULL, MB_OK|MB_ICONERROR, "Can't connect FTP server", "Can't enter the passive mode at the FTP server %s:%u, server reply error:\n%s",
-                 g_settings.ftpHost, g_settings.ftpPort, serverMessage);
-        ftpCleanUp(&ftp_sock, &p_sock);
-        return 0;
-    }
+    ZeroMemory(&session, sizeof(session));
+    ftpClient_init(&session.client);
+    session.index = (int)(size_t)lpParameter;
 
-    p_port =  ftpParsePassivePort(serverMessage, &res);
-    if(!res)
-    {
-        msgBoxPr(NULL, MB_OK|MB_ICONASTERISK, "Failed to send via FTP", "Failed to detect FTP mode (corrupted data received): %s", serverMessage);
-        ftpCleanUp(&ftp_sock, &p_sock);
+    if(!ftpStartWinSock())
         return 0;
-    }
-
-    debugLog("--FTP Passive Port: %u\n", p_port);
 
-
-    while((fileToSend = queue_get()) != NULL)
+    while(!s_senderQuit)
     {
-        send_file_name = ftpGetBaseName(fileToSend->filePath);
-        if(!send_file_name)
+        if(session.paused)
         {
-            errorMessageBox(NULL, "Failed to figure filename in the send file path: %s", "Can't run FTP sender");
-            ftpCleanUp(&ftp_sock, &p_sock);
-            free(fileToSend);
-            return 0;
+            /* Don't take the wake-ups from the working connections while resting */
+            Sleep(FTP_PAUSE_SLICE);
+            if((LONG)(GetTickCount() - session.pausedUntil) >= 0)
+                session.paused = FALSE;
+            continue;
         }
 
-        res = sendFtpCommandNR(sendBuffer, bufSizes, ftp_sock, "STOR", send_file_name);
-        if(res < 0)
+        /* Stay asleep while there is no session to keep */
+        if(session.client.loggedIn)
+            wait = (DWORD)g_settings.ftpKeepAlive * 1000;
+        else
+            wait = INFINITE;
+
+        if(WaitForSingleObject(s_senderSemaphore, wait) == WAIT_TIMEOUT)
         {
-            msgBoxPr(NULL, MB_OK|MB_ICONERROR, "Can't connect to FTP server", "Failed to send STOR command: %ld", WSAGetLastError());
-            ftpCleanUp(&ftp_sock, &p_sock);
-            free(fileToSend);
-            return 0;
+            ftpKeepAlive(&session);
+            continue;
         }
 
-        debugLog("--FTP Store file: %s\n", send_file_name);
-
-        p_sock = socket(2, SOCK_STREAM, IPPROTO_TCP);
-        if(p_sock == INVALID_SOCKET)
+        if(ftpIsDeferred())
         {
-            errorMessageBox(NULL, "Failed to connect passive port: %s", "Can't run FTP sender");
-            ftpCleanUp(&ftp_sock, &p_sock);
-            free(fileToSend);
-            return 0;
+            /* Keep the wake-up for later, and leave the whole link to the game meanwhile */
+            ReleaseSemaphore(s_senderSemaphore, 1, NULL);
+            ftpDisconnect(&session, TRUE);
+            Sleep(FTP_DEFER_SLICE);
+            continue;
         }
 
-        p_server.sin_family = 2;
-        p_server.sin_port = htons(p_port);
-        p_server.sin_addr.s_addr = inet_addr(g_settings.ftpHost);
+        /* Every queued file gives one wake-up, the extra ones just find the queue empty */
+        InterlockedIncrement(&s_senderUploading);
+        ftpUploadQueue(&session);
 
-        try_count = 0;
-        conn_error = connect(p_sock, (LPSOCKADDR)&p_server, sizeof(struct sockaddr));
-        while(conn_error == SOCKET_ERROR)
-        {
-            conn_error = connect(p_sock, (LPSOCKADDR)&p_server, sizeof(struct sockaddr));
-            try_count++;
+        if(g_settings.ftpKeepAlive <= 0)
+            ftpDisconnect(&session, TRUE);
 
-            if(try_count >= 10)
-            {
-                errorMessageBox(NULL, "Failed to connect passive port: %s", "Can't run FTP sender");
-                ftpCleanUp(&ftp_sock, &p_sock);
-                free(fileToSend);
-                return 0;
-            }
-        }
+        InterlockedDecrement(&s_senderUploading);
+    }
 
-        p_file = fopen(fileToSend->filePath, "rb");
-        if(p_file)
-        {
-            while((p_read = fread(sendBuffer, 1, bufSizes, p_file)) > 0)
-            {
-                res = send(p_sock, sendBuffer, p_read, 0);
-                if(res < 0)
-                {
-                    msgBoxPr(NULL, MB_OK|MB_ICONERROR, "Failes to send data to FTP server", "Failed to send data by passive port: %ld", WSAGetLastError());
-                    ftpCleanUp(&ftp_sock, &p_sock);
-                    free(fileToSend);
-                    return 0;
-                }
-            }
-            fclose(p_file);
-        }
+    ftpDisconnect(&session, TRUE);
+    coreNet_quit();
 
-        closesocket(p_sock);
+    return 0;
+}
 
-        if(g_settings.ftpRemoveUploaded)
-            DeleteFileA(fileToSend->filePath);
+/* Upload everything right in the current thread when the sender thread can't be started */
+static void ftp_sender_sync()
+{
+    FtpSession session;
 
-        free(fileToSend);
-    }
+    ZeroMemory(&session, sizeof(session));
+    ftpClient_init(&session.client);
 
-    res = sendFtpCommandND(sendBuffer, bufSizes, serverMessage, bufSizes, ftp_sock, "QUIT");
-    if(res < 0)
-    {
-        msgBoxPr(NULL, MB_OK|MB_ICONERROR, "Can't connect to FTP server", "Failed to send QUIT command: %ld", WSAGetLastError());
-        ftpCleanUp(&ftp_sock, &p_sock);
-        return 0;
-    }
-    debugLog("--FTP Quit: %s\n", serverMessage);
-    /* 150 Ok to send data. */
+    if(!ftpStartWinSock())
+        return;
 
-    ftpCleanUp(&ftp_sock, &p_sock);
+    ftpUploadQueue(&session);
+    ftpDisconnect(&session, TRUE);
+    coreNet_quit();
+}
 
-    return 0;
+static int connectionsCount()
+{
+    int count = g_settings.ftpConnections;
+
+    if(count < 1)
+        count = 1;
+    else if(count > FTP_MAX_CONNECTIONS)
+        count = FTP_MAX_CONNECTIONS;
+
+    return count;
 }
 
 BOOL ftpSender_isBusy()
 {
-    DWORD res = 0;
-
-    if(s_senderThread)
-        res = WaitForSingleObject(s_senderThread, 0);
-    else
-        res = WAIT_OBJECT_0;
+    return s_senderUploading > 0 || !queue_isEmpty();
+}
 
-    return res != WAIT_OBJECT_0;
+int ftpSender_pendingCount()
+{
+    return queue_count() + (int)s_filesUploading;
 }
 
 void ftpSender_init()
 {
     if(!s_queue_mutex)
         s_queue_mutex = CreateMutexA(NULL, FALSE, NULL);
+
+    if(!s_senderSemaphore)
+        s_senderSemaphore = CreateSemaphoreA(NULL, 0, 0x7FFFFFFF, NULL);
+
+    ftpTransfer_init();
+    ftpClient_setLog(&debugLog);
+    ftpClient_initResolver();
 }
 
 void ftpSender_quit()
 {
-    if(s_senderThread)
+    int i;
+
+    InterlockedExchange(&s_senderQuit, 1);
+
+    if(s_senderSemaphore)
+        ReleaseSemaphore(s_senderSemaphore, FTP_MAX_CONNECTIONS, NULL);
+
+    for(i = 0; i < FTP_MAX_CONNECTIONS; ++i)
     {
-        WaitForSingleObject(s_senderThread, INFINITE);
-        CloseHandle(s_senderThread);
-        s_senderThread = NULL;
+        if(s_senderThreads[i])
+        {
+            WaitForSingleObject(s_senderThreads[i], INFINITE);
+            CloseHandle(s_senderThreads[i]);
+            s_senderThreads[i] = NULL;
+        }
+    }
+
+    ftpTransfer_quit();
+    ftpClient_quitResolver();
+
+    /* Unsent files stay in the journal until the next run */
+    queue_clear();
+    ftpJournal_quit();
+
+    if(s_senderSemaphore)
+    {
+        CloseHandle(s_senderSemaphore);
+        s_senderSemaphore = 0;
     }
 
     if(s_queue_mutex)
@@ -556,42 +774,108 @@ void ftpSender_quit()
     }
 }
 
+/* Start the missing connection threads, the main one is required, the helpers are optional */
 static BOOL tryRunFtpThread(HWND hWnd)
 {
-    DWORD res = 0;
+    DWORD threadId;
+    int i, count;
 
-    if(s_senderThread)
-        res = WaitForSingleObject(s_senderThread, 0);
-    else
-        res = WAIT_OBJECT_0;
+    if(!s_senderSemaphore)
+        return FALSE;
+
+    count = connectionsCount();
 
-    if(res == WAIT_OBJECT_0)
+    for(i = 0; i < count; ++i)
     {
-        s_senderThread = CreateThread(NULL, 0, &ftp_sender_thread, NULL, 0, &s_senderThreadId);
-        if(!s_senderThread)
+        if(s_senderThreads[i] && WaitForSingleObject(s_senderThreads[i], 0) == WAIT_OBJECT_0)
         {
-            errorMessageBox(hWnd, "Failed to make FTP sender thread: %s\n\nTrying without.", "Whoops");
-            return FALSE;
+            /* Has quit because of the WinSock failure */
+            CloseHandle(s_senderThreads[i]);
+            s_senderThreads[i] = NULL;
+        }
+
+        if(!s_senderThreads[i])
+        {
+            s_senderThreads[i] = CreateThread(NULL, 0, &ftp_sender_thread, (LPVOID)(size_t)i, 0, &threadId);
+            if(!s_senderThreads[i] && i == 0)
+            {
+                errorMessageBox(hWnd, "Failed to make FTP sender thread: %s\n\nTrying without.", "Whoops");
+                return FALSE;
+            }
         }
     }
 
     return TRUE;
 }
 
-void ftpSender_queueFile(HWND hWnd, const char *filePath)
+static void ftpSender_queue(HWND hWnd, FileSend *fileToSend)
 {
-    FileSend *fileToSend = (FileSend *)malloc(sizeof(FileSend));
-    ZeroMemory(fileToSend, sizeof(FileSend));
-    strncpy(fileToSend->filePath, filePath, MAX_PATH);
+    ftpJournal_add(fileToSend->filePath);
     queue_insert(fileToSend);
 
     if(!tryRunFtpThread(hWnd))
     {
         sysTraySetIcon(SET_ICON_UPLOAD);
-        ftp_sender_thread(NULL);
+        ftp_sender_sync();
         sysTraySetIcon(SET_ICON_NORMAL);
     }
     else
+    {
+        ReleaseSemaphore(s_senderSemaphore, 1, NULL);
         initIconBlinker(hWnd);
+    }
+}
+
+void ftpSender_queueFile(HWND hWnd, const char *filePath)
+{
+    FileSend *fileToSend = (FileSend *)malloc(sizeof(FileSend));
+    ZeroMemory(fileToSend, sizeof(FileSend));
+    strncpy(fileToSend->filePath, filePath, MAX_PATH);
+    ftpSender_queue(hWnd, fileToSend);
+}
+
+void ftpSender_queueBuffer(HWND hWnd, const char *filePath, uint8_t *data, size_t dataSize, uint32_t traceShot)
+{
+    FileSend *fileToSend = (FileSend *)malloc(sizeof(FileSend));
+    ZeroMemory(fileToSend, sizeof(FileSend));
+    strncpy(fileToSend->filePath, filePath, MAX_PATH);
+    fileToSend->data = data;
+    fileToSend->dataSize = dataSize;
+    fileToSend->trace = traceShot;
+    ftpSender_queue(hWnd, fileToSend);
 }
 
+static HWND s_resumeHWnd = NULL;
+
+static BOOL ftpSender_resumeFile(const char *filePath)
+{
+    FileSend *fileToSend;
+    long size = ftpTransfer_fileSize(filePath);
+
+    /* Already removed by the user, or the empty placeholder of the shot that was uploaded
+       from the memory and lost by the crash: the upload would overwrite the part on the server */
+    if(size <= 0)
+    {
+        debugLog("--FTP Journal: %s is %s, dropped\n", filePath, size < 0 ? "missing" : "empty");
+        return FALSE;
+    }
+
+    fileToSend = (FileSend *)malloc(sizeof(FileSend));
+    ZeroMemory(fileToSend, sizeof(FileSend));
+    strncpy(fileToSend->filePath, filePath, MAX_PATH);
+    fileToSend->resume = TRUE;
+    ftpSender_queue(s_resumeHWnd, fileToSend);
+
+    return TRUE;
+}
+
+void ftpSender_resume(HWND hWnd, const char *configDir)
+{
+    ftpJournal_init(configDir);
+
+    if(!g_settings.ftpEnable)
+        return;
+
+    s_resumeHWnd = hWnd;
+    ftpJournal_replay(&ftpSender_resumeFile);
+}
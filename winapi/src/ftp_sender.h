@@ -25,13 +25,38 @@
 #ifndef FTP_SENDER_H
 #define FTP_SENDER_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include <windef.h>
 
+/* Maximum number of the parallel FTP connections */
+#define FTP_MAX_CONNECTIONS     4
+
 BOOL ftpSender_isBusy();
+/**
+ * @brief Number of the files waiting for the upload, including the ones being uploaded right now
+ */
+int ftpSender_pendingCount();
 
 void ftpSender_init();
 void ftpSender_quit();
 
+/**
+ * @brief Open the upload journal and queue the files that the previous run didn't upload, must be called after settingsInit()
+ * @param hWnd Parent window
+ * @param configDir Directory of the config file, the journal is kept there
+ */
+void ftpSender_resume(HWND hWnd, const char *configDir);
+
 void ftpSender_queueFile(HWND hWnd, const char *filePath);
+/**
+ * @brief Queue the file that is already in the memory, the upload doesn't read the disk
+ * @param hWnd Parent window
+ * @param filePath Local path of the file, its base name is used as the remote name
+ * @param data File data allocated by malloc(), the sender takes the ownership of it
+ * @param dataSize Size of the data
+ * @param traceShot Number of the shot to mark its upload in the trace, or 0
+ */
+void ftpSender_queueBuffer(HWND hWnd, const char *filePath, uint8_t *data, size_t dataSize, uint32_t traceShot);
 
 #endif /* FTP_SENDER_H */
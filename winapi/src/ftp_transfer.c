@@ -0,0 +1,234 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <windows.h>
+#include <winsock.h>
+
+#include "ftp_transfer.h"
+#include "rate_limit.h"
+#include "core_sys.h"
+#include "settings.h"
+#include "misc.h"
+
+
+static HINSTANCE                lib_mswsock = NULL;
+/* Same as in mswsock.h, the TRANSMIT_FILE_BUFFERS is never used */
+typedef BOOL (PASCAL *PtrTransmitFile)(SOCKET, HANDLE, DWORD, DWORD, LPOVERLAPPED, LPVOID, DWORD);
+static PtrTransmitFile          ptrTransmitFile = NULL;
+/* TransmitFile() has failed while the chunks went fine, the stack doesn't support it */
+static volatile LONG            s_transmitFileRefused = 0;
+
+/* Token bucket of the [ftp] rate-limit-kb, shared by all connections */
+static RateLimit s_bucket;
+static BOOL s_bucketReady = FALSE;
+
+
+static size_t chunkSize()
+{
+    size_t chunk = (size_t)g_settings.ftpChunkKB * 1024;
+
+    if(chunk < FTP_TRANSFER_MIN_CHUNK)
+        chunk = FTP_TRANSFER_MIN_CHUNK;
+    else if(chunk > FTP_TRANSFER_MAX_CHUNK)
+        chunk = FTP_TRANSFER_MAX_CHUNK;
+
+    return chunk;
+}
+
+static DWORD rateSetting()
+{
+    return g_settings.ftpRateLimitKB > 0 ? (DWORD)g_settings.ftpRateLimitKB * 1024 : 0;
+}
+
+/* Wait until the bucket allows to send the data, returns the number of bytes that may be sent now */
+static size_t throttleTake(size_t want)
+{
+    DWORD rate = rateSetting();
+    uint64_t wait;
+    size_t got;
+
+    if(rate == 0 || !s_bucketReady)
+        return want;
+
+    /* The setting may be changed while the sender works */
+    if(s_bucket.rate != rate)
+        rateLimit_setRate(&s_bucket, rate, FTP_TRANSFER_MIN_CHUNK);
+
+    while((got = rateLimit_take(&s_bucket, want, coreSys_timeUs(), &wait)) == 0)
+        Sleep((DWORD)(wait / 1000) + 1);
+
+    return got;
+}
+
+void ftpTransfer_init()
+{
+    /* Missing at the clean Windows 95 without the WinSock 2 update */
+    if(!lib_mswsock)
+        lib_mswsock = LoadLibraryA("mswsock");
+
+    if(lib_mswsock)
+        ptrTransmitFile = (PtrTransmitFile)GetProcAddress(lib_mswsock, "TransmitFile");
+
+    debugLog("-- TransmitFile is %s\n", ptrTransmitFile ? "available" : "unavailable");
+
+    if(!s_bucketReady)
+    {
+        rateLimit_init(&s_bucket, rateSetting(), FTP_TRANSFER_MIN_CHUNK, coreSys_timeUs());
+        s_bucketReady = TRUE;
+    }
+}
+
+void ftpTransfer_quit()
+{
+    ptrTransmitFile = NULL;
+
+    if(lib_mswsock)
+    {
+        FreeLibrary(lib_mswsock);
+        lib_mswsock = NULL;
+    }
+
+    if(s_bucketReady)
+    {
+        rateLimit_free(&s_bucket);
+        s_bucketReady = FALSE;
+    }
+}
+
+int ftpTransfer_sendBufferSize()
+{
+    /* The data that already sits in the big buffer can't be throttled */
+    if(rateSetting() > 0 || g_settings.ftpSendBufferKB <= 0)
+        return 0;
+
+    /* Bigger buffer keeps the link busy while the sender waits for the ACKs */
+    return g_settings.ftpSendBufferKB * 1024;
+}
+
+BOOL ftpTransfer_sendBuffer(SOCKET sock, const uint8_t *data, size_t size)
+{
+    size_t chunk = chunkSize();
+    int res;
+
+    while(size > 0)
+    {
+        /* send() may take only a part of the chunk */
+        res = send(sock, (const char *)data, (int)throttleTake(min(size, chunk)), 0);
+        if(res <= 0)
+            return FALSE;
+
+        data += res;
+        size -= res;
+    }
+
+    return TRUE;
+}
+
+static BOOL sendFileByChunks(SOCKET sock, FILE *f)
+{
+    size_t chunk = chunkSize(), got;
+    uint8_t *buffer;
+    BOOL ret = TRUE;
+
+    buffer = (uint8_t *)malloc(chunk);
+    if(!buffer)
+        return FALSE;
+
+    while(ret && (got = fread(buffer, 1, chunk, f)) > 0)
+        ret = ftpTransfer_sendBuffer(sock, buffer, got);
+
+    free(buffer);
+
+    return ret;
+}
+
+long ftpTransfer_fileSize(const char *filePath)
+{
+    long size;
+    FILE *f;
+
+    f = fopen(filePath, "rb");
+    if(!f)
+        return -1;
+
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fclose(f);
+
+    return size;
+}
+
+BOOL ftpTransfer_sendFile(SOCKET sock, const char *filePath, long offset)
+{
+    HANDLE file;
+    FILE *f;
+    BOOL ret, fallback = FALSE;
+
+    /* TransmitFile() sends the whole file at once, so the throttled upload goes by chunks */
+    if(ptrTransmitFile && rateSetting() == 0 && !s_transmitFileRefused)
+    {
+        file = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if(file != INVALID_HANDLE_VALUE)
+        {
+            /* TransmitFile() starts at the current position of the file */
+            if(offset > 0)
+                SetFilePointer(file, offset, NULL, FILE_BEGIN);
+
+            /* The kernel sends the whole file without copying it through this process */
+            ret = ptrTransmitFile(sock, file, 0, 0, NULL, NULL, 0);
+            CloseHandle(file);
+
+            if(ret)
+                return TRUE;
+
+            /* Win9x and the workstation NT may refuse it without sending anything, the chunks go then.
+               On the broken connection the chunks fail too */
+            debugLog("--FTP TransmitFile failed: %ld, sending by chunks\n", WSAGetLastError());
+            fallback = TRUE;
+        }
+    }
+
+    f = fopen(filePath, "rb");
+    if(!f)
+    {
+        debugLog("--FTP Can't open %s\n", filePath);
+        return FALSE;
+    }
+
+    if(offset > 0)
+        fseek(f, offset, SEEK_SET);
+
+    ret = sendFileByChunks(sock, f);
+    fclose(f);
+
+    if(fallback && ret)
+    {
+        debugLog("--FTP TransmitFile is not used anymore\n");
+        InterlockedExchange(&s_transmitFileRefused, 1);
+    }
+
+    return ret;
+}
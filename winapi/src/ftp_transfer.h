@@ -0,0 +1,75 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef FTP_TRANSFER_H
+#define FTP_TRANSFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <windef.h>
+#include <winsock.h>
+
+/* Limits of the [ftp] chunk-kb setting */
+#define FTP_TRANSFER_MIN_CHUNK      4096
+#define FTP_TRANSFER_MAX_CHUNK      (4 * 1024 * 1024)
+
+/**
+ * @brief Load the optional TransmitFile() from mswsock.dll, must be called before the sender starts
+ */
+void ftpTransfer_init();
+void ftpTransfer_quit();
+
+/**
+ * @brief Get the send buffer size of the data sockets from settings
+ * @return Size in bytes, or 0 to keep the system one
+ */
+int ftpTransfer_sendBufferSize();
+
+/**
+ * @brief Send the memory buffer by large chunks
+ * @param sock Data socket
+ * @param data Data to send
+ * @param size Size of the data
+ * @return TRUE on success, FALSE on socket error
+ */
+BOOL ftpTransfer_sendBuffer(SOCKET sock, const uint8_t *data, size_t size);
+
+/**
+ * @brief Get the size of the local file
+ * @param filePath Path to the file
+ * @return Size of the file, or -1 if it can't be opened
+ */
+long ftpTransfer_fileSize(const char *filePath);
+
+/**
+ * @brief Send the file: by the TransmitFile() if available, or by reading it with large chunks,
+ * also when TransmitFile() fails
+ * @param sock Data socket
+ * @param filePath Path to the file
+ * @param offset Position in the file to start from, used to resume the interrupted upload
+ * @return TRUE on success, FALSE on socket error or if the file can't be opened
+ */
+BOOL ftpTransfer_sendFile(SOCKET sock, const char *filePath, long offset);
+
+#endif /* FTP_TRANSFER_H */
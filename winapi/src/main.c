@@ -30,11 +30,16 @@
 #include "resource.h"
 
 #include "shot_proc.h"
+#include "shot_burst.h"
+#include "shot_transcode.h"
 #include "shot_data.h"
 #include "shot_hooks.h"
 #include "ftp_sender.h"
 #include "tray_icon.h"
 #include "settings.h"
+#include "frame_pool.h"
+#include "shot_trace.h"
+#include "shot_stats.h"
 
 
 void runMsgLoop()
@@ -61,9 +66,13 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 
     InitCommonControls();
 
+    shotTrace_init();
+    shotStats_init();
     shotProc_init();
+    shotTranscode_init();
     ftpSender_init();
     settingsInit(hInstance);
+    framePool_init(g_settings.framePoolDepth, g_settings.framePoolPolicy);
     ShotData_init(&g_shotData);
 
     ret = initSysTrayIcon(hInstance);
@@ -71,15 +80,25 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
         return ret;
 
     ShotData_update(&g_shotData);
+    ftpSender_resume(g_trayIconHWnd, settingsConfigDir());
 
     initKeyHook(g_trayIconHWnd, hInstance);
+    initStatsTimer(g_trayIconHWnd);
 
     runMsgLoop();
 
+    shotBurst_stop(g_trayIconHWnd);
+    shotTranscode_stop();
+    closeStatsTimer(g_trayIconHWnd);
+
     settingsDestroy();
     closeSysTrayIcon();
     shotProc_quit();
+    shotTranscode_quit();
+    framePool_quit();
     ftpSender_quit();
+    shotStats_quit();
+    shotTrace_quit();
 
     ShotData_free(&g_shotData);
 
@@ -31,6 +31,9 @@
 #include "misc.h"
 #include "resource.h"
 #include "settings.h"
+#include "png_preset.h"
+#include "shot_format.h"
+#include "frame_pool.h"
 
 
 static char s_configFilePath[MAX_PATH];
@@ -73,6 +76,11 @@ void settingsInit(HINSTANCE inst)
     settingsLoad();
 }
 
+const char *settingsConfigDir()
+{
+    return s_configDir;
+}
+
 static void touchConfigFile()
 {
     FILE *f = fopen(s_configFilePath, "r");
@@ -99,14 +107,55 @@ static BOOL writeIniInt(const char *section, const char *key, int value, const c
 
 void settingsLoad()
 {
+    char compression[32];
+    char saveFormat[32];
+    char poolPolicy[32];
+    char queuePolicy[32];
+    char dupAction[32];
+    char burstFormat[32];
+
     touchConfigFile();
 
     GetPrivateProfileStringA("main", "save-path", s_configDir, g_settings.savePath, MAX_PATH, s_configFilePath);
+    g_settings.encodeThreads = GetPrivateProfileIntA("main", "encode-threads", 0, s_configFilePath);
+    g_settings.saveWorkers = GetPrivateProfileIntA("main", "save-workers", 2, s_configFilePath);
+    GetPrivateProfileStringA("main", "compression", "desktop", compression, 32, s_configFilePath);
+    g_settings.compression = pngPreset_fromName(compression);
+    GetPrivateProfileStringA("main", "save-format", "png", saveFormat, 32, s_configFilePath);
+    g_settings.saveFormat = shotFormat_fromName(saveFormat);
+    g_settings.transcodeIdle = GetPrivateProfileIntA("main", "transcode-idle", 0, s_configFilePath);
+    g_settings.framePoolDepth = GetPrivateProfileIntA("main", "frame-pool-depth", 2, s_configFilePath);
+    GetPrivateProfileStringA("main", "frame-pool-policy", "spill", poolPolicy, 32, s_configFilePath);
+    g_settings.framePoolPolicy = framePool_policyFromName(poolPolicy);
+    g_settings.queueBudgetMB = GetPrivateProfileIntA("main", "queue-budget-mb", 64, s_configFilePath);
+    GetPrivateProfileStringA("main", "queue-policy", "drop-newest", queuePolicy, 32, s_configFilePath);
+    g_settings.queuePolicy = shotQueue_policyFromName(queuePolicy);
+    g_settings.statsInterval = GetPrivateProfileIntA("main", "stats-interval", 60, s_configFilePath);
+    g_settings.dupHistory = GetPrivateProfileIntA("main", "skip-duplicates", 0, s_configFilePath);
+    GetPrivateProfileStringA("main", "duplicate-action", "skip", dupAction, 32, s_configFilePath);
+    g_settings.dupAction = shotProc_dupActionFromName(dupAction);
+    g_settings.deltaCapture = GetPrivateProfileIntA("main", "delta-capture", 0, s_configFilePath);
+    g_settings.deltaTile = GetPrivateProfileIntA("main", "delta-tile", 64, s_configFilePath);
+    g_settings.deltaKeyframe = GetPrivateProfileIntA("main", "delta-keyframe", 50, s_configFilePath);
+    g_settings.burstInterval = GetPrivateProfileIntA("main", "burst-interval", 200, s_configFilePath);
+    g_settings.burstDuration = GetPrivateProfileIntA("main", "burst-duration", 3000, s_configFilePath);
+    g_settings.burstSlots = GetPrivateProfileIntA("main", "burst-slots", 8, s_configFilePath);
+    GetPrivateProfileStringA("main", "burst-format", "apng", burstFormat, 32, s_configFilePath);
+    g_settings.burstFormat = shotProc_burstFormatFromName(burstFormat);
 
     g_settings.ftpEnable = GetPrivateProfileIntA("ftp", "enable", FALSE, s_configFilePath);
     g_settings.ftpRemoveUploaded = GetPrivateProfileIntA("ftp", "remove-files", FALSE, s_configFilePath);
     GetPrivateProfileStringA("ftp", "host", "", g_settings.ftpHost, 120, s_configFilePath);
     g_settings.ftpPort = GetPrivateProfileIntA("ftp", "port", 21, s_configFilePath);
+    g_settings.ftpKeepAlive = GetPrivateProfileIntA("ftp", "keep-alive", 30, s_configFilePath);
+    g_settings.ftpIdleTimeout = GetPrivateProfileIntA("ftp", "idle-timeout", 300, s_configFilePath);
+    g_settings.ftpChunkKB = GetPrivateProfileIntA("ftp", "chunk-kb", 64, s_configFilePath);
+    g_settings.ftpSendBufferKB = GetPrivateProfileIntA("ftp", "send-buffer-kb", 256, s_configFilePath);
+    g_settings.ftpConnections = GetPrivateProfileIntA("ftp", "connections", 1, s_configFilePath);
+    g_settings.ftpRetryMax = GetPrivateProfileIntA("ftp", "retry-max", 300, s_configFilePath);
+    g_settings.ftpConnectTimeout = GetPrivateProfileIntA("ftp", "connect-timeout", 10, s_configFilePath);
+    g_settings.ftpRateLimitKB = GetPrivateProfileIntA("ftp", "rate-limit-kb", 0, s_configFilePath);
+    g_settings.ftpDeferFullscreen = GetPrivateProfileIntA("ftp", "defer-fullscreen", FALSE, s_configFilePath);
 
     GetPrivateProfileStringA("ftp", "user", "", g_settings.ftpUser, 120, s_configFilePath);
     GetPrivateProfileStringA("ftp", "password", "", g_settings.ftpPassword, 120, s_configFilePath);
@@ -118,11 +167,39 @@ void settingsSave()
     touchConfigFile();
 
     WritePrivateProfileStringA("main", "save-path", g_settings.savePath, s_configFilePath);
+    writeIniInt("main", "encode-threads", g_settings.encodeThreads, s_configFilePath);
+    writeIniInt("main", "save-workers", g_settings.saveWorkers, s_configFilePath);
+    WritePrivateProfileStringA("main", "compression", pngPreset_get(g_settings.compression)->name, s_configFilePath);
+    WritePrivateProfileStringA("main", "save-format", shotFormat_name(g_settings.saveFormat), s_configFilePath);
+    writeIniInt("main", "transcode-idle", g_settings.transcodeIdle, s_configFilePath);
+    writeIniInt("main", "frame-pool-depth", g_settings.framePoolDepth, s_configFilePath);
+    WritePrivateProfileStringA("main", "frame-pool-policy", framePool_policyName(g_settings.framePoolPolicy), s_configFilePath);
+    writeIniInt("main", "queue-budget-mb", g_settings.queueBudgetMB, s_configFilePath);
+    WritePrivateProfileStringA("main", "queue-policy", shotQueue_policyName(g_settings.queuePolicy), s_configFilePath);
+    writeIniInt("main", "stats-interval", g_settings.statsInterval, s_configFilePath);
+    writeIniInt("main", "skip-duplicates", g_settings.dupHistory, s_configFilePath);
+    WritePrivateProfileStringA("main", "duplicate-action", shotProc_dupActionName(g_settings.dupAction), s_configFilePath);
+    writeIniInt("main", "delta-capture", g_settings.deltaCapture, s_configFilePath);
+    writeIniInt("main", "delta-tile", g_settings.deltaTile, s_configFilePath);
+    writeIniInt("main", "delta-keyframe", g_settings.deltaKeyframe, s_configFilePath);
+    writeIniInt("main", "burst-interval", g_settings.burstInterval, s_configFilePath);
+    writeIniInt("main", "burst-duration", g_settings.burstDuration, s_configFilePath);
+    writeIniInt("main", "burst-slots", g_settings.burstSlots, s_configFilePath);
+    WritePrivateProfileStringA("main", "burst-format", shotProc_burstFormatName(g_settings.burstFormat), s_configFilePath);
 
     writeIniInt("ftp", "enable", g_settings.ftpEnable, s_configFilePath);
     writeIniInt("ftp", "remove-files", g_settings.ftpRemoveUploaded, s_configFilePath);
     WritePrivateProfileStringA("ftp", "host", g_settings.ftpHost, s_configFilePath);
     writeIniInt("ftp", "port", g_settings.ftpPort, s_configFilePath);
+    writeIniInt("ftp", "keep-alive", g_settings.ftpKeepAlive, s_configFilePath);
+    writeIniInt("ftp", "idle-timeout", g_settings.ftpIdleTimeout, s_configFilePath);
+    writeIniInt("ftp", "chunk-kb", g_settings.ftpChunkKB, s_configFilePath);
+    writeIniInt("ftp", "send-buffer-kb", g_settings.ftpSendBufferKB, s_configFilePath);
+    writeIniInt("ftp", "connections", g_settings.ftpConnections, s_configFilePath);
+    writeIniInt("ftp", "retry-max", g_settings.ftpRetryMax, s_configFilePath);
+    writeIniInt("ftp", "connect-timeout", g_settings.ftpConnectTimeout, s_configFilePath);
+    writeIniInt("ftp", "rate-limit-kb", g_settings.ftpRateLimitKB, s_configFilePath);
+    writeIniInt("ftp", "defer-fullscreen", g_settings.ftpDeferFullscreen, s_configFilePath);
 
     WritePrivateProfileStringA("ftp", "user", g_settings.ftpUser, s_configFilePath);
     WritePrivateProfileStringA("ftp", "password", g_settings.ftpPassword, s_configFilePath);
@@ -31,11 +31,39 @@
 struct TinyShotSettings
 {
     char savePath[MAX_PATH];
+    int  encodeThreads;
+    int  saveWorkers;
+    int  compression;
+    int  saveFormat;
+    BOOL transcodeIdle;
+    int  framePoolDepth;
+    int  framePoolPolicy;
+    int  queueBudgetMB;
+    int  queuePolicy;
+    int  statsInterval;
+    int  dupHistory;
+    int  dupAction;
+    BOOL deltaCapture;
+    int  deltaTile;
+    int  deltaKeyframe;
+    int  burstInterval;
+    int  burstDuration;
+    int  burstSlots;
+    int  burstFormat;
 
     BOOL        ftpEnable;
     BOOL        ftpRemoveUploaded;
     char        ftpHost[120];
     uint16_t    ftpPort;
+    int         ftpKeepAlive;
+    int         ftpIdleTimeout;
+    int         ftpChunkKB;
+    int         ftpSendBufferKB;
+    int         ftpConnections;
+    int         ftpRetryMax;
+    int         ftpConnectTimeout;
+    int         ftpRateLimitKB;
+    BOOL        ftpDeferFullscreen;
     char        ftpUser[120];
     char        ftpPassword[120];
     char        ftpSavePath[MAX_PATH];
@@ -46,6 +74,8 @@ typedef struct TinyShotSettings TinyShotSettings;
 extern TinyShotSettings g_settings;
 
 void settingsInit(HINSTANCE inst);
+/* Directory of the tinyscr_w.ini file */
+const char *settingsConfigDir();
 
 void settingsLoad();
 void settingsSave();
@@ -0,0 +1,202 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <windows.h>
+
+#include "shot_burst.h"
+#include "shot_proc.h"
+#include "shot_data.h"
+#include "frame_pool.h"
+#include "shot_stats.h"
+#include "tray_icon.h"
+#include "settings.h"
+#include "misc.h"
+#include "core_sys.h"
+#include "resource_ex.h"
+
+/* How long the tooltip shows the numbers of the finished burst, in milliseconds */
+#define BURST_TIP_TIME  10000
+
+static BOOL s_active = FALSE;
+/* The capture is in progress, the timer ticks that come from the message boxes get ignored */
+static BOOL s_inFrame = FALSE;
+static uint64_t s_start = 0;
+static uint32_t s_frames = 0;
+static uint32_t s_dropped = 0;
+static DWORD s_stopTick = 0;
+static BOOL s_happened = FALSE;
+
+static uint32_t elapsedMs()
+{
+    return (uint32_t)((coreSys_timeUs() - s_start) / 1000);
+}
+
+static void burstFrame(HWND hWnd)
+{
+    int ret;
+
+    s_inFrame = TRUE;
+    ret = shotProc_burstFrame(hWnd, &g_shotData);
+    s_inFrame = FALSE;
+
+    s_frames++;
+    if(ret != SHOT_BURST_SAVED)
+        s_dropped++;
+
+    shotStats_burstProgress(s_frames, s_dropped, elapsedMs());
+
+    if(ret == SHOT_BURST_FAILED)
+        shotBurst_stop(hWnd);
+}
+
+static void CALLBACK burstTimer(HWND p1, UINT p2, UINT_PTR p3, DWORD p4)
+{
+    (void)p2; (void)p3; (void)p4;
+
+    if(!s_active || s_inFrame)
+        return;
+
+    if(g_settings.burstDuration > 0 && elapsedMs() >= (uint32_t)g_settings.burstDuration)
+    {
+        shotBurst_stop(p1);
+        return;
+    }
+
+    burstFrame(p1);
+}
+
+static int burstInterval()
+{
+    int interval = g_settings.burstInterval;
+
+    if(interval < SHOT_BURST_MIN_INTERVAL)
+        interval = SHOT_BURST_MIN_INTERVAL;
+    if(interval > SHOT_BURST_MAX_INTERVAL)
+        interval = SHOT_BURST_MAX_INTERVAL;
+
+    return interval;
+}
+
+static void burstStart(HWND hWnd)
+{
+    int ret, interval = burstInterval();
+
+    ShotData_update(&g_shotData);
+
+    /* All the memory of the burst gets taken here, the capture itself only reuses it */
+    ret = framePool_beginBurst(g_settings.burstSlots, g_shotData.m_pixels_size);
+    if(ret == FRAME_POOL_FULL)
+    {
+        debugLog("-- The frames of the previous burst are still being saved\n");
+        MessageBeep(MB_ICONHAND);
+        return;
+    }
+    else if(ret != FRAME_POOL_OK)
+    {
+        msgBoxPr(hWnd, MB_OK|MB_ICONERROR, "Whoops",
+                 "Not enough memory for %d burst frames of %lu KB, reduce the burst-slots setting.",
+                 g_settings.burstSlots, (unsigned long)(g_shotData.m_pixels_size / 1024));
+        return;
+    }
+
+    if(!shotProc_burstBegin(hWnd, &g_shotData, (uint32_t)interval))
+    {
+        framePool_endBurst();
+        return;
+    }
+
+    if(!SetTimer(hWnd, ID_BURST_TIMER, (UINT)interval, &burstTimer))
+    {
+        framePool_endBurst();
+        shotProc_burstEnd();
+        errorMessageBox(hWnd, "Failed to start the burst timer: %s", "Error");
+        return;
+    }
+
+    debugLog("-- Burst started: every %d ms for %d ms, %d slots\n",
+             interval, g_settings.burstDuration, g_settings.burstSlots);
+
+    s_active = TRUE;
+    s_happened = TRUE;
+    s_frames = 0;
+    s_dropped = 0;
+    s_start = coreSys_timeUs();
+    shotStats_burstStarted((uint32_t)interval);
+
+    /* The first frame goes right away, the timer takes the rest */
+    MessageBeep(MB_OK);
+    burstFrame(hWnd);
+}
+
+void shotBurst_stop(HWND hWnd)
+{
+    char tip[64];
+
+    if(!s_active)
+        return;
+
+    KillTimer(hWnd, ID_BURST_TIMER);
+    s_active = FALSE;
+    s_stopTick = GetTickCount();
+
+    /* The frames still being saved keep their buffers until the saver is done with them */
+    framePool_endBurst();
+    shotProc_burstEnd();
+
+    shotStats_burstProgress(s_frames, s_dropped, elapsedMs());
+
+    debugLog("-- Burst finished: %lu frames, %lu dropped, %lu ms\n",
+             (unsigned long)s_frames, (unsigned long)s_dropped, (unsigned long)elapsedMs());
+
+    if(shotBurst_formatTip(tip, sizeof(tip)))
+        sysTraySetTip(tip);
+
+    MessageBeep(MB_ICONEXCLAMATION);
+}
+
+void shotBurst_toggle(HWND hWnd)
+{
+    if(s_active)
+        shotBurst_stop(hWnd);
+    else
+        burstStart(hWnd);
+}
+
+BOOL shotBurst_isActive()
+{
+    return s_active;
+}
+
+BOOL shotBurst_formatTip(char *out, size_t size)
+{
+    ShotStats stats;
+
+    if(!s_happened || (!s_active && GetTickCount() - s_stopTick >= BURST_TIP_TIME))
+        return FALSE;
+
+    shotStats_get(&stats);
+    shotStats_formatBurstTip(&stats, out, size);
+
+    return TRUE;
+}
@@ -0,0 +1,56 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SHOT_BURST_H
+#define SHOT_BURST_H
+
+#include <windef.h>
+
+/* Limits of the interval between the burst frames in milliseconds */
+#define SHOT_BURST_MIN_INTERVAL 20
+#define SHOT_BURST_MAX_INTERVAL 60000
+
+/**
+ * @brief Start the burst capture, or stop the running one
+ *
+ * The frames are captured every burst-interval milliseconds into the ring
+ * of burst-slots buffers allocated at the start, and get saved by the usual
+ * saver threads behind the capture. The burst stops by itself after the
+ * burst-duration milliseconds.
+ */
+void shotBurst_toggle(HWND hWnd);
+
+void shotBurst_stop(HWND hWnd);
+
+BOOL shotBurst_isActive();
+
+/**
+ * @brief Make the tooltip with the rate of the running or just finished burst
+ * @param out Output buffer
+ * @param size Size of the output buffer
+ * @return FALSE when no burst happened lately, the regular tooltip should be shown then
+ */
+BOOL shotBurst_formatTip(char *out, size_t size);
+
+#endif /* SHOT_BURST_H */
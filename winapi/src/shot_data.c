@@ -43,12 +43,6 @@ void ShotData_free(ShotData *data)
 
     ShotData_clear(data);
 
-    if(data->m_pixels)
-    {
-        free(data->m_pixels);
-        data->m_pixels = NULL;
-    }
-
     ZeroMemory(data, sizeof(ShotData));
 }
 
@@ -105,11 +99,6 @@ void ShotData_update(ShotData *data)
     {
         ShotData_clear(data);
 
-        if(!data->m_pixels)
-            data->m_pixels = (uint8_t*)malloc(newSize + w);
-        else
-            data->m_pixels = (uint8_t*)realloc(data->m_pixels, newSize);
-
         data->m_pixels_size = newSize;
 
         data->m_screenW = w;
@@ -32,7 +32,7 @@
 struct ShotData_t
 {
     int     m_isInit;
-    uint8_t *m_pixels;
+    /* Size of the whole screen frame in BGRA format, the buffer is taken from the frame pool on every shot */
     size_t  m_pixels_size;
 
     LONG    m_screenW;
@@ -22,13 +22,18 @@
  * SOFTWARE.
  */
 
+#include <stdio.h>
 #include <windows.h>
 
 #include "misc.h"
 #include "shot_hooks.h"
 #include "ftp_sender.h"
 #include "shot_proc.h"
+#include "shot_burst.h"
 #include "tray_icon.h"
+#include "shot_trace.h"
+#include "shot_stats.h"
+#include "settings.h"
 #include "resource.h"
 #include "resource_ex.h"
 
@@ -37,18 +42,21 @@ static HHOOK    s_msgHook = NULL;
 static BOOL     s_prScrPressed = FALSE;
 static BOOL     s_hookBlocked = FALSE;
 
-BOOL isForegroundFullscreen()
+BOOL isWindowFullscreen(HWND window)
 {
-    HWND window = GetForegroundWindow();
     RECT a, b;
-    BOOL ret;
     GetWindowRect(window, &a);
     GetWindowRect(GetDesktopWindow(), &b);
 
-    ret = (a.left   == b.left  &&
-           a.top    == b.top   &&
-           a.right  == b.right &&
-           a.bottom == b.bottom);
+    return (a.left   == b.left  &&
+            a.top    == b.top   &&
+            a.right  == b.right &&
+            a.bottom == b.bottom);
+}
+
+BOOL isForegroundFullscreen()
+{
+    BOOL ret = isWindowFullscreen(GetForegroundWindow());
 
     if(!ret && s_hookBlocked)
         s_hookBlocked = FALSE;
@@ -68,7 +76,14 @@ LRESULT CALLBACK ntWindowHookLL(int code, WPARAM wParam, LPARAM lParam)
     {
         KBDLLHOOKSTRUCT*s = (KBDLLHOOKSTRUCT*)lParam;
         if(s->vkCode == VK_SNAPSHOT)
-            SendMessageA(g_trayIconHWnd, WM_COMMAND, (WPARAM)ID_CMD_MAKE_SHOT, (LPARAM)0);
+        {
+            shotTrace_point(TRACE_HOOK, 0, (uint32_t)s->vkCode);
+            /* Ctrl+PrScr starts or stops the burst */
+            if(GetAsyncKeyState(VK_CONTROL) & 0x8000)
+                SendMessageA(g_trayIconHWnd, WM_COMMAND, (WPARAM)ID_CMD_BURST, (LPARAM)0);
+            else
+                SendMessageA(g_trayIconHWnd, WM_COMMAND, (WPARAM)ID_CMD_MAKE_SHOT, (LPARAM)0);
+        }
     }
 
     return CallNextHookEx(s_msgHook, code, wParam, lParam);
@@ -94,7 +109,13 @@ void CALLBACK win9xWindowHook(HWND p1, UINT p2, UINT_PTR p3, DWORD p4)
     {
         s_prScrPressed = FALSE;
         if(needHook)
-            SendMessageA(g_trayIconHWnd, WM_COMMAND, (WPARAM)ID_CMD_MAKE_SHOT, (LPARAM)0);
+        {
+            shotTrace_point(TRACE_HOOK, 0, VK_SNAPSHOT);
+            if(GetAsyncKeyState(VK_CONTROL) & 0x8000)
+                SendMessageA(g_trayIconHWnd, WM_COMMAND, (WPARAM)ID_CMD_BURST, (LPARAM)0);
+            else
+                SendMessageA(g_trayIconHWnd, WM_COMMAND, (WPARAM)ID_CMD_MAKE_SHOT, (LPARAM)0);
+        }
     }
 }
 
@@ -114,6 +135,7 @@ void initKeyHook(HWND hWnd, HINSTANCE hInstance)
 
     RegisterHotKey(hWnd, ID_HOTKEY_ALT_SHOT, MOD_ALT, VK_SNAPSHOT);
     RegisterHotKey(hWnd, ID_HOTKEY_SHOT, 0, VK_SNAPSHOT);
+    RegisterHotKey(hWnd, ID_HOTKEY_BURST, MOD_CONTROL, VK_SNAPSHOT);
 
     if(isDosBased) /* Make a watch timer */
     {
@@ -131,6 +153,7 @@ void closeKeyHooks(HWND hWnd)
 {
     UnregisterHotKey(hWnd, ID_HOTKEY_SHOT);
     UnregisterHotKey(hWnd, ID_HOTKEY_ALT_SHOT);
+    UnregisterHotKey(hWnd, ID_HOTKEY_BURST);
     KillTimer(hWnd, ID_HOOK_TIMER);
 }
 
@@ -138,6 +161,123 @@ void closeKeyHooks(HWND hWnd)
 static BOOL s_icon_blinkToggle = FALSE;
 static UINT_PTR s_icon_activeTimer = 0;
 
+/* How often to refresh the tooltip, in milliseconds */
+#define STATS_TIMER_PERIOD  2000
+
+static DWORD s_statsLastWrite = 0;
+static BOOL s_statsWritten = FALSE;
+static ShotStats s_statsLast;
+
+static void takeStats(ShotStats *stats)
+{
+    shotStats_get(stats);
+    shotProc_queueStatus(&stats->queueDepth, &stats->queueBytes);
+    stats->uploadsPending = ftpSender_pendingCount();
+}
+
+/* The idle tooltip shows the summary once anything was shot */
+static void updateStatsTip()
+{
+    ShotStats stats;
+    char tip[64];
+
+    if(shotBurst_formatTip(tip, sizeof(tip)))
+    {
+        sysTraySetTip(tip);
+        return;
+    }
+
+    takeStats(&stats);
+
+    if(stats.shotsTaken == 0)
+    {
+        sysTraySetTip(NULL);
+        return;
+    }
+
+    shotStats_formatTip(&stats, tip, sizeof(tip));
+    sysTraySetTip(tip);
+}
+
+static BOOL statsChanged(const ShotStats *a, const ShotStats *b)
+{
+    return a->shotsTaken != b->shotsTaken || a->shotsDropped != b->shotsDropped || a->shotsSkipped != b->shotsSkipped ||
+           a->shotsSaved != b->shotsSaved || a->uploadsDone != b->uploadsDone ||
+           a->uploadsFailed != b->uploadsFailed || a->queueDepth != b->queueDepth ||
+           a->uploadsPending != b->uploadsPending;
+}
+
+/* Nothing gets written while the statistics stay the same */
+static void writeStatsFile()
+{
+    ShotStats stats;
+    char path[MAX_PATH];
+
+    takeStats(&stats);
+
+    if(s_statsWritten && !statsChanged(&stats, &s_statsLast))
+        return;
+
+    snprintf(path, MAX_PATH, "%s\\tinyscr_stats.json", settingsConfigDir());
+
+    if(!shotStats_writeJson(&stats, path))
+    {
+        debugLog("-- Failed to write the statistics file %s\n", path);
+        return;
+    }
+
+    s_statsLast = stats;
+    s_statsWritten = TRUE;
+}
+
+static void CALLBACK statsTimer(HWND p1, UINT p2, UINT_PTR p3, DWORD p4)
+{
+    (void)p1; (void)p2; (void)p3; (void)p4;
+
+    /* The blinker shows the save queue meanwhile */
+    if(!s_icon_activeTimer)
+        updateStatsTip();
+
+    if(g_settings.statsInterval <= 0 || GetTickCount() - s_statsLastWrite < (DWORD)g_settings.statsInterval * 1000)
+        return;
+
+    s_statsLastWrite = GetTickCount();
+    writeStatsFile();
+}
+
+void initStatsTimer(HWND hWnd)
+{
+    s_statsLastWrite = GetTickCount();
+    SetTimer(hWnd, ID_STATS_TIMER, STATS_TIMER_PERIOD, &statsTimer);
+}
+
+void closeStatsTimer(HWND hWnd)
+{
+    KillTimer(hWnd, ID_STATS_TIMER);
+
+    if(g_settings.statsInterval > 0)
+        writeStatsFile();
+}
+
+static void updateQueueTip()
+{
+    char tip[64];
+    int count;
+    size_t bytes;
+
+    shotProc_queueStatus(&count, &bytes);
+
+    if(count <= 0 || shotBurst_formatTip(tip, sizeof(tip)))
+    {
+        updateStatsTip();
+        return;
+    }
+
+    snprintf(tip, 64, "TinyShot: %d shot(s) pending, %u.%u MB",
+             count, (unsigned)(bytes / 1048576), (unsigned)((bytes % 1048576) * 10 / 1048576));
+    sysTraySetTip(tip);
+}
+
 static void CALLBACK iconBlinkerTimer(HWND p1, UINT p2, UINT_PTR p3, DWORD p4)
 {
     BOOL is_ftp = ftpSender_isBusy();
@@ -147,6 +287,8 @@ static void CALLBACK iconBlinkerTimer(HWND p1, UINT p2, UINT_PTR p3, DWORD p4)
 
     s_icon_blinkToggle = !s_icon_blinkToggle;
 
+    updateQueueTip();
+
     if(!s_icon_blinkToggle && is_saver)
     {
         if(is_ftp)
@@ -189,5 +331,6 @@ void initIconBlinkerFinish(HWND hWnd)
     KillTimer(hWnd, s_icon_activeTimer);
     s_icon_activeTimer = 0;
     sysTraySetIcon(SET_ICON_NORMAL);
+    updateStatsTip();
     s_icon_blinkToggle = 0;
 }
@@ -28,7 +28,12 @@
 #include <windef.h>
 
 /**
- * @brief Detects the full-screen video game that is unable to process Windows global hotkeys, so, workarounds needed
+ * @brief Checks if the window covers the whole screen, has no side effects, so can be called from any thread
+ */
+BOOL isWindowFullscreen(HWND window);
+/**
+ * @brief Detects the full-screen video game that is unable to process Windows global hotkeys, so, workarounds needed.
+ * Unblocks the hook once the foreground window is not fullscreen, so only the hook and the tray window call it
  * @return If foreground window possibly fullscreen
  */
 BOOL isForegroundFullscreen();
@@ -40,4 +45,13 @@ void closeKeyHooks(HWND hWnd);
 void initIconBlinker(HWND hWnd);
 void initIconBlinkerFinish(HWND hWnd);
 
+/**
+ * @brief Start to show the statistics at the tray icon tooltip and to write them into the tinyscr_stats.json file
+ */
+void initStatsTimer(HWND hWnd);
+/**
+ * @brief Stop the statistics timer and write the final state of the statistics into the file
+ */
+void closeStatsTimer(HWND hWnd);
+
 #endif /* SHOT_HOOKS_H */
@@ -24,130 +24,624 @@
 
 #include <stdio.h>
 #include <stdint.h>
-#include <shlwapi.h>
 #include <windows.h>
 
 #include "shot_proc.h"
 #include "shot_data.h"
 #include "shot_hooks.h"
+#include "shot_transcode.h"
 #include "tray_icon.h"
 #include "ftp_sender.h"
 #include "settings.h"
 #include "misc.h"
+#include "png_stripes.h"
+#include "png_preset.h"
+#include "pix_conv.h"
+#include "frame_pool.h"
+#include "shot_queue.h"
+#include "shot_name.h"
+#include "shot_trace.h"
+#include "shot_stats.h"
+#include "frame_hash.h"
+#include "frame_delta.h"
+#include "apng_writer.h"
+#include "shot_format.h"
+#include "core_sys.h"
 
 #include "spng.h"
 
 
 typedef struct tagSaveData
 {
+    /* Link of the save queue, the bytes field is the size of the pix_data */
+    ShotQueueItem link;
     char save_path[MAX_PATH];
     uint8_t *pix_data;
     size_t pix_len;
     uint32_t w;
     uint32_t h;
     uint32_t pitch;
-    struct tagSaveData *b_next;
-    struct tagSaveData *b_prev;
+    /* One of ShotFormat values, the extension of the save_path */
+    int format;
+    /* Encoded file to upload right from the memory, owned by the FTP sender after the hand over */
+    uint8_t *png;
+    size_t png_len;
+    /* The file is written in the fast format and should be converted into PNG later */
+    BOOL transcode;
+    /* Number of the shot in the trace */
+    uint32_t trace;
+    /* Hash of the pixels, 0 when the duplicates aren't looked for */
+    uint64_t hash;
+    /* The shot is equal to the earlier one saved at this path, it gets linked instead of encoding */
+    char dup_of[MAX_PATH];
+    /* The whole screen shot, only these get saved as the deltas */
+    BOOL screen;
+    /* Only the rect part of the screen is in pix_data, the file continues the delta_prev shot */
+    BOOL delta;
+    FrameDeltaRect rect;
+    char delta_prev[MAX_PATH];
+    /* Frame of the burst capture, saved without the sound */
+    BOOL burst;
+    /*
+     * Frame of the burst APNG: only the rect part gets encoded, but the buffer has the
+     * whole frame until it's written. The part is drawn over the frame number apngBase,
+     * 0 means that the rect is the whole frame. The time is counted from the burst start.
+     */
+    BOOL apng;
+    uint32_t apngFrame;
+    uint32_t apngBase;
+    uint32_t apngTime;
 } SaveData;
 
-static SaveData* s_queue_begin = NULL;
-static SaveData* s_queue_end = NULL;
-static HANDLE s_queue_mutex = 0;
+static ShotQueue s_queue;
 
-static void queue_insert(SaveData *item)
+/* Recent shots to find the duplicates, only touched by the thread that takes the shots */
+typedef struct tagRecentShot
 {
-    if(s_queue_mutex)
-        WaitForSingleObject(s_queue_mutex, INFINITE);
+    uint64_t hash;
+    /* Empty when the slot is free or the shot was dropped */
+    char path[MAX_PATH];
+} RecentShot;
+
+static RecentShot s_recent[SHOTPROC_MAX_DUP_HISTORY];
+static int s_recentNext = 0;
+
+/* The previous screen shot the next delta gets compared with, only touched by the thread that takes the shots */
+static FrameDelta s_delta;
+static char s_deltaPrev[MAX_PATH];
+
+/* APNG of the running burst, the frames are written into it by the hand over in the order of shots */
+static ApngWriter s_apng;
+static HANDLE s_apngMutex = 0;
+static BOOL s_apngOpen = FALSE;
+/* No more frames come, the file gets closed once the pending ones are written */
+static BOOL s_apngEnding = FALSE;
+/* Frames that are queued, but not written or dropped yet */
+static int s_apngPending = 0;
+/* Number of the latest frame written into the file */
+static uint32_t s_apngWritten = 0;
+static uint32_t s_apngDelay = 0;
+static char s_apngPath[MAX_PATH];
+
+/* Burst APNG state of the thread that takes the shots */
+static BOOL s_burstApng = FALSE;
+static FrameDelta s_apngDelta;
+static uint32_t s_apngCaptured = 0;
+static uint32_t s_apngW = 0;
+static uint32_t s_apngH = 0;
+static uint64_t s_apngStart = 0;
+
+static const char *s_burstFormatNames[SHOT_BURST_FORMAT_COUNT] =
+{
+    "apng",
+    "png"
+};
+
+static const char *s_dupActionNames[SHOT_DUP_ACTION_COUNT] =
+{
+    "skip",
+    "link"
+};
+
+static void recent_forget(const char *path)
+{
+    int i;
+
+    for(i = 0; i < SHOTPROC_MAX_DUP_HISTORY; ++i)
+    {
+        if(s_recent[i].path[0] && lstrcmpiA(s_recent[i].path, path) == 0)
+            s_recent[i].path[0] = '\0';
+    }
+}
+
+static void apng_lock()
+{
+    if(s_apngMutex)
+        WaitForSingleObject(s_apngMutex, INFINITE);
+}
+
+static void apng_unlock()
+{
+    if(s_apngMutex)
+        ReleaseMutex(s_apngMutex);
+}
+
+/* Must be called with the locked mutex */
+static void apngFinish()
+{
+    int ret;
+
+    s_apngOpen = FALSE;
+
+    ret = apngWriter_close(&s_apng);
+    if(ret)
+        debugLog("-- Failed to finish the burst file %s: %s\n", s_apngPath, spng_strerror(ret));
+
+    debugLog("-- Burst file %s has %lu frames\n", s_apngPath, (unsigned long)s_apng.frames);
+
+    if(s_apng.frames == 0)
+    {
+        DeleteFileA(s_apngPath);
+        return;
+    }
 
-    if(!s_queue_begin) /* First item */
+    if(g_settings.ftpEnable)
+        ftpSender_queueFile(NULL, s_apngPath);
+}
+
+/* Must be called with the locked mutex when the queued frame got written or dropped */
+static void apngFrameDone()
+{
+    s_apngPending--;
+
+    if(s_apngEnding && s_apngPending <= 0 && s_apngOpen)
+        apngFinish();
+}
+
+/* Throw the frame away, including the placeholder file made by generateShotFileName() */
+static void dropFrame(SaveData *item)
+{
+    debugLog("-- Save queue is full, dropping %s\n", item->apng ? "the burst frame" : item->save_path);
+    shotStats_shotDropped();
+
+    if(item->apng)
     {
-        s_queue_begin = item;
-        s_queue_end = item;
+        /* The next frame can't be drawn over this one, so it gets taken whole */
+        frameDelta_reset(&s_apngDelta);
+        apng_lock();
+        apngFrameDone();
+        apng_unlock();
     }
     else
     {
-        s_queue_end->b_next = item;
-        item->b_prev = s_queue_end;
-        s_queue_end = item;
+        recent_forget(item->save_path);
+        /* The next delta would continue the file that never gets written */
+        if(item->screen && g_settings.deltaCapture)
+            frameDelta_reset(&s_delta);
+        DeleteFileA(item->save_path);
     }
 
-    if(s_queue_mutex)
-        ReleaseMutex(s_queue_mutex);
+    framePool_release(item->pix_data);
+    free(item);
+}
+
+/* The frame pool has no free buffer for the new shot */
+static void poolFull()
+{
+    shotStats_shotTaken();
+    shotStats_shotDropped();
+    MessageBeep(MB_ICONHAND);
+}
+
+static size_t queueBudget()
+{
+    return (size_t)g_settings.queueBudgetMB * 1024 * 1024;
+}
+
+/* Returns FALSE if the item was dropped because of the memory budget */
+static BOOL queue_insert(SaveData *item)
+{
+    ShotQueueItem *dropped, *next;
+    BOOL accept;
+
+    item->link.bytes = item->pix_len;
+    accept = shotQueue_insert(&s_queue, &item->link, queueBudget(), g_settings.queuePolicy, &dropped);
+
+    while(dropped)
+    {
+        next = dropped->next;
+        dropFrame((SaveData *)dropped);
+        dropped = next;
+    }
+
+    if(!accept)
+        dropFrame(item);
+
+    return accept;
 }
 
 static SaveData *queue_get()
 {
-    SaveData *ret = NULL;
+    return (SaveData *)shotQueue_get(&s_queue);
+}
+
+/* The saver has finished with the item taken by queue_get() */
+static void queue_done(SaveData *item)
+{
+    shotQueue_done(&s_queue, &item->link, queueBudget());
+}
+
+void shotProc_queueStatus(int *count, size_t *bytes)
+{
+    shotQueue_status(&s_queue, count, bytes);
+}
+
+static HANDLE s_saverThreads[SHOTPROC_MAX_SAVERS];
+static int s_saverThreadsCount = 0;
+static HANDLE s_saverSemaphore = 0;
+static volatile LONG s_saverQuit = 0;
+
+/* Position of the delta on the screen, and the file name of the previous shot */
+static void setDeltaChunks(spng_ctx *ctx, SaveData *saver)
+{
+    struct spng_offs offs;
+    struct spng_text text;
+    const char *prev = saver->delta_prev;
+    const char *p;
+
+    for(p = saver->delta_prev; *p; ++p)
+    {
+        if(*p == '\\' || *p == '/')
+            prev = p + 1;
+    }
+
+    offs.x = (int32_t)saver->rect.x;
+    offs.y = (int32_t)saver->rect.y;
+    offs.unit_specifier = 0;
+    spng_set_offs(ctx, &offs);
+
+    ZeroMemory(&text, sizeof(text));
+    lstrcpynA(text.keyword, FRAME_DELTA_KEYWORD, sizeof(text.keyword));
+    text.type = SPNG_TEXT;
+    text.length = lstrlenA(prev);
+    text.text = (char *)prev;
+    spng_set_text(ctx, &text, 1);
+}
+
+/* Encode the PNG into the file, or into the saver->png buffer when f is NULL */
+static int savePngSingle(FILE *f, SaveData *saver, const PngPreset *preset)
+{
+    struct spng_ihdr ihdr;
+    spng_ctx *ctx;
+    int ret;
+
+    ZeroMemory(&ihdr, sizeof(ihdr));
+
+    ctx = spng_ctx_new(SPNG_CTX_ENCODER);
+    if(!ctx)
+        return SPNG_EMEM;
+
+    ihdr.width = saver->w;
+    ihdr.height = saver->h;
+    ihdr.color_type = SPNG_COLOR_TYPE_TRUECOLOR;
+    ihdr.bit_depth = 8;
+
+    spng_set_ihdr(ctx, &ihdr);
+    if(f)
+        spng_set_png_file(ctx, f);
+    else
+        spng_set_option(ctx, SPNG_ENCODE_TO_BUFFER, 1);
+    spng_set_option(ctx, SPNG_IMG_COMPRESSION_LEVEL, preset->level);
+    spng_set_option(ctx, SPNG_IMG_COMPRESSION_STRATEGY, preset->strategy);
+    spng_set_option(ctx, SPNG_FILTER_CHOICE, preset->filters);
+
+    if(saver->delta)
+        setDeltaChunks(ctx, saver);
+
+    ret = spng_encode_image(ctx, saver->pix_data, saver->pix_len, SPNG_FMT_PNG, SPNG_ENCODE_FINALIZE);
+
+    if(!f && !ret)
+        saver->png = (uint8_t *)spng_get_png_buffer(ctx, &saver->png_len, &ret);
+
+    spng_ctx_free(ctx);
+
+    return ret;
+}
+
+typedef BOOL (WINAPI *PtrCreateHardLinkA)(LPCSTR, LPCSTR, LPSECURITY_ATTRIBUTES);
+
+/* The earlier file is already written, as the frames are handed over in the order of shots */
+static void linkDuplicate(SaveData *dup)
+{
+    static PtrCreateHardLinkA createHardLink = NULL;
+    static BOOL triedLoad = FALSE;
+
+    /* Windows 2000 and newer only */
+    if(!triedLoad)
+    {
+        createHardLink = (PtrCreateHardLinkA)GetProcAddress(GetModuleHandleA("kernel32"), "CreateHardLinkA");
+        triedLoad = TRUE;
+    }
 
-    if(s_queue_mutex)
-        WaitForSingleObject(s_queue_mutex, INFINITE);
+    /* The placeholder made by generateShotFileName() is in the way */
+    DeleteFileA(dup->save_path);
 
-    if(s_queue_begin)
+    if(createHardLink && createHardLink(dup->save_path, dup->dup_of, NULL))
+        return;
+
+    /* FAT file systems can't link */
+    if(!CopyFileA(dup->dup_of, dup->save_path, FALSE))
+        debugLog("-- Failed to copy the duplicate shot %s: %lu\n", dup->dup_of, GetLastError());
+}
+
+/* Write the burst frame into the APNG, it's called in the order of frames */
+static void apngAppend(SaveData *frame)
+{
+    FrameDeltaRect whole;
+    const PngPreset *preset;
+    int ret;
+
+    apng_lock();
+
+    if(s_apngOpen)
     {
-        ret = s_queue_begin;
-        s_queue_begin = s_queue_begin->b_next;
+        if(frame->png && (frame->apngBase == 0 || frame->apngBase == s_apngWritten))
+            ret = apngWriter_addFrame(&s_apng, frame->png, frame->png_len, &frame->rect, frame->apngTime, s_apngDelay);
+        else
+        {
+            /* The frame this part is drawn over never got into the file, so the whole frame is needed */
+            whole.x = 0;
+            whole.y = 0;
+            whole.w = frame->w;
+            whole.h = frame->h;
+            preset = pngPreset_get(g_settings.compression);
+            ret = apngWriter_encodeFrame(&s_apng, frame->pix_data, frame->pitch, &whole,
+                                         pngStripes_workersCount(g_settings.encodeThreads, frame->h), preset,
+                                         frame->apngTime, s_apngDelay);
+        }
 
-        if(!s_queue_begin) /* Reached end of queue */
-            s_queue_end = NULL;
+        if(ret)
+            debugLog("-- Failed to write the burst frame %lu: %s\n", (unsigned long)frame->apngFrame, spng_strerror(ret));
         else
-            s_queue_begin->b_prev = NULL;
+            s_apngWritten = frame->apngFrame;
+
+        shotTrace_point(TRACE_FILE_WRITTEN, frame->trace, (uint32_t)frame->png_len);
     }
 
-    if(s_queue_mutex)
-        ReleaseMutex(s_queue_mutex);
+    apngFrameDone();
 
-    return ret;
+    apng_unlock();
 }
 
-static HANDLE s_saverThread = NULL;
-static DWORD s_saverThreadId = 0;
+static void passToSender(ShotQueueItem *item, void *user)
+{
+    SaveData *ready = (SaveData *)item;
 
-static DWORD WINAPI png_saver_thread(LPVOID lpParameter)
+    (void)user;
+
+    if(ready->apng)
+    {
+        apngAppend(ready);
+        if(ready->png)
+            free(ready->png);
+        framePool_release(ready->pix_data);
+        free(ready);
+        return;
+    }
+
+    if(ready->dup_of[0])
+        linkDuplicate(ready);
+
+    if(ready->png)
+        ftpSender_queueBuffer(NULL, ready->save_path, ready->png, ready->png_len, ready->trace);
+
+    if(ready->transcode)
+        shotTranscode_add(ready->save_path);
+
+    free(ready);
+}
+
+/* Files must reach the FTP sender in the order of shots, even when the savers finish them in another order */
+static void queue_handOver(SaveData *item)
+{
+    shotQueue_handOver(&s_queue, &item->link, &passToSender, NULL);
+}
+
+/*
+ * The file to upload gets encoded into the memory: the FTP sender takes it from
+ * there, and the local copy is only written when it should be kept.
+ */
+static int encodeForUpload(SaveData *saver, const PngPreset *preset, int workers)
 {
-    SaveData *saver = NULL;
     FILE *f;
-    struct spng_ihdr ihdr;
-    spng_ctx *ctx;
     int ret;
 
-    (void)lpParameter;
+    if(workers > 1)
+        ret = pngStripes_encodeToBuffer(&saver->png, &saver->png_len, saver->pix_data,
+                                        saver->w, saver->h, saver->pitch, 3, workers, preset);
+    else
+        ret = savePngSingle(NULL, saver, preset);
 
-    while((saver = queue_get()) != NULL)
-    {
-        ZeroMemory(&ihdr, sizeof(ihdr));
+    if(ret)
+        return ret;
 
+    /* Otherwise the empty placeholder keeps the name reserved until the sender removes it */
+    if(!g_settings.ftpRemoveUploaded)
+    {
         f = fopen(saver->save_path, "wb");
+        if(!f || fwrite(saver->png, 1, saver->png_len, f) != saver->png_len)
+            ret = SPNG_IO_ERROR;
         if(f)
-        {
-            ctx = spng_ctx_new(SPNG_CTX_ENCODER);
-            if(ctx)
-            {
-                ihdr.width = saver->w;
-                ihdr.height = saver->h;
-                ihdr.color_type = SPNG_COLOR_TYPE_TRUECOLOR_ALPHA;
-                ihdr.bit_depth = 8;
+            fclose(f);
+        shotTrace_point(TRACE_FILE_WRITTEN, saver->trace, (uint32_t)saver->png_len);
+    }
 
-                spng_set_ihdr(ctx, &ihdr);
-                spng_set_png_file(ctx, f);
+    return ret;
+}
 
-                ret = spng_encode_image(ctx, saver->pix_data, saver->pix_len, SPNG_FMT_PNG, SPNG_ENCODE_FINALIZE);
+/*
+ * QOI, BMP and TGA files are encoded into the memory in one pass and written
+ * at once. The file gets uploaded from the memory, unless it is going to be
+ * converted into PNG: then the PNG gets uploaded instead.
+ */
+static int saveFastFrame(SaveData *saver, size_t *size)
+{
+    FILE *f;
+    int ret;
 
-                if(ret)
-                    MessageBoxA(NULL, spng_strerror(ret), "PNG Encode error", MB_OK|MB_ICONERROR);
+    ret = shotFormat_encode(saver->format, &saver->png, &saver->png_len,
+                            saver->pix_data, saver->w, saver->h, saver->pitch, 1, NULL);
 
-                spng_ctx_free(ctx);
-            }
+    shotTrace_point(TRACE_ENCODE_END, saver->trace, (uint32_t)saver->png_len);
+
+    if(ret)
+        return ret;
 
+    *size = saver->png_len;
+
+    if(!g_settings.ftpEnable || !g_settings.ftpRemoveUploaded || g_settings.transcodeIdle)
+    {
+        f = fopen(saver->save_path, "wb");
+        if(!f || fwrite(saver->png, 1, saver->png_len, f) != saver->png_len)
+            ret = SPNG_IO_ERROR;
+        if(f)
             fclose(f);
+        shotTrace_point(TRACE_FILE_WRITTEN, saver->trace, (uint32_t)saver->png_len);
+    }
+
+    if(!g_settings.ftpEnable || g_settings.transcodeIdle)
+    {
+        free(saver->png);
+        saver->png = NULL;
+        saver->png_len = 0;
+    }
+
+    saver->transcode = ret == 0 && g_settings.transcodeIdle;
+
+    return ret;
+}
 
-            if(g_settings.ftpEnable)
-                ftpSender_queueFile(NULL, saver->save_path);
+/* Only the part changed since the previous burst frame gets encoded, the APNG is written by the hand over */
+static void saveApngFrame(SaveData *saver)
+{
+    const PngPreset *preset = pngPreset_get(saver->link.degraded ? PNG_PRESET_FASTEST : g_settings.compression);
+    int ret, workers = pngStripes_workersCount(g_settings.encodeThreads, saver->rect.h);
+    uint64_t encodeStart = coreSys_timeUs();
+
+    shotTrace_point(TRACE_ENCODE_BEGIN, saver->trace, (uint32_t)workers);
+
+    ret = pngStripes_encodeToBuffer(&saver->png, &saver->png_len,
+                                    saver->pix_data + (size_t)saver->rect.y * saver->pitch + (size_t)saver->rect.x * 3,
+                                    saver->rect.w, saver->rect.h, saver->pitch, 3, workers, preset);
+
+    shotTrace_point(TRACE_ENCODE_END, saver->trace, (uint32_t)saver->png_len);
+
+    if(ret == 0)
+        shotStats_shotSaved((uint32_t)((coreSys_timeUs() - encodeStart) / 1000), saver->png_len);
+    else
+        debugLog("-- Failed to encode the burst frame %lu: %s\n", (unsigned long)saver->apngFrame, spng_strerror(ret));
+
+    /* The buffer is kept until the hand over, as the whole frame is needed when its base frame is lost */
+    queue_done(saver);
+    queue_handOver(saver);
+}
+
+static void saveFrame(SaveData *saver)
+{
+    FILE *f;
+    const PngPreset *preset;
+    int ret = -1, workers;
+    size_t pngSize = 0;
+    uint64_t encodeStart;
+
+    if(saver->apng)
+    {
+        saveApngFrame(saver);
+        return;
+    }
+
+    /* Duplicates have nothing to encode, they only wait for their turn in the hand over */
+    if(saver->dup_of[0])
+    {
+        queue_done(saver);
+        queue_handOver(saver);
+        return;
+    }
+
+    /* The striped encoder doesn't write the extra chunks, the deltas are small anyway */
+    workers = saver->delta ? 1 : pngStripes_workersCount(g_settings.encodeThreads, saver->h);
+    preset = pngPreset_get(saver->link.degraded ? PNG_PRESET_FASTEST : g_settings.compression);
+
+    shotTrace_point(TRACE_ENCODE_BEGIN, saver->trace, (uint32_t)workers);
+    encodeStart = coreSys_timeUs();
+
+    if(saver->format != SHOT_FORMAT_PNG)
+    {
+        ret = saveFastFrame(saver, &pngSize);
+        if(ret)
+            MessageBoxA(NULL, spng_strerror(ret), "Encode error", MB_OK|MB_ICONERROR);
+    }
+    else if(g_settings.ftpEnable)
+    {
+        ret = encodeForUpload(saver, preset, workers);
+        pngSize = saver->png_len;
+        shotTrace_point(TRACE_ENCODE_END, saver->trace, (uint32_t)saver->png_len);
+        if(ret)
+            MessageBoxA(NULL, spng_strerror(ret), "PNG Encode error", MB_OK|MB_ICONERROR);
+    }
+    else
+    {
+        f = fopen(saver->save_path, "wb");
+        if(f)
+        {
+            if(workers > 1)
+                ret = pngStripes_encode(f, saver->pix_data, saver->w, saver->h, saver->pitch, 3, workers, preset);
+            else
+                ret = savePngSingle(f, saver, preset);
+
+            shotTrace_point(TRACE_ENCODE_END, saver->trace, 0);
+
+            if(ret)
+                MessageBoxA(NULL, spng_strerror(ret), "PNG Encode error", MB_OK|MB_ICONERROR);
+            else
+                pngSize = (size_t)ftell(f);
+
+            fclose(f);
+            shotTrace_point(TRACE_FILE_WRITTEN, saver->trace, (uint32_t)pngSize);
         }
+    }
+
+    if(ret == 0)
+        shotStats_shotSaved((uint32_t)((coreSys_timeUs() - encodeStart) / 1000), pngSize);
 
-        free(saver->pix_data);
-        free(saver);
+    queue_done(saver);
+    framePool_release(saver->pix_data);
+    saver->pix_data = NULL;
+    queue_handOver(saver);
 
+    if(!saver->burst)
         MessageBeep(MB_ICONEXCLAMATION);
+}
+
+static void saveAllFrames()
+{
+    SaveData *saver;
+
+    while((saver = queue_get()) != NULL)
+        saveFrame(saver);
+}
+
+static DWORD WINAPI png_saver_thread(LPVOID lpParameter)
+{
+    (void)lpParameter;
+
+    /* One semaphore count is given for every queued frame, the extra wake-ups just find the queue empty */
+    while(WaitForSingleObject(s_saverSemaphore, INFINITE) == WAIT_OBJECT_0)
+    {
+        saveAllFrames();
+
+        if(s_saverQuit)
+            break;
     }
 
     return 0;
@@ -155,109 +649,391 @@ static DWORD WINAPI png_saver_thread(LPVOID lpParameter)
 
 BOOL shotProc_isBusy()
 {
-    DWORD res = 0;
+    int count;
+    size_t bytes;
 
-    if(s_saverThread)
-        res = WaitForSingleObject(s_saverThread, 0);
-    else
-        res = WAIT_OBJECT_0;
+    shotProc_queueStatus(&count, &bytes);
 
-    return res != WAIT_OBJECT_0;
+    return count > 0;
 }
 
 void shotProc_init()
 {
-    if(!s_queue_mutex)
-        s_queue_mutex = CreateMutexA(NULL, FALSE, NULL);
+    shotQueue_init(&s_queue);
+    frameDelta_init(&s_delta);
+    frameDelta_init(&s_apngDelta);
+    /* The settings aren't loaded yet, the stripe helpers get started by the first shot that needs them */
+    pngStripes_init(1);
+
+    if(!s_apngMutex)
+        s_apngMutex = CreateMutexA(NULL, FALSE, NULL);
 }
 
 void shotProc_quit()
 {
-    if(s_saverThread)
+    closePngSaverThread();
+    pngStripes_quit();
+    shotQueue_free(&s_queue);
+    frameDelta_free(&s_delta);
+    frameDelta_free(&s_apngDelta);
+
+    /* All frames are saved by now, the burst file should be already closed */
+    apng_lock();
+    if(s_apngOpen)
+        apngFinish();
+    apng_unlock();
+
+    if(s_apngMutex)
     {
-        WaitForSingleObject(s_saverThread, INFINITE);
-        CloseHandle(s_saverThread);
-        s_saverThread = NULL;
+        CloseHandle(s_apngMutex);
+        s_apngMutex = 0;
     }
+}
+
+static int saversCount()
+{
+    SYSTEM_INFO sysInfo;
+    int savers = g_settings.saveWorkers;
 
-    if(s_queue_mutex)
+    if(savers <= 0)
     {
-        CloseHandle(s_queue_mutex);
-        s_queue_mutex = 0;
+        GetSystemInfo(&sysInfo);
+        savers = (int)sysInfo.dwNumberOfProcessors;
     }
+
+    if(savers > SHOTPROC_MAX_SAVERS)
+        savers = SHOTPROC_MAX_SAVERS;
+
+    if(savers < 1)
+        savers = 1;
+
+    return savers;
 }
 
+/* Start the savers once, they stay alive and wait for frames until the quit */
 static BOOL tryRunPngThread(HWND hWnd)
 {
-    DWORD res = 0;
+    DWORD threadId;
+    int i, savers;
 
-    if(s_saverThread)
-        res = WaitForSingleObject(s_saverThread, 0);
-    else
-        res = WAIT_OBJECT_0;
+    if(s_saverThreadsCount > 0)
+        return TRUE;
 
-    if(res == WAIT_OBJECT_0)
+    if(!s_saverSemaphore)
     {
-        s_saverThread = CreateThread(NULL, 0, &png_saver_thread, NULL, 0, &s_saverThreadId);
-        if(!s_saverThread)
+        s_saverSemaphore = CreateSemaphoreA(NULL, 0, 0x7FFFFFFF, NULL);
+        if(!s_saverSemaphore)
         {
-            errorMessageBox(hWnd, "Failed to make PNG saver thread: %s.\n\nTrying without.", "Whoops");
+            errorMessageBox(hWnd, "Failed to make PNG saver semaphore: %s.\n\nTrying without.", "Whoops");
             return FALSE;
         }
     }
 
+    s_saverQuit = 0;
+    savers = saversCount();
+
+    for(i = 0; i < savers; ++i)
+    {
+        s_saverThreads[s_saverThreadsCount] = CreateThread(NULL, 0, &png_saver_thread, NULL, 0, &threadId);
+        if(!s_saverThreads[s_saverThreadsCount])
+            break;
+        s_saverThreadsCount++;
+    }
+
+    if(s_saverThreadsCount == 0)
+    {
+        errorMessageBox(hWnd, "Failed to make PNG saver thread: %s.\n\nTrying without.", "Whoops");
+        return FALSE;
+    }
+
+    debugLog("-- Started %d PNG saver threads\n", s_saverThreadsCount);
+
+    return TRUE;
+}
+
+/*
+ * The shot equal to one of the recent shots doesn't get encoded again: it is
+ * either thrown away, or queued without pixels to be linked to the earlier
+ * file. Returns TRUE if the shot was thrown away.
+ */
+static BOOL skipDuplicate(SaveData *saver)
+{
+    int i, found = -1, history = g_settings.dupHistory;
+
+    if(history <= 0)
+        return FALSE;
+
+    if(history > SHOTPROC_MAX_DUP_HISTORY)
+        history = SHOTPROC_MAX_DUP_HISTORY;
+
+    /* The size goes to the seed, so the frames of different sizes never match */
+    saver->hash = frameHash_compute(saver->pix_data, saver->pix_len, ((uint64_t)saver->w << 32) | saver->h);
+
+    for(i = 0; i < history; ++i)
+    {
+        if(s_recent[i].path[0] && s_recent[i].hash == saver->hash)
+        {
+            found = i;
+            break;
+        }
+    }
+
+    shotTrace_point(TRACE_HASH, saver->trace, found >= 0);
+
+    if(found < 0)
+    {
+        s_recentNext %= history;
+        s_recent[s_recentNext].hash = saver->hash;
+        lstrcpynA(s_recent[s_recentNext].path, saver->save_path, MAX_PATH);
+        s_recentNext++;
+        return FALSE;
+    }
+
+    debugLog("-- Shot %s repeats %s\n", saver->save_path, s_recent[found].path);
+    shotStats_shotSkipped();
+
+    framePool_release(saver->pix_data);
+    saver->pix_data = NULL;
+    saver->pix_len = 0;
+
+    /*
+     * The uploaded files get removed, so there may be nothing to link to, the delta files
+     * can't be linked, and the files waiting for the conversion get replaced by PNG
+     */
+    if(g_settings.dupAction == SHOT_DUP_LINK && !(g_settings.ftpEnable && g_settings.ftpRemoveUploaded) &&
+       !(saver->screen && g_settings.deltaCapture && saver->format == SHOT_FORMAT_PNG) &&
+       !(saver->format != SHOT_FORMAT_PNG && g_settings.transcodeIdle))
+    {
+        lstrcpynA(saver->dup_of, s_recent[found].path, MAX_PATH);
+        return FALSE;
+    }
+
+    DeleteFileA(saver->save_path);
+    free(saver);
+
+    return TRUE;
+}
+
+/*
+ * Keep only the part of the screen shot that has changed since the previous
+ * shot. The part moves into its own buffer, so the pooled frame is free for
+ * the next shot, and the queue budget counts only what is going to be saved.
+ */
+static void makeDelta(SaveData *saver)
+{
+    uint8_t *part;
+    size_t partLen;
+
+    if(frameDelta_compare(&s_delta, saver->pix_data, saver->w, saver->h, 3,
+                          (uint32_t)g_settings.deltaTile, (uint32_t)g_settings.deltaKeyframe, &saver->rect))
+    {
+        lstrcpynA(s_deltaPrev, saver->save_path, MAX_PATH);
+        return;
+    }
+
+    partLen = (size_t)saver->rect.w * saver->rect.h * 3;
+    part = (uint8_t *)malloc(partLen);
+    if(!part)
+    {
+        /* The whole frame is the same as the remembered one, so it still fits as the key frame */
+        debugLog("-- Out of memory for the delta of %s\n", saver->save_path);
+        lstrcpynA(s_deltaPrev, saver->save_path, MAX_PATH);
+        return;
+    }
+
+    frameDelta_crop(saver->pix_data, saver->pitch, 3, &saver->rect);
+    memcpy(part, saver->pix_data, partLen);
+    framePool_release(saver->pix_data);
+
+    saver->pix_data = part;
+    saver->pix_len = partLen;
+    saver->w = saver->rect.w;
+    saver->h = saver->rect.h;
+    saver->pitch = saver->rect.w * 3;
+    saver->delta = TRUE;
+    lstrcpynA(saver->delta_prev, s_deltaPrev, MAX_PATH);
+    lstrcpynA(s_deltaPrev, saver->save_path, MAX_PATH);
+}
+
+/* Put the frame into the save queue and make sure the saver does its job, returns FALSE if it was dropped */
+static BOOL submitFrame(HWND hWnd, SaveData *saver)
+{
+    uint32_t trace = saver->trace;
+    BOOL accepted, burst = saver->burst;
+
+    shotStats_shotTaken();
+
+    if(!saver->apng && skipDuplicate(saver))
+    {
+        sysTraySetIcon(SET_ICON_NORMAL);
+        return TRUE;
+    }
+
+    /* The deltas need the PNG chunks */
+    if(saver->screen && !saver->apng && g_settings.deltaCapture && saver->format == SHOT_FORMAT_PNG)
+        makeDelta(saver);
+
+    accepted = queue_insert(saver);
+
+    shotTrace_point(TRACE_ENQUEUE, trace, (uint32_t)accepted);
+
+    if(!accepted)
+    {
+        sysTraySetIcon(SET_ICON_NORMAL);
+        if(!burst)
+            MessageBeep(MB_ICONHAND);
+        return FALSE;
+    }
+
+    if(!tryRunPngThread(hWnd))
+    {
+        sysTraySetIcon(SET_ICON_BUSY);
+        saveAllFrames();
+        sysTraySetIcon(SET_ICON_NORMAL);
+    }
+    else
+    {
+        ReleaseSemaphore(s_saverSemaphore, 1, NULL);
+        initIconBlinker(hWnd);
+    }
+
     return TRUE;
 }
 
+int shotProc_dupActionFromName(const char *name)
+{
+    int i;
+
+    for(i = 0; i < SHOT_DUP_ACTION_COUNT; ++i)
+    {
+        if(lstrcmpiA(name, s_dupActionNames[i]) == 0)
+            return i;
+    }
+
+    return SHOT_DUP_SKIP;
+}
+
+const char *shotProc_dupActionName(int action)
+{
+    if(action < 0 || action >= SHOT_DUP_ACTION_COUNT)
+        action = SHOT_DUP_SKIP;
+
+    return s_dupActionNames[action];
+}
+
 void closePngSaverThread()
 {
-    if(s_saverThread)
+    int i;
+
+    if(s_saverThreadsCount > 0)
+    {
+        /* Savers finish all queued frames before they leave */
+        InterlockedExchange(&s_saverQuit, 1);
+        ReleaseSemaphore(s_saverSemaphore, s_saverThreadsCount, NULL);
+
+        for(i = 0; i < s_saverThreadsCount; ++i)
+        {
+            WaitForSingleObject(s_saverThreads[i], INFINITE);
+            CloseHandle(s_saverThreads[i]);
+            s_saverThreads[i] = NULL;
+        }
+
+        s_saverThreadsCount = 0;
+    }
+
+    if(s_saverSemaphore)
     {
-        WaitForSingleObject(s_saverThread, INFINITE);
-        CloseHandle(s_saverThread);
-        s_saverThread = NULL;
+        CloseHandle(s_saverSemaphore);
+        s_saverSemaphore = 0;
     }
 }
 
 
-static void generatePngFileName(char *out, size_t out_size)
+static void generateShotFileName(char *out, size_t out_size, int format)
 {
     SYSTEMTIME ltime;
-    uint32_t diff = 0;
-    FILE *f;
+    ShotTime t;
 
     GetLocalTime(&ltime);
 
-    snprintf(out, out_size, "%s\\Scr_%04u-%02u-%02u_%02u-%02u-%02u.png",
-             g_settings.savePath,
-             ltime.wYear, ltime.wMonth, ltime.wDay,
-             ltime.wHour, ltime.wMinute, ltime.wSecond);
+    t.year = ltime.wYear;
+    t.month = ltime.wMonth;
+    t.day = ltime.wDay;
+    t.hour = ltime.wHour;
+    t.minute = ltime.wMinute;
+    t.second = ltime.wSecond;
 
-    while(PathFileExistsA(out))
-    {
-        snprintf(out, out_size, "%s\\Scr_%04u-%02u-%02u_%02u-%02u-%02u-%u.png",
-                 g_settings.savePath,
-                 ltime.wYear, ltime.wMonth, ltime.wDay,
-                 ltime.wHour, ltime.wMinute, ltime.wSecond, ++diff);
-    }
+    shotName_generate(out, out_size, g_settings.savePath, &t, shotFormat_extension(format));
+}
 
-    /* Truncate filename to avoid races */
-    f = fopen(out, "wb");
-    if(f)
-        fclose(f);
+/*
+ * Find the part of the burst frame changed since the previous one, it's the only
+ * part to encode into the APNG. Returns FALSE if nothing has changed: the frame is
+ * not needed, as the previous frame just stays longer on the screen.
+ */
+static BOOL prepareApngFrame(SaveData *saver)
+{
+    uint32_t time = (uint32_t)((coreSys_timeUs() - s_apngStart) / 1000);
+    int key;
+
+    key = frameDelta_compare(&s_apngDelta, saver->pix_data, saver->w, saver->h, 3,
+                             (uint32_t)g_settings.deltaTile, 0, &saver->rect);
+
+    if(s_apngDelta.unchanged)
+        return FALSE;
+
+    saver->apng = TRUE;
+    saver->apngFrame = ++s_apngCaptured;
+    saver->apngBase = key ? 0 : saver->apngFrame - 1;
+    saver->apngTime = time;
+
+    apng_lock();
+    s_apngPending++;
+    apng_unlock();
+
+    return TRUE;
 }
 
-void cmd_makeScreenshot(HWND hWnd, ShotData *data)
+/* The burst frames are taken from the pre-allocated ring and don't make any sound */
+static int takeScreen(HWND hWnd, ShotData *data, BOOL burst)
 {
     BITMAPINFO bi;
     SaveData *saver = NULL;
-    uint8_t *pix8, tmp;
-    LONG i;
+    uint8_t *pixels;
+    uint32_t trace = shotTrace_newShot();
+    int ret;
 
+    shotTrace_point(TRACE_CAPTURE, trace, (uint32_t)burst);
     sysTraySetIcon(SET_ICON_BUSY);
 
     ShotData_update(data);
     BitBlt(data->m_screen_bitmap_dc, 0, 0, data->m_screenW, data->m_screenH, data->m_screen_dc, 0, 0, SRCCOPY);
+    shotTrace_point(TRACE_BITBLT, trace, 0);
+
+    /* GetDIBits() writes right into the pooled buffer that gets passed to the saver thread */
+    if(burst)
+        ret = framePool_acquireBurst(&pixels, data->m_pixels_size);
+    else
+        ret = framePool_acquire(&pixels, data->m_pixels_size);
+
+    if(ret == FRAME_POOL_FULL)
+    {
+        sysTraySetIcon(SET_ICON_NORMAL);
+        if(burst)
+        {
+            shotStats_shotTaken();
+            shotStats_shotDropped();
+        }
+        else
+            poolFull();
+        return SHOT_BURST_DROPPED;
+    }
+    else if(ret != FRAME_POOL_OK)
+    {
+        sysTraySetIcon(SET_ICON_NORMAL);
+        errorMessageBox(hWnd, "Out of memory: %s", "Whoops");
+        return SHOT_BURST_FAILED;
+    }
 
     memset(&bi, 0, sizeof(BITMAPINFO));
     bi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
@@ -268,48 +1044,149 @@ void cmd_makeScreenshot(HWND hWnd, ShotData *data)
     bi.bmiHeader.biCompression = BI_RGB;
     bi.bmiHeader.biSizeImage = data->m_screenW * data->m_screenH * 4;
 
-    if(GetDIBits(data->m_screenDC, data->m_screen_bitmap, 0, data->m_screenH, data->m_pixels, &bi, DIB_RGB_COLORS) == 0)
+    if(GetDIBits(data->m_screenDC, data->m_screen_bitmap, 0, data->m_screenH, pixels, &bi, DIB_RGB_COLORS) == 0)
     {
+        framePool_release(pixels);
         errorMessageBox(hWnd, "Failed to take the screenshot using GetDIBits: %s", "Whoops");
-        return;
+        return SHOT_BURST_FAILED;
     }
 
-    pix8 = data->m_pixels;
+    shotTrace_point(TRACE_GETDIBITS, trace, 0);
+    if(!burst)
+        MessageBeep(MB_OK);
 
-    for(i = 0; i < data->m_screenW * data->m_screenH; ++i)
+    saver = (SaveData*)malloc(sizeof(SaveData));
+    if(!saver)
     {
-        tmp = pix8[0];
-        pix8[0] = pix8[2];
-        pix8[2] = tmp;
-        pix8[3] = 0xFF;
-        pix8 += 4;
+        framePool_release(pixels);
+        return SHOT_BURST_FAILED;
     }
 
-    MessageBeep(MB_OK);
+    ZeroMemory(saver, sizeof(SaveData));
+    saver->w = data->m_screenW;
+    saver->h = data->m_screenH;
+    saver->pitch = data->m_screenW * 3;
+    saver->pix_len = saver->pitch * saver->h;
+    saver->pix_data = pixels;
+    saver->trace = trace;
+    saver->screen = TRUE;
+    saver->burst = burst;
 
-    saver = (SaveData*)malloc(sizeof(SaveData));
-    if(saver)
-    {
-        ZeroMemory(saver, sizeof(SaveData));
-        saver->w = data->m_screenW;
-        saver->h = data->m_screenH;
-        saver->pitch = data->m_screenW * 4;
-        generatePngFileName(saver->save_path, MAX_PATH);
-        saver->pix_data = malloc(data->m_pixels_size);
-        saver->pix_len = data->m_pixels_size;
-        memcpy(saver->pix_data,  data->m_pixels,  data->m_pixels_size);
+    pixConv_bgraToRgb(pixels, pixels, (size_t)saver->w * saver->h);
+    shotTrace_point(TRACE_SWIZZLE, trace, 0);
 
-        queue_insert(saver);
+    if(burst && s_burstApng)
+    {
+        /* The frames of another size don't fit the APNG canvas */
+        if(saver->w != s_apngW || saver->h != s_apngH)
+        {
+            shotStats_shotTaken();
+            shotStats_shotDropped();
+            framePool_release(pixels);
+            free(saver);
+            sysTraySetIcon(SET_ICON_NORMAL);
+            return SHOT_BURST_DROPPED;
+        }
 
-        if(!tryRunPngThread(hWnd))
+        if(!prepareApngFrame(saver))
         {
-            sysTraySetIcon(SET_ICON_BUSY);
-            png_saver_thread(NULL);
+            shotStats_shotTaken();
+            shotStats_shotSkipped();
+            framePool_release(pixels);
+            free(saver);
             sysTraySetIcon(SET_ICON_NORMAL);
+            return SHOT_BURST_SAVED;
         }
-        else
-            initIconBlinker(hWnd);
     }
+    else
+    {
+        saver->format = g_settings.saveFormat;
+        generateShotFileName(saver->save_path, MAX_PATH, saver->format);
+    }
+
+    return submitFrame(hWnd, saver) ? SHOT_BURST_SAVED : SHOT_BURST_DROPPED;
+}
+
+void cmd_makeScreenshot(HWND hWnd, ShotData *data)
+{
+    takeScreen(hWnd, data, FALSE);
+}
+
+BOOL shotProc_burstBegin(HWND hWnd, ShotData *data, uint32_t intervalMs)
+{
+    int ret;
+
+    s_burstApng = g_settings.burstFormat == SHOT_BURST_APNG;
+    if(!s_burstApng)
+        return TRUE;
+
+    generateShotFileName(s_apngPath, MAX_PATH, SHOT_FORMAT_PNG);
+
+    apng_lock();
+    ret = apngWriter_open(&s_apng, s_apngPath, (uint32_t)data->m_screenW, (uint32_t)data->m_screenH);
+    s_apngOpen = ret == 0;
+    s_apngEnding = FALSE;
+    s_apngPending = 0;
+    s_apngWritten = 0;
+    s_apngDelay = intervalMs;
+    apng_unlock();
+
+    if(ret)
+    {
+        DeleteFileA(s_apngPath);
+        msgBoxPr(hWnd, MB_OK|MB_ICONERROR, "Whoops", "Can't create the burst file %s: %s", s_apngPath, spng_strerror(ret));
+        s_burstApng = FALSE;
+        return FALSE;
+    }
+
+    /* The first frame is the whole screen */
+    frameDelta_reset(&s_apngDelta);
+    s_apngCaptured = 0;
+    s_apngW = (uint32_t)data->m_screenW;
+    s_apngH = (uint32_t)data->m_screenH;
+    s_apngStart = coreSys_timeUs();
+
+    return TRUE;
+}
+
+int shotProc_burstFrame(HWND hWnd, ShotData *data)
+{
+    return takeScreen(hWnd, data, TRUE);
+}
+
+void shotProc_burstEnd()
+{
+    if(!s_burstApng)
+        return;
+
+    s_burstApng = FALSE;
+
+    apng_lock();
+    s_apngEnding = TRUE;
+    if(s_apngPending <= 0 && s_apngOpen)
+        apngFinish();
+    apng_unlock();
+}
+
+int shotProc_burstFormatFromName(const char *name)
+{
+    int i;
+
+    for(i = 0; i < SHOT_BURST_FORMAT_COUNT; ++i)
+    {
+        if(lstrcmpiA(name, s_burstFormatNames[i]) == 0)
+            return i;
+    }
+
+    return SHOT_BURST_APNG;
+}
+
+const char *shotProc_burstFormatName(int format)
+{
+    if(format < 0 || format >= SHOT_BURST_FORMAT_COUNT)
+        format = SHOT_BURST_APNG;
+
+    return s_burstFormatNames[format];
 }
 
 void cmd_makeWindowShot(HWND hWnd)
@@ -317,15 +1194,18 @@ void cmd_makeWindowShot(HWND hWnd)
     RECT aRect;
     HWND srcWnd;
     HDC srcDC;
-    LONG i, w, h;
+    LONG w, h;
     HBITMAP dstBitmap;
     HDC dstDC;
     HGDIOBJ nullBitmap;
     BITMAPINFO bi;
     SaveData *saver = NULL;
-    uint8_t *pixels, *pix8, tmp;
+    uint8_t *pixels;
     size_t pixelsSize;
+    uint32_t trace = shotTrace_newShot();
+    int ret;
 
+    shotTrace_point(TRACE_CAPTURE, trace, 0);
     sysTraySetIcon(SET_ICON_BUSY);
 
     srcWnd = GetForegroundWindow();
@@ -341,17 +1221,21 @@ void cmd_makeWindowShot(HWND hWnd)
     nullBitmap = SelectObject(dstDC, dstBitmap);
 
     BitBlt(dstDC, 0, 0, w, h, srcDC, 0, 0, SRCCOPY);
+    shotTrace_point(TRACE_BITBLT, trace, 0);
 
     pixelsSize = w * h * 4;
-    pixels = (uint8_t *)malloc(pixelsSize);
-    if(!pixels)
+    ret = framePool_acquire(&pixels, pixelsSize);
+    if(ret != FRAME_POOL_OK)
     {
         ReleaseDC(srcWnd, srcDC);
         SelectObject(dstDC, nullBitmap);
         DeleteDC(dstDC);
         DeleteObject(dstBitmap);
         sysTraySetIcon(SET_ICON_NORMAL);
-        errorMessageBox(hWnd, "Out of memory: %s", "Whoops");
+        if(ret == FRAME_POOL_FULL)
+            poolFull();
+        else
+            errorMessageBox(hWnd, "Out of memory: %s", "Whoops");
         return;
     }
 
@@ -366,7 +1250,7 @@ void cmd_makeWindowShot(HWND hWnd)
 
     if(GetDIBits(srcDC, dstBitmap, 0, h, pixels, &bi, DIB_RGB_COLORS) == 0)
     {
-        free(pixels);
+        framePool_release(pixels);
         ReleaseDC(srcWnd, srcDC);
         SelectObject(dstDC, nullBitmap);
         DeleteDC(dstDC);
@@ -376,16 +1260,9 @@ void cmd_makeWindowShot(HWND hWnd)
         return;
     }
 
-    pix8 = pixels;
-
-    for(i = 0; i < w * h; ++i)
-    {
-        tmp = pix8[0];
-        pix8[0] = pix8[2];
-        pix8[2] = tmp;
-        pix8[3] = 0xFF;
-        pix8 += 4;
-    }
+    shotTrace_point(TRACE_GETDIBITS, trace, 0);
+    pixConv_bgraToRgb(pixels, pixels, (size_t)w * h);
+    shotTrace_point(TRACE_SWIZZLE, trace, 0);
 
     MessageBeep(MB_OK);
 
@@ -400,21 +1277,16 @@ void cmd_makeWindowShot(HWND hWnd)
         ZeroMemory(saver, sizeof(SaveData));
         saver->w = w;
         saver->h = h;
-        saver->pitch = w * 4;
-        generatePngFileName(saver->save_path, MAX_PATH);
+        saver->pitch = w * 3;
+        saver->format = g_settings.saveFormat;
+        generateShotFileName(saver->save_path, MAX_PATH, saver->format);
         saver->pix_data = pixels;
-        saver->pix_len = pixelsSize;
-        queue_insert(saver);
-
-        if(!tryRunPngThread(hWnd))
-        {
-            sysTraySetIcon(SET_ICON_BUSY);
-            png_saver_thread(NULL);
-            sysTraySetIcon(SET_ICON_NORMAL);
-        }
-        else
-            initIconBlinker(hWnd);
+        saver->pix_len = saver->pitch * h;
+        saver->trace = trace;
+        submitFrame(hWnd, saver);
     }
+    else
+        framePool_release(pixels);
 }
 
 void cmd_dumpClipboard(HWND hWnd, ShotData *data)
@@ -423,11 +1295,12 @@ void cmd_dumpClipboard(HWND hWnd, ShotData *data)
     BITMAP bitmapInfo;
     BITMAPINFO bi;
     HBITMAP bBitClip;
-    uint8_t *img_src, *pix8, tmp;
+    uint8_t *img_src;
     HDC bBitClipDC;
     HWND bBitClipOwner;
-    LONG i;
     size_t pixSize;
+    uint32_t trace;
+    int ret;
 
     if(!IsClipboardFormatAvailable(CF_BITMAP))
         return;
@@ -438,14 +1311,19 @@ void cmd_dumpClipboard(HWND hWnd, ShotData *data)
 
         if(bBitClip)
         {
+            trace = shotTrace_newShot();
+            shotTrace_point(TRACE_CAPTURE, trace, 0);
             sysTraySetIcon(SET_ICON_BUSY);
             GetObject(bBitClip, sizeof( BITMAP ), &bitmapInfo);
 
             pixSize = bitmapInfo.bmWidth * bitmapInfo.bmHeight * 4;
-            img_src = malloc(pixSize);
-            if(!img_src)
+            ret = framePool_acquire(&img_src, pixSize);
+            if(ret != FRAME_POOL_OK)
             {
-                errorMessageBox(hWnd, "Out of memory: %s", "Error");
+                if(ret == FRAME_POOL_FULL)
+                    poolFull();
+                else
+                    errorMessageBox(hWnd, "Out of memory: %s", "Error");
                 CloseClipboard();
                 return;
             }
@@ -467,11 +1345,12 @@ void cmd_dumpClipboard(HWND hWnd, ShotData *data)
                 errorMessageBox(hWnd, "Failed to take the clipboard content using GetDIBits: %s", "Whoops");
                 ReleaseDC(bBitClipOwner, bBitClipDC);
                 CloseClipboard();
-                free(img_src);
+                framePool_release(img_src);
                 return;
             }
 
             ReleaseDC(bBitClipOwner, bBitClipDC);
+            shotTrace_point(TRACE_GETDIBITS, trace, 0);
             MessageBeep(MB_OK);
 
             saver = (SaveData*)malloc(sizeof(SaveData));
@@ -480,32 +1359,20 @@ void cmd_dumpClipboard(HWND hWnd, ShotData *data)
                 ZeroMemory(saver, sizeof(SaveData));
                 saver->w = bitmapInfo.bmWidth;
                 saver->h = bitmapInfo.bmHeight;
-                saver->pitch = bitmapInfo.bmWidth * 4;
-                generatePngFileName(saver->save_path, MAX_PATH);
+                saver->pitch = bitmapInfo.bmWidth * 3;
+                saver->format = g_settings.saveFormat;
+                generateShotFileName(saver->save_path, MAX_PATH, saver->format);
                 saver->pix_data = img_src;
-                saver->pix_len = pixSize;
-
-                pix8 = img_src;
-                for(i = 0; i < saver->w * saver->h; ++i)
-                {
-                    tmp = pix8[0];
-                    pix8[0] = pix8[2];
-                    pix8[2] = tmp;
-                    pix8[3] = 0xFF;
-                    pix8 += 4;
-                }
-
-                queue_insert(saver);
-
-                if(!tryRunPngThread(hWnd))
-                {
-                    sysTraySetIcon(SET_ICON_BUSY);
-                    png_saver_thread(NULL);
-                    sysTraySetIcon(SET_ICON_NORMAL);
-                }
-                else
-                    initIconBlinker(hWnd);
+                saver->pix_len = saver->pitch * saver->h;
+                saver->trace = trace;
+
+                pixConv_bgraToRgb(img_src, img_src, (size_t)saver->w * saver->h);
+                shotTrace_point(TRACE_SWIZZLE, trace, 0);
+
+                submitFrame(hWnd, saver);
             }
+            else
+                framePool_release(img_src);
         }
 
         CloseClipboard();
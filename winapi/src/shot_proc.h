@@ -25,19 +25,109 @@
 #ifndef SHOT_PROC_H
 #define SHOT_PROC_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include <windef.h>
 
+#include "shot_queue.h"
+
 #ifndef SHOTDATA_DEFINED
 #   define SHOTDATA_DEFINED
 typedef struct ShotData_t ShotData;
 #endif
 
+/* Maximum number of the parallel PNG saver threads */
+#define SHOTPROC_MAX_SAVERS     8
+/* Maximum number of the previous shots the new one gets compared with */
+#define SHOTPROC_MAX_DUP_HISTORY    16
+
+/* What to do with the shot that is equal to one of the previous shots */
+enum ShotDupAction
+{
+    /* Don't save it at all */
+    SHOT_DUP_SKIP = 0,
+    /* Make the hard link to the file of the previous shot, or the copy when the file system can't link */
+    SHOT_DUP_LINK,
+    SHOT_DUP_ACTION_COUNT
+};
+
+/* How the frames of the burst get saved */
+enum ShotBurstFormat
+{
+    /* One animated PNG per burst, the frames after the first one keep only the changed part */
+    SHOT_BURST_APNG = 0,
+    /* Every frame is the separate PNG file */
+    SHOT_BURST_PNG,
+    SHOT_BURST_FORMAT_COUNT
+};
+
+/* Result of the burst frame capture */
+enum ShotBurstResult
+{
+    /* The frame was queued to be saved, or skipped as a duplicate */
+    SHOT_BURST_SAVED = 0,
+    /* The burst ring or the save queue is full, the frame was thrown away */
+    SHOT_BURST_DROPPED,
+    /* The error was reported, the burst should stop */
+    SHOT_BURST_FAILED
+};
+
 BOOL shotProc_isBusy();
+/**
+ * @brief Get the number of shots waiting for the saver (including the one being saved) and their size in memory
+ * @param count Number of shots
+ * @param bytes Total size of the pixel data
+ */
+void shotProc_queueStatus(int *count, size_t *bytes);
 void shotProc_init();
 void shotProc_quit();
 void closePngSaverThread();
 
+/**
+ * @brief Convert the duplicate action name from the config file into the ShotDupAction value
+ * @param name Name of the action: "skip" or "link" (case-insensitive)
+ * @return Action value, or SHOT_DUP_SKIP if name is unknown
+ */
+int shotProc_dupActionFromName(const char *name);
+
+/**
+ * @brief Get the name of the duplicate action for the config file
+ */
+const char *shotProc_dupActionName(int action);
+
 void cmd_makeScreenshot(HWND hWnd, ShotData *data);
+
+/**
+ * @brief Prepare to save the frames of the new burst, call it after framePool_beginBurst()
+ * @param hWnd Parent window for the errors
+ * @param data Screen data, its size is the size of the burst frames
+ * @param intervalMs Requested interval between the frames, the delay of the last APNG frame
+ * @return FALSE if the burst can't be saved
+ */
+BOOL shotProc_burstBegin(HWND hWnd, ShotData *data, uint32_t intervalMs);
+
+/**
+ * @brief Capture the screen into the next buffer of the burst ring made by framePool_beginBurst() and queue it
+ * @return One of ShotBurstResult values
+ */
+int shotProc_burstFrame(HWND hWnd, ShotData *data);
+
+/**
+ * @brief No more frames come for the burst, the APNG file gets finished once the queued frames are written
+ */
+void shotProc_burstEnd();
+
+/**
+ * @brief Convert the burst format name from the config file into the ShotBurstFormat value
+ * @param name Name of the format: "apng" or "png" (case-insensitive)
+ * @return Format value, or SHOT_BURST_APNG if name is unknown
+ */
+int shotProc_burstFormatFromName(const char *name);
+
+/**
+ * @brief Get the name of the burst format for the config file
+ */
+const char *shotProc_burstFormatName(int format);
 void cmd_makeWindowShot(HWND hWnd);
 void cmd_dumpClipboard(HWND hWnd, ShotData *data);
 
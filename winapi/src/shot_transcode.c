@@ -0,0 +1,326 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <windows.h>
+
+#include "shot_transcode.h"
+#include "shot_proc.h"
+#include "shot_burst.h"
+#include "ftp_sender.h"
+#include "settings.h"
+#include "misc.h"
+#include "shot_format.h"
+#include "png_preset.h"
+
+#include "spng.h"
+
+/* The files get converted only after this number of milliseconds without new shots */
+#define TRANSCODE_IDLE_TIME 5000
+/* How often the thread checks whether the program is idle, in milliseconds */
+#define TRANSCODE_POLL_TIME 1000
+
+typedef struct tagTranscodeFile
+{
+    struct tagTranscodeFile *next;
+    char path[MAX_PATH];
+} TranscodeFile;
+
+static TranscodeFile *s_first = NULL;
+static TranscodeFile *s_last = NULL;
+static int s_count = 0;
+static DWORD s_lastAdd = 0;
+
+static HANDLE s_mutex = 0;
+static HANDLE s_wake = 0;
+static HANDLE s_thread = NULL;
+static volatile LONG s_stop = 0;
+
+static void list_lock()
+{
+    if(s_mutex)
+        WaitForSingleObject(s_mutex, INFINITE);
+}
+
+static void list_unlock()
+{
+    if(s_mutex)
+        ReleaseMutex(s_mutex);
+}
+
+static BOOL list_take(char *path)
+{
+    TranscodeFile *item;
+
+    list_lock();
+
+    item = s_first;
+    if(item)
+    {
+        s_first = item->next;
+        if(!s_first)
+            s_last = NULL;
+        s_count--;
+    }
+
+    list_unlock();
+
+    if(!item)
+        return FALSE;
+
+    lstrcpynA(path, item->path, MAX_PATH);
+    free(item);
+
+    return TRUE;
+}
+
+static BOOL isIdle()
+{
+    DWORD lastAdd;
+
+    list_lock();
+    lastAdd = s_lastAdd;
+    list_unlock();
+
+    return GetTickCount() - lastAdd >= TRANSCODE_IDLE_TIME && !shotProc_isBusy() && !shotBurst_isActive();
+}
+
+static uint8_t *readFile(const char *path, size_t *len)
+{
+    uint8_t *data = NULL;
+    FILE *f;
+    long size;
+
+    f = fopen(path, "rb");
+    if(!f)
+        return NULL;
+
+    if(fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) > 0 && fseek(f, 0, SEEK_SET) == 0)
+    {
+        data = (uint8_t *)malloc((size_t)size);
+        if(data && fread(data, 1, (size_t)size, f) != (size_t)size)
+        {
+            free(data);
+            data = NULL;
+        }
+        *len = (size_t)size;
+    }
+
+    fclose(f);
+
+    return data;
+}
+
+/* The PNG is written into the temporary file first, so the exit in the middle never leaves the broken shot.
+   The original gets deleted only when the conversion is checked to keep every pixel */
+static void transcodeFile(const char *path)
+{
+    char pngPath[MAX_PATH], tmpPath[MAX_PATH + 4];
+    uint8_t *data, *png;
+    size_t len = 0, pngLen;
+    char *ext;
+    FILE *f;
+    int ret;
+
+    lstrcpynA(pngPath, path, MAX_PATH);
+    ext = strrchr(pngPath, '.');
+    if(!ext || strchr(ext, '\\') || lstrlenA(pngPath) - (ext - pngPath) != 4)
+    {
+        debugLog("-- Can't convert %s: unknown extension\n", path);
+        return;
+    }
+
+    lstrcpyA(ext, ".png");
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", pngPath);
+
+    data = readFile(path, &len);
+    if(!data)
+    {
+        debugLog("-- Can't read %s for the conversion: %lu\n", path, GetLastError());
+        return;
+    }
+
+    ret = shotFormat_convertToPng(data, len, &png, &pngLen, 1, pngPreset_get(g_settings.compression));
+    free(data);
+
+    if(ret != 0)
+    {
+        debugLog("-- Can't convert %s: %s, the file is kept\n", path,
+                 ret == -1 ? "the file is damaged" : ret == -2 ? "the pixels don't match" : spng_strerror(ret));
+        return;
+    }
+
+    f = fopen(tmpPath, "wb");
+    if(!f || fwrite(png, 1, pngLen, f) != pngLen)
+        ret = -1;
+    if(f && fclose(f) != 0)
+        ret = -1;
+
+    free(png);
+
+    if(ret != 0)
+    {
+        debugLog("-- Failed to convert %s: can't write %s\n", path, tmpPath);
+        DeleteFileA(tmpPath);
+        return;
+    }
+
+    /* Nothing else takes the name of the PNG while the fast file exists */
+    if(!MoveFileA(tmpPath, pngPath))
+    {
+        debugLog("-- Failed to rename %s: %lu\n", tmpPath, GetLastError());
+        DeleteFileA(tmpPath);
+        return;
+    }
+
+    DeleteFileA(path);
+
+    if(g_settings.ftpEnable)
+        ftpSender_queueFile(NULL, pngPath);
+}
+
+static DWORD WINAPI transcode_thread(LPVOID lpParameter)
+{
+    char path[MAX_PATH];
+
+    (void)lpParameter;
+
+    while(!s_stop)
+    {
+        WaitForSingleObject(s_wake, TRANSCODE_POLL_TIME);
+
+        /* Every next file waits for the idle time again, new shots may come in between */
+        while(!s_stop && isIdle() && list_take(path))
+            transcodeFile(path);
+    }
+
+    return 0;
+}
+
+void shotTranscode_add(const char *path)
+{
+    TranscodeFile *item;
+    DWORD threadId;
+
+    if(!s_mutex)
+        return;
+
+    item = (TranscodeFile *)malloc(sizeof(TranscodeFile));
+    if(!item)
+    {
+        debugLog("-- Out of memory to convert %s\n", path);
+        return;
+    }
+
+    item->next = NULL;
+    lstrcpynA(item->path, path, MAX_PATH);
+
+    list_lock();
+
+    if(s_last)
+        s_last->next = item;
+    else
+        s_first = item;
+    s_last = item;
+    s_count++;
+    s_lastAdd = GetTickCount();
+
+    if(!s_thread && !s_stop)
+    {
+        s_thread = CreateThread(NULL, 0, &transcode_thread, NULL, 0, &threadId);
+        if(s_thread)
+            SetThreadPriority(s_thread, THREAD_PRIORITY_IDLE);
+        else
+            debugLog("-- Failed to make the conversion thread: %lu\n", GetLastError());
+    }
+
+    list_unlock();
+}
+
+int shotTranscode_pendingCount()
+{
+    int count;
+
+    list_lock();
+    count = s_count;
+    list_unlock();
+
+    return count;
+}
+
+void shotTranscode_init()
+{
+    if(!s_mutex)
+        s_mutex = CreateMutexA(NULL, FALSE, NULL);
+
+    if(!s_wake)
+        s_wake = CreateEventA(NULL, FALSE, FALSE, NULL);
+}
+
+void shotTranscode_stop()
+{
+    HANDLE thread;
+
+    list_lock();
+    InterlockedExchange(&s_stop, 1);
+    thread = s_thread;
+    s_thread = NULL;
+    list_unlock();
+
+    if(thread)
+    {
+        SetEvent(s_wake);
+        WaitForSingleObject(thread, INFINITE);
+        CloseHandle(thread);
+    }
+}
+
+void shotTranscode_quit()
+{
+    char path[MAX_PATH];
+
+    shotTranscode_stop();
+
+    /* The list isn't kept between the runs, these files just stay in the fast format */
+    if(s_count > 0)
+        debugLog("-- %d shots are left unconverted\n", s_count);
+
+    while(list_take(path))
+        ;
+
+    if(s_mutex)
+    {
+        CloseHandle(s_mutex);
+        s_mutex = 0;
+    }
+
+    if(s_wake)
+    {
+        CloseHandle(s_wake);
+        s_wake = 0;
+    }
+}
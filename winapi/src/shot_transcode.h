@@ -0,0 +1,56 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2018-2025 Vitaly Novichkov
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SHOT_TRANSCODE_H
+#define SHOT_TRANSCODE_H
+
+/**
+ * @brief Convert the shot saved in the fast format into PNG later
+ *
+ * The files get converted one by one by the thread of the idle priority, only
+ * when no shots were saved for a few seconds, the save queue is empty and no
+ * burst is running. The converted PNG replaces the original file and gets
+ * uploaded when the FTP upload is enabled.
+ * @param path Path of the QOI, BMP or TGA file
+ */
+void shotTranscode_add(const char *path);
+
+/**
+ * @brief Number of the files waiting for the conversion
+ */
+int shotTranscode_pendingCount();
+
+void shotTranscode_init();
+
+/**
+ * @brief Stop the conversion thread, the file being converted gets finished
+ *
+ * Must be called before shotProc_quit(), the files added after it are left
+ * in their format.
+ */
+void shotTranscode_stop();
+
+void shotTranscode_quit();
+
+#endif /* SHOT_TRANSCODE_H */
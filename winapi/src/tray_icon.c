@@ -30,7 +30,10 @@
 #include "shot_data.h"
 #include "shot_hooks.h"
 #include "shot_proc.h"
+#include "shot_burst.h"
+#include "shot_transcode.h"
 #include "settings.h"
+#include "shot_trace.h"
 #include "resource.h"
 #include "resource_ex.h"
 
@@ -93,12 +96,20 @@ int detectShellVersion()
 static void ShowPopupMenu(HWND hWnd)
 {
     HMENU menu = CreatePopupMenu();
+    HMENU traceMenu = CreatePopupMenu();
     POINT pt;
 
     if(menu)
     {
         InsertMenuA(menu, -1, MF_BYPOSITION, IDM_SETTINGS, "Settings");
         InsertMenuA(menu, -1, MF_BYPOSITION, IDM_SAVECLIP, "Save image in clipboard");
+        if(traceMenu)
+        {
+            InsertMenuA(traceMenu, -1, MF_BYPOSITION, IDM_TRACE_JSON, "Chrome trace (JSON)");
+            InsertMenuA(traceMenu, -1, MF_BYPOSITION, IDM_TRACE_BINARY, "Binary");
+            /* The submenu gets destroyed together with the menu */
+            InsertMenuA(menu, -1, MF_BYPOSITION|MF_POPUP, (UINT_PTR)traceMenu, "Save latency trace");
+        }
         InsertMenuA(menu, -1, MF_SEPARATOR, -1, "");
         InsertMenuA(menu, -1, MF_BYPOSITION, IDM_QUIT, "Quit");
 
@@ -108,6 +119,23 @@ static void ShowPopupMenu(HWND hWnd)
         TrackPopupMenu(menu, TPM_BOTTOMALIGN, pt.x, pt.y, 0, hWnd, NULL);
         DestroyMenu(menu);
     }
+    else if(traceMenu)
+        DestroyMenu(traceMenu);
+}
+
+/* Dump the latest trace points next to the config file */
+static void saveTrace(HWND hWnd, int format)
+{
+    char path[MAX_PATH];
+    int count;
+
+    snprintf(path, MAX_PATH, "%s\\tinyscr_trace.%s", settingsConfigDir(), format == TRACE_FORMAT_BINARY ? "bin" : "json");
+
+    count = shotTrace_dump(path, format);
+    if(count < 0)
+        msgBoxPr(hWnd, MB_OK|MB_ICONERROR, "Save latency trace", "Can't write the trace file %s", path);
+    else
+        msgBoxPr(hWnd, MB_OK|MB_ICONINFORMATION, "Save latency trace", "%d trace events were saved into %s", count, path);
 }
 
 static BOOL OnCommand(HWND hWnd, WPARAM wParam, LPARAM lParam)
@@ -129,11 +157,21 @@ static BOOL OnCommand(HWND hWnd, WPARAM wParam, LPARAM lParam)
         cmd_dumpClipboard(hWnd, &g_shotData);
         break;
 
+    case IDM_TRACE_JSON:
+        saveTrace(hWnd, TRACE_FORMAT_JSON);
+        break;
+
+    case IDM_TRACE_BINARY:
+        saveTrace(hWnd, TRACE_FORMAT_BINARY);
+        break;
+
     case IDM_QUIT:
         if(IsWindowVisible(hWnd))
             SendMessage(hWnd, WM_DESTROY, (WPARAM)0, (LPARAM)0);
         else
             SendMessage(hWnd, WM_CLOSE, (WPARAM)0, (LPARAM)0);
+        shotBurst_stop(hWnd);
+        shotTranscode_stop();
         settingsDestroy();
         closeSysTrayIcon();
         shotProc_quit();
@@ -143,6 +181,10 @@ static BOOL OnCommand(HWND hWnd, WPARAM wParam, LPARAM lParam)
         cmd_makeScreenshot(hWnd, &g_shotData);
         break;
 
+    case ID_CMD_BURST:
+        shotBurst_toggle(hWnd);
+        break;
+
     default:
         ret = FALSE;
     }
@@ -175,6 +217,7 @@ static LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM l
         return OnCommand(hWnd, wParam, lParam);
 
     case WM_HOTKEY:
+        shotTrace_point(TRACE_HOOK, 0, (uint32_t)wParam);
         switch((int)wParam)
         {
         case IDHOT_SNAPDESKTOP:
@@ -201,6 +244,12 @@ static LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM l
                 setHookBlocked(TRUE);
             cmd_makeWindowShot(hWnd);
             break;
+        case ID_HOTKEY_BURST:
+            debugLog("Got a BURST hot key!\n");
+            if(isForegroundFullscreen())
+                setHookBlocked(TRUE);
+            shotBurst_toggle(hWnd);
+            break;
         }
         break;
 
@@ -249,6 +298,25 @@ void sysTraySetIcon(IconToSet icon)
     Shell_NotifyIconA(NIM_MODIFY, &g_trayIcon.tnd);
 }
 
+void sysTraySetTip(const char *tip)
+{
+    char newTip[64];
+
+    if(!g_trayIconHWnd)
+        return;
+
+    if(!tip)
+        tip = TRAY_ICON_DEFAULT_TIP;
+
+    lstrcpynA(newTip, tip, g_trayIcon.maxTipLength);
+
+    if(lstrcmpA(g_trayIcon.tnd.szTip, newTip) == 0)
+        return;
+
+    lstrcpyA(g_trayIcon.tnd.szTip, newTip);
+    Shell_NotifyIconA(NIM_MODIFY, &g_trayIcon.tnd);
+}
+
 ATOM regMyWindowClass(HINSTANCE hInst, LPCSTR lpzClassName)
 {
     WNDCLASS wcWindowClass;
@@ -300,6 +368,7 @@ int initSysTrayIcon(HINSTANCE hInstance)
     g_trayIcon.tnd.uFlags = NIF_MESSAGE|NIF_ICON|NIF_TIP;
     g_trayIcon.tnd.uCallbackMessage = MYWM_NOTIFYICON;
     g_trayIcon.tnd.hIcon = g_trayIcon.hIcon16;
+    lstrcpynA(g_trayIcon.tnd.szTip, TRAY_ICON_DEFAULT_TIP, g_trayIcon.maxTipLength);
 
     Shell_NotifyIconA(NIM_ADD, &g_trayIcon.tnd);
 
@@ -48,6 +48,7 @@ typedef struct TrayIcon TrayIcon;
 
 
 #define MYWM_NOTIFYICON (WM_APP + 101)
+#define TRAY_ICON_DEFAULT_TIP "Tiny Screenshoter"
 
 
 extern HWND g_trayIconHWnd;
@@ -65,6 +66,11 @@ typedef enum
 } IconToSet;
 
 void sysTraySetIcon(IconToSet icon);
+/**
+ * @brief Change the tooltip of the tray icon
+ * @param tip Tooltip text, NULL to restore the default one
+ */
+void sysTraySetTip(const char *tip);
 
 int initSysTrayIcon(HINSTANCE hInstance);
 void closeSysTrayIcon();